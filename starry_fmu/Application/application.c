@@ -30,11 +30,17 @@
 #include "sensor_manager.h"
 #include "console.h"
 #include "statistic.h"
+#include "trace.h"
 #include "copter_main.h"
 #include "file_manager.h"
 #include "logger.h"
+#include "log_writer.h"
 #include "fast_loop.h"
 #include "calibration.h"
+#ifdef SITL_SIMULATION
+#include <stdlib.h>
+#include "log_replay.h"
+#endif
 
 #ifdef RT_USING_LWIP
 #include <lwip/sys.h>
@@ -66,12 +72,18 @@ struct rt_thread thread_copter_handle;
 static char thread_logger_stack[2048];
 struct rt_thread thread_logger_handle;
 
+static char thread_log_writer_stack[2048];
+struct rt_thread thread_log_writer_handle;
+
 static char thread_led_stack[512];
 struct rt_thread thread_led_handle;
 
 static char thread_cali_stack[4096];
 struct rt_thread thread_cali_handle;
 
+static char thread_param_stack[2048];
+struct rt_thread thread_param_handle;
+
 FATFS FatFs;
 
 void vehicle_main_loop(void *parameter);
@@ -82,6 +94,7 @@ void rt_init_thread_entry(void* parameter)
 
 	rt_hw_mavlink_console_init();
 	statistic_init();
+	trace_init();
 	
     /* GDB STUB */
 #ifdef RT_USING_GDB
@@ -94,6 +107,14 @@ void rt_init_thread_entry(void* parameter)
 	device_led_init();
 	device_sensor_init();
 	device_mavproxy_init();
+	log_writer_init();
+	
+#ifdef SITL_SIMULATION
+	/* replay mode, run estimators on log file and quit */
+	if(log_replay_enabled()){
+		exit(log_replay_run());
+	}
+#endif
 	
 	//rt_console_set_device(CONSOLE_DEVICE);
 	
@@ -161,6 +182,15 @@ void rt_init_thread_entry(void* parameter)
 	if (res == RT_EOK)
 		rt_thread_startup(&thread_logger_handle);
 	
+	res = rt_thread_init(&thread_log_writer_handle,
+						   "log_writer",
+						   log_writer_entry,
+						   RT_NULL,
+						   &thread_log_writer_stack[0],
+						   sizeof(thread_log_writer_stack),LOG_WRITER_THREAD_PRIORITY,1);
+	if (res == RT_EOK)
+		rt_thread_startup(&thread_log_writer_handle);
+	
 	res = rt_thread_init(&thread_led_handle,
 						   "led",
 						   led_entry,
@@ -178,6 +208,15 @@ void rt_init_thread_entry(void* parameter)
 						   sizeof(thread_cali_stack),CALI_THREAD_PRIORITY,2);
 	if (res == RT_EOK)
 		rt_thread_startup(&thread_cali_handle);
+	
+	res = rt_thread_init(&thread_param_handle,
+						   "param",
+						   param_entry,
+						   RT_NULL,
+						   &thread_param_stack[0],
+						   sizeof(thread_param_stack),PARAM_THREAD_PRIORITY,1);
+	if (res == RT_EOK)
+		rt_thread_startup(&thread_param_handle);
 
 	/* delete itself */
 	rt_thread_delete(tid0);
@@ -185,7 +224,9 @@ void rt_init_thread_entry(void* parameter)
 
 int rt_application_init()
 {
+#ifndef SITL_SIMULATION
 	usb_cdc_init();
+#endif
 	fm_init("0:");
 	console_init(CONSOLE_INTERFACE_SERIAL);
 	rt_console_set_device(CONSOLE_DEVICE);
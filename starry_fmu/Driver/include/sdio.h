@@ -428,6 +428,8 @@ void SD_ProcessDMAIRQ(void);
 SD_Error SD_WaitReadOperation(void);
 SD_Error SD_WaitWriteOperation(void);
 SD_Error SD_HighSpeed(void);
+SD_Error SD_ReadDisk(uint8_t *readbuff, uint32_t sector, uint32_t count);
+SD_Error SD_WriteDisk(const uint8_t *writebuff, uint32_t sector, uint32_t count);
 
 ///////////////////////////////////
 void SD_LowLevel_DeInit(void);
@@ -383,6 +383,8 @@ uint8_t convert_from_bytes_to_power_of_two(uint16_t NumberOfBytes);
 //static OS_MUTEX SdioSD_Mutex;
 //static rt_mutex_t SdioSD_Mutex;
 static struct rt_mutex SdioSD_Mutex;
+/* released by SDIO interrupt when data transfer ends or fails */
+static struct rt_semaphore SdioSD_XferSem;
 
 rt_mutex_t rt_mutex_create (const char* name, rt_uint8_t flag);
 static rt_err_t SD_LockInit(void)
@@ -391,6 +393,8 @@ static rt_err_t SD_LockInit(void)
 	//OSMutexCreate(&SdioSD_Mutex, "SDIO SD Mutex", &err);	
 	//SdioSD_Mutex = rt_mutex_create ("SDIO_Mutex", RT_IPC_FLAG_PRIO);
 	err = rt_mutex_init (&SdioSD_Mutex, "SDIO_Mutex", RT_IPC_FLAG_PRIO);
+	if(err == RT_EOK)
+		err = rt_sem_init(&SdioSD_XferSem, "SDIO_Xfer", 0, RT_IPC_FLAG_FIFO);
 	
 	return err;
 	
@@ -2087,6 +2091,12 @@ SD_Error SD_ProcessIRQSrc(void)
   SDIO_ITConfig(SDIO_IT_DCRCFAIL | SDIO_IT_DTIMEOUT | SDIO_IT_DATAEND |
                 SDIO_IT_TXFIFOHE | SDIO_IT_RXFIFOHF | SDIO_IT_TXUNDERR |
                 SDIO_IT_RXOVERR | SDIO_IT_STBITERR, DISABLE);
+
+  /* wake up the thread waiting in SD_WaitDataEnd() */
+  if (TransferEnd || TransferError != SD_OK)
+  {
+    rt_sem_release(&SdioSD_XferSem);
+  }
   return(TransferError);
 }
 
@@ -2978,145 +2988,124 @@ SD_Error SD_HighSpeed (void)
 }
 
 //////////////////////////////////////
-#include <string.h>
-static uint32_t dma_buffer[512/sizeof(uint32_t)];
+/* ticks to wait for a transfer to end, or for the card to leave programming state */
+#define SD_XFER_TIMEOUT_TICK		500
+/* CMD13 polls before sleeping a tick, write programming usually ends within a few hundred us */
+#define SD_READY_POLL_NUM			32
+
+/* block until SDIO interrupt reports the end of data transfer */
+static SD_Error SD_WaitDataEnd(void)
+{
+	if(rt_sem_take(&SdioSD_XferSem, SD_XFER_TIMEOUT_TICK) != RT_EOK)
+		return SD_DATA_TIMEOUT;
+	
+	return TransferError;
+}
+
+/* wait card back to transfer state, poll first and only sleep for long programming */
+static SD_Error SD_WaitCardReady(void)
+{
+	SDTransferState state;
+	uint32_t poll_cnt = 0;
+	uint32_t tick_cnt = 0;
+	
+	while((state = SD_GetStatus()) == SD_TRANSFER_BUSY)
+	{
+		if(++poll_cnt < SD_READY_POLL_NUM)
+			continue;
+		if(++tick_cnt > SD_XFER_TIMEOUT_TICK)
+			return SD_DATA_TIMEOUT;
+		rt_thread_delay(1);
+	}
+	
+	return state == SD_TRANSFER_OK ? SD_OK : SD_ERROR;
+}
+
+/* readbuff must be 4 bytes aligned for DMA, disk_read() bounces unaligned buffer.
+ * More than one sector is always read by a single CMD18 */
 SD_Error SD_ReadDisk(uint8_t *readbuff, uint32_t sector, uint32_t count)
 {
-	uint32_t i;
 	SD_Error Status = SD_OK;
+	
+	if(((uint32_t)readbuff & 0x03) != 0 || count == 0)
+		return SD_INVALID_PARAMETER;
 
 	SD_LockPend();
-
-	if(((uint32_t)readbuff & 0x03) != 0)
-	{
-		for(i=0; i<count; i++)
-		{
-			Status = SD_ReadBlock((uint8_t*)dma_buffer, (sector + i) << 9 , 512);
-
-			if (Status != SD_OK)
-				goto returen_status;
-			
+	
 #ifdef SD_DMA_MODE
-			/* SDIODMAģʽҪDMAǷ */
-			Status = SD_WaitReadOperation();
-			if (Status != SD_OK)
-				goto returen_status;
-
-			//while(SD_GetStatus() != SD_TRANSFER_OK);
-			while(SD_GetStatus() != SD_TRANSFER_OK)
-			{
-//				OS_ERR      err;
-//				OSTimeDly(1, OS_OPT_TIME_DLY, &err);
-				rt_thread_delay(1);
-			}
-#endif	
-
-			memcpy(readbuff, (uint8_t*)dma_buffer, 512);
-			readbuff += 512;
-		}
+	/* drop wakeup left by previous transfer */
+	rt_sem_control(&SdioSD_XferSem, RT_IPC_CMD_RESET, 0);
+#endif
+	if (count == 1)
+	{
+		Status = SD_ReadBlock(readbuff, (uint64_t)sector << 9 , 512);
 	}
 	else
 	{
-		if (count == 1)
-		{
-			Status = SD_ReadBlock(readbuff, sector << 9 , 512);
-		}
-		else
-		{
-			Status = SD_ReadMultiBlocks(readbuff, sector << 9 , 512, count);
-		}
-		if (Status != SD_OK)
-			goto returen_status;
+		Status = SD_ReadMultiBlocks(readbuff, (uint64_t)sector << 9 , 512, count);
+	}
+	
 #ifdef SD_DMA_MODE
-		/* SDIODMAģʽҪDMAǷ */
+	if (Status == SD_OK)
+	{
+		SD_Error XferStatus = SD_WaitDataEnd();
+		
+		/* wait DMA and send CMD12 for multiple blocks even if transfer fails */
 		Status = SD_WaitReadOperation();
-		if (Status != SD_OK)
-			goto returen_status;
-		//while(SD_GetStatus() != SD_TRANSFER_OK);
-		while(SD_GetStatus() != SD_TRANSFER_OK)
-		{
-//			OS_ERR      err;
-//			OSTimeDly(1, OS_OPT_TIME_DLY, &err);
-			rt_thread_delay(1);
-		}
-#endif
+		if (XferStatus != SD_OK)
+			Status = XferStatus;
+	}
+	if (Status == SD_OK)
+	{
+		Status = SD_WaitCardReady();
 	}
+#endif
 
-returen_status:
 	SD_LockPost();
 	return Status;
 }
 
+/* writebuff must be 4 bytes aligned for DMA, disk_write() bounces unaligned buffer.
+ * More than one sector is always written by a single CMD25 */
 SD_Error SD_WriteDisk(const uint8_t *writebuff, uint32_t sector, uint32_t count)
 {
-	uint32_t i;
 	SD_Error Status = SD_OK;
 	
+	if(((uint32_t)writebuff & 0x03) != 0 || count == 0)
+		return SD_INVALID_PARAMETER;
+	
 	SD_LockPend();
 	
-	if(((uint32_t)writebuff & 0x03) != 0)
-	{
-		for(i=0; i<count; i++)
-		{
-			memcpy((uint8_t*)dma_buffer, writebuff, 512);
-			writebuff += 512;
-			
-			Status = SD_WriteBlock((uint8_t*)dma_buffer, (sector + i) << 9 , 512);
-			if(Status != SD_OK)
-				goto returen_status;
 #ifdef SD_DMA_MODE
-			/* SDIODMAģʽҪDMAǷ */
-			Status = SD_WaitWriteOperation();
-			if (Status != SD_OK)
-				goto returen_status;
-
-			//while(SD_GetStatus() != SD_TRANSFER_OK);
-			while(SD_GetStatus() != SD_TRANSFER_OK)
-			{
-//				OS_ERR      err;
-//				OSTimeDly(1, OS_OPT_TIME_DLY, &err);
-				rt_thread_delay(1);
-			}
+	/* drop wakeup left by previous transfer */
+	rt_sem_control(&SdioSD_XferSem, RT_IPC_CMD_RESET, 0);
 #endif
-		}
+	if (count == 1)
+	{
+		Status = SD_WriteBlock((uint8_t *)writebuff, (uint64_t)sector << 9 ,512);
 	}
 	else
 	{
-		if (count == 1)
-		{
-			Status = SD_WriteBlock((uint8_t *)writebuff, sector << 9 ,512);
-		}
-		else
-		{
-			/* ˴ʣ д count 1block޷д */
-			Status = SD_WriteMultiBlocks((uint8_t *)writebuff, sector << 9 ,512, count);
-			//Status = SD_WriteMultiBlocks((uint8_t *)writebuff, sector << 9 ,512, count + 1);
-		}
-		
-		if (Status != SD_OK)
-			goto returen_status;
+		Status = SD_WriteMultiBlocks((uint8_t *)writebuff, (uint64_t)sector << 9 ,512, count);
+	}
 
 #ifdef SD_DMA_MODE
-		/* SDIODMAģʽҪDMAǷ */
-		Status = SD_WaitWriteOperation();
-		if (Status != SD_OK)
-			goto returen_status;
-
-//		wts = OS_AbsoluteTime();
-		//while(SD_GetStatus() != SD_TRANSFER_OK);
-//		wte = OS_AbsoluteTime();
-//		wtu = wte-wts; //3550us		
-		while(SD_GetStatus() != SD_TRANSFER_OK)
-		{
-			rt_thread_delay(1);
-			//OS_ERR      err;
-			//OSTimeDly(1, OS_OPT_TIME_DLY, &err);
-		}
-#endif	
+	if (Status == SD_OK)
+	{
+		SD_Error XferStatus = SD_WaitDataEnd();
 		
+		/* wait DMA and send CMD12 for multiple blocks even if transfer fails */
+		Status = SD_WaitWriteOperation();
+		if (XferStatus != SD_OK)
+			Status = XferStatus;
 	}
+	if (Status == SD_OK)
+	{
+		/* card is busy programming flash after data is received */
+		Status = SD_WaitCardReady();
+	}
+#endif
 	
-returen_status:
 	SD_LockPost();
 	return Status;
 }
@@ -3307,16 +3296,12 @@ void SD_LowLevel_DMA_RxConfig(uint32_t *BufferDST, uint32_t BufferSize)
   */
 void SDIO_IRQHandler(void)
 {
-//	CPU_SR_ALLOC();
-//	
-//    CPU_CRITICAL_ENTER();                                       /* Tell the OS that we are starting an ISR            */
-//    OSIntEnter();
-//    CPU_CRITICAL_EXIT();
+	rt_interrupt_enter();
 	
 	  /* Process All SDIO Interrupt Sources */
 	  SD_ProcessIRQSrc();
 	
-//	OSIntExit();	
+	rt_interrupt_leave();
 }
 
 /**
@@ -3327,16 +3312,12 @@ void SDIO_IRQHandler(void)
   */
 void SD_SDIO_DMA_IRQHANDLER(void)
 {
-//	CPU_SR_ALLOC();
-//	
-//    CPU_CRITICAL_ENTER();                                       /* Tell the OS that we are starting an ISR            */
-//    OSIntEnter();
-//    CPU_CRITICAL_EXIT();
+	rt_interrupt_enter();
 	
   /* Process DMA2 Stream3 or DMA2 Stream6 Interrupt Sources */
   SD_ProcessDMAIRQ();
 	
-//	OSIntExit();	
+	rt_interrupt_leave();
 }
 
 /**
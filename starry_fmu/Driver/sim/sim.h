@@ -0,0 +1,35 @@
+/*
+ * File      : sim.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#ifndef __SIM_H__
+#define __SIM_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+/* vehicle state seen by the simulated sensors, in body frame unless noted */
+typedef struct
+{
+	float gyr[3];		/* rad/s */
+	float acc[3];		/* m/s^2, specific force */
+	float mag[3];		/* gauss */
+	float baro_alt;		/* m above MSL */
+	int32_t lat;		/* 1E-7 deg */
+	int32_t lon;		/* 1E-7 deg */
+	float vel_ned[3];	/* m/s, NED frame */
+}SIM_StateDef;
+
+void rt_hw_sim_serial_init(void);
+void rt_hw_sim_motor_init(void);
+
+void sim_set_state(const SIM_StateDef* state);
+void sim_get_state(SIM_StateDef* state);
+void sim_get_motor_output(float* duty_cyc, uint8_t num);
+
+#endif
@@ -0,0 +1,33 @@
+/*
+ * File      : sim_board.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <rtdevice.h>
+#include "board.h"
+#include "delay.h"
+#include "sim.h"
+
+/* no i2c bus in SITL, the led driver runs without its i2c device */
+rt_err_t device_i2c_init(char* name)
+{
+	return RT_ENOSYS;
+}
+
+/**
+ * This function will initial the simulated board.
+ */
+void rt_hw_board_init(void)
+{
+	/* os tick is generated by the posix cpu port */
+	device_delay_init();
+	
+	rt_hw_sim_serial_init();
+	rt_hw_sim_motor_init();
+}
@@ -0,0 +1,139 @@
+/*
+ * File      : sim_disk.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rtthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "diskio.h"
+
+#define SECTOR_SIZE		512
+
+#define MMC		0
+
+#ifndef SITL_SD_IMAGE
+#define SITL_SD_IMAGE	"sitl_sd.img"
+#endif
+
+/* the sd card is a FAT image file on host, create it with
+ * "mkfs.vfat -C sitl_sd.img 65536" before starting SITL */
+static int _img_fd = -1;
+
+DSTATUS disk_status (
+	BYTE pdrv
+)
+{
+	if(pdrv != MMC || _img_fd < 0)
+		return STA_NOINIT;
+	
+	return RES_OK;
+}
+
+DSTATUS disk_initialize (
+	BYTE pdrv
+)
+{
+	if(pdrv != MMC)
+		return STA_NOINIT;
+	
+	if(_img_fd < 0){
+		_img_fd = open(SITL_SD_IMAGE, O_RDWR);
+		if(_img_fd < 0){
+			rt_kprintf("open sd image %s fail\n", SITL_SD_IMAGE);
+			return STA_NOINIT;
+		}
+	}
+	
+	return RES_OK;
+}
+
+DRESULT disk_read (
+	BYTE pdrv,
+	BYTE *buff,
+	DWORD sector,
+	UINT count
+)
+{
+	size_t len = (size_t)count*SECTOR_SIZE;
+	
+	if(pdrv != MMC || _img_fd < 0)
+		return RES_PARERR;
+	
+	if(pread(_img_fd, buff, len, (off_t)sector*SECTOR_SIZE) != (ssize_t)len)
+		return RES_ERROR;
+	
+	return RES_OK;
+}
+
+DRESULT disk_write (
+	BYTE pdrv,
+	const BYTE *buff,
+	DWORD sector,
+	UINT count
+)
+{
+	size_t len = (size_t)count*SECTOR_SIZE;
+	
+	if(pdrv != MMC || _img_fd < 0)
+		return RES_PARERR;
+	
+	if(pwrite(_img_fd, buff, len, (off_t)sector*SECTOR_SIZE) != (ssize_t)len)
+		return RES_ERROR;
+	
+	return RES_OK;
+}
+
+DRESULT disk_ioctl (
+	BYTE pdrv,
+	BYTE cmd,
+	void *buff
+)
+{
+	struct stat st;
+	
+	if(pdrv != MMC || _img_fd < 0)
+		return RES_PARERR;
+	
+	switch(cmd)
+	{
+		case CTRL_SYNC:
+			return fsync(_img_fd) == 0 ? RES_OK : RES_ERROR;
+		case GET_SECTOR_COUNT:
+			if(fstat(_img_fd, &st) != 0)
+				return RES_ERROR;
+			*(DWORD*)buff = st.st_size / SECTOR_SIZE;
+			return RES_OK;
+		case GET_SECTOR_SIZE:
+			*(WORD*)buff = SECTOR_SIZE;
+			return RES_OK;
+		case GET_BLOCK_SIZE:
+			*(DWORD*)buff = 1;
+			return RES_OK;
+		case CTRL_ERASE_SECTOR:
+			return RES_OK;
+		default:
+			return RES_PARERR;
+	}
+}
+
+DWORD get_fattime (void)
+{
+	time_t t = time(NULL);
+	struct tm tm_now;
+	
+	localtime_r(&t, &tm_now);
+	
+	return	  ((DWORD)(tm_now.tm_year + 1900 - 1980) << 25)
+			| ((DWORD)(tm_now.tm_mon + 1) << 21)
+			| ((DWORD)tm_now.tm_mday << 16)
+			| ((DWORD)tm_now.tm_hour << 11)
+			| ((DWORD)tm_now.tm_min << 5)
+			| ((DWORD)tm_now.tm_sec >> 1);
+}
@@ -0,0 +1,72 @@
+/*
+ * File      : sim_motor.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include "pwm_io.h"
+#include "motor.h"
+#include "global.h"
+#include "sim.h"
+
+/* starryio_protocol updates it when io board reports, keep the symbol for SITL */
+float _remote_pwm_duty_cycle[MAX_PWM_MAIN_CHAN];
+
+static float _pwm_duty_cycle[MAX_PWM_MAIN_CHAN];
+static int _pwm_freq;
+static int _pwm_enable;
+static Motor_Chan_Info _sim_chan_info = {MOTOR_DEV_MAIN, MAX_PWM_MAIN_CHAN};
+
+static void _sim_pwm_configure(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+	if(cmd == PWM_CMD_SET_FREQ){
+		_pwm_freq = *((int*)args);
+	}else if(cmd == PWM_CMD_ENABLE){
+		_pwm_enable = *((int*)args);
+	}
+}
+
+static void _sim_pwm_write(struct rt_device *device, uint8_t chan_id, float* duty_cyc)
+{
+	for(uint8_t i = 0 ; i < MAX_PWM_MAIN_CHAN ; i++){
+		if(chan_id & (1<<i))
+			_pwm_duty_cycle[i] = duty_cyc[i];
+	}
+}
+
+static int _sim_pwm_read(struct rt_device *device, uint8_t chan_id, float* buffer)
+{
+	for(uint8_t i = 0 ; i < MAX_PWM_MAIN_CHAN ; i++){
+		if(chan_id & (1<<i))
+			buffer[i] = _pwm_duty_cycle[i];
+	}
+	
+	return 0;
+}
+
+const static struct rt_pwm_ops _sim_pwm_ops =
+{
+	_sim_pwm_configure,
+	_sim_pwm_write,
+	_sim_pwm_read,
+};
+
+void sim_get_motor_output(float* duty_cyc, uint8_t num)
+{
+	if(num > MAX_PWM_MAIN_CHAN)
+		num = MAX_PWM_MAIN_CHAN;
+	
+	OS_ENTER_CRITICAL;
+	memcpy(duty_cyc, _pwm_duty_cycle, num*sizeof(float));
+	OS_EXIT_CRITICAL;
+}
+
+void rt_hw_sim_motor_init(void)
+{
+	rt_device_motor_register("motor", &_sim_pwm_ops, &_sim_chan_info);
+}
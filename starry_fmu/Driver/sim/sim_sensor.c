@@ -0,0 +1,322 @@
+/*
+ * File      : sim_sensor.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rtthread.h>
+#include <string.h>
+#include <math.h>
+#include "global.h"
+#include "delay.h"
+#include "console.h"
+#include "ap_math.h"
+#include "sensor_manager.h"
+#include "ms5611.h"
+#include "gps.h"
+#include "uMCN.h"
+#include "log_replay.h"
+#include "sim.h"
+
+/* the simulated vehicle sits level on the ground unless sim_set_state()
+ * feeds a new state, sensors add white noise on top of it */
+#define SIM_GYR_NOISE			0.002f		/* rad/s */
+#define SIM_ACC_NOISE			0.05f		/* m/s^2 */
+#define SIM_MAG_NOISE			0.002f		/* gauss */
+#define SIM_BARO_NOISE			0.1f		/* m */
+
+#define SIM_GYR_LSB				(16.4f*57.2957795f)	/* LSB per rad/s */
+#define SIM_ACC_LSB				(2048.0f/9.80665f)	/* LSB per m/s^2 */
+#define SIM_MAG_LSB				1000.0f				/* LSB per gauss */
+
+#define SIM_BARO_CONV_TIME		10		/* ms */
+#define SIM_GPS_PERIOD			200		/* ms */
+
+#define SIM_DEVICE_ID			0x5A
+
+MCN_DEFINE(GPS_POSITION, sizeof(struct vehicle_gps_position_s));
+
+static char* TAG = "SIM";
+
+static SIM_StateDef _state = {
+	.gyr = {0.0f, 0.0f, 0.0f},
+	.acc = {0.0f, 0.0f, -9.80665f},
+	.mag = {0.21f, 0.0f, 0.43f},
+	.baro_alt = 10.0f,
+	.lat = 225433330,
+	.lon = 1139440000,
+	.vel_ned = {0.0f, 0.0f, 0.0f},
+};
+
+static struct rt_device _mpu_device;
+static struct rt_device _lsm_device;
+static struct rt_device _l3g_device;
+static struct rt_device _baro_device;
+static struct rt_device _gps_device;
+
+static uint32_t _rand_seed = 0x1234567;
+static uint32_t _baro_conv_time;
+static float _baro_pressure;
+
+static struct vehicle_gps_position_s* _gps_position;
+
+/* approximately gaussian noise in [-3,3]*amp from sum of uniforms */
+static float _noise(float amp)
+{
+	float sum = 0.0f;
+	
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		_rand_seed = _rand_seed * 1664525u + 1013904223u;
+		sum += (float)(_rand_seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+	}
+	
+	return sum * amp;
+}
+
+void sim_set_state(const SIM_StateDef* state)
+{
+	OS_ENTER_CRITICAL;
+	_state = *state;
+	OS_EXIT_CRITICAL;
+}
+
+void sim_get_state(SIM_StateDef* state)
+{
+	OS_ENTER_CRITICAL;
+	*state = _state;
+	OS_EXIT_CRITICAL;
+}
+
+static void _sim_vector(const float src[3], float noise, float dst[3])
+{
+	OS_ENTER_CRITICAL;
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		dst[i] = src[i];
+	}
+	OS_EXIT_CRITICAL;
+	
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		dst[i] += _noise(noise);
+	}
+}
+
+static void _sim_vector_raw(const float src[3], float noise, float lsb, int16_t dst[3])
+{
+	float val[3];
+	
+	_sim_vector(src, noise, val);
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		dst[i] = (int16_t)constrain_float(val[i]*lsb, -32768.0f, 32767.0f);
+	}
+}
+
+static rt_err_t _sim_sensor_control(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+	if(cmd == SENSOR_GET_DEVICE_ID){
+		*(uint8_t*)args = SIM_DEVICE_ID;
+		return RT_EOK;
+	}
+	
+	return RT_ERROR;
+}
+
+static rt_size_t _sim_imu_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+	switch(pos)
+	{
+		case GYR_RAW_POS:
+			_sim_vector_raw(_state.gyr, SIM_GYR_NOISE, SIM_GYR_LSB, (int16_t*)buffer);
+			break;
+		case GYR_SCALE_POS:
+			_sim_vector(_state.gyr, SIM_GYR_NOISE, (float*)buffer);
+			break;
+		case ACC_RAW_POS:
+			_sim_vector_raw(_state.acc, SIM_ACC_NOISE, SIM_ACC_LSB, (int16_t*)buffer);
+			break;
+		case ACC_SCALE_POS:
+			_sim_vector(_state.acc, SIM_ACC_NOISE, (float*)buffer);
+			break;
+		case MAG_RAW_POS:
+			_sim_vector_raw(_state.mag, SIM_MAG_NOISE, SIM_MAG_LSB, (int16_t*)buffer);
+			break;
+		case MAG_SCLAE_POS:
+			_sim_vector(_state.mag, SIM_MAG_NOISE, (float*)buffer);
+			break;
+		default:
+			/* unknow pos */
+			return 0;
+	}
+	
+	return size;
+}
+
+/* inverse of the standard atmosphere used by ms5611 driver, in mbar */
+static float _sim_alt_to_pressure(float alt)
+{
+	const double T1 = 15.0 + 273.15;
+	const double a  = -6.5 / 1000;
+	const double g  = 9.80665;
+	const double R  = 287.05;
+	
+	return (float)(1013.25 * pow((a*alt + T1) / T1, -g / (a*R)));
+}
+
+static rt_size_t _sim_baro_read(rt_device_t dev, rt_off_t pos, void *buffer, rt_size_t size)
+{
+	MS5611_REPORT_Def* report;
+	float alt;
+	
+	if(pos == RAW_TEMPERATURE_POS || pos == RAW_PRESSURE_POS){
+		return size;
+	}else if(pos == COLLECT_DATA_POS){
+		OS_ENTER_CRITICAL;
+		alt = _state.baro_alt;
+		OS_EXIT_CRITICAL;
+		alt += _noise(SIM_BARO_NOISE);
+		_baro_pressure = _sim_alt_to_pressure(alt);
+		
+		report = (MS5611_REPORT_Def*)buffer;
+		report->raw_temperature = 0;
+		report->raw_pressure = 0;
+		report->temperature = 25.0f;
+		report->pressure = _baro_pressure;
+		report->altitude = alt;
+		report->time_stamp = time_nowMs();
+		
+		return size;
+	}
+	
+	return 0;
+}
+
+static rt_err_t _sim_baro_control(rt_device_t dev, rt_uint8_t cmd, void *args)
+{
+	switch(cmd)
+	{
+		case SENSOR_CONVERSION:
+		{
+			if(*(u8*)args != 0x48 && *(u8*)args != 0x58)
+				return RT_ERROR;
+			_baro_conv_time = time_nowMs();
+		}break;
+		case SENSOR_IS_CONV_FIN:
+		{
+			return time_nowMs() - _baro_conv_time >= SIM_BARO_CONV_TIME ? RT_EOK : RT_EBUSY;
+		}
+		default:
+			return RT_ERROR;
+	}
+	
+	return RT_EOK;
+}
+
+static void _sim_gps_entry(void *parameter)
+{
+	SIM_StateDef state;
+	uint64_t now;
+	
+	while(1)
+	{
+		sim_get_state(&state);
+		now = time_nowUs();
+		
+		_gps_position->timestamp_position = now;
+		_gps_position->lat = state.lat;
+		_gps_position->lon = state.lon;
+		_gps_position->alt = (int32_t)(state.baro_alt*1e3f);
+		_gps_position->timestamp_variance = now;
+		_gps_position->s_variance_m_s = 0.3f;
+		_gps_position->c_variance_rad = 0.1f;
+		_gps_position->fix_type = 3;
+		_gps_position->eph = 1.0f;
+		_gps_position->epv = 1.5f;
+		_gps_position->timestamp_velocity = now;
+		_gps_position->vel_n_m_s = state.vel_ned[0];
+		_gps_position->vel_e_m_s = state.vel_ned[1];
+		_gps_position->vel_d_m_s = state.vel_ned[2];
+		_gps_position->vel_m_s = sqrtf(state.vel_ned[0]*state.vel_ned[0] + state.vel_ned[1]*state.vel_ned[1]);
+		_gps_position->cog_rad = atan2f(state.vel_ned[1], state.vel_ned[0]);
+		_gps_position->vel_ned_valid = RT_TRUE;
+		_gps_position->timestamp_time = now;
+		_gps_position->time_gps_usec = now;
+		_gps_position->satellites_used = 12;
+		_gps_position->hdop = _gps_position->vdop = 0.8f;
+		
+		/* gps topic comes from the log in replay mode */
+		if(!log_replay_enabled())
+			mcn_publish(MCN_ID(GPS_POSITION), _gps_position);
+		
+		rt_thread_delay(SIM_GPS_PERIOD);
+	}
+}
+
+static rt_err_t _sim_gps_open(rt_device_t dev, rt_uint16_t oflag)
+{
+	rt_thread_t tid;
+	
+	if(dev->open_flag & RT_DEVICE_OFLAG_OPEN)
+		return RT_EOK;
+	
+	tid = rt_thread_create("sim_gps", _sim_gps_entry, RT_NULL, 1024, 15, 5);
+	if(tid == RT_NULL)
+		return RT_ENOMEM;
+	
+	return rt_thread_startup(tid);
+}
+
+static rt_err_t _sim_device_register(struct rt_device* dev, const char* name,
+					rt_size_t (*read)(rt_device_t, rt_off_t, void*, rt_size_t),
+					rt_err_t (*control)(rt_device_t, rt_uint8_t, void*))
+{
+	dev->type    = RT_Device_Class_Miscellaneous;
+	dev->init    = RT_NULL;
+	dev->open    = RT_NULL;
+	dev->close   = RT_NULL;
+	dev->read    = read;
+	dev->write   = RT_NULL;
+	dev->control = control;
+	
+	return rt_device_register(dev, name, RT_DEVICE_FLAG_RDWR);
+}
+
+rt_err_t rt_mpu6000_init(char* spi_device_name)
+{
+	return _sim_device_register(&_mpu_device, "mpu6000", _sim_imu_read, _sim_sensor_control);
+}
+
+rt_err_t rt_lsm303d_init(char* spi_device_name)
+{
+	return _sim_device_register(&_lsm_device, "lsm303d", _sim_imu_read, _sim_sensor_control);
+}
+
+rt_err_t rt_l3gd20h_init(char* spi_device_name)
+{
+	return _sim_device_register(&_l3g_device, "l3gd20h", _sim_imu_read, _sim_sensor_control);
+}
+
+rt_err_t rt_ms5611_init(char* spi_device_name)
+{
+	return _sim_device_register(&_baro_device, "ms5611", _sim_baro_read, _sim_baro_control);
+}
+
+rt_err_t rt_gps_init(char* serial_device_name , struct vehicle_gps_position_s *gps_position, struct satellite_info_s *satellite_info)
+{
+	rt_err_t res;
+	int mcn_res;
+	
+	_gps_position = gps_position;
+	memset(_gps_position, 0, sizeof(struct vehicle_gps_position_s));
+	
+	res = _sim_device_register(&_gps_device, "gps", RT_NULL, RT_NULL);
+	_gps_device.open = _sim_gps_open;
+	
+	mcn_res = mcn_advertise(MCN_ID(GPS_POSITION));
+	if(mcn_res != 0){
+		Console.e(TAG, "err:%d, gps position advertise fail!\n", mcn_res);
+	}
+	
+	return res;
+}
@@ -0,0 +1,153 @@
+/*
+ * File      : sim_serial.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rtthread.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include "board.h"
+#include "sim.h"
+
+#define SIM_SERIAL_POLL_PERIOD		10		/* ms */
+#define SIM_SERIAL_RX_SIZE			256
+
+struct sim_serial
+{
+	struct rt_device parent;
+	int fd_in;		/* -1 for null device */
+	int fd_out;
+};
+
+/* console goes to host stdin/stdout, other uarts behave as unconnected port */
+static struct sim_serial _console = {.fd_in = STDIN_FILENO, .fd_out = STDOUT_FILENO};
+static struct sim_serial _null_uart[4] = {
+	{.fd_in = -1, .fd_out = -1}, {.fd_in = -1, .fd_out = -1},
+	{.fd_in = -1, .fd_out = -1}, {.fd_in = -1, .fd_out = -1},
+};
+static const char* _null_uart_name[4] = {"uart1", "uart2", "uart4", "uart6"};
+
+static char _rx_buffer[SIM_SERIAL_RX_SIZE];
+static rt_uint32_t _rx_head, _rx_tail;
+
+static void _serial_poll_entry(void* parameter)
+{
+	struct sim_serial* serial = (struct sim_serial*)parameter;
+	char ch;
+	rt_size_t cnt;
+	
+	while(1)
+	{
+		cnt = 0;
+		while(read(serial->fd_in, &ch, 1) == 1){
+			if((_rx_head+1) % SIM_SERIAL_RX_SIZE == _rx_tail)
+				break;
+			_rx_buffer[_rx_head] = ch;
+			_rx_head = (_rx_head+1) % SIM_SERIAL_RX_SIZE;
+			cnt++;
+		}
+		
+		if(cnt && serial->parent.rx_indicate != RT_NULL){
+			serial->parent.rx_indicate(&serial->parent, cnt);
+		}
+		
+		rt_thread_delay(SIM_SERIAL_POLL_PERIOD);
+	}
+}
+
+static rt_err_t _serial_init(rt_device_t dev)
+{
+	struct sim_serial* serial = (struct sim_serial*)dev;
+	
+	if(serial->fd_in >= 0){
+		/* never block the simulator on a host read */
+		fcntl(serial->fd_in, F_SETFL, fcntl(serial->fd_in, F_GETFL) | O_NONBLOCK);
+	}
+	
+	return RT_EOK;
+}
+
+static rt_err_t _serial_open(rt_device_t dev, rt_uint16_t oflag)
+{
+	struct sim_serial* serial = (struct sim_serial*)dev;
+	rt_thread_t tid;
+	
+	if(serial->fd_in >= 0 && !(dev->open_flag & RT_DEVICE_OFLAG_OPEN)){
+		tid = rt_thread_create("sim_rx", _serial_poll_entry, serial, 1024, RT_THREAD_PRIORITY_MAX-3, 5);
+		if(tid == RT_NULL)
+			return RT_ENOMEM;
+		rt_thread_startup(tid);
+	}
+	
+	return RT_EOK;
+}
+
+static rt_size_t _serial_read(rt_device_t dev, rt_off_t pos, void* buffer, rt_size_t size)
+{
+	struct sim_serial* serial = (struct sim_serial*)dev;
+	char* ptr = (char*)buffer;
+	rt_size_t cnt = 0;
+	
+	if(serial->fd_in < 0)
+		return 0;
+	
+	while(cnt < size && _rx_tail != _rx_head){
+		ptr[cnt++] = _rx_buffer[_rx_tail];
+		_rx_tail = (_rx_tail+1) % SIM_SERIAL_RX_SIZE;
+	}
+	
+	return cnt;
+}
+
+static rt_size_t _serial_write(rt_device_t dev, rt_off_t pos, const void* buffer, rt_size_t size)
+{
+	struct sim_serial* serial = (struct sim_serial*)dev;
+	ssize_t n;
+	
+	if(serial->fd_out < 0){
+		/* nothing connected, data is simply dropped */
+		return size;
+	}
+	
+	n = write(serial->fd_out, buffer, size);
+	
+	return n > 0 ? n : 0;
+}
+
+static rt_err_t _serial_control(rt_device_t dev, rt_uint8_t cmd, void* args)
+{
+	return RT_EOK;
+}
+
+static void _serial_register(struct sim_serial* serial, const char* name)
+{
+	struct rt_device* device = &serial->parent;
+	
+	device->type 		= RT_Device_Class_Char;
+	device->rx_indicate = RT_NULL;
+	device->tx_complete = RT_NULL;
+	device->init 		= _serial_init;
+	device->open		= _serial_open;
+	device->close		= RT_NULL;
+	device->read 		= _serial_read;
+	device->write 		= _serial_write;
+	device->control 	= _serial_control;
+	device->user_data	= RT_NULL;
+	
+	rt_device_register(device, name, RT_DEVICE_FLAG_RDWR | RT_DEVICE_FLAG_INT_RX | RT_DEVICE_FLAG_STREAM);
+}
+
+void rt_hw_sim_serial_init(void)
+{
+	int i;
+	
+	_serial_register(&_console, CONSOLE_DEVICE);
+	for(i = 0 ; i < 4 ; i++){
+		_serial_register(&_null_uart[i], _null_uart_name[i]);
+	}
+}
@@ -0,0 +1,86 @@
+/*
+ * File      : sim_startup.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rthw.h>
+#include <rtthread.h>
+#include <stdio.h>
+#include <string.h>
+#include "board.h"
+#include "log_replay.h"
+
+#define SITL_HEAP_SIZE		(2*1024*1024)
+
+extern int rt_application_init(void);
+#ifdef RT_USING_FINSH
+extern void finsh_system_init(void);
+extern void finsh_set_device(const char* device);
+#endif
+
+static rt_uint8_t _heap[SITL_HEAP_SIZE];
+
+void rtthread_startup(void)
+{
+	/* init board */
+	rt_hw_board_init();
+	/* init tick */
+	rt_system_tick_init();
+	/* init kernel object */
+	rt_system_object_init();
+	/* init timer system */
+	rt_system_timer_init();
+	/* heap comes from host memory */
+	rt_system_heap_init((void*)_heap, (void*)&_heap[SITL_HEAP_SIZE]);
+	/* init scheduler system */
+	rt_system_scheduler_init();
+	/* init application */
+	rt_application_init();
+#ifdef RT_USING_FINSH
+	/* init finsh */
+	finsh_system_init();
+	finsh_set_device(FINSH_DEVICE_NAME);
+#endif
+	/* init timer thread */
+	rt_system_timer_thread_init();
+	/* init idle thread */
+	rt_thread_idle_init();
+	/* start scheduler, the posix port never returns from here */
+	rt_system_scheduler_start();
+}
+
+static void _usage(const char* name)
+{
+	printf("usage: %s [-r replay_log [-o output_log]]\n", name);
+}
+
+int main(int argc, char** argv)
+{
+	const char* replay_in = NULL;
+	const char* replay_out = "REPLAY.LOG";
+	
+	for(int i = 1 ; i < argc ; i++){
+		if(strcmp(argv[i], "-r") == 0 && i+1 < argc){
+			replay_in = argv[++i];
+		}else if(strcmp(argv[i], "-o") == 0 && i+1 < argc){
+			replay_out = argv[++i];
+		}else{
+			_usage(argv[0]);
+			return 1;
+		}
+	}
+	if(replay_in != NULL){
+		log_replay_set_file(replay_in, replay_out);
+	}
+	
+	/* disable interrupt first */
+	rt_hw_interrupt_disable();
+	/* startup RT-Thread RTOS */
+	rtthread_startup();
+	
+	return 0;
+}
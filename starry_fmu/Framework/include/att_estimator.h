@@ -21,6 +21,7 @@ void attitude_inputGyr(const float gyr[3]);
 void attitude_inputMag(const float mag[3]);
 void attitude_loop(void *parameter);
 void attitude_est_run(float dT);
+void attitude_est_reset(void);
 void att_gyr_acc_fusion(float dT);
 void att_mag_fusion(float dT);
 	
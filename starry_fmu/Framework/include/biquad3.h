@@ -0,0 +1,36 @@
+/*
+ * File      : biquad3.h
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#ifndef __BIQUAD3_H__
+#define __BIQUAD3_H__
+
+#include <stdint.h>
+
+#define BIQUAD3_MAX_STAGE		2
+
+/* cascaded butterworth low pass for x/y/z axis. Delay elements are kept as
+ * structure of arrays, so all three axis are filtered in the same loop */
+typedef struct{
+	uint8_t	stage_num;			/* 0 means no filtering */
+	float	sample_freq;
+	float	cutoff_freq;
+	float	b0[BIQUAD3_MAX_STAGE];
+	float	b1[BIQUAD3_MAX_STAGE];
+	float	b2[BIQUAD3_MAX_STAGE];
+	float	a1[BIQUAD3_MAX_STAGE];
+	float	a2[BIQUAD3_MAX_STAGE];
+	float	w1[BIQUAD3_MAX_STAGE][3];	/* buffered sample -1 */
+	float	w2[BIQUAD3_MAX_STAGE][3];	/* buffered sample -2 */
+}Biquad3;
+
+void biquad3_init(Biquad3* bq, float sample_freq, float cutoff_freq, uint8_t stage_num);
+void biquad3_set_cutoff_frequency(Biquad3* bq, float sample_freq, float cutoff_freq);
+void biquad3_reset(Biquad3* bq, const float sample[3], float out[3]);
+void biquad3_filter_process(Biquad3* bq, const float in[3], float out[3]);
+
+#endif
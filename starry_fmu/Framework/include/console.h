@@ -33,6 +33,7 @@ typedef struct
 extern CONSOLE_Typedef Console;
 
 int console_redirect_device(const char *name);
+void console_set_error_hook(void (*hook)(char* tag));
 
 uint8_t console_init(CONSOLE_INTERFACE_Typedef console_if);
 
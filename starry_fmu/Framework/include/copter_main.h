@@ -15,11 +15,18 @@
 //#define AHRS_PERIOD			2
 //#define CONTROL_PERIOD		2
 //#define POS_EST_PERIOD		10
+
 #define AHRS_PERIOD			2
 #define EKF_PERIOD			4
 #define CONTROL_PERIOD		4
 #define POS_EST_PERIOD		10
 
+/* execution time budget of each rate group, us */
+#define AHRS_BUDGET_US		500
+#define EKF_BUDGET_US		2000
+#define CONTROL_BUDGET_US	500
+#define POS_EST_BUDGET_US	1000
+
 typedef enum
 {
 	AHRS_Period = 0,
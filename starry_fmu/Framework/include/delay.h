@@ -25,6 +25,11 @@ uint64_t time_nowUs(void);
 uint32_t time_nowMs(void);
 void time_waitUs(uint32_t delay);
 void time_waitMs(uint32_t delay);
+#ifdef SITL_SIMULATION
+void time_set_virtual(uint64_t time_us);
+void time_clear_virtual(void);
+uint64_t time_wallUs(void);
+#endif
 
 extern DELAY_TIME_Def _delay_t;
 
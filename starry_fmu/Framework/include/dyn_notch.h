@@ -0,0 +1,57 @@
+/*
+ * File      : dyn_notch.h
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#ifndef __DYN_NOTCH_H__
+#define __DYN_NOTCH_H__
+
+#include <stdint.h>
+
+/* power of 2, frequency resolution is sample_freq/DYN_NOTCH_FFT_SIZE */
+#define DYN_NOTCH_FFT_SIZE		128
+/* notch filters per axis, each tracks one spectrum peak */
+#define DYN_NOTCH_PEAK_NUM		2
+/* a notch goes back to bypass after its peak is not found in this many analyses of its axis */
+#define DYN_NOTCH_RELEASE_CNT	3
+
+/* notch filters for x/y/z axis whose center frequencies follow the vibration
+ * peaks found by a windowed FFT over the latest input samples */
+typedef struct{
+	float		sample_freq;
+	float		min_freq;
+	float		max_freq;
+	float		q;
+	uint16_t	update_div;			/* run analysis every update_div samples, one axis each time */
+	uint16_t	sample_cnt;
+	uint16_t	buff_idx;
+	uint8_t		axis;				/* next axis to analyse */
+	uint8_t		enable;
+	/* tracked peaks, 0 means no peak and notch is bypassed */
+	float		center_freq[3][DYN_NOTCH_PEAK_NUM];
+	/* analyses in a row without a peak for the notch, it is released at DYN_NOTCH_RELEASE_CNT */
+	uint8_t		miss_cnt[3][DYN_NOTCH_PEAK_NUM];
+	/* DF1 notch filters, direct form 1 keeps stable output while coefficients change.
+	 * For a notch b2 = b0 and a1 = b1, so only three coefficients are kept */
+	float		b0[3][DYN_NOTCH_PEAK_NUM];
+	float		b1[3][DYN_NOTCH_PEAK_NUM];
+	float		a2[3][DYN_NOTCH_PEAK_NUM];
+	float		x1[3][DYN_NOTCH_PEAK_NUM];
+	float		x2[3][DYN_NOTCH_PEAK_NUM];
+	float		y1[3][DYN_NOTCH_PEAK_NUM];
+	float		y2[3][DYN_NOTCH_PEAK_NUM];
+	/* analysis */
+	float		buff[3][DYN_NOTCH_FFT_SIZE];
+	uint32_t	fft_cnt;
+}DynNotch;
+
+void dyn_notch_init(DynNotch* dn, float sample_freq, float min_freq, float max_freq, float q, float analyse_freq);
+void dyn_notch_enable(DynNotch* dn, uint8_t enable);
+void dyn_notch_filter_process(DynNotch* dn, const float in[3], float out[3]);
+void dyn_notch_analyse(DynNotch* dn, uint8_t axis);
+void dyn_notch_set_center_frequency(DynNotch* dn, uint8_t axis, uint8_t n, float center_freq);
+
+#endif
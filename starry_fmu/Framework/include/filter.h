@@ -13,6 +13,8 @@
 #include <rtthread.h>
 #include "butter.h"
 #include "fir.h"
+#include "biquad3.h"
+#include "dyn_notch.h"
 //#include <rtdevice.h>
 
 rt_err_t filter_init(void);
@@ -26,5 +28,10 @@ const float * magfilter_current(void);
 void accfilter_read(float* mag);
 void gyrfilter_read(float* mag);
 void magfilter_read(float* mag);
+void accfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq);
+void gyrfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq);
+void magfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq);
+void gyrfilter_dyn_notch_enable(uint8_t enable);
+float gyrfilter_dyn_notch_frequency(uint8_t axis, uint8_t n);
 	
 #endif
@@ -27,6 +27,8 @@
 #define MAVLINK_THREAD_PRIORITY			12
 #define LED_THREAD_PRIORITY				13
 #define CALI_THREAD_PRIORITY			13
+#define LOG_WRITER_THREAD_PRIORITY		14
+#define PARAM_THREAD_PRIORITY			14
 
 #define Rad2Deg(x)			((x)*57.2957795f)
 #define Deg2Rad(x)			((x)*0.0174533f)
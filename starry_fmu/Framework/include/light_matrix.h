@@ -42,6 +42,14 @@ Mat* MatTrans(Mat* src, Mat* dst);
 LIGHT_MATRIX_TYPE MatDet(Mat* mat);
 Mat* MatAdj(Mat* src, Mat* dst);
 Mat* MatInv(Mat* src, Mat* dst);
+Mat* MatSolve(Mat* src1, Mat* src2, Mat* dst);
+
+int MatLU(Mat* mat, int* pivot, int* sign);
+Mat* MatLUSolve(Mat* lu, int* pivot, Mat* src, Mat* dst);
+int MatCholesky(Mat* mat);
+Mat* MatCholeskySolve(Mat* L, Mat* src, Mat* dst);
+Mat* MatForwardSub(Mat* L, Mat* src, Mat* dst, int unit_diag);
+Mat* MatBackSub(Mat* U, Mat* src, Mat* dst);
 
 void MatEig(Mat *mat, LIGHT_MATRIX_TYPE *eig_val, Mat *eig_vec, LIGHT_MATRIX_TYPE eps, int njt);
 	
@@ -0,0 +1,34 @@
+/*
+ * File      : log_compress.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __LOG_COMPRESS_H__
+#define __LOG_COMPRESS_H__
+
+#include <stdint.h>
+#include <rtthread.h>
+
+/* compress method of log block */
+enum
+{
+	LOG_COMPRESS_NONE = 0,
+	LOG_COMPRESS_LZO,			// lzo1x-1, fast
+	LOG_COMPRESS_DEFLATE,		// raw deflate, dense
+	LOG_COMPRESS_NUM,
+};
+
+/* worst case output size of lzo1x, deflate never writes more than input size */
+#define LOG_COMPRESS_BOUND(_size)	((_size) + (_size)/16 + 64 + 3)
+
+uint8_t log_compress_open(uint8_t method);
+void log_compress_close(void);
+uint32_t log_compress_block(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size);
+const char* log_compress_name(uint8_t method);
+uint8_t log_compress_method(const char* name);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * File      : log_delta.h
+ *
+ * Delta coding of log records. It depends on nothing but libc, so host tools
+ * can decode with the same code.
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __LOG_DELTA_H__
+#define __LOG_DELTA_H__
+
+#include <stdint.h>
+
+/* a plain record is written after this number of delta records of a message */
+#define LOG_DELTA_KEY_INTERVAL		64
+/* worst case body size of a record with _word_num 32-bit words */
+#define LOG_DELTA_BOUND(_word_num)	(5u + 5u*(_word_num))
+
+/* coding state of one message, prev points to word_num words owned by caller */
+typedef struct
+{
+	uint32_t*	prev;
+	uint16_t	word_num;
+	uint16_t	delta_cnt;			/* delta records since last key record */
+	uint32_t	prev_time;
+	uint8_t		valid;				/* prev holds the last record */
+}log_delta_t;
+
+void log_delta_init(log_delta_t* d, uint32_t* prev, uint16_t word_num);
+void log_delta_reset(log_delta_t* d);
+uint32_t log_delta_encode(log_delta_t* d, uint32_t timestamp, const void* payload, uint8_t* out, uint32_t out_size);
+void log_delta_key(log_delta_t* d, uint32_t timestamp, const void* payload);
+uint32_t log_delta_decode(log_delta_t* d, const uint8_t* in, uint32_t in_size, uint32_t* timestamp, void* payload);
+
+#endif
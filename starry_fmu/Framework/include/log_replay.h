@@ -0,0 +1,40 @@
+/*
+ * File      : log_replay.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#ifndef __LOG_REPLAY_H__
+#define __LOG_REPLAY_H__
+
+#include <rtthread.h>
+#include "global.h"
+
+/* legacy (version 1) log header, records are fixed size float rows
+ * sampled every log_period ms */
+typedef struct
+{
+	uint32_t start_time;		// ms
+	uint32_t log_period;		// ms
+	uint32_t element_num;
+	uint32_t header_size;
+	uint32_t field_size;
+}LOG_LegacyHeaderDef;
+
+typedef struct
+{
+	uint32_t record_cnt;
+	uint32_t skip_cnt;
+	uint32_t est_cnt;
+	uint64_t log_time_us;		// time span covered by the log
+	uint64_t wall_time_us;		// host time spent on replay
+}LOG_ReplayStatusDef;
+
+void log_replay_set_file(const char* in_file, const char* out_file);
+bool log_replay_enabled(void);
+uint8_t log_replay_run(void);
+
+#endif
@@ -0,0 +1,37 @@
+/*
+ * File      : log_ring.h
+ *
+ * Ring of whole log records which always keeps the newest ones. It depends
+ * on nothing but libc, so it also builds on host.
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __LOG_RING_H__
+#define __LOG_RING_H__
+
+#include <stdint.h>
+
+/* each record is stored with a 2 bytes length */
+#define LOG_RING_OVERHEAD		2
+
+typedef struct
+{
+	uint8_t*	buff;
+	uint32_t	size;
+	uint32_t	head;				/* write position */
+	uint32_t	tail;				/* oldest record */
+	uint32_t	used;
+	uint32_t	record_num;
+	uint32_t	evict_cnt;			/* oldest records overwritten by new ones */
+}log_ring_t;
+
+void log_ring_init(log_ring_t* ring, uint8_t* buff, uint32_t size);
+void log_ring_clear(log_ring_t* ring);
+uint8_t log_ring_push(log_ring_t* ring, const void* data, uint32_t len);
+uint32_t log_ring_peek(const log_ring_t* ring, void* data, uint32_t size);
+void log_ring_drop(log_ring_t* ring);
+
+#endif
@@ -0,0 +1,59 @@
+/*
+ * File      : log_writer.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#ifndef __LOG_WRITER_H__
+#define __LOG_WRITER_H__
+
+#include <stdint.h>
+#include <rtthread.h>
+#include "ff.h"
+
+#define LOG_BUFFER_NUM			2
+#define LOG_BUFFER_SIZE			8192	// must be multiple of sector size (512 byte)
+#define LOG_SYNC_INTERVAL		16384	// raw bytes between sync markers
+#define LOG_SYNC_PERIOD			1000	// ms between f_sync of log file
+#define LOG_INDEX_MAX_NUM		256		// index footer must fit in one buffer
+#define WRITER_STOP_TIMEOUT		1000	// ticks a log stop waits for the writer
+
+typedef struct
+{
+	uint32_t write_cnt;			// f_write call count
+	uint32_t write_bytes;
+	uint32_t write_err;
+	uint32_t drop_cnt;			// records dropped because buffers are full
+	uint32_t drop_bytes;
+	uint32_t high_water;		// maximal pending bytes in buffers
+	uint32_t latency_last;		// f_write latency, us
+	uint32_t latency_max;
+	uint64_t latency_sum;
+	uint8_t compress;			// compress method
+	uint32_t block_cnt;			// compressed blocks
+	uint32_t raw_bytes;			// bytes before compression
+	uint32_t compress_last;		// compress time of one block, us
+	uint32_t compress_max;
+	uint64_t compress_sum;
+	uint32_t mark_cnt;			// sync markers
+	uint32_t index_num;			// index entries
+	uint32_t index_stride;		// markers between index entries
+	uint32_t fsync_cnt;			// f_sync call count
+	uint32_t fsync_err;
+	uint32_t fsync_max;			// f_sync latency, us
+}LOG_WriterStatusDef;
+
+rt_err_t log_writer_init(void);
+uint8_t log_writer_start(FIL* fp, uint8_t compress);
+uint8_t log_writer_stop(void);
+uint8_t log_writer_push(const void* data, uint32_t size);
+uint32_t log_writer_free(void);
+uint8_t log_writer_mark(uint32_t timestamp);
+LOG_WriterStatusDef log_writer_get_status(void);
+void log_writer_show_status(void);
+void log_writer_entry(void *parameter);
+
+#endif
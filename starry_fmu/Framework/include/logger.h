@@ -15,6 +15,18 @@
 
 #define LOG_MAX_NAME_LENGTH		20
 #define LOG_MAX_ELEMENT_NUM		100
+#define LOG_MAX_MSG_NUM			32
+#define LOG_MAX_PAYLOAD_SIZE	256
+
+#define LOG_MAGIC				0x474C5053	/* "SPLG" */
+#define LOG_VERSION				2
+#define LOG_RECORD_SYNC			0xA5
+#define LOG_RECORD_SYNC_DELTA	0xA6
+#define LOG_RECORD_SYNC_MARK	0xA7
+#define LOG_RECORD_SYNC_INDEX	0xA8
+#define LOG_BLOCK_MAGIC			0x5A4C5053	/* "SPLZ" */
+#define LOG_SYNC_MAGIC			0x59535053	/* "SPSY" */
+#define LOG_INDEX_MAGIC			0x58495053	/* "SPIX" */
 	
 #define LOG_ELEMENT_INFO_FLOAT(_name) \
 			{ \
@@ -28,8 +40,20 @@
 			}
 
 #define LOG_ELEMENT_FLOAT(_name)						float _name##_elem
-#define LOG_SET_ELEMENT(_logger_info, _name, _val)		_logger_info.log_field._name##_elem = _val
-#define LOG_GET_ELEMENT(_logger_info, _name)			(_logger_info.log_field._name##_elem)
+#define LOG_SET_ELEMENT(_msg, _name, _val)				(_msg)._name##_elem = _val
+#define LOG_GET_ELEMENT(_msg, _name)					((_msg)._name##_elem)
+
+#define LOG_MSG_INFO(_id, _name, _type, _element_list, _period) \
+			{ \
+				.msg_id = _id, \
+				.name = #_name, \
+				.period = _period, \
+				.element_info = _element_list, \
+				.element_num = sizeof(_element_list)/sizeof(LOG_ElementInfoDef), \
+				.payload_size = sizeof(_type), \
+				.last_record_time = 0, \
+				.record_cnt = 0 \
+			}
 
 enum
 {
@@ -37,6 +61,79 @@ enum
 	LOGGER_BUSY
 };
 
+/* events which start a log from pre-trigger ring */
+enum
+{
+	LOG_TRIGGER_ARM = 1<<0,
+	LOG_TRIGGER_EST_RESET = 1<<1,
+	LOG_TRIGGER_ERROR = 1<<2,			// Console.e of other modules
+	LOG_TRIGGER_SHELL = 1<<3,
+	LOG_TRIGGER_ALL = 0x0F,
+};
+
+enum
+{
+	LOG_INT8 = 0,
+	LOG_UINT8,
+	LOG_INT16,
+	LOG_UINT16,
+	LOG_INT32,
+	LOG_UINT32,
+	LOG_FLOAT,
+	LOG_DOUBLE,
+};
+
+/* log message id */
+enum
+{
+	LOG_MSG_GYR = 1,
+	LOG_MSG_ACC,
+	LOG_MSG_MAG,
+	LOG_MSG_FILTER,
+	LOG_MSG_ATT,
+	LOG_MSG_POS,
+	LOG_MSG_MOTOR,
+	LOG_MSG_ADRC,
+	LOG_MSG_GPS,
+	LOG_MSG_BARO,
+	LOG_MSG_LOAD,
+};
+
+/* log message payload */
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(GYR_X);
+	LOG_ELEMENT_FLOAT(GYR_Y);
+	LOG_ELEMENT_FLOAT(GYR_Z);
+}LOG_GyrDef;
+
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(ACC_X);
+	LOG_ELEMENT_FLOAT(ACC_Y);
+	LOG_ELEMENT_FLOAT(ACC_Z);
+}LOG_AccDef;
+
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(MAG_X);
+	LOG_ELEMENT_FLOAT(MAG_Y);
+	LOG_ELEMENT_FLOAT(MAG_Z);
+	LOG_ELEMENT_FLOAT(MAG_FILTER_X);
+	LOG_ELEMENT_FLOAT(MAG_FILTER_Y);
+	LOG_ELEMENT_FLOAT(MAG_FILTER_Z);
+}LOG_MagDef;
+
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(GYR_FILTER_X);
+	LOG_ELEMENT_FLOAT(GYR_FILTER_Y);
+	LOG_ELEMENT_FLOAT(GYR_FILTER_Z);
+	LOG_ELEMENT_FLOAT(ACC_FILTER_X);
+	LOG_ELEMENT_FLOAT(ACC_FILTER_Y);
+	LOG_ELEMENT_FLOAT(ACC_FILTER_Z);
+}LOG_FilterDef;
+
 typedef struct
 {
 	LOG_ELEMENT_FLOAT(QUATERNION_W);
@@ -46,40 +143,38 @@ typedef struct
 	LOG_ELEMENT_FLOAT(ROLL);
 	LOG_ELEMENT_FLOAT(PITCH);
 	LOG_ELEMENT_FLOAT(YAW);
+}LOG_AttDef;
+
+typedef struct
+{
 	LOG_ELEMENT_FLOAT(X);
 	LOG_ELEMENT_FLOAT(Y);
 	LOG_ELEMENT_FLOAT(Z);
 	LOG_ELEMENT_FLOAT(VX);
 	LOG_ELEMENT_FLOAT(VY);
 	LOG_ELEMENT_FLOAT(VZ);
-	LOG_ELEMENT_FLOAT(GYR_X);
-	LOG_ELEMENT_FLOAT(GYR_Y);
-	LOG_ELEMENT_FLOAT(GYR_Z);
-	LOG_ELEMENT_FLOAT(GYR_FILTER_X);
-	LOG_ELEMENT_FLOAT(GYR_FILTER_Y);
-	LOG_ELEMENT_FLOAT(GYR_FILTER_Z);
-	LOG_ELEMENT_FLOAT(ACC_X);
-	LOG_ELEMENT_FLOAT(ACC_Y);
-	LOG_ELEMENT_FLOAT(ACC_Z);
-	LOG_ELEMENT_FLOAT(ACC_FILTER_X);
-	LOG_ELEMENT_FLOAT(ACC_FILTER_Y);
-	LOG_ELEMENT_FLOAT(ACC_FILTER_Z);
-	LOG_ELEMENT_FLOAT(MAG_X);
-	LOG_ELEMENT_FLOAT(MAG_Y);
-	LOG_ELEMENT_FLOAT(MAG_Z);
-	LOG_ELEMENT_FLOAT(MAG_FILTER_X);
-	LOG_ELEMENT_FLOAT(MAG_FILTER_Y);
-	LOG_ELEMENT_FLOAT(MAG_FILTER_Z);
+}LOG_PosDef;
+
+typedef struct
+{
 	LOG_ELEMENT_FLOAT(MOTOR_1);
 	LOG_ELEMENT_FLOAT(MOTOR_2);
 	LOG_ELEMENT_FLOAT(MOTOR_3);
 	LOG_ELEMENT_FLOAT(MOTOR_4);
+}LOG_MotorDef;
+
+typedef struct
+{
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_SP_RATE);
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_V);
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_V1);
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_V2);
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_Z1);
 	LOG_ELEMENT_FLOAT(ADRC_PITCH_Z2);
+}LOG_AdrcDef;
+
+typedef struct
+{
 	LOG_ELEMENT_FLOAT(GPS_LAT);
 	LOG_ELEMENT_FLOAT(GPS_LON);
 	LOG_ELEMENT_FLOAT(GPS_X);
@@ -89,45 +184,41 @@ typedef struct
 	LOG_ELEMENT_FLOAT(GPS_VE);
 	LOG_ELEMENT_FLOAT(GPS_VD);
 	LOG_ELEMENT_FLOAT(GPS_HDOP);
+}LOG_GpsDef;
+
+typedef struct
+{
 	LOG_ELEMENT_FLOAT(BARO_ALT);
 	LOG_ELEMENT_FLOAT(BARO_VEL);
-//	LOG_ELEMENT_FLOAT(KF_U_X);
-//	LOG_ELEMENT_FLOAT(KF_U_Y);
-//	LOG_ELEMENT_FLOAT(KF_U_Z);
-//	LOG_ELEMENT_FLOAT(KF_X);
-//	LOG_ELEMENT_FLOAT(KF_Y);
-//	LOG_ELEMENT_FLOAT(KF_Z);
-//	LOG_ELEMENT_FLOAT(KF_VX);
-//	LOG_ELEMENT_FLOAT(KF_VY);
-//	LOG_ELEMENT_FLOAT(KF_VZ);
-//	LOG_ELEMENT_FLOAT(KF_Z_X);
-//	LOG_ELEMENT_FLOAT(KF_Z_Y);
-//	LOG_ELEMENT_FLOAT(KF_Z_Z);
-//	LOG_ELEMENT_FLOAT(KF_Z_VX);
-//	LOG_ELEMENT_FLOAT(KF_Z_VY);
-//	LOG_ELEMENT_FLOAT(KF_Z_VZ);
-}LOG_FieldDef;
+}LOG_BaroDef;
+
+/* cpu load(%) and maximal wakeup latency(us) of main threads */
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(CPU);
+	LOG_ELEMENT_FLOAT(FASTLOOP_LOAD);
+	LOG_ELEMENT_FLOAT(FASTLOOP_LAT);
+	LOG_ELEMENT_FLOAT(COPTER_LOAD);
+	LOG_ELEMENT_FLOAT(COPTER_LAT);
+	LOG_ELEMENT_FLOAT(MAVPROXY_LOAD);
+	LOG_ELEMENT_FLOAT(MAVPROXY_LAT);
+	LOG_ELEMENT_FLOAT(LOGGER_LOAD);
+	LOG_ELEMENT_FLOAT(LOGGER_LAT);
+	LOG_ELEMENT_FLOAT(LOG_WRITER_LOAD);
+	LOG_ELEMENT_FLOAT(LOG_WRITER_LAT);
+}LOG_LoadDef;
 
 typedef struct
 {
 	uint8_t status;
 	uint32_t log_period;
 	uint32_t last_record_time;
-	LOG_FieldDef log_field;
+	uint32_t record_cnt;
+	uint32_t delta_cnt;
+	uint32_t ring_drop_cnt;		// ring records not drained before stop timed out
+	uint8_t delta;
 }LOGGER_InfoDef;
 
-enum
-{
-	LOG_INT8 = 0,
-	LOG_UINT8,
-	LOG_INT16,
-	LOG_UINT16,
-	LOG_INT32,
-	LOG_UINT32,
-	LOG_FLOAT,
-	LOG_DOUBLE,
-};
-
 typedef struct
 {
 	char name[LOG_MAX_NAME_LENGTH];
@@ -136,14 +227,111 @@ typedef struct
 
 typedef struct
 {
-	uint32_t start_time;
-	uint32_t log_period;
+	uint8_t msg_id;
+	const char* name;
+	uint32_t period;			// minimal record interval in ms, 0 to record every update
+	const LOG_ElementInfoDef* element_info;
 	uint32_t element_num;
-	uint32_t header_size;
-	uint32_t field_size;
-	LOG_ElementInfoDef *element_info;
+	uint32_t payload_size;
+	uint32_t last_record_time;
+	uint32_t record_cnt;
+}LOG_MsgInfoDef;
+
+/* Log file layout:
+ * LOG_HeaderDef
+ * msg_num * (LOG_FormatDef + element_num * LOG_ElementInfoDef)
+ * records, each is LOG_RecordHeaderDef + payload, or LOG_DeltaHeaderDef + body
+ * if delta coding is on (see log_delta.c), every message starts with a plain record
+ * LOG_SyncDef markers between records every LOG_SYNC_INTERVAL bytes
+ * index footer, LOG_IndexHeaderDef + entry_num * LOG_IndexEntryDef + LOG_IndexTailDef
+ *
+ * Delta coding restarts at each marker, so decoding can start from any of them.
+ * The footer is only written when log is stopped. A log cut by power loss has
+ * none, tool/LogIndex/logidx rebuilds it from the markers.
+ *
+ * A compressed log is a sequence of blocks, each is LOG_BlockHeaderDef + data.
+ * Blocks are compressed independently and their raw data joined in order is
+ * the layout above, so a truncated file still decodes up to its last block.
+ * The footer is stored uncompressed in the last block, so it is at the end of
+ * file in both cases.
+ */
+typedef struct
+{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t msg_num;
+	uint32_t start_time;		// ms
+	uint32_t header_size;		// size of header and format definition section
 }LOG_HeaderDef;
 
+typedef struct
+{
+	uint8_t msg_id;
+	uint8_t element_num;
+	uint16_t payload_size;
+	uint32_t period;
+	char name[LOG_MAX_NAME_LENGTH];
+}LOG_FormatDef;
+
+typedef struct
+{
+	uint8_t sync;				// LOG_RECORD_SYNC
+	uint8_t msg_id;
+	uint16_t payload_size;
+	uint32_t timestamp;			// us, wraps around every ~71 minutes
+}LOG_RecordHeaderDef;
+
+typedef struct
+{
+	uint8_t sync;				// LOG_RECORD_SYNC_DELTA
+	uint8_t msg_id;
+	uint16_t body_size;
+}LOG_DeltaHeaderDef;
+
+typedef struct
+{
+	uint8_t sync;				// LOG_RECORD_SYNC_MARK
+	uint8_t reserved;
+	uint16_t seq;				// marker number, wraps around
+	uint32_t magic;				// LOG_SYNC_MAGIC
+	uint32_t timestamp;			// us, timestamp of the record following marker
+	uint32_t raw_offset;		// offset of this marker in uncompressed log
+}LOG_SyncDef;
+
+typedef struct
+{
+	uint8_t sync;				// LOG_RECORD_SYNC_INDEX
+	uint8_t reserved;
+	uint16_t stride;			// markers between two entries
+	uint32_t entry_num;
+}LOG_IndexHeaderDef;
+
+typedef struct
+{
+	uint64_t timestamp;			// us, marker timestamp without wrap around
+	uint32_t raw_offset;		// offset of the marker in uncompressed log
+	uint32_t file_offset;		// offset of the marker, or of its block in compressed log
+}LOG_IndexEntryDef;
+
+typedef struct
+{
+	uint32_t magic;				// LOG_INDEX_MAGIC
+	uint32_t entry_num;
+	uint32_t index_size;		// size of the whole footer including this tail
+	uint32_t raw_offset;		// offset of LOG_IndexHeaderDef in uncompressed log
+}LOG_IndexTailDef;
+
+typedef struct
+{
+	uint32_t magic;				// LOG_BLOCK_MAGIC
+	uint8_t method;				// compress method of data, LOG_COMPRESS_NONE if it does not shrink
+	uint8_t reserved;
+	uint16_t raw_size;			// size of data after decompression
+	uint32_t data_size;			// size of data following this header
+	uint32_t raw_offset;		// offset of raw data in uncompressed log
+}LOG_BlockHeaderDef;
+
+void logger_trigger(uint32_t reason);
 void logger_entry(void *parameter);
 
 #endif
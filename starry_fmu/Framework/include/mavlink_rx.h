@@ -0,0 +1,35 @@
+/*
+ * File      : mavlink_rx.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#ifndef __MAVLINK_RX_H__
+#define __MAVLINK_RX_H__
+
+#include <stdint.h>
+
+#pragma anon_unions
+#include "../../Library/mavlink/v1.0/common/mavlink.h"
+
+#define MAVLINK_RX_BUFFER_SIZE		512
+
+typedef void (*mavlink_rx_handler_t)(mavlink_message_t* msg);
+
+typedef struct{
+	uint8_t frame[MAVLINK_MAX_PACKET_LEN];
+	uint16_t idx;			/* received bytes of current frame, including STX */
+	uint16_t frame_len;		/* total frame length, valid when idx >= 2 */
+	uint32_t rx_bytes;
+	uint32_t frame_cnt;
+	uint32_t crc_err;
+}mavlink_rx_t;
+
+void mavlink_rx_init(mavlink_rx_t* rx);
+uint16_t mavlink_rx_crc(const uint8_t* buf, uint32_t len, uint16_t crc);
+uint32_t mavlink_rx_parse(mavlink_rx_t* rx, const uint8_t* buf, uint32_t len, mavlink_message_t* msg, mavlink_rx_handler_t handler);
+
+#endif
@@ -0,0 +1,38 @@
+/*
+ * File      : mixer.h
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __MIXER_H__
+#define __MIXER_H__
+
+#include <stdint.h>
+
+#define MIXER_MAX_MOTOR_NUM		6
+
+/* mixer frame, same order as FrameType */
+enum
+{
+	MIXER_FRAME_X = 0,
+	MIXER_FRAME_PLUS,
+	MIXER_FRAME_HEXA,
+	MIXER_FRAME_BLUEJAY,
+	MIXER_FRAME_NUM,
+};
+
+/* motor output = throttle + mix * [roll pitch yaw]' */
+typedef struct
+{
+	const char*	name;
+	uint8_t		motor_num;
+	float		mix[MIXER_MAX_MOTOR_NUM][3];
+}mixer_frame_t;
+
+const mixer_frame_t* mixer_get_frame(uint8_t frame);
+uint8_t mixer_mix(uint8_t frame, const float att[3], float throttle, float* out, uint8_t out_num,
+					float out_min, float out_max, uint8_t desat);
+
+#endif
@@ -162,6 +162,8 @@ typedef struct
 	PARAM_DECLARE(ATT_ROLLR_I_LIM);
 	PARAM_DECLARE(ATT_PITCHR_I_LIM);
 	PARAM_DECLARE(ATT_YAWR_I_LIM);
+	PARAM_DECLARE(ATT_MIX_FRAME);
+	PARAM_DECLARE(ATT_MIX_DESAT);
 }PARAM_GROUP(ATT_CONTROLLER);
 
 typedef struct
@@ -218,6 +220,12 @@ typedef struct
 	PARAM_DECLARE(HIL_POS_EST_PRD);
 	PARAM_DECLARE(HIL_CONTROL_PRD);
 }PARAM_GROUP(HIL_SIM);
+
+typedef struct
+{
+	PARAM_DECLARE(GYR_NOTCH_EN);
+	PARAM_DECLARE(GYR_NOTCH_LPF);
+}PARAM_GROUP(SENSOR_FILTER);
 /* Parameter Declare End */		
 
 #define PARAM_GET(_group, _name)				((_param_##_group *)(param_list._param_##_group.content))->_name
@@ -229,6 +237,35 @@ typedef struct
 #define PARAM_SET_UINT32(_group, _name, _val)	((_param_##_group *)(param_list._param_##_group.content))->_name.val.u = _val
 #define PARAM_SET_FLOAT(_group, _name, _val)	((_param_##_group *)(param_list._param_##_group.content))->_name.val.f = _val
 
+enum{
+	PARAM_LOAD_SRC_DEFAULT = 0,
+	PARAM_LOAD_SRC_BIN,
+	PARAM_LOAD_SRC_XML,
+};
+
+typedef struct{
+	uint32_t dirty_cnt;
+	uint32_t set_cnt;
+	uint32_t flush_cnt;
+	uint32_t flush_record;
+	uint32_t write_bytes;
+	uint32_t err_cnt;
+	uint32_t flush_time_last;
+	uint32_t load_src;
+	uint32_t load_time;			/* us */
+}param_store_status_t;
+
+/* same as mavlink param_id length */
+#define PARAM_NAME_MAX_LEN		16
+
+/* open addressing hash index from name to item index of a param table */
+typedef struct{
+	uint16_t*	slot;			/* item index + 1, 0 means empty */
+	uint16_t	mask;			/* slot number - 1, slot number is power of 2 */
+	uint16_t	item_num;
+	const char* (*get_name)(uint16_t item);
+}param_name_index_t;
+
 typedef struct{
 	const char* name;
 	const uint32_t param_num;
@@ -242,6 +279,7 @@ typedef struct{
 	param_group_info	PARAM_GROUP(ALT_CONTROLLER);
 	param_group_info	PARAM_GROUP(ADRC_ATT);
 	param_group_info	PARAM_GROUP(HIL_SIM);
+	param_group_info	PARAM_GROUP(SENSOR_FILTER);
 }param_list_t;
 
 extern param_list_t param_list;
@@ -257,5 +295,19 @@ uint32_t param_get_info_count(void);
 uint32_t param_get_info_index(char* param_name);
 int param_set_by_info(param_info_t* param, float val);
 int param_get_by_info(param_info_t* param, float *val);
+void param_mark_dirty(param_info_t* param);
+uint8_t param_flush(void);
+void param_flush_request(void);
+void param_store(void);
+void param_load(void);
+uint8_t param_export(void);
+param_store_status_t param_get_store_status(void);
+void param_show_store_status(void);
+void param_entry(void *parameter);
+
+uint32_t param_name_hash(const char* name);
+void param_name_index_init(param_name_index_t* index, uint16_t* slot, uint16_t slot_num, const char* (*get_name)(uint16_t item));
+int param_name_index_add(param_name_index_t* index, uint16_t item);
+int param_name_index_find(const param_name_index_t* index, const char* name);
 
 #endif
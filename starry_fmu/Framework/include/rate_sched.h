@@ -0,0 +1,54 @@
+/*
+ * File      : rate_sched.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#ifndef __RATE_SCHED_H__
+#define __RATE_SCHED_H__
+
+#include <stdint.h>
+
+#define SCHED_MAX_TASK_NUM		8
+/* log2 histogram: bin 0 is 0us, bin n is [2^(n-1), 2^n) us, last bin collects the rest */
+#define SCHED_HIST_BIN_NUM		14
+
+typedef void (*sched_task_func)(void* parameter);
+typedef uint64_t (*sched_clock_func)(void);
+
+typedef struct{
+	const char*		name;
+	sched_task_func	run;
+	void*			parameter;
+	uint32_t		period_us;
+	uint32_t		phase_us;
+	uint32_t		budget_us;
+	uint64_t		release;			/* next release time */
+	/* statistics */
+	uint32_t		run_cnt;
+	uint32_t		overrun_cnt;		/* execution time exceed budget */
+	uint32_t		miss_cnt;			/* finished after next release */
+	uint32_t		skip_cnt;			/* releases dropped because of late start */
+	uint32_t		exec_last;
+	uint32_t		exec_max;
+	uint64_t		exec_sum;
+	uint32_t		jitter_max;			/* start time - release time */
+	uint32_t		jitter_hist[SCHED_HIST_BIN_NUM];
+	uint32_t		exec_hist[SCHED_HIST_BIN_NUM];
+}sched_task_t;
+
+void sched_init(sched_clock_func clock, uint32_t tolerance_us);
+int sched_task_register(const char* name, sched_task_func run, void* parameter, 
+						uint32_t period_us, uint32_t phase_us, uint32_t budget_us);
+void sched_start(void);
+uint32_t sched_run(void);
+const sched_task_t* sched_get_task(uint8_t id);
+uint8_t sched_get_task_num(void);
+void sched_reset_statistic(void);
+void sched_show_status(void);
+void sched_show_histogram(void);
+
+#endif
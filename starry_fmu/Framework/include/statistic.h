@@ -6,13 +6,58 @@
  * Date           Author       	Notes
  * 2017-09-028     zoujiachi   	the first version
  */
- 
+
 #ifndef __STATISTIC_H__
 #define __STATISTIC_H__
 
 #include "global.h"
 
+/* maximal number of threads accounted, threads created later are counted as untracked */
+#define STAT_THREAD_MAX_NUM		16
+/* log2 histogram: bin 0 is 0us, bin n is [2^(n-1), 2^n) us, last bin collects the rest */
+#define STAT_HIST_BIN_NUM		14
+
+/* accumulated statistic of one thread, updated from scheduler hooks */
+typedef struct
+{
+	rt_thread_t		thread;
+	char			name[RT_NAME_MAX];
+	uint64_t		run_time;			/* total time running, us */
+	uint32_t		switch_cnt;			/* times switched in */
+	uint32_t		wakeup_cnt;			/* times switched in after being made ready */
+	uint64_t		latency_sum;		/* us */
+	uint32_t		latency_max;		/* us */
+	uint32_t		latency_peak;		/* maximal latency since last statistic interval, us */
+	uint64_t		ready_time;			/* time made ready, 0 if not waiting for cpu */
+	uint32_t		latency_hist[STAT_HIST_BIN_NUM];
+}thread_stat_t;
+
+/* per-thread load of last statistic interval, published as SYS_LOAD topic */
+typedef struct
+{
+	char			name[RT_NAME_MAX];
+	uint16_t		load;				/* cpu load, 0.01% */
+	uint16_t		switch_rate;		/* switched in per second */
+	uint16_t		latency_avg;		/* wakeup latency, us */
+	uint16_t		latency_max;		/* wakeup latency, us */
+}thread_load_t;
+
+typedef struct
+{
+	uint32_t		timestamp_ms;
+	uint32_t		interval_ms;
+	float			cpu_usage;			/* % */
+	uint32_t		untracked_switch;	/* switches of threads not in table */
+	uint8_t			thread_num;
+	thread_load_t	thread[STAT_THREAD_MAX_NUM];
+}sys_load_t;
+
 void statistic_init(void);
 float get_cpu_usage(void);
+uint8_t statistic_get_thread_load(const char* name, thread_load_t* load);
+uint8_t statistic_get_thread_stat(uint8_t index, thread_stat_t* stat);
+void statistic_reset(void);
+void statistic_show_thread(void);
+void statistic_show_histogram(void);
 
 #endif
@@ -0,0 +1,113 @@
+/*
+ * File      : trace.h
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+#include <rtthread.h>
+#include <stdint.h>
+
+/* comment out to compile trace zones away */
+#define TRACE_USING_ZONE
+
+#define TRACE_DEFAULT_RECORD_NUM	2048
+#define TRACE_THREAD_MAX_NUM		32
+#define TRACE_NAME_LEN				16
+
+#define TRACE_FILE_MAGIC			0x43525453	/* "STRC" */
+#define TRACE_FILE_VERSION			1
+
+/* record type */
+enum
+{
+	TRACE_EVT_SWITCH = 0,		/* id: thread switched in, arg: thread switched out */
+	TRACE_EVT_READY,			/* id: thread made ready */
+	TRACE_EVT_IRQ_ENTER,		/* id: exception number */
+	TRACE_EVT_IRQ_LEAVE,		/* id: exception number */
+	TRACE_EVT_ZONE_BEGIN,		/* id: zone */
+	TRACE_EVT_ZONE_END,			/* id: zone */
+	TRACE_EVT_MARK,				/* id: mark, arg: user value */
+};
+
+/* user zone id, must be in the same order as zone name list */
+enum
+{
+	TRACE_ZONE_SENSOR_COLLECT = 0,
+	TRACE_ZONE_ATT_CONTROL,
+	TRACE_ZONE_EKF_PREDICT,
+	TRACE_ZONE_EKF_CORRECT,
+	TRACE_ZONE_NUM,
+};
+
+/* mark id, must be in the same order as mark name list */
+enum
+{
+	TRACE_MARK_FASTLOOP_MISS = 0,	/* arg: fast loop period, us */
+	TRACE_MARK_USER,
+	TRACE_MARK_NUM,
+};
+
+/* 8 bytes fixed size record, timestamp wraps around every ~71 minutes */
+typedef struct
+{
+	uint32_t	timestamp;			/* us */
+	uint8_t		type;
+	uint8_t		id;
+	uint16_t	arg;
+}trace_record_t;
+
+/* Trace file layout:
+ * trace_file_header_t
+ * thread_num * TRACE_NAME_LEN thread names, in thread id order
+ * zone_num * TRACE_NAME_LEN zone names
+ * mark_num * TRACE_NAME_LEN mark names
+ * record_num * trace_record_t, oldest first
+ */
+typedef struct
+{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	record_size;
+	uint32_t	record_num;
+	uint32_t	lost_num;			/* records overwritten in ring */
+	uint8_t		thread_num;
+	uint8_t		zone_num;
+	uint8_t		mark_num;
+	uint8_t		reserved;
+}trace_file_header_t;
+
+typedef struct
+{
+	uint8_t		running;
+	uint8_t		trigger;			/* stop automatically after a mark */
+	uint32_t	capacity;
+	uint32_t	record_cnt;
+	uint32_t	post_cnt;			/* records left to be recorded after trigger */
+}trace_status_t;
+
+void trace_init(void);
+uint8_t trace_start(uint32_t record_num, uint8_t trigger);
+void trace_stop(void);
+uint8_t trace_dump(const char* file_name);
+trace_status_t trace_get_status(void);
+
+void trace_record(uint8_t type, uint8_t id, uint16_t arg);
+void trace_sched_switch(rt_thread_t from, rt_thread_t to);
+void trace_sched_ready(rt_thread_t thread);
+void trace_mark(uint8_t mark, uint16_t arg);
+
+#ifdef TRACE_USING_ZONE
+	#define TRACE_ZONE_BEGIN(_zone)		trace_record(TRACE_EVT_ZONE_BEGIN, _zone, 0)
+	#define TRACE_ZONE_END(_zone)		trace_record(TRACE_EVT_ZONE_END, _zone, 0)
+#else
+	#define TRACE_ZONE_BEGIN(_zone)
+	#define TRACE_ZONE_END(_zone)
+#endif
+
+#endif
@@ -14,6 +14,7 @@
 #include <rtthread.h>
 #include <rtdevice.h>
 #include "global.h"
+#include "delay.h"
 
 #define MCN_EVENT_HANDLE			rt_event_t	
 #define MCN_SEND_EVENT(event_t)		rt_event_send(event_t, 1)
@@ -21,9 +22,19 @@
 #define MCN_FREE(ptr)				rt_free(ptr)
 #define MCN_ENTER_CRITICAL			OS_ENTER_CRITICAL
 #define MCN_EXIT_CRITICAL			OS_EXIT_CRITICAL
+#ifdef SITL_SIMULATION
+#define MCN_MEM_BARRIER()			__sync_synchronize()
+#else
+#define MCN_MEM_BARRIER()			__DMB()
+#endif
+#define MCN_TIME_STAMP()			((uint32_t)time_nowUs())
 
 #define MCN_MAX_LINK_NUM		30
 
+/* hub access mode */
+#define MCN_MODE_CRITICAL		0	// publish/copy protected by scheduler lock
+#define MCN_MODE_SEQLOCK		1	// lock-free, two copies guarded by sequence counter
+
 typedef struct mcn_node		McnNode;
 typedef struct mcn_node*	McnNode_t;
 struct mcn_node
@@ -31,6 +42,9 @@ struct mcn_node
 	volatile uint8_t renewal;
 	void (*cb)(void *parameter);
 	McnNode_t next;
+	uint32_t cursor;	// next sample to pop, only used for queued hub
+	uint32_t lost;		// samples overwritten before being popped
+	uint32_t stamp;		// publish time (us) of last popped/copied sample, only used for queued hub
 };
 
 typedef struct mcn_hub		McnHub;
@@ -43,6 +57,12 @@ struct mcn_hub
 	McnNode_t link_tail;
 	uint32_t link_num;
 	uint8_t published;	// publish flag
+	const uint8_t mode;	// MCN_MODE_CRITICAL or MCN_MODE_SEQLOCK
+	volatile uint32_t seq;	// sequence counter, only used in seqlock mode
+	volatile uint32_t retry;	// torn read retry counter, only used in lock-free access
+	uint32_t queue_depth;	// sample queue depth, 0 for single-slot hub
+	volatile uint32_t pub_cnt;	// published sample count, only used for queued hub
+	uint32_t* pstamp;	// publish time (us) of each queue slot
 };
 
 #define MCN_ID(_name)				(&__mcn_##_name)
@@ -57,15 +77,44 @@ struct mcn_hub
 		.link_head = NULL,	                \
 		.link_tail = NULL,	                \
 		.link_num = 0,						\
-		.published = 0						\
+		.published = 0,						\
+		.mode = MCN_MODE_CRITICAL,			\
+		.seq = 0,							\
+		.retry = 0,							\
+		.queue_depth = 0,					\
+		.pub_cnt = 0,						\
+		.pstamp = NULL						\
+	}
+
+/* lock-free hub: one publisher, any number of readers. Publisher never
+ * blocks, readers retry when the copy they read was overwritten */
+#define MCN_DEFINE_SEQLOCK(_name, _size)	\
+	McnHub __mcn_##_name = {	        	\
+		.obj_name = #_name,					\
+		.obj_size = _size,					\
+		.pdata = NULL,                      \
+		.link_head = NULL,	                \
+		.link_tail = NULL,	                \
+		.link_num = 0,						\
+		.published = 0,						\
+		.mode = MCN_MODE_SEQLOCK,			\
+		.seq = 0,							\
+		.retry = 0,							\
+		.queue_depth = 0,					\
+		.pub_cnt = 0,						\
+		.pstamp = NULL						\
 	}
 	
 int mcn_advertise(McnHub* hub);
+int mcn_advertise_queue(McnHub* hub, uint32_t depth);
 McnNode_t mcn_subscribe(McnHub* hub, void (*cb)(void *parameter));
 int mcn_publish(McnHub* hub, const void* data);
 bool mcn_poll(McnNode_t node_t);
 int mcn_copy(McnHub* hub, McnNode_t node_t, void* buffer);
 int mcn_copy_from_hub(McnHub* hub, void* buffer);
+int mcn_pop(McnHub* hub, McnNode_t node_t, void* buffer);
+uint32_t mcn_pending(McnHub* hub, McnNode_t node_t);
+void mcn_clear(McnHub* hub, McnNode_t node_t);
 
 #endif
 	
\ No newline at end of file
@@ -24,6 +24,7 @@ static rt_device_t console_usb_device;
 #define CONSOLE_BUFF_SIZE			128
 #define CONSOLE_SEND_BUFF_SIZE		1024
 static char console_buf[CONSOLE_BUFF_SIZE];
+static void (*_error_hook)(char* tag) = NULL;
 
 /* redefine fputc(),for printf() function to call */
 int fputc(int ch, FILE * file)
@@ -50,6 +51,15 @@ void console_error(char* tag, const char *fmt, ...)
 	va_end(args);
 	
 	console_output(console_device, console_buf, length);
+	
+	if(_error_hook)
+		_error_hook(tag);
+}
+
+/* hook is called after each error is printed */
+void console_set_error_hook(void (*hook)(char* tag))
+{
+	_error_hook = hook;
 }
 
 void console_warning(char* tag, const char *fmt, ...)
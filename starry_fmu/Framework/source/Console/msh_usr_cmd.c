@@ -11,6 +11,7 @@
 #include <finsh.h>
 #include <shell.h>
 #include <string.h>
+#include <stdlib.h>
 #include "calibration.h"
 #include "starryio_uploader.h"
 #include "pos_estimator.h"
@@ -154,6 +155,20 @@ int handle_help_shell_cmd(int argc, char** argv)
 		}
 		if( strcmp(argv[1], "sys") == 0 ){
 			Console.print("Show system status.\n");
+			Console.print("Usage: sys [thread|hist|reset]\n");
+			Console.print("\n");
+			Console.print("%8s,\t%s\n", "thread", "Show per-thread cpu load, switch rate and wakeup latency.");
+			Console.print("%8s,\t%s\n", "hist", "Show per-thread wakeup latency histogram.");
+			Console.print("%8s,\t%s\n", "reset", "Reset thread statistic.");
+		}
+		if( strcmp(argv[1], "trace") == 0 ){
+			Console.print("Record thread switch, interrupt and zone trace.\n");
+			Console.print("Usage: trace [start [records] [trig]|stop|mark|dump <file>]\n");
+			Console.print("\n");
+			Console.print("%8s,\t%s\n", "start", "Start recording into a ring, trig stops it half a ring after a mark.");
+			Console.print("%8s,\t%s\n", "stop", "Stop recording.");
+			Console.print("%8s,\t%s\n", "mark", "Insert a user mark.");
+			Console.print("%8s,\t%s\n", "dump", "Write the ring to file, convert it with tool/Trace/trace2json.");
 		}
 		if( strcmp(argv[1], "calib") == 0 ){
 			Console.print("Calibrate sensors.\n");
@@ -286,8 +301,13 @@ int handle_help_shell_cmd(int argc, char** argv)
 			Console.print("\n");
 			Console.print("action:\n");
 			Console.print("\t%-23s - %s\n", "start <file> [period]", "Start logger.");
+			Console.print("\t%-23s - %s\n", "      [none|lzo|deflate]", "Compress log in blocks.");
+			Console.print("\t%-23s - %s\n", "      [delta]", "Delta code records.");
 			Console.print("\t%-23s - %s\n", "stop", "Stop logger.");
 			Console.print("\t%-23s - %s\n", "info <file>", "Show log file information.");
+			Console.print("\t%-23s - %s\n", "ring <KB>|off", "Keep newest records before log starts.");
+			Console.print("\t%-23s - %s\n", "      [method] [delta]", "Options of triggered log.");
+			Console.print("\t%-23s - %s\n", "trigger", "Start TRIGxxx.LOG with ring data.");
 		}
 		if( strcmp(argv[1], "control") == 0 ){
 			Console.print("Control commands.\n");
@@ -324,7 +344,11 @@ int handle_help_shell_cmd(int argc, char** argv)
 int cmd_reboot(int argc, char** argv)
 {
 	rt_kprintf("rebooting...\n\n");
+#ifdef SITL_SIMULATION
+	exit(0);
+#else
 	NVIC_SystemReset();
+#endif
 	return 0;
 }
 FINSH_FUNCTION_EXPORT_ALIAS(cmd_reboot, __cmd_reboot, reboot the system);
@@ -494,3 +518,17 @@ int cmd_control(int argc, char** argv)
 }
 FINSH_FUNCTION_EXPORT_ALIAS(cmd_control, __cmd_control, control operations);
 
+int handle_sched_shell_cmd(int argc, char** argv);
+int cmd_sched(int argc, char** argv)
+{
+	return handle_sched_shell_cmd(argc, argv);
+}
+FINSH_FUNCTION_EXPORT_ALIAS(cmd_sched, __cmd_sched, rate group scheduler status);
+
+int handle_trace_shell_cmd(int argc, char** argv);
+int cmd_trace(int argc, char** argv)
+{
+	return handle_trace_shell_cmd(argc, argv);
+}
+FINSH_FUNCTION_EXPORT_ALIAS(cmd_trace, __cmd_trace, scheduler and interrupt trace);
+
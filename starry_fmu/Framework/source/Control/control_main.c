@@ -33,12 +33,16 @@
 #include "copter_main.h"
 #include "adrc_att.h"
 #include "gps.h"
+#include "mixer.h"
+#include "logger.h"
 
 #define EVENT_CONTROL			(1<<0)
 
 /* Definition */
 #define ATT_CTRL_INTERVAL		10
 #define ALT_CTRL_INTERVAL		10
+/* adrc log samples kept for logger */
+#define ADRC_QUEUE_DEPTH		16
 /* the control angle for rc(degree) */
 #define ANGLE_CONTROL_SCALE		(20.0f)
 /* the maximal yaw rotation speed 20 deg/s */
@@ -84,12 +88,6 @@ static uint8_t _att_outerloop_update = 1;
 Euler _ec;	//current euler angle
 HomePosition _home = {0.0f, 0.0f, 0};	// home position
 
-#ifdef BLUEJAY
-FrameType _frame_type = frame_type_4;
-#else
-FrameType _frame_type = frame_type_1;	/* the default frame type is X frame */
-#endif
-
 static char* TAG = "Control";
 
 MCN_DEFINE(MOTOR_THROTTLE, MOTOR_NUM*sizeof(float));
@@ -190,56 +188,11 @@ void ctrl_constrain_throttle(float* throttle, uint8_t throttle_num)
 
 void _ctrl_mix_throttle_out(float *out, float* in, float base_throttle)
 {
-	if(_frame_type == frame_type_1){
-		/* X frame */
-		/* -1	 1	 1 */
-		/*  1	-1	 1 */
-		/*  1	 1	-1 */
-		/* -1	-1	-1 */
-		out[0] = base_throttle - in[0] + in[1] + in[2];
-		out[1] = base_throttle + in[0] - in[1] + in[2];
-		out[2] = base_throttle + in[0] + in[1] - in[2];
-		out[3] = base_throttle - in[0] - in[1] - in[2];		
-	}else if(_frame_type == frame_type_2){
-		/* + frame */
-		/* -sqrt(2)	  0	 		sqrt(2) */
-		/*  sqrt(2)	  0	 		sqrt(2) */
-		/*  0	 	sqrt(2)		-sqrt(2) */
-		/*  0		-sqrt(2)	-sqrt(2) */
-		out[0] = base_throttle - 1.414f*in[0]          			+ 1.414f*in[2];
-		out[1] = base_throttle + 1.414f*in[0]          			+ 1.414f*in[2];
-		out[2] = base_throttle          		+ 1.414f*in[1] 	- 1.414f*in[2];
-		out[3] = base_throttle          		- 1.414f*in[1] 	- 1.414f*in[2];	
-	}else if(_frame_type == frame_type_3){
-		/* hexrotor frame */
-		/*      0	 	  1	 	-1 */
-		/*      0	 	 -1		 1 */
-		/*  sqrt(3)/2	-1/2	-1 */
-		/* -sqrt(3)/2	 1/2	 1 */
-		/*  sqrt(3)/2	 1/2	 1 */
-		/* -sqrt(3)/2	-1/2	-1 */
-		out[0] = base_throttle                 +      in[1]  - in[2];
-		out[1] = base_throttle                 -      in[1]  + in[2];
-		out[2] = base_throttle + 0.866f*in[0]  - 0.5f*in[1]  - in[2];
-		out[3] = base_throttle - 0.866f*in[0]  + 0.5f*in[1]  + in[2];
-		out[4] = base_throttle + 0.866f*in[0]  + 0.5f*in[1]  + in[2];
-		out[5] = base_throttle - 0.866f*in[0]  - 0.5f*in[1]  - in[2];		
-	}else if(_frame_type == frame_type_4){
-		/* blue jay's frame */
-		/*     -1	 	  0	 	  -1 */
-		/*      1	 	  0		   1 */
-		/*     1/2    sqrt(3)/2	  -1 */
-		/*    -1/2	 -sqrt(3)/2	   1 */
-		/*    -1/2	  sqrt(3)/2	   1 */
-		/*     1/2	 -sqrt(3)/2	  -1 */
-		out[0] = base_throttle+ 1.414f*(-      in[0]                )  - in[2];
-		out[1] = base_throttle+ 1.414f*(+      in[0]                )  + in[2];
-		out[2] = base_throttle+ 1.414f*(+ 0.5f*in[0]  + 0.866f*in[1])  - in[2];
-		out[3] = base_throttle+ 1.414f*(- 0.5f*in[0]  - 0.866f*in[1])  + in[2];
-		out[4] = base_throttle+ 1.414f*(- 0.5f*in[0]  + 0.866f*in[1])  + in[2];
-		out[5] = base_throttle+ 1.414f*(+ 0.5f*in[0]  - 0.866f*in[1])  - in[2];		
-	}else{
-		Console.e(TAG, "err, unknow frame type:%d\n", _frame_type);
+	uint8_t frame = PARAM_GET_INT32(ATT_CONTROLLER, ATT_MIX_FRAME);
+	uint8_t desat = PARAM_GET_INT32(ATT_CONTROLLER, ATT_MIX_DESAT);
+	
+	if(mixer_mix(frame, in, base_throttle, out, MOTOR_NUM, THROTTLE_MIN, THROTTLE_MAX, desat)){
+		Console.e(TAG, "err, unknow frame type:%d\n", frame);
 		rc_enter_status(RC_LOCK_STATUS);
 	}
 }
@@ -488,6 +441,7 @@ void ctrl_unlock_vehicle(void)
 	
 	rt_device_control(motor_device_t, PWM_CMD_ENABLE, (void*)&on_off);
 	_vehicle_status = 1;
+	logger_trigger(LOG_TRIGGER_ARM);
 	
 	/* set home position */
 	ctrl_set_home();
@@ -516,6 +470,9 @@ void ctrl_lock_vehicle(void)
 	rt_device_control(motor_device_t, PWM_CMD_ENABLE, (void*)&on_off);
 	_vehicle_status = 0;
 	alt_hold_mode = 0;
+	
+	/* store params changed during flight */
+	param_flush_request();
 }
 
 void control_init(void)
@@ -534,7 +491,7 @@ void control_init(void)
 	if(mcn_res != 0){
 		Console.e(TAG, "err:%d, MOTOR_THROTTLE advertise fail!\n", mcn_res);
 	}
-	mcn_res = mcn_advertise(MCN_ID(ADRC));
+	mcn_res = mcn_advertise_queue(MCN_ID(ADRC), ADRC_QUEUE_DEPTH);
 	if(mcn_res != 0){
 		Console.e(TAG, "err:%d, ADRC advertise fail!\n", mcn_res);
 	}
@@ -0,0 +1,145 @@
+/*
+ * File      : mixer.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stddef.h>
+#include "mixer.h"
+
+#define SQRT2		1.414f
+
+static const mixer_frame_t _frame[MIXER_FRAME_NUM] =
+{
+	{
+		"X", 4,
+		{
+			{-1.0f,  1.0f,  1.0f},
+			{ 1.0f, -1.0f,  1.0f},
+			{ 1.0f,  1.0f, -1.0f},
+			{-1.0f, -1.0f, -1.0f},
+		}
+	},
+	{
+		"+", 4,
+		{
+			{-SQRT2,  0.0f,   SQRT2},
+			{ SQRT2,  0.0f,   SQRT2},
+			{ 0.0f,   SQRT2, -SQRT2},
+			{ 0.0f,  -SQRT2, -SQRT2},
+		}
+	},
+	{
+		"hexa", 6,
+		{
+			{ 0.0f,    1.0f, -1.0f},
+			{ 0.0f,   -1.0f,  1.0f},
+			{ 0.866f, -0.5f, -1.0f},
+			{-0.866f,  0.5f,  1.0f},
+			{ 0.866f,  0.5f,  1.0f},
+			{-0.866f, -0.5f, -1.0f},
+		}
+	},
+	{
+		"bluejay", 6,
+		{
+			{-SQRT2,        0.0f,          -1.0f},
+			{ SQRT2,        0.0f,           1.0f},
+			{ SQRT2*0.5f,   SQRT2*0.866f,  -1.0f},
+			{-SQRT2*0.5f,  -SQRT2*0.866f,   1.0f},
+			{-SQRT2*0.5f,   SQRT2*0.866f,   1.0f},
+			{ SQRT2*0.5f,  -SQRT2*0.866f,  -1.0f},
+		}
+	},
+};
+
+const mixer_frame_t* mixer_get_frame(uint8_t frame)
+{
+	if(frame >= MIXER_FRAME_NUM)
+		return NULL;
+	
+	return &_frame[frame];
+}
+
+static void _mixer_range(const float* val, uint8_t num, float* min, float* max)
+{
+	*min = *max = val[0];
+	for(uint8_t i = 1 ; i < num ; i++){
+		if(val[i] < *min)
+			*min = val[i];
+		if(val[i] > *max)
+			*max = val[i];
+	}
+}
+
+/*
+ * Mix roll/pitch/yaw output and throttle into motor outputs in [out_min, out_max].
+ * Without desat, each motor is clipped. With desat, attitude authority is kept in
+ * the order roll/pitch > yaw > throttle:
+ *   1. roll/pitch is scaled down only if its spread alone exceeds output range
+ *   2. yaw is scaled down until roll/pitch/yaw spread fits output range
+ *   3. throttle is shifted so that all motors are inside output range (airmode)
+ * Outputs are identical to clipping when no motor saturates.
+ * Return 0 if success.
+ */
+uint8_t mixer_mix(uint8_t frame, const float att[3], float throttle, float* out, uint8_t out_num,
+					float out_min, float out_max, uint8_t desat)
+{
+	const mixer_frame_t* f = mixer_get_frame(frame);
+	float rp[MIXER_MAX_MOTOR_NUM] = {0.0f};
+	float yaw[MIXER_MAX_MOTOR_NUM];
+	float motor[MIXER_MAX_MOTOR_NUM] = {0.0f};
+	float min, max, rp_range, range;
+	float span = out_max - out_min;
+	uint8_t i;
+	
+	if(f == NULL)
+		return 1;
+	
+	for(i = 0 ; i < f->motor_num ; i++){
+		rp[i] = f->mix[i][0]*att[0] + f->mix[i][1]*att[1];
+		yaw[i] = f->mix[i][2]*att[2];
+		motor[i] = rp[i] + yaw[i];
+	}
+	
+	if(desat){
+		_mixer_range(motor, f->motor_num, &min, &max);
+		range = max - min;
+		
+		if(range > span){
+			_mixer_range(rp, f->motor_num, &min, &max);
+			rp_range = max - min;
+			
+			if(rp_range >= span){
+				/* no room for yaw */
+				float k = rp_range > 0.0f ? span/rp_range : 0.0f;
+				for(i = 0 ; i < f->motor_num ; i++)
+					motor[i] = k*rp[i];
+			}else{
+				/* range is convex in yaw scale, so the linear interpolation is a safe scale */
+				float k = (span - rp_range)/(range - rp_range);
+				for(i = 0 ; i < f->motor_num ; i++)
+					motor[i] = rp[i] + k*yaw[i];
+			}
+		}
+		
+		/* shift throttle to fit */
+		_mixer_range(motor, f->motor_num, &min, &max);
+		if(throttle + max > out_max)
+			throttle = out_max - max;
+		if(throttle + min < out_min)
+			throttle = out_min - min;
+	}
+	
+	for(i = 0 ; i < f->motor_num && i < out_num ; i++){
+		out[i] = throttle + motor[i];
+		if(out[i] < out_min)
+			out[i] = out_min;
+		if(out[i] > out_max)
+			out[i] = out_max;
+	}
+	
+	return 0;
+}
@@ -19,8 +19,10 @@
 #include "param.h"
 #include "gps.h"
 #include "state_est.h"
+#include "rate_sched.h"
 
 #define EVENT_COPTER_FAST_LOOP		(1<<0)
+#define COPTER_SCHED_TOLERANCE_US	500
 
 static struct rt_timer timer_copter;
 static struct rt_event event_copter;
@@ -29,35 +31,39 @@ uint32_t _ekf_est_period;
 
 static char* TAG = "Copter_Main";
 
-void copter_main_loop(uint32_t att_est_period, uint32_t pos_est_period, uint32_t control_period)
+static void copter_state_est_task(void* parameter)
 {
-	static uint32_t ahrs_time = 0;
-	static uint32_t pos_est_time = 0;
-	static uint32_t ctrl_time = 0;
-	static uint32_t state_est_time = 0;
-	
-	uint32_t now = time_nowMs();
+	state_est_update();
+}
 
-#ifdef AHRS_USE_EKF	
-	if(TIME_GAP(state_est_time, now) >= 4){
-		state_est_time = now;
-		state_est_update();
-	}
-#else	
-	if(TIME_GAP(ahrs_time, now) >= att_est_period){
-		ahrs_time = now;
-		attitude_est_run(0.001f*att_est_period);
-	}
+static void copter_att_est_task(void* parameter)
+{
+	attitude_est_run(0.001f*_att_est_period);
+}
+
+static void copter_pos_est_task(void* parameter)
+{
+	pos_est_update(0.001f*_pos_est_period);
+}
+
+static void copter_control_task(void* parameter)
+{
+	control_vehicle(0.001f*_control_period);
+}
+
+static void copter_sched_init(void)
+{
+	/* woken up by 1ms tick, allow half tick early release */
+	sched_init(time_nowUs, COPTER_SCHED_TOLERANCE_US);
 	
-	if(TIME_GAP(pos_est_time, now) >= pos_est_period){
-		pos_est_time = now;
-		pos_est_update(0.001f*pos_est_period);
-	}
+	/* tasks run in registration order when released at the same time */
+#ifdef AHRS_USE_EKF
+	sched_task_register("state_est", copter_state_est_task, RT_NULL, 1000*_ekf_est_period, 0, EKF_BUDGET_US);
+#else
+	sched_task_register("att_est", copter_att_est_task, RT_NULL, 1000*_att_est_period, 0, AHRS_BUDGET_US);
+	sched_task_register("pos_est", copter_pos_est_task, RT_NULL, 1000*_pos_est_period, 0, POS_EST_BUDGET_US);
 #endif
-	if(TIME_GAP(ctrl_time, now) >= control_period){
-		ctrl_time = now;
-		control_vehicle(0.001f*control_period);
-	}
+	sched_task_register("control", copter_control_task, RT_NULL, 1000*_control_period, 0, CONTROL_BUDGET_US);
 }
 
 static void timer_copter_update(void* parameter)
@@ -118,6 +124,8 @@ void copter_entry(void *parameter)
 	sensor_manager_init();
 	pos_est_init(1e-3f*_pos_est_period);
 	
+	copter_sched_init();
+	
 	/* create event */
 	res = rt_event_init(&event_copter, "copter_event", RT_IPC_FLAG_FIFO);
 
@@ -128,6 +136,12 @@ void copter_entry(void *parameter)
 					1,
 					RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_SOFT_TIMER);
 	rt_timer_start(&timer_copter);
+	
+	/* align task release with timer tick */
+	rt_event_recv(&event_copter, wait_set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 
+					RT_WAITING_FOREVER, &recv_set);
+	sched_start();
+	sched_run();
 
 	while(1)
 	{
@@ -136,7 +150,7 @@ void copter_entry(void *parameter)
 		
 		if(res == RT_EOK){
 			if(recv_set & EVENT_COPTER_FAST_LOOP){
-				copter_main_loop(_att_est_period, _pos_est_period, _control_period);
+				sched_run();
 			}
 		}
 	}
@@ -32,8 +32,12 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "filter.h"
 #include "hil_interface.h"
 #include "control_main.h"
+#include "delay.h"
+#include "trace.h"
 
 #define EVENT_FAST_LOOP		(1<<0)
+/* fast loop runs every 1ms, mark the trace when one slot is missed */
+#define FAST_LOOP_MISS_US	1500
 
 static struct rt_timer timer_fastloop;
 static struct rt_event event_fastloop;
@@ -45,14 +49,26 @@ static void timer_fastloop_update(void* parameter)
 
 void fast_loop(void)
 {
+	static uint32_t last_time = 0;
+	uint32_t now = (uint32_t)time_nowUs();
+	uint32_t period = now - last_time;
 	
+	if(last_time && period > FAST_LOOP_MISS_US){
+		trace_mark(TRACE_MARK_FASTLOOP_MISS, period < 0xFFFF ? period : 0xFFFF);
+	}
+	last_time = now;
+	
+	TRACE_ZONE_BEGIN(TRACE_ZONE_SENSOR_COLLECT);
 #ifdef HIL_SIMULATION
 	hil_sensor_collect();
 #else
 	sensor_collect();
 #endif
+	TRACE_ZONE_END(TRACE_ZONE_SENSOR_COLLECT);
 	
+	TRACE_ZONE_BEGIN(TRACE_ZONE_ATT_CONTROL);
 	ctrl_att_adrc_update();
+	TRACE_ZONE_END(TRACE_ZONE_ATT_CONTROL);
 	
 }
 
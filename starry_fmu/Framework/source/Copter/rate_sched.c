@@ -0,0 +1,232 @@
+/*
+ * File      : rate_sched.c
+ *
+ * Rate group scheduler. Tasks are released at phase + k*period on a
+ * microsecond clock and run in registration order when due.
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+ 
+#include <string.h>
+#include "rate_sched.h"
+#include "console.h"
+
+static sched_task_t _task[SCHED_MAX_TASK_NUM];
+static uint8_t _task_num = 0;
+static sched_clock_func _clock = NULL;
+/* task is treated as due when it's released within this time, to absorb 
+ * the wake up error when scheduler is driven by a coarse tick */
+static uint32_t _tolerance_us = 0;
+
+/* scheduler bookkeeping time of one sched_run(), task execution excluded */
+static uint32_t _overhead_last;
+static uint32_t _overhead_max;
+static uint32_t _run_cnt;
+
+static uint8_t _hist_bin(uint32_t val)
+{
+	uint8_t bin = 0;
+	
+	while(val && bin < SCHED_HIST_BIN_NUM-1){
+		val >>= 1;
+		bin++;
+	}
+	
+	return bin;
+}
+
+void sched_init(sched_clock_func clock, uint32_t tolerance_us)
+{
+	memset(_task, 0, sizeof(_task));
+	_task_num = 0;
+	_clock = clock;
+	_tolerance_us = tolerance_us;
+	_overhead_last = _overhead_max = 0;
+	_run_cnt = 0;
+}
+
+/* return task id, or -1 if fail */
+int sched_task_register(const char* name, sched_task_func run, void* parameter, 
+						uint32_t period_us, uint32_t phase_us, uint32_t budget_us)
+{
+	sched_task_t* task;
+	
+	if(_task_num >= SCHED_MAX_TASK_NUM || run == NULL || period_us == 0){
+		return -1;
+	}
+	
+	task = &_task[_task_num];
+	memset(task, 0, sizeof(sched_task_t));
+	task->name = name;
+	task->run = run;
+	task->parameter = parameter;
+	task->period_us = period_us;
+	task->phase_us = phase_us;
+	task->budget_us = budget_us;
+	
+	return _task_num++;
+}
+
+void sched_start(void)
+{
+	uint64_t now = _clock();
+	
+	for(uint8_t i = 0 ; i < _task_num ; i++){
+		_task[i].release = now + _task[i].phase_us;
+	}
+}
+
+/* run all due tasks, return time in us until the next release */
+uint32_t sched_run(void)
+{
+	sched_task_t* task;
+	uint64_t enter, now, start, end, next;
+	uint32_t exec, jitter, missed;
+	uint64_t task_time = 0;
+	
+	enter = _clock();
+	
+	for(uint8_t i = 0 ; i < _task_num ; i++){
+		task = &_task[i];
+		
+		now = _clock();
+		if(now + _tolerance_us < task->release)
+			continue;
+		
+		/* drop releases which are already over, keep the phase */
+		jitter = now > task->release ? (uint32_t)(now - task->release) : 0;
+		if(jitter >= task->period_us){
+			missed = jitter / task->period_us;
+			task->skip_cnt += missed;
+			task->release += (uint64_t)missed * task->period_us;
+			jitter = (uint32_t)(now - task->release);
+		}
+		
+		start = now;
+		task->run(task->parameter);
+		end = _clock();
+		
+		exec = (uint32_t)(end - start);
+		task_time += exec;
+		
+		task->run_cnt++;
+		task->exec_last = exec;
+		task->exec_sum += exec;
+		if(exec > task->exec_max)
+			task->exec_max = exec;
+		if(jitter > task->jitter_max)
+			task->jitter_max = jitter;
+		task->exec_hist[_hist_bin(exec)]++;
+		task->jitter_hist[_hist_bin(jitter)]++;
+		if(task->budget_us && exec > task->budget_us)
+			task->overrun_cnt++;
+		
+		task->release += task->period_us;
+		if(end > task->release)
+			task->miss_cnt++;
+	}
+	
+	now = _clock();
+	_overhead_last = (uint32_t)(now - enter - task_time);
+	if(_overhead_last > _overhead_max)
+		_overhead_max = _overhead_last;
+	_run_cnt++;
+	
+	if(_task_num == 0)
+		return 0;
+	
+	next = _task[0].release;
+	for(uint8_t i = 1 ; i < _task_num ; i++){
+		if(_task[i].release < next)
+			next = _task[i].release;
+	}
+	
+	return next > now ? (uint32_t)(next - now) : 0;
+}
+
+const sched_task_t* sched_get_task(uint8_t id)
+{
+	if(id >= _task_num)
+		return NULL;
+	
+	return &_task[id];
+}
+
+uint8_t sched_get_task_num(void)
+{
+	return _task_num;
+}
+
+void sched_reset_statistic(void)
+{
+	sched_task_t* task;
+	
+	for(uint8_t i = 0 ; i < _task_num ; i++){
+		task = &_task[i];
+		task->run_cnt = task->overrun_cnt = task->miss_cnt = task->skip_cnt = 0;
+		task->exec_last = task->exec_max = task->jitter_max = 0;
+		task->exec_sum = 0;
+		memset(task->jitter_hist, 0, sizeof(task->jitter_hist));
+		memset(task->exec_hist, 0, sizeof(task->exec_hist));
+	}
+	_overhead_last = _overhead_max = 0;
+	_run_cnt = 0;
+}
+
+void sched_show_status(void)
+{
+	sched_task_t* task;
+	
+	Console.print("%-12s %7s %6s %6s %8s %6s %6s %6s %6s %6s %6s\n", "task", "period", "phase", "budget", 
+					"run", "overr", "miss", "skip", "exec", "e_max", "j_max");
+	for(uint8_t i = 0 ; i < _task_num ; i++){
+		task = &_task[i];
+		Console.print("%-12s %7d %6d %6d %8d %6d %6d %6d %6d %6d %6d\n", task->name, task->period_us, task->phase_us, 
+						task->budget_us, task->run_cnt, task->overrun_cnt, task->miss_cnt, task->skip_cnt, 
+						task->run_cnt ? (uint32_t)(task->exec_sum/task->run_cnt) : 0, task->exec_max, task->jitter_max);
+	}
+	Console.print("scheduler overhead(us): last:%d max:%d, run:%d\n", _overhead_last, _overhead_max, _run_cnt);
+}
+
+static void _sched_print_hist(const char* title, const uint32_t* hist)
+{
+	Console.print("  %s:", title);
+	for(uint8_t n = 0 ; n < SCHED_HIST_BIN_NUM ; n++){
+		if(hist[n] == 0)
+			continue;
+		if(n <= 1)
+			Console.print(" [%d]:%d", n, hist[n]);
+		else if(n == SCHED_HIST_BIN_NUM-1)
+			Console.print(" [%d+]:%d", 1<<(n-1), hist[n]);
+		else
+			Console.print(" [%d-%d]:%d", 1<<(n-1), (1<<n)-1, hist[n]);
+	}
+	Console.print("\n");
+}
+
+void sched_show_histogram(void)
+{
+	for(uint8_t i = 0 ; i < _task_num ; i++){
+		Console.print("%s (us):\n", _task[i].name);
+		_sched_print_hist("jitter", _task[i].jitter_hist);
+		_sched_print_hist("exec", _task[i].exec_hist);
+	}
+}
+
+int handle_sched_shell_cmd(int argc, char** argv)
+{
+	if(argc > 1){
+		if(strcmp(argv[1], "hist") == 0){
+			sched_show_histogram();
+		}
+		if(strcmp(argv[1], "reset") == 0){
+			sched_reset_statistic();
+		}
+	}else{
+		sched_show_status();
+	}
+	
+	return 0;
+}
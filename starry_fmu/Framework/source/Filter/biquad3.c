@@ -0,0 +1,101 @@
+/*
+ * File      : biquad3.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <math.h>
+#include <string.h>
+#include "biquad3.h"
+#include "global.h"
+
+void biquad3_init(Biquad3* bq, float sample_freq, float cutoff_freq, uint8_t stage_num)
+{
+	memset(bq, 0, sizeof(Biquad3));
+	
+	if(stage_num > BIQUAD3_MAX_STAGE)
+		stage_num = BIQUAD3_MAX_STAGE;
+	bq->stage_num = stage_num;
+	
+	biquad3_set_cutoff_frequency(bq, sample_freq, cutoff_freq);
+}
+
+/* can be called at runtime, the delay elements are kept */
+void biquad3_set_cutoff_frequency(Biquad3* bq, float sample_freq, float cutoff_freq)
+{
+	bq->sample_freq = sample_freq;
+	bq->cutoff_freq = cutoff_freq;
+	if(cutoff_freq <= 0.0f || bq->stage_num == 0){
+		// no filtering
+		return;
+	}
+	
+	float fr = sample_freq/cutoff_freq;
+	float ohm = tanf(PI/fr);
+	
+	for(uint8_t k = 0 ; k < bq->stage_num ; k++){
+		/* pole pair k of a 2*stage_num order butterworth, stage_num=1 is the same as Butter2 */
+		float theta = PI*(2*k+1)/(4.0f*bq->stage_num);
+		float c = 1.0f+2.0f*cosf(theta)*ohm + ohm*ohm;
+		bq->b0[k] = ohm*ohm/c;
+		bq->b1[k] = 2.0f*bq->b0[k];
+		bq->b2[k] = bq->b0[k];
+		bq->a1[k] = 2.0f*(ohm*ohm-1.0f)/c;
+		bq->a2[k] = (1.0f-2.0f*cosf(theta)*ohm+ohm*ohm)/c;
+	}
+}
+
+/* set delay elements to the steady state of sample */
+void biquad3_reset(Biquad3* bq, const float sample[3], float out[3])
+{
+	float tmp[3];
+	
+	if(bq->cutoff_freq <= 0.0f || bq->stage_num == 0){
+		if(out != NULL)
+			memcpy(out, sample, sizeof(tmp));
+		return;
+	}
+	
+	/* dc gain of each stage is 1, so every stage sees the same input */
+	for(uint8_t k = 0 ; k < bq->stage_num ; k++){
+		for(uint8_t i = 0 ; i < 3 ; i++){
+			float dval = sample[i] / (bq->b0[k] + bq->b1[k] + bq->b2[k]);
+			bq->w1[k][i] = dval;
+			bq->w2[k][i] = dval;
+		}
+	}
+	
+	biquad3_filter_process(bq, sample, out != NULL ? out : tmp);
+}
+
+void biquad3_filter_process(Biquad3* bq, const float in[3], float out[3])
+{
+	float x[3];
+	
+	x[0] = in[0];
+	x[1] = in[1];
+	x[2] = in[2];
+	
+	if(bq->cutoff_freq > 0.0f){
+		for(uint8_t k = 0 ; k < bq->stage_num ; k++){
+			const float b0 = bq->b0[k], b1 = bq->b1[k], b2 = bq->b2[k];
+			const float a1 = bq->a1[k], a2 = bq->a2[k];
+			float* w1 = bq->w1[k];
+			float* w2 = bq->w2[k];
+			
+			/* direct form II, same operation order as butter2_filter_process() */
+			for(uint8_t i = 0 ; i < 3 ; i++){
+				float w0 = x[i] - w1[i] * a1 - w2[i] * a2;
+				x[i] = w0 * b0 + w1[i] * b1 + w2[i] * b2;
+				w2[i] = w1[i];
+				w1[i] = w0;
+			}
+		}
+	}
+	
+	out[0] = x[0];
+	out[1] = x[1];
+	out[2] = x[2];
+}
@@ -0,0 +1,313 @@
+/*
+ * File      : dyn_notch.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <math.h>
+#include <string.h>
+#include "dyn_notch.h"
+#include "global.h"
+
+#define FFT_HALF_SIZE			(DYN_NOTCH_FFT_SIZE/2)
+/* a peak must exceed the mean power of search band by this ratio */
+#define PEAK_POWER_RATIO		4.0f
+/* and reach this sine amplitude (input unit), so a flat noise floor does not hold a notch.
+ * A sine of amplitude A has power (A*N/4)^2 at its bin with hann window */
+#define PEAK_MIN_AMP			0.02f
+#define PEAK_MIN_POWER			((PEAK_MIN_AMP*DYN_NOTCH_FFT_SIZE/4)*(PEAK_MIN_AMP*DYN_NOTCH_FFT_SIZE/4))
+/* low pass of tracked center frequency, per analysis */
+#define CENTER_SMOOTH_ALPHA		0.5f
+
+/* tables are shared by all instances. The work buffer makes analysis non-reentrant,
+ * it runs in the context which feeds samples (fast loop) */
+static float _window[DYN_NOTCH_FFT_SIZE];
+static float _cos[FFT_HALF_SIZE];			/* cos(2*PI*k/N) */
+static float _sin[FFT_HALF_SIZE];			/* sin(2*PI*k/N) */
+static float _re[FFT_HALF_SIZE];
+static float _im[FFT_HALF_SIZE];
+static float _power[FFT_HALF_SIZE];
+static uint8_t _table_ready = 0;
+
+static void _dyn_notch_init_table(void)
+{
+	for(uint16_t i = 0 ; i < DYN_NOTCH_FFT_SIZE ; i++){
+		/* hann window */
+		_window[i] = 0.5f - 0.5f*cosf(2.0f*PI*i/DYN_NOTCH_FFT_SIZE);
+	}
+	for(uint16_t k = 0 ; k < FFT_HALF_SIZE ; k++){
+		_cos[k] = cosf(2.0f*PI*k/DYN_NOTCH_FFT_SIZE);
+		_sin[k] = sinf(2.0f*PI*k/DYN_NOTCH_FFT_SIZE);
+	}
+	_table_ready = 1;
+}
+
+/* in-place radix-2 complex FFT of FFT_HALF_SIZE points on _re/_im */
+static void _cfft_half(void)
+{
+	uint16_t i, j, k, m, step;
+	float tr, ti;
+	
+	/* bit reversal */
+	for(i = 1, j = 0 ; i < FFT_HALF_SIZE ; i++){
+		for(k = FFT_HALF_SIZE >> 1 ; j & k ; k >>= 1)
+			j ^= k;
+		j |= k;
+		if(i < j){
+			tr = _re[i]; _re[i] = _re[j]; _re[j] = tr;
+			ti = _im[i]; _im[i] = _im[j]; _im[j] = ti;
+		}
+	}
+	
+	/* butterflies, twiddle of length m FFT is W_N^(k*N/m) */
+	for(m = 2 ; m <= FFT_HALF_SIZE ; m <<= 1){
+		step = DYN_NOTCH_FFT_SIZE / m;
+		for(k = 0 ; k < m/2 ; k++){
+			float wr = _cos[k*step];
+			float wi = -_sin[k*step];
+			for(i = k ; i < FFT_HALF_SIZE ; i += m){
+				j = i + m/2;
+				tr = wr*_re[j] - wi*_im[j];
+				ti = wr*_im[j] + wi*_re[j];
+				_re[j] = _re[i] - tr;
+				_im[j] = _im[i] - ti;
+				_re[i] += tr;
+				_im[i] += ti;
+			}
+		}
+	}
+}
+
+/* power spectrum of N real samples in bin [k_min, k_max], by packing them as N/2 complex samples */
+static void _rfft_power(const float* x, uint16_t k_min, uint16_t k_max)
+{
+	for(uint16_t k = 0 ; k < FFT_HALF_SIZE ; k++){
+		_re[k] = x[2*k];
+		_im[k] = x[2*k+1];
+	}
+	
+	_cfft_half();
+	
+	for(uint16_t k = k_min ; k <= k_max ; k++){
+		uint16_t nk = (FFT_HALF_SIZE - k) % FFT_HALF_SIZE;
+		/* even part: (Z[k] + conj(Z[M-k]))/2, odd part: (Z[k] - conj(Z[M-k]))/2j */
+		float e_re = 0.5f*(_re[k] + _re[nk]);
+		float e_im = 0.5f*(_im[k] - _im[nk]);
+		float o_re = 0.5f*(_im[k] + _im[nk]);
+		float o_im = -0.5f*(_re[k] - _re[nk]);
+		/* X[k] = E[k] + W_N^k * O[k] */
+		float wr = _cos[k];
+		float wi = -_sin[k];
+		float xr = e_re + wr*o_re - wi*o_im;
+		float xi = e_im + wr*o_im + wi*o_re;
+		_power[k] = xr*xr + xi*xi;
+	}
+}
+
+static void _dyn_notch_update_coef(DynNotch* dn, uint8_t axis, uint8_t n)
+{
+	float freq = dn->center_freq[axis][n];
+	float omega = 2.0f*PI*freq/dn->sample_freq;
+	float alpha = sinf(omega)/(2.0f*dn->q);
+	float a0 = 1.0f + alpha;
+	
+	dn->b0[axis][n] = 1.0f/a0;
+	dn->b1[axis][n] = -2.0f*cosf(omega)/a0;
+	dn->a2[axis][n] = (1.0f - alpha)/a0;
+}
+
+void dyn_notch_set_center_frequency(DynNotch* dn, uint8_t axis, uint8_t n, float center_freq)
+{
+	if(center_freq > 0.0f){
+		if(center_freq < dn->min_freq)
+			center_freq = dn->min_freq;
+		if(center_freq > dn->max_freq)
+			center_freq = dn->max_freq;
+	}else{
+		center_freq = 0.0f;
+	}
+	
+	dn->center_freq[axis][n] = center_freq;
+	if(center_freq > 0.0f){
+		_dyn_notch_update_coef(dn, axis, n);
+	}
+}
+
+void dyn_notch_init(DynNotch* dn, float sample_freq, float min_freq, float max_freq, float q, float analyse_freq)
+{
+	memset(dn, 0, sizeof(DynNotch));
+	
+	if(!_table_ready)
+		_dyn_notch_init_table();
+	
+	/* keep away from nyquist frequency */
+	if(max_freq > 0.45f*sample_freq)
+		max_freq = 0.45f*sample_freq;
+	dn->sample_freq = sample_freq;
+	dn->min_freq = min_freq;
+	dn->max_freq = max_freq;
+	dn->q = q;
+	dn->update_div = analyse_freq > 0.0f ? (uint16_t)(sample_freq/analyse_freq) : 0;
+	if(dn->update_div == 0)
+		dn->update_div = 1;
+	/* off until enabled by user */
+	dn->enable = 0;
+}
+
+void dyn_notch_enable(DynNotch* dn, uint8_t enable)
+{
+	/* peaks are searched again after enabled */
+	if(!enable){
+		memset(dn->center_freq, 0, sizeof(dn->center_freq));
+		memset(dn->miss_cnt, 0, sizeof(dn->miss_cnt));
+	}
+	dn->enable = enable;
+}
+
+/* find spectrum peaks of one axis and move notches to them */
+void dyn_notch_analyse(DynNotch* dn, uint8_t axis)
+{
+	static float x[DYN_NOTCH_FFT_SIZE];
+	float bin_freq = dn->sample_freq/DYN_NOTCH_FFT_SIZE;
+	uint16_t k_min = (uint16_t)(dn->min_freq/bin_freq);
+	uint16_t k_max = (uint16_t)(dn->max_freq/bin_freq) + 1;
+	uint16_t peak_bin[DYN_NOTCH_PEAK_NUM];
+	float peak_freq[DYN_NOTCH_PEAK_NUM];
+	uint8_t peak_num = 0;
+	uint8_t taken[DYN_NOTCH_PEAK_NUM];
+	float mean = 0.0f;
+	
+	/* one bin margin on each side for peak test and interpolation */
+	if(k_min < 2)
+		k_min = 2;
+	if(k_max > FFT_HALF_SIZE-2)
+		k_max = FFT_HALF_SIZE-2;
+	if(k_min >= k_max)
+		return;
+	
+	/* oldest sample first, remove mean and apply window */
+	for(uint16_t i = 0 ; i < DYN_NOTCH_FFT_SIZE ; i++){
+		x[i] = dn->buff[axis][(dn->buff_idx+i) % DYN_NOTCH_FFT_SIZE];
+		mean += x[i];
+	}
+	mean /= DYN_NOTCH_FFT_SIZE;
+	for(uint16_t i = 0 ; i < DYN_NOTCH_FFT_SIZE ; i++){
+		x[i] = (x[i] - mean) * _window[i];
+	}
+	
+	_rfft_power(x, k_min-1, k_max+1);
+	dn->fft_cnt++;
+	
+	mean = 0.0f;
+	for(uint16_t k = k_min ; k <= k_max ; k++){
+		mean += _power[k];
+	}
+	mean /= (k_max - k_min + 1);
+	
+	/* keep the largest local maxima, sorted by power */
+	for(uint16_t k = k_min ; k <= k_max ; k++){
+		if(_power[k] <= _power[k-1] || _power[k] < _power[k+1] || _power[k] < PEAK_POWER_RATIO*mean
+			|| _power[k] < PEAK_MIN_POWER)
+			continue;
+	
+		uint8_t pos = peak_num;
+		while(pos > 0 && _power[peak_bin[pos-1]] < _power[k]){
+			if(pos < DYN_NOTCH_PEAK_NUM)
+				peak_bin[pos] = peak_bin[pos-1];
+			pos--;
+		}
+		if(pos < DYN_NOTCH_PEAK_NUM){
+			peak_bin[pos] = k;
+			if(peak_num < DYN_NOTCH_PEAK_NUM)
+				peak_num++;
+		}
+	}
+	
+	/* quadratic interpolation on magnitude for sub-bin frequency */
+	for(uint8_t p = 0 ; p < peak_num ; p++){
+		uint16_t k = peak_bin[p];
+		float m0 = sqrtf(_power[k-1]);
+		float m1 = sqrtf(_power[k]);
+		float m2 = sqrtf(_power[k+1]);
+		float den = m0 - 2.0f*m1 + m2;
+		float delta = den < 0.0f ? 0.5f*(m0 - m2)/den : 0.0f;
+	
+		peak_freq[p] = (k + delta) * bin_freq;
+		taken[p] = 0;
+	}
+	
+	/* each tracking notch follows the nearest peak, so notches do not swap between peaks */
+	for(uint8_t n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++){
+		float center = dn->center_freq[axis][n];
+		int8_t best = -1;
+	
+		if(center <= 0.0f)
+			continue;
+		for(uint8_t p = 0 ; p < peak_num ; p++){
+			if(taken[p])
+				continue;
+			if(best < 0 || fabsf(peak_freq[p]-center) < fabsf(peak_freq[best]-center))
+				best = p;
+		}
+		if(best >= 0){
+			taken[best] = 1;
+			dn->miss_cnt[axis][n] = 0;
+			dyn_notch_set_center_frequency(dn, axis, n, center + CENTER_SMOOTH_ALPHA*(peak_freq[best]-center));
+		}else if(++dn->miss_cnt[axis][n] >= DYN_NOTCH_RELEASE_CNT){
+			/* peak is below threshold, stop cutting signal there */
+			dn->miss_cnt[axis][n] = 0;
+			dyn_notch_set_center_frequency(dn, axis, n, 0.0f);
+		}
+	}
+	/* new peaks take idle notches */
+	for(uint8_t p = 0 ; p < peak_num ; p++){
+		if(taken[p])
+			continue;
+		for(uint8_t n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++){
+			if(dn->center_freq[axis][n] <= 0.0f){
+				dn->miss_cnt[axis][n] = 0;
+				dyn_notch_set_center_frequency(dn, axis, n, peak_freq[p]);
+				break;
+			}
+		}
+	}
+}
+
+void dyn_notch_filter_process(DynNotch* dn, const float in[3], float out[3])
+{
+	float x, y;
+	
+	/* buffer raw samples for analysis */
+	dn->buff[0][dn->buff_idx] = in[0];
+	dn->buff[1][dn->buff_idx] = in[1];
+	dn->buff[2][dn->buff_idx] = in[2];
+	dn->buff_idx = (dn->buff_idx+1) % DYN_NOTCH_FFT_SIZE;
+	
+	if(++dn->sample_cnt >= dn->update_div){
+		dn->sample_cnt = 0;
+		if(dn->enable){
+			dyn_notch_analyse(dn, dn->axis);
+		}
+		dn->axis = (dn->axis+1) % 3;
+	}
+	
+	for(uint8_t i = 0 ; i < 3 ; i++){
+		x = in[i];
+		for(uint8_t n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++){
+			if(dn->enable && dn->center_freq[i][n] > 0.0f){
+				y = dn->b0[i][n]*(x + dn->x2[i][n]) + dn->b1[i][n]*(dn->x1[i][n] - dn->y1[i][n]) - dn->a2[i][n]*dn->y2[i][n];
+			}else{
+				/* bypass, keep delay elements going for a smooth start */
+				y = x;
+			}
+			dn->x2[i][n] = dn->x1[i][n];
+			dn->x1[i][n] = x;
+			dn->y2[i][n] = dn->y1[i][n];
+			dn->y1[i][n] = y;
+			x = y;
+		}
+		out[i] = x;
+	}
+}
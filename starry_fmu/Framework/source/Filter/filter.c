@@ -5,6 +5,7 @@
  * Date           Author       Notes
  * 2016-07-01     zoujiachi    first version.
  * 2017-09-06	  zoujiachi	   add butterworth filter and fir filter
+ * 2026-10-15	  StarryPilot	   filter x/y/z together with Biquad3
  */
 
 #include <math.h>
@@ -12,18 +13,40 @@
 #include "global.h"
 #include "sensor_manager.h"
 #include "butter.h"
+#include "biquad3.h"
+#include "dyn_notch.h"
+#include "param.h"
+
+#ifdef HIL_SIMULATION
+#define GYR_FILTER_SAMPLE_FREQ		250
+#define ACC_FILTER_SAMPLE_FREQ		250
+#else
+#define GYR_FILTER_SAMPLE_FREQ		1000
+#define ACC_FILTER_SAMPLE_FREQ		1000
+#endif
+#define MAG_FILTER_SAMPLE_FREQ		100
+
+#define GYR_FILTER_CUTOFF_FREQ		30
+#define ACC_FILTER_CUTOFF_FREQ		30
+#define MAG_FILTER_CUTOFF_FREQ		30
+
+/* number of cascaded 2nd order stages */
+#define SENSOR_FILTER_STAGE_NUM		1
+
+/* dynamic notch searches motor vibration in this band, each axis is analysed at GYR_NOTCH_ANALYSE_FREQ/3 */
+#define GYR_NOTCH_MIN_FREQ			80
+#define GYR_NOTCH_MAX_FREQ			400
+#define GYR_NOTCH_Q					3.0f
+#define GYR_NOTCH_ANALYSE_FREQ		90
 
 static float g_gyr[3];
 static float g_mag[3];
 static float g_acc[3];
 
-static Butter2 _butter_acc[3];
-static Butter2 _butter_gyr[3];
-static Butter2 _butter_mag[3];
-static Butter3* _butter3_gyr[3];
-static Butter3* _butter3_acc[3];
-static Butter3* _butter3_mag[3];
-
+static Biquad3 _biquad_acc;
+static Biquad3 _biquad_gyr;
+static Biquad3 _biquad_mag;
+static DynNotch _dyn_notch_gyr;
 
 float lpf_get_alpha(float cutoff_freq, float dt)
 {
@@ -33,51 +56,22 @@ float lpf_get_alpha(float cutoff_freq, float dt)
 
 void accfilter_init(void)
 {
-    for(int i=0;i<3;i++)
-		g_acc[i] = 0.0f;
+	const float init_val[3] = {0.0f, 0.0f, -9.8f};
 
-#ifdef HIL_SIMULATION
-//	/* 30Hz cut-off frequency, 250Hz sampling frequency */
-//	float B[4] = {0.0286, 0.0859, 0.0859, 0.0286};
-//	float A[4] = {1.0, -1.5189, 0.96, -0.2120};
-	butter2_set_cutoff_frequency(&_butter_acc[0], 250, 30);
-	butter2_set_cutoff_frequency(&_butter_acc[1], 250, 30);
-	butter2_set_cutoff_frequency(&_butter_acc[2], 250, 30);
-#else
-//	/* 30Hz cut-off frequency, 1000Hz sampling frequency */
-//	float B[4] = {0.0007, 0.0021, 0.0021, 0.0007};
-//	float A[4] = {1.0, -2.6236, 2.3147, -0.6855};
-	butter2_set_cutoff_frequency(&_butter_acc[0], 1000, 30);
-	butter2_set_cutoff_frequency(&_butter_acc[1], 1000, 30);
-	butter2_set_cutoff_frequency(&_butter_acc[2], 1000, 30);
-#endif
-//	_butter3_acc[0] = butter3_filter_create(B, A);
-//	_butter3_acc[1] = butter3_filter_create(B, A);
-//	_butter3_acc[2] = butter3_filter_create(B, A);
+	biquad3_init(&_biquad_acc, ACC_FILTER_SAMPLE_FREQ, ACC_FILTER_CUTOFF_FREQ, SENSOR_FILTER_STAGE_NUM);
 	
 	/* set initial data */
-	butter2_reset(&_butter_acc[0], 0);
-	butter2_reset(&_butter_acc[1], 0);
-	butter2_reset(&_butter_acc[2], -9.8f);
+	biquad3_reset(&_biquad_acc, init_val, g_acc);
+}
+
+void accfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq)
+{
+	biquad3_set_cutoff_frequency(&_biquad_acc, sample_freq, cutoff_freq);
 }
 
 void accfilter_input(const float val[3])
 {
-    for(uint8_t i=0;i<3;i++)
-    {
-#ifdef HIL_SIMULATION
-		// do not filter for HIL simulation
-//		g_acc[i] = val[i];
-		g_acc[i] = butter2_filter_process(&_butter_acc[i], val[i]);
-#else
-		//g_acc[i] = butter3_filter_process(val[i], _butter3_acc[i]);
-		g_acc[i] = butter2_filter_process(&_butter_acc[i], val[i]);
-		//g_acc[i] = val[i];
-#endif
-		//g_acc[i] = butter2_filter_process(&_butter_acc[i], val[i]);
-		//g_acc[i] = butter3_filter_process(val[i], _butter3_acc[i]);
-		//g_acc[i] = val[i];
-	}
+	biquad3_filter_process(&_biquad_acc, val, g_acc);
 }
 
 const float * accfilter_current(void)
@@ -96,51 +90,52 @@ void accfilter_read(float* acc)
 
 void gyrfilter_init(void)
 {
-    for(uint8_t i=0;i<3;i++)
-        g_gyr[i] = 0;
+	const float init_val[3] = {0.0f, 0.0f, 0.0f};
 
-#ifdef HIL_SIMULATION
-//	/* 30Hz cut-off frequency, 250Hz sampling frequency */
-//	float B[4] = {0.0286, 0.0859, 0.0859, 0.0286};
-//	float A[4] = {1.0, -1.5189, 0.96, -0.2120};
-	butter2_set_cutoff_frequency(&_butter_gyr[0], 250, 30);
-	butter2_set_cutoff_frequency(&_butter_gyr[1], 250, 30);
-	butter2_set_cutoff_frequency(&_butter_gyr[2], 250, 30);
-#else
-//	/* 30Hz cut-off frequency, 1000Hz sampling frequency */
-//	float B[4] = {0.0007, 0.0021, 0.0021, 0.0007};
-//	float A[4] = {1.0, -2.6236, 2.3147, -0.6855};
-	butter2_set_cutoff_frequency(&_butter_gyr[0], 1000, 30);
-	butter2_set_cutoff_frequency(&_butter_gyr[1], 1000, 30);
-	butter2_set_cutoff_frequency(&_butter_gyr[2], 1000, 30);
-#endif
-//	_butter3_gyr[0] = butter3_filter_create(B, A);
-//	_butter3_gyr[1] = butter3_filter_create(B, A);
-//	_butter3_gyr[2] = butter3_filter_create(B, A);
+	biquad3_init(&_biquad_gyr, GYR_FILTER_SAMPLE_FREQ, GYR_FILTER_CUTOFF_FREQ, SENSOR_FILTER_STAGE_NUM);
+	dyn_notch_init(&_dyn_notch_gyr, GYR_FILTER_SAMPLE_FREQ, GYR_NOTCH_MIN_FREQ, GYR_NOTCH_MAX_FREQ,
+					GYR_NOTCH_Q, GYR_NOTCH_ANALYSE_FREQ);
+	gyrfilter_dyn_notch_enable(PARAM_GET_INT32(SENSOR_FILTER, GYR_NOTCH_EN) != 0);
 	
 	/* set initial data */
-	butter2_reset(&_butter_gyr[0], 0);
-	butter2_reset(&_butter_gyr[1], 0);
-	butter2_reset(&_butter_gyr[2], 0);
+	biquad3_reset(&_biquad_gyr, init_val, g_gyr);
+}
+
+/* motor vibration is removed by the notches when enabled, so low pass cutoff is raised
+ * to GYR_NOTCH_LPF for less phase lag. Otherwise low pass has to hide it alone */
+void gyrfilter_dyn_notch_enable(uint8_t enable)
+{
+#ifndef HIL_SIMULATION
+	float cutoff_freq = GYR_FILTER_CUTOFF_FREQ;
+	
+	if(enable && PARAM_GET_FLOAT(SENSOR_FILTER, GYR_NOTCH_LPF) > GYR_FILTER_CUTOFF_FREQ)
+		cutoff_freq = PARAM_GET_FLOAT(SENSOR_FILTER, GYR_NOTCH_LPF);
+	dyn_notch_enable(&_dyn_notch_gyr, enable);
+	biquad3_set_cutoff_frequency(&_biquad_gyr, GYR_FILTER_SAMPLE_FREQ, cutoff_freq);
+#endif
+}
+
+float gyrfilter_dyn_notch_frequency(uint8_t axis, uint8_t n)
+{
+	return _dyn_notch_gyr.center_freq[axis][n];
+}
+
+void gyrfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq)
+{
+	biquad3_set_cutoff_frequency(&_biquad_gyr, sample_freq, cutoff_freq);
 }
 
 void gyrfilter_input(const float val[3])
 {
-    for(int i=0;i<3;i++)
-	{
 #ifdef HIL_SIMULATION
-		// do not filter for HIL simulation
-		//g_gyr[i] = val[i];
-		g_gyr[i] = butter2_filter_process(&_butter_gyr[i], val[i]);
+	biquad3_filter_process(&_biquad_gyr, val, g_gyr);
 #else
-		//g_gyr[i] = butter3_filter_process(val[i], _butter3_gyr[i]);
-		g_gyr[i] = butter2_filter_process(&_butter_gyr[i], val[i]);
-		//g_gyr[i] = val[i];
+	float notched[3];
+	
+	/* remove vibration peaks first, so low pass cutoff can stay high */
+	dyn_notch_filter_process(&_dyn_notch_gyr, val, notched);
+	biquad3_filter_process(&_biquad_gyr, notched, g_gyr);
 #endif
-		//g_gyr[i] = butter2_filter_process(&_butter_gyr[i], val[i]);
-		//g_gyr[i] = butter3_filter_process(val[i], _butter3_gyr[i]);
-		//g_gyr[i] = val[i];
-	}
 }
 
 const float* gyrfilter_current(void)
@@ -157,41 +152,29 @@ void gyrfilter_read(float* gyr)
 
 void magfilter_init(void)
 {
-    for(int i=0;i<3;i++)
-        g_mag[i] = 0;
-	
-//	/* 10Hz cut-off frequency, 100Hz sampling frequency */
-//	float B[4] = {0.0181, 0.0543, 0.0543, 0.0181};
-//	float A[4] = {1.0000, -1.7600, 1.1829, -0.2781};
-//	_butter3_mag[0] = butter3_filter_create(B, A);
-//	_butter3_mag[1] = butter3_filter_create(B, A);
-//	_butter3_mag[2] = butter3_filter_create(B, A);
-
-	butter2_set_cutoff_frequency(&_butter_mag[0], 100, 30);
-	butter2_set_cutoff_frequency(&_butter_mag[1], 100, 30);
-	butter2_set_cutoff_frequency(&_butter_mag[2], 100, 30);
+	const float init_val[3] = {0.0f, 0.7071f, 0.7071f};
+
+	biquad3_init(&_biquad_mag, MAG_FILTER_SAMPLE_FREQ, MAG_FILTER_CUTOFF_FREQ, SENSOR_FILTER_STAGE_NUM);
 	
 	/* set initial data */
-	butter2_reset(&_butter_mag[0], 0);
-	butter2_reset(&_butter_mag[1], 0.7071);
-	butter2_reset(&_butter_mag[2], 0.7071);
+	biquad3_reset(&_biquad_mag, init_val, g_mag);
+}
+
+void magfilter_set_cutoff_frequency(float sample_freq, float cutoff_freq)
+{
+	biquad3_set_cutoff_frequency(&_biquad_mag, sample_freq, cutoff_freq);
 }
 
 void magfilter_input(const float val[3])
 {
-    for(int i=0;i<3;i++){
 #ifdef HIL_SIMULATION
-		// do not filter for HIL simulation
-		g_mag[i] = val[i];
-		//g_mag[i] = butter2_filter_process(&_butter_mag[i], val[i]);
+	// do not filter for HIL simulation
+	g_mag[0] = val[0];
+	g_mag[1] = val[1];
+	g_mag[2] = val[2];
 #else
-		g_mag[i] = butter2_filter_process(&_butter_mag[i], val[i]);
-		//g_mag[i] = val[i];
+	biquad3_filter_process(&_biquad_mag, val, g_mag);
 #endif
-        //g_mag[i] = val[i];
-		//g_mag[i] = butter2_filter_process(&_butter_mag[i], val[i]);
-		//g_mag[i] = butter3_filter_process(val[i], _butter3_mag[i]);
-	}
 }
 
 const float * magfilter_current(void)
@@ -12,6 +12,10 @@
 
 #define MAX(x,y) (x > y ? x : y)
 
+/* use sparse covariance prediction instead of dense matrix multiplication */
+#define EKF_SPARSE_COV_PREDICT
+#define F_NZ_MAX	6
+
 // estimate covariance
 #define q_gx			0.0025
 #define q_gy			0.0025
@@ -73,6 +77,17 @@ static float32_t KY_Data[NUM_X];
 static float32_t KH_Data[NUM_X*NUM_X];
 static float32_t KHP_Data[NUM_X*NUM_X];
 
+#ifdef EKF_SPARSE_COV_PREDICT
+/* structural non-zero columns of F for each row, rows 10~13 are zero */
+static const uint8_t F_NZ_NUM[NUM_X] = {1, 1, 1, 5, 5, 5, 6, 6, 6, 6, 0, 0, 0, 0};
+static const uint8_t F_NZ_COL[NUM_X][F_NZ_MAX] = {
+	{3}, {4}, {5},
+	{6, 7, 8, 9, 13}, {6, 7, 8, 9, 13}, {6, 7, 8, 9, 13},
+	{7, 8, 9, 10, 11, 12}, {6, 8, 9, 10, 11, 12}, {6, 7, 9, 10, 11, 12}, {6, 7, 8, 10, 11, 12},
+	{0}, {0}, {0}, {0}
+};
+#endif
+
 
 void mat_fill_f32(arm_matrix_instance_f32* mat, float32_t val)
 {
@@ -98,6 +113,102 @@ void mat_fill_identity(arm_matrix_instance_f32* mat)
 
 ///////////////////////////////////////
 
+#ifdef EKF_SPARSE_COV_PREDICT
+/* P(k|k-1) = (I+F(k)*T)*P(k-1|k-1)*(I+F(k)*T)' + T^2*G*Q(k)*G'
+ * Only the structural non-zero entries of F are visited (see F_NZ_COL), P is
+ * symmetric so only the upper triangle is calculated and mirrored. G*Q*G' is
+ * block diagonal because gyr, acc and bias noise drive disjoint states, Q is
+ * diagonal. IFTP is used as scratch for (I+F*T)*P */
+static arm_status _ekf14_predict_cov(EKF_Def* ekf_t)
+{
+	float32_t* P = ekf_t->P.pData;
+	float32_t* F = ekf_t->F.pData;
+	float32_t* G = ekf_t->G.pData;
+	float32_t* Q = ekf_t->Q.pData;
+	float32_t* AP = ekf_t->IFTP.pData;
+	float32_t T = ekf_t->dT;
+	float32_t TT = T*T;
+	float32_t TF[NUM_X][F_NZ_MAX];
+	float32_t GQ[3];
+	float32_t sum;
+	uint8_t i, j, k, n;
+	
+	for(i = 0 ; i < NUM_X ; i++){
+		for(n = 0 ; n < F_NZ_NUM[i] ; n++)
+			TF[i][n] = T * F[i*NUM_X + F_NZ_COL[i][n]];
+	}
+	
+	/* AP = (I+F*T)*P */
+	for(i = 0 ; i < NUM_X ; i++){
+		for(j = 0 ; j < NUM_X ; j++){
+			sum = P[i*NUM_X + j];
+			for(n = 0 ; n < F_NZ_NUM[i] ; n++)
+				sum += TF[i][n] * P[F_NZ_COL[i][n]*NUM_X + j];
+			AP[i*NUM_X + j] = sum;
+		}
+	}
+	
+	/* P = AP*(I+F*T)', upper triangle */
+	for(i = 0 ; i < NUM_X ; i++){
+		for(j = i ; j < NUM_X ; j++){
+			sum = AP[i*NUM_X + j];
+			for(n = 0 ; n < F_NZ_NUM[j] ; n++)
+				sum += TF[j][n] * AP[i*NUM_X + F_NZ_COL[j][n]];
+			P[i*NUM_X + j] = sum;
+		}
+	}
+	
+	/* P += T^2*G*Q*G', acc block: states 3~5 with noise 3~5 */
+	for(i = STATE_VX ; i <= STATE_VZ ; i++){
+		for(k = 0 ; k < 3 ; k++)
+			GQ[k] = TT * G[i*NUM_W + 3+k] * Q[(3+k)*NUM_W + 3+k];
+		for(j = i ; j <= STATE_VZ ; j++)
+			P[i*NUM_X + j] += GQ[0]*G[j*NUM_W + 3] + GQ[1]*G[j*NUM_W + 4] + GQ[2]*G[j*NUM_W + 5];
+	}
+	/* quaternion block: states 6~9 with noise 0~2 */
+	for(i = STATE_Q0 ; i <= STATE_Q3 ; i++){
+		for(k = 0 ; k < 3 ; k++)
+			GQ[k] = TT * G[i*NUM_W + k] * Q[k*NUM_W + k];
+		for(j = i ; j <= STATE_Q3 ; j++)
+			P[i*NUM_X + j] += GQ[0]*G[j*NUM_W + 0] + GQ[1]*G[j*NUM_W + 1] + GQ[2]*G[j*NUM_W + 2];
+	}
+	/* bias block: states 10~13 with noise 6~9, G is identity here */
+	for(n = 0 ; n < 4 ; n++){
+		P[(STATE_GX_BIAS+n)*NUM_X + STATE_GX_BIAS+n] += TT * Q[(6+n)*NUM_W + 6+n];
+	}
+	
+	/* mirror upper triangle */
+	for(i = 1 ; i < NUM_X ; i++){
+		for(j = 0 ; j < i ; j++)
+			P[i*NUM_X + j] = P[j*NUM_X + i];
+	}
+	
+	return ARM_MATH_SUCCESS;
+}
+#else
+static arm_status _ekf14_predict_cov(EKF_Def* ekf_t)
+{
+	arm_status res = ARM_MATH_SUCCESS;
+	
+	res |= arm_mat_scale_f32(&ekf_t->F, ekf_t->dT, &ekf_t->IFT);
+	for(uint8_t n = 0 ; n < NUM_X ; n++){
+		MAT_ELEMENT(ekf_t->IFT, n, n) += 1.0f;
+	}
+	res |= arm_mat_trans_f32(&ekf_t->IFT, &ekf_t->IFTT);
+	res |= arm_mat_mult_f32(&ekf_t->IFT, &ekf_t->P, &ekf_t->IFTP);
+	res |= arm_mat_mult_f32(&ekf_t->IFTP, &ekf_t->IFTT, &ekf_t->IFTPIFTT);
+	
+	res |= arm_mat_mult_f32(&ekf_t->G, &ekf_t->Q, &ekf_t->GQ);
+	res |= arm_mat_trans_f32(&ekf_t->G, &ekf_t->GT);
+	res |= arm_mat_mult_f32(&ekf_t->GQ, &ekf_t->GT, &ekf_t->GQGT);
+	res |= arm_mat_scale_f32(&ekf_t->GQGT, ekf_t->dT*ekf_t->dT, &ekf_t->GQGT);
+	
+	res |= arm_mat_add_f32(&ekf_t->IFTPIFTT, &ekf_t->GQGT, &ekf_t->P);
+	
+	return res;
+}
+#endif
+
 uint8_t EKF14_Init(EKF_Def* ekf_t, float32_t dT)
 {
 	ekf_t->dT = dT;
@@ -345,23 +456,8 @@ uint8_t EKF14_Prediction(EKF_Def* ekf_t)
 	MAT_ELEMENT(ekf_t->X, STATE_Q2, 0) *= inv_norm;
 	MAT_ELEMENT(ekf_t->X, STATE_Q3, 0) *= inv_norm;
 	
-	arm_status res = ARM_MATH_SUCCESS;
-	
 	/* P(k|k-1) = (I+F(k)*T)*P(k-1|k-1)*(I+F(k)*T)' + T^2*G*Q(k)*G' */
-	res |= arm_mat_scale_f32(&ekf_t->F, ekf_t->dT, &ekf_t->IFT);
-	for(uint8_t n = 0 ; n < NUM_X ; n++){
-		MAT_ELEMENT(ekf_t->IFT, n, n) += 1.0f;
-	}
-	res |= arm_mat_trans_f32(&ekf_t->IFT, &ekf_t->IFTT);
-	res |= arm_mat_mult_f32(&ekf_t->IFT, &ekf_t->P, &ekf_t->IFTP);
-	res |= arm_mat_mult_f32(&ekf_t->IFTP, &ekf_t->IFTT, &ekf_t->IFTPIFTT);
-	
-	res |= arm_mat_mult_f32(&ekf_t->G, &ekf_t->Q, &ekf_t->GQ);
-	res |= arm_mat_trans_f32(&ekf_t->G, &ekf_t->GT);
-	res |= arm_mat_mult_f32(&ekf_t->GQ, &ekf_t->GT, &ekf_t->GQGT);
-	res |= arm_mat_scale_f32(&ekf_t->GQGT, ekf_t->dT*ekf_t->dT, &ekf_t->GQGT);
-	
-	res |= arm_mat_add_f32(&ekf_t->IFTPIFTT, &ekf_t->GQGT, &ekf_t->P);
+	arm_status res = _ekf14_predict_cov(ekf_t);
 	
 //	if(res != ARM_MATH_SUCCESS){
 //		Console.print("predict err:%d\n", res);
@@ -567,23 +663,8 @@ uint8_t EKF14_SerialPrediction(EKF_Def* ekf_t, uint32_t enable_bitmask)
 	MAT_ELEMENT(ekf_t->X, STATE_Q2, 0) *= inv_norm;
 	MAT_ELEMENT(ekf_t->X, STATE_Q3, 0) *= inv_norm;
 	
-	arm_status res = ARM_MATH_SUCCESS;
-	
 	/* P(k|k-1) = (I+F(k)*T)*P(k-1|k-1)*(I+F(k)*T)' + T^2*G*Q(k)*G' */
-	res |= arm_mat_scale_f32(&ekf_t->F, ekf_t->dT, &ekf_t->IFT);
-	for(uint8_t n = 0 ; n < NUM_X ; n++){
-		MAT_ELEMENT(ekf_t->IFT, n, n) += 1.0f;
-	}
-	res |= arm_mat_trans_f32(&ekf_t->IFT, &ekf_t->IFTT);
-	res |= arm_mat_mult_f32(&ekf_t->IFT, &ekf_t->P, &ekf_t->IFTP);
-	res |= arm_mat_mult_f32(&ekf_t->IFTP, &ekf_t->IFTT, &ekf_t->IFTPIFTT);
-	
-	res |= arm_mat_mult_f32(&ekf_t->G, &ekf_t->Q, &ekf_t->GQ);
-	res |= arm_mat_trans_f32(&ekf_t->G, &ekf_t->GT);
-	res |= arm_mat_mult_f32(&ekf_t->GQ, &ekf_t->GT, &ekf_t->GQGT);
-	res |= arm_mat_scale_f32(&ekf_t->GQGT, ekf_t->dT*ekf_t->dT, &ekf_t->GQGT);
-	
-	res |= arm_mat_add_f32(&ekf_t->IFTPIFTT, &ekf_t->GQGT, &ekf_t->P);
+	arm_status res = _ekf14_predict_cov(ekf_t);
 	
 //	if(res != ARM_MATH_SUCCESS){
 //		Console.print("predict err:%d\n", res);
@@ -74,9 +74,13 @@ void KF_Update(KF_Def* kf_t)
 		MatSub(&kf_t->z, &kf_t->x, &kf_t->y);
 		// S(k) = H(k)*P(k|k-1)*H(k)' + R(k)
 		MatAdd(&kf_t->P, &kf_t->R, &kf_t->S);
-		// K(k) = P(k|k-1)*H(k)'*S(k)^-1
-		MatInv(&kf_t->S, &kf_t->M_nn_1);
-		MatMul(&kf_t->P, &kf_t->M_nn_1, &kf_t->K);
+		// K(k) = P(k|k-1)*H(k)'*S(k)^-1, solve S(k)*K(k)' = P(k|k-1) by cholesky
+		if(MatCholesky(&kf_t->S)){
+			/* S is not positive definite, skip this update */
+			return;
+		}
+		MatCholeskySolve(&kf_t->S, &kf_t->P, &kf_t->M_nn_1);
+		MatTrans(&kf_t->M_nn_1, &kf_t->K);
 		// x(k|k) = x(k|k-1) + K(k)*y(k)
 		MatAdd(&kf_t->x, MatMul(&kf_t->K, &kf_t->y, &kf_t->M_n1_1), &kf_t->x);
 #ifdef USE_OPT_KF_GAIN
@@ -96,9 +100,14 @@ void KF_Update(KF_Def* kf_t)
 		// S(k) = H(k)*P(k|k-1)*H(k)' + R(k)
 		MatMul(MatMul(&kf_t->H, &kf_t->P, &kf_t->M_nn_1), MatTrans(&kf_t->H, &kf_t->M_nn_2), &kf_t->M_nn_3);
 		MatAdd(&kf_t->M_nn_3, &kf_t->R, &kf_t->S);
-		// K(k) = P(k|k-1)*H(k)'*S(k)^-1
-		MatMul(&kf_t->P, MatTrans(&kf_t->H, &kf_t->M_nn_1), &kf_t->M_nn_2);
-		MatMul(&kf_t->M_nn_2, MatInv(&kf_t->S, &kf_t->M_nn_1), &kf_t->K);
+		// K(k) = P(k|k-1)*H(k)'*S(k)^-1, solve S(k)*K(k)' = H(k)*P(k|k-1) by cholesky
+		if(MatCholesky(&kf_t->S)){
+			/* S is not positive definite, skip this update */
+			return;
+		}
+		MatMul(&kf_t->H, &kf_t->P, &kf_t->M_nn_2);
+		MatCholeskySolve(&kf_t->S, &kf_t->M_nn_2, &kf_t->M_nn_1);
+		MatTrans(&kf_t->M_nn_1, &kf_t->K);
 		// x(k|k) = x(k|k-1) + K(k)*y(k)
 		MatAdd(&kf_t->x, MatMul(&kf_t->K, &kf_t->y, &kf_t->M_n1_1), &kf_t->x);
 #ifdef USE_OPT_KF_GAIN
@@ -0,0 +1,165 @@
+/*
+ * File      : log_compress.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <string.h>
+#include "log_compress.h"
+#include "console.h"
+
+#ifdef RT_USING_LZO
+#include "minilzo.h"
+#endif
+#ifdef RT_USING_LIBZ
+#include "zlib.h"
+#endif
+
+/* raw deflate with 4K window and small hash keeps zlib state around 30K,
+ * blocks are compressed independently so a bigger window helps little */
+#define DEFLATE_LEVEL			6
+#define DEFLATE_WINDOW_BITS		12
+#define DEFLATE_MEM_LEVEL		4
+
+static char* TAG = "LogCompress";
+
+static const char* _method_name[LOG_COMPRESS_NUM] =
+{
+	"none",
+	"lzo",
+	"deflate",
+};
+
+static uint8_t _method = LOG_COMPRESS_NONE;
+
+#ifdef RT_USING_LZO
+static void* _lzo_wrkmem = NULL;
+#endif
+
+#ifdef RT_USING_LIBZ
+/* zlib allocates its state from rt heap by its default zcalloc */
+static z_stream _zs;
+#endif
+
+const char* log_compress_name(uint8_t method)
+{
+	return method < LOG_COMPRESS_NUM ? _method_name[method] : "unknown";
+}
+
+/* return LOG_COMPRESS_NUM if name is not a method */
+uint8_t log_compress_method(const char* name)
+{
+	for(uint8_t i = 0 ; i < LOG_COMPRESS_NUM ; i++){
+		if(strcmp(name, _method_name[i]) == 0)
+			return i;
+	}
+	
+	return LOG_COMPRESS_NUM;
+}
+
+/* allocate work memory of compressor, it is only held while logging */
+uint8_t log_compress_open(uint8_t method)
+{
+	log_compress_close();
+	
+	switch(method)
+	{
+		case LOG_COMPRESS_NONE:
+			break;
+#ifdef RT_USING_LZO
+		case LOG_COMPRESS_LZO:
+		{
+			if(lzo_init() != LZO_E_OK){
+				Console.e(TAG, "lzo init fail\n");
+				return 1;
+			}
+			_lzo_wrkmem = rt_malloc(LZO1X_1_MEM_COMPRESS);
+			if(_lzo_wrkmem == NULL){
+				Console.e(TAG, "fail to malloc lzo work memory:%d\n", LZO1X_1_MEM_COMPRESS);
+				return 1;
+			}
+		}break;
+#endif
+#ifdef RT_USING_LIBZ
+		case LOG_COMPRESS_DEFLATE:
+		{
+			memset(&_zs, 0, sizeof(_zs));
+			/* negative window bits for raw deflate, block header carries the sizes */
+			if(deflateInit2(&_zs, DEFLATE_LEVEL, Z_DEFLATED, -DEFLATE_WINDOW_BITS, DEFLATE_MEM_LEVEL,
+							Z_DEFAULT_STRATEGY) != Z_OK){
+				Console.e(TAG, "deflate init fail\n");
+				return 1;
+			}
+		}break;
+#endif
+		default:
+			Console.e(TAG, "compress method %s is not supported\n", log_compress_name(method));
+			return 1;
+	}
+	
+	_method = method;
+	
+	return 0;
+}
+
+void log_compress_close(void)
+{
+#ifdef RT_USING_LZO
+	if(_lzo_wrkmem){
+		rt_free(_lzo_wrkmem);
+		_lzo_wrkmem = NULL;
+	}
+#endif
+#ifdef RT_USING_LIBZ
+	if(_method == LOG_COMPRESS_DEFLATE){
+		deflateEnd(&_zs);
+	}
+#endif
+	_method = LOG_COMPRESS_NONE;
+}
+
+/* Compress one block independently of others. out must hold LOG_COMPRESS_BOUND(in_size).
+ * Return compressed size, or 0 if data does not shrink and should be stored as it is.
+ */
+uint32_t log_compress_block(const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t out_size)
+{
+	if(in_size == 0)
+		return 0;
+	
+	switch(_method)
+	{
+#ifdef RT_USING_LZO
+		case LOG_COMPRESS_LZO:
+		{
+			lzo_uint out_len = out_size;
+	
+			if(out_size < LOG_COMPRESS_BOUND(in_size))
+				return 0;
+			if(lzo1x_1_compress(in, in_size, out, &out_len, _lzo_wrkmem) != LZO_E_OK || out_len >= in_size)
+				return 0;
+	
+			return out_len;
+		}
+#endif
+#ifdef RT_USING_LIBZ
+		case LOG_COMPRESS_DEFLATE:
+		{
+			deflateReset(&_zs);
+			_zs.next_in = (Bytef*)in;
+			_zs.avail_in = in_size;
+			_zs.next_out = out;
+			/* output which does not shrink is useless */
+			_zs.avail_out = out_size < in_size ? out_size : in_size - 1;
+			if(deflate(&_zs, Z_FINISH) != Z_STREAM_END)
+				return 0;
+	
+			return _zs.total_out;
+		}
+#endif
+		default:
+			return 0;
+	}
+}
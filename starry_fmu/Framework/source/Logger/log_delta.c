@@ -0,0 +1,131 @@
+/*
+ * File      : log_delta.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <string.h>
+#include "log_delta.h"
+
+/* Body of a delta record:
+ * varint(timestamp - previous timestamp)
+ * word_num * varint(zigzag(word - previous word))
+ * Words are taken as integers, so a slowly changing float of the same sign and
+ * exponent gives a small difference of its bit pattern. Unchanged words cost 1 byte.
+ */
+
+static uint8_t* _put_varint(uint8_t* p, uint32_t val)
+{
+	while(val >= 0x80){
+		*p++ = (uint8_t)val | 0x80;
+		val >>= 7;
+	}
+	*p++ = (uint8_t)val;
+	
+	return p;
+}
+
+/* return NULL if input ends or value exceeds 32 bits */
+static const uint8_t* _get_varint(const uint8_t* p, const uint8_t* end, uint32_t* val)
+{
+	uint32_t v = 0;
+	
+	for(uint8_t shift = 0 ; shift < 35 ; shift += 7){
+		if(p >= end)
+			return NULL;
+		v |= (uint32_t)(*p & 0x7F) << shift;
+		if(!(*p++ & 0x80)){
+			*val = v;
+			return p;
+		}
+	}
+	
+	return NULL;
+}
+
+void log_delta_init(log_delta_t* d, uint32_t* prev, uint16_t word_num)
+{
+	d->prev = prev;
+	d->word_num = word_num;
+	log_delta_reset(d);
+}
+
+/* next record will be a key record */
+void log_delta_reset(log_delta_t* d)
+{
+	d->valid = 0;
+	d->delta_cnt = 0;
+}
+
+/* Encode a record against the previous one. Return body size, or 0 if a key
+ * record should be written instead, then caller must call log_delta_key().
+ * Delta record header is 4 bytes shorter than a plain one, so a body longer
+ * than payload + 3 is not worth it.
+ */
+uint32_t log_delta_encode(log_delta_t* d, uint32_t timestamp, const void* payload, uint8_t* out, uint32_t out_size)
+{
+	const uint8_t* src = (const uint8_t*)payload;
+	uint8_t* p = out;
+	uint32_t word;
+	int32_t diff;
+	
+	if(!d->valid || d->delta_cnt >= LOG_DELTA_KEY_INTERVAL || out_size < LOG_DELTA_BOUND(d->word_num))
+		return 0;
+	
+	p = _put_varint(p, timestamp - d->prev_time);
+	for(uint16_t i = 0 ; i < d->word_num ; i++){
+		/* payload of a message struct is not always word aligned on stack */
+		memcpy(&word, &src[4*i], sizeof(word));
+		diff = (int32_t)(word - d->prev[i]);
+		p = _put_varint(p, ((uint32_t)diff << 1) ^ (uint32_t)(diff >> 31));
+		d->prev[i] = word;
+	}
+	d->prev_time = timestamp;
+	d->delta_cnt++;
+	
+	if(p - out >= 4*d->word_num + 4)
+		return 0;
+	
+	return p - out;
+}
+
+void log_delta_key(log_delta_t* d, uint32_t timestamp, const void* payload)
+{
+	memcpy(d->prev, payload, 4*d->word_num);
+	d->prev_time = timestamp;
+	d->delta_cnt = 0;
+	d->valid = 1;
+}
+
+/* Decode a delta record body. Return consumed size, or 0 if body is broken
+ * or no key record is seen yet.
+ */
+uint32_t log_delta_decode(log_delta_t* d, const uint8_t* in, uint32_t in_size, uint32_t* timestamp, void* payload)
+{
+	const uint8_t* p = in;
+	const uint8_t* end = in + in_size;
+	uint32_t val;
+	
+	if(!d->valid)
+		return 0;
+	
+	p = _get_varint(p, end, &val);
+	if(p == NULL)
+		return 0;
+	*timestamp = d->prev_time + val;
+	for(uint16_t i = 0 ; i < d->word_num ; i++){
+		p = _get_varint(p, end, &val);
+		if(p == NULL){
+			/* state is half updated, wait for next key record */
+			d->valid = 0;
+			return 0;
+		}
+		d->prev[i] += (val >> 1) ^ (0u - (val & 1));
+	}
+	d->prev_time = *timestamp;
+	memcpy(payload, d->prev, 4*d->word_num);
+	
+	return p - in;
+}
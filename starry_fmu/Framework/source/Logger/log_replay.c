@@ -0,0 +1,714 @@
+/*
+ * File      : log_replay.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "log_replay.h"
+#include "logger.h"
+#include "log_delta.h"
+#include "console.h"
+#include "delay.h"
+#include "uMCN.h"
+#include "sensor_manager.h"
+#include "att_estimator.h"
+#include "pos_estimator.h"
+#include "state_est.h"
+#include "copter_main.h"
+#include "gps.h"
+
+/* Replay runs on SITL only. Records of a log file are republished into the
+ * sensor topics and the estimators are stepped with the log time stamp, as
+ * fast as the host can go. Estimator outputs are written to a new log. */
+
+#define REPLAY_IO_BUFFER_SIZE		(64*1024)
+#define REPLAY_LEGACY_MSG_ID		0
+#define REPLAY_GPS_FIX_CNT			10
+
+#define REPLAY_TOPIC_GYR			(1<<0)
+#define REPLAY_TOPIC_ACC			(1<<1)
+#define REPLAY_TOPIC_MAG			(1<<2)
+#define REPLAY_TOPIC_RAW_ACC		(1<<3)
+#define REPLAY_TOPIC_RAW_MAG		(1<<4)
+#define REPLAY_TOPIC_BARO			(1<<5)
+#define REPLAY_TOPIC_GPS			(1<<6)
+
+/* output log message id */
+enum
+{
+	REPLAY_MSG_ATT = 1,
+	REPLAY_MSG_POS,
+	REPLAY_MSG_EKF,
+};
+
+typedef struct
+{
+	float gyr[3];
+	float acc[3];
+	float mag[3];
+	float raw_acc[3];
+	float raw_mag[3];
+	float baro_alt;
+	float baro_vel;
+	float gps_lat;
+	float gps_lon;
+	float gps_vel[3];
+	float gps_hdop;
+}REPLAY_InputDef;
+
+typedef struct
+{
+	const char* name;
+	float* dst;
+	uint32_t topic;
+	/* resolved from log header */
+	bool found;
+	uint8_t msg_id;
+	uint16_t offset;
+}REPLAY_ChanDef;
+
+typedef struct
+{
+	LOG_ELEMENT_FLOAT(QUATERNION_W);
+	LOG_ELEMENT_FLOAT(QUATERNION_X);
+	LOG_ELEMENT_FLOAT(QUATERNION_Y);
+	LOG_ELEMENT_FLOAT(QUATERNION_Z);
+	LOG_ELEMENT_FLOAT(X);
+	LOG_ELEMENT_FLOAT(Y);
+	LOG_ELEMENT_FLOAT(Z);
+	LOG_ELEMENT_FLOAT(VX);
+	LOG_ELEMENT_FLOAT(VY);
+	LOG_ELEMENT_FLOAT(VZ);
+}REPLAY_EkfDef;
+
+MCN_DECLARE(SENSOR_ACC);
+MCN_DECLARE(SENSOR_MAG);
+MCN_DECLARE(SENSOR_FILTER_GYR);
+MCN_DECLARE(SENSOR_FILTER_ACC);
+MCN_DECLARE(SENSOR_FILTER_MAG);
+MCN_DECLARE(BARO_POSITION);
+MCN_DECLARE(GPS_POSITION);
+MCN_DECLARE(GPS_STATUS);
+MCN_DECLARE(ATT_QUATERNION);
+MCN_DECLARE(ATT_EULER);
+MCN_DECLARE(POS_KF);
+
+static char* TAG = "Replay";
+
+static const char* _in_file = NULL;
+static const char* _out_file = NULL;
+
+static FILE* _in_fp;
+static FILE* _out_fp;
+static char _in_io_buffer[REPLAY_IO_BUFFER_SIZE];
+static char _out_io_buffer[REPLAY_IO_BUFFER_SIZE];
+
+static REPLAY_InputDef _input;
+static uint32_t _updated_topic;
+static GPS_Status _gps_status;
+static bool _att_reset;
+static LOG_ReplayStatusDef _status;
+
+/* log time */
+static bool _legacy_log;
+static LOG_LegacyHeaderDef _legacy_header;
+static uint16_t _payload_size[256];
+static log_delta_t _delta[LOG_MAX_MSG_NUM+1];
+static uint32_t _delta_prev[LOG_MAX_MSG_NUM+1][LOG_MAX_PAYLOAD_SIZE/4];
+static uint64_t _time_base_us;
+static uint32_t _last_stamp;
+static uint64_t _now_us;
+
+static REPLAY_ChanDef _chan_list[] =
+{
+	{"GYR_FILTER_X", &_input.gyr[0], REPLAY_TOPIC_GYR},
+	{"GYR_FILTER_Y", &_input.gyr[1], REPLAY_TOPIC_GYR},
+	{"GYR_FILTER_Z", &_input.gyr[2], REPLAY_TOPIC_GYR},
+	{"ACC_FILTER_X", &_input.acc[0], REPLAY_TOPIC_ACC},
+	{"ACC_FILTER_Y", &_input.acc[1], REPLAY_TOPIC_ACC},
+	{"ACC_FILTER_Z", &_input.acc[2], REPLAY_TOPIC_ACC},
+	{"MAG_FILTER_X", &_input.mag[0], REPLAY_TOPIC_MAG},
+	{"MAG_FILTER_Y", &_input.mag[1], REPLAY_TOPIC_MAG},
+	{"MAG_FILTER_Z", &_input.mag[2], REPLAY_TOPIC_MAG},
+	{"ACC_X", &_input.raw_acc[0], REPLAY_TOPIC_RAW_ACC},
+	{"ACC_Y", &_input.raw_acc[1], REPLAY_TOPIC_RAW_ACC},
+	{"ACC_Z", &_input.raw_acc[2], REPLAY_TOPIC_RAW_ACC},
+	{"MAG_X", &_input.raw_mag[0], REPLAY_TOPIC_RAW_MAG},
+	{"MAG_Y", &_input.raw_mag[1], REPLAY_TOPIC_RAW_MAG},
+	{"MAG_Z", &_input.raw_mag[2], REPLAY_TOPIC_RAW_MAG},
+	{"BARO_ALT", &_input.baro_alt, REPLAY_TOPIC_BARO},
+	{"BARO_VEL", &_input.baro_vel, REPLAY_TOPIC_BARO},
+	{"GPS_LAT", &_input.gps_lat, REPLAY_TOPIC_GPS},
+	{"GPS_LON", &_input.gps_lon, REPLAY_TOPIC_GPS},
+	{"GPS_VN", &_input.gps_vel[0], REPLAY_TOPIC_GPS},
+	{"GPS_VE", &_input.gps_vel[1], REPLAY_TOPIC_GPS},
+	{"GPS_VD", &_input.gps_vel[2], REPLAY_TOPIC_GPS},
+	{"GPS_HDOP", &_input.gps_hdop, REPLAY_TOPIC_GPS},
+};
+#define REPLAY_CHAN_NUM		(sizeof(_chan_list)/sizeof(REPLAY_ChanDef))
+
+static const LOG_ElementInfoDef att_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_W),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_X),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_Y),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_Z),
+	LOG_ELEMENT_INFO_FLOAT(ROLL),
+	LOG_ELEMENT_INFO_FLOAT(PITCH),
+	LOG_ELEMENT_INFO_FLOAT(YAW),
+};
+
+static const LOG_ElementInfoDef pos_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(X),
+	LOG_ELEMENT_INFO_FLOAT(Y),
+	LOG_ELEMENT_INFO_FLOAT(Z),
+	LOG_ELEMENT_INFO_FLOAT(VX),
+	LOG_ELEMENT_INFO_FLOAT(VY),
+	LOG_ELEMENT_INFO_FLOAT(VZ),
+};
+
+static const LOG_ElementInfoDef ekf_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_W),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_X),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_Y),
+	LOG_ELEMENT_INFO_FLOAT(QUATERNION_Z),
+	LOG_ELEMENT_INFO_FLOAT(X),
+	LOG_ELEMENT_INFO_FLOAT(Y),
+	LOG_ELEMENT_INFO_FLOAT(Z),
+	LOG_ELEMENT_INFO_FLOAT(VX),
+	LOG_ELEMENT_INFO_FLOAT(VY),
+	LOG_ELEMENT_INFO_FLOAT(VZ),
+};
+
+/* message list, must be in the same order as message id */
+static LOG_MsgInfoDef _out_msg_list[] =
+{
+	LOG_MSG_INFO(REPLAY_MSG_ATT, ATT, LOG_AttDef, att_element_list, 0),
+	LOG_MSG_INFO(REPLAY_MSG_POS, POS, LOG_PosDef, pos_element_list, 0),
+	LOG_MSG_INFO(REPLAY_MSG_EKF, EKF, REPLAY_EkfDef, ekf_element_list, 0),
+};
+#define REPLAY_MSG_NUM		(sizeof(_out_msg_list)/sizeof(LOG_MsgInfoDef))
+
+static uint32_t _element_size(uint32_t type)
+{
+	switch(type)
+	{
+		case LOG_INT8:
+		case LOG_UINT8:
+			return 1;
+		case LOG_INT16:
+		case LOG_UINT16:
+			return 2;
+		case LOG_DOUBLE:
+			return 8;
+		default:
+			return 4;
+	}
+}
+
+static void _bind_element(const LOG_ElementInfoDef* element, uint8_t msg_id, uint16_t offset)
+{
+	for(uint32_t i = 0 ; i < REPLAY_CHAN_NUM ; i++){
+		/* the first match wins, filtered data is also logged in several messages */
+		if(_chan_list[i].found || strncmp(_chan_list[i].name, element->name, LOG_MAX_NAME_LENGTH) != 0)
+			continue;
+		if(element->type != LOG_FLOAT)
+			continue;
+		_chan_list[i].found = true;
+		_chan_list[i].msg_id = msg_id;
+		_chan_list[i].offset = offset;
+	}
+}
+
+static uint8_t _parse_header(void)
+{
+	LOG_HeaderDef header;
+	LOG_FormatDef format;
+	LOG_ElementInfoDef element;
+	uint32_t magic;
+	uint32_t offset;
+	
+	memset(_payload_size, 0, sizeof(_payload_size));
+	for(uint32_t i = 0 ; i < REPLAY_CHAN_NUM ; i++)
+		_chan_list[i].found = false;
+	
+	if(fread(&magic, sizeof(magic), 1, _in_fp) != 1)
+		return 1;
+	rewind(_in_fp);
+	
+	if(magic == LOG_BLOCK_MAGIC){
+		Console.print("compressed log, unpack it with tool/LogCompress/logz first\n");
+		return 2;
+	}
+	
+	if(magic != LOG_MAGIC){
+		/* version 1 log has no magic, it starts with the start time */
+		if(fread(&_legacy_header, sizeof(_legacy_header), 1, _in_fp) != 1)
+			return 1;
+		if(_legacy_header.field_size == 0 || _legacy_header.field_size > LOG_MAX_ELEMENT_NUM*sizeof(float)
+			|| _legacy_header.element_num > LOG_MAX_ELEMENT_NUM)
+			return 2;
+	
+		offset = 0;
+		for(uint32_t i = 0 ; i < _legacy_header.element_num ; i++){
+			if(fread(&element, sizeof(element), 1, _in_fp) != 1)
+				return 1;
+			element.name[LOG_MAX_NAME_LENGTH-1] = '\0';
+			_bind_element(&element, REPLAY_LEGACY_MSG_ID, offset);
+			offset += _element_size(element.type);
+		}
+		/* elements must lie in the row, they are read at these offsets */
+		if(offset > _legacy_header.field_size)
+			return 2;
+		_legacy_log = true;
+		_time_base_us = (uint64_t)_legacy_header.start_time*1000;
+	
+		return fseek(_in_fp, _legacy_header.header_size, SEEK_SET) == 0 ? 0 : 1;
+	}
+	
+	if(fread(&header, sizeof(header), 1, _in_fp) != 1)
+		return 1;
+	if(header.version != LOG_VERSION)
+		return 2;
+	
+	for(uint32_t n = 0 ; n < header.msg_num ; n++){
+		if(fread(&format, sizeof(format), 1, _in_fp) != 1)
+			return 1;
+		/* a message may only be described once, channels are bound to its layout */
+		if(format.payload_size > LOG_MAX_PAYLOAD_SIZE || _payload_size[format.msg_id] != 0)
+			return 2;
+		_payload_size[format.msg_id] = format.payload_size;
+		if(format.msg_id <= LOG_MAX_MSG_NUM){
+			log_delta_init(&_delta[format.msg_id], _delta_prev[format.msg_id],
+							format.payload_size % 4 == 0 ? format.payload_size/4 : 0);
+		}
+	
+		offset = 0;
+		for(uint32_t i = 0 ; i < format.element_num ; i++){
+			if(fread(&element, sizeof(element), 1, _in_fp) != 1)
+				return 1;
+			element.name[LOG_MAX_NAME_LENGTH-1] = '\0';
+			_bind_element(&element, format.msg_id, offset);
+			offset += _element_size(element.type);
+		}
+		if(offset > format.payload_size)
+			return 2;
+	}
+	_legacy_log = false;
+	_time_base_us = 0;
+	_last_stamp = 0;
+	
+	return fseek(_in_fp, header.header_size, SEEK_SET) == 0 ? 0 : 1;
+}
+
+/* read next record and update log time, return 0 at the end of file */
+static int _read_record(uint8_t* msg_id, uint8_t* payload)
+{
+	LOG_RecordHeaderDef header;
+	uint32_t timestamp;
+	size_t n;
+	
+	if(_legacy_log){
+		if(fread(payload, _legacy_header.field_size, 1, _in_fp) != 1)
+			return 0;
+		*msg_id = REPLAY_LEGACY_MSG_ID;
+		_now_us = _time_base_us + (uint64_t)_status.record_cnt*_legacy_header.log_period*1000;
+	
+		return 1;
+	}
+	
+	/* a delta record may be shorter than a plain header at the end of file */
+	while((n = fread(&header, 1, sizeof(header), _in_fp)) >= sizeof(LOG_DeltaHeaderDef)){
+		if(n < sizeof(header) && header.sync != LOG_RECORD_SYNC_DELTA)
+			return 0;
+		if(header.sync == LOG_RECORD_SYNC_DELTA){
+			LOG_DeltaHeaderDef* delta_header = (LOG_DeltaHeaderDef*)&header;
+			uint8_t body[LOG_DELTA_BOUND(LOG_MAX_PAYLOAD_SIZE/4)];
+			uint16_t body_size = delta_header->body_size;
+	
+			*msg_id = delta_header->msg_id;
+			if(*msg_id > LOG_MAX_MSG_NUM || body_size == 0 || body_size > sizeof(body)){
+				_status.skip_cnt++;
+				fseek(_in_fp, 1-(long)n, SEEK_CUR);
+				continue;
+			}
+			/* delta header is shorter, part of body is already read */
+			fseek(_in_fp, (long)sizeof(LOG_DeltaHeaderDef)-(long)n, SEEK_CUR);
+			if(fread(body, body_size, 1, _in_fp) != 1)
+				return 0;
+			if(log_delta_decode(&_delta[*msg_id], body, body_size, &timestamp, payload) != body_size){
+				/* no plain record of this message is seen yet or body is broken */
+				_status.skip_cnt++;
+				continue;
+			}
+		}else if(header.sync == LOG_RECORD_SYNC_MARK){
+			LOG_SyncDef mark;
+	
+			/* records after a marker are decoded as before, just skip it */
+			memcpy(&mark, &header, sizeof(header));
+			if(fread((uint8_t*)&mark + sizeof(header), sizeof(mark) - sizeof(header), 1, _in_fp) != 1)
+				return 0;
+			if(mark.magic != LOG_SYNC_MAGIC){
+				_status.skip_cnt++;
+				fseek(_in_fp, 1-(long)sizeof(mark), SEEK_CUR);
+			}
+			continue;
+		}else if(header.sync == LOG_RECORD_SYNC_INDEX){
+			LOG_IndexHeaderDef* index = (LOG_IndexHeaderDef*)&header;
+			long pos = ftell(_in_fp);
+	
+			/* index footer follows the last record and ends the file */
+			fseek(_in_fp, 0, SEEK_END);
+			if(pos - (long)sizeof(header) + sizeof(LOG_IndexHeaderDef) + index->entry_num*sizeof(LOG_IndexEntryDef)
+				+ sizeof(LOG_IndexTailDef) == ftell(_in_fp))
+				return 0;
+			_status.skip_cnt++;
+			fseek(_in_fp, pos + 1-(long)sizeof(header), SEEK_SET);
+			continue;
+		}else if(header.sync != LOG_RECORD_SYNC || header.payload_size > LOG_MAX_PAYLOAD_SIZE){
+			/* lost sync, step one byte and search the next record */
+			_status.skip_cnt++;
+			fseek(_in_fp, 1-(long)sizeof(header), SEEK_CUR);
+			continue;
+		}else{
+			if(fread(payload, header.payload_size, 1, _in_fp) != 1)
+				return 0;
+			if(header.payload_size != _payload_size[header.msg_id]){
+				_status.skip_cnt++;
+				if(header.msg_id <= LOG_MAX_MSG_NUM)
+					log_delta_reset(&_delta[header.msg_id]);
+				continue;
+			}
+			*msg_id = header.msg_id;
+			timestamp = header.timestamp;
+			if(*msg_id <= LOG_MAX_MSG_NUM)
+				log_delta_key(&_delta[*msg_id], timestamp, payload);
+		}
+	
+		/* queued topics are recorded with publish time, so stamps may step back a little */
+		if(timestamp < _last_stamp && _last_stamp - timestamp > 0x80000000u)
+			_time_base_us += 0x100000000ull;
+		_last_stamp = timestamp;
+		if(_time_base_us + timestamp > _now_us)
+			_now_us = _time_base_us + timestamp;
+	
+		return 1;
+	}
+	
+	return 0;
+}
+
+static void _apply_record(uint8_t msg_id, const uint8_t* payload)
+{
+	uint32_t size = _legacy_log ? _legacy_header.field_size : _payload_size[msg_id];
+	
+	for(uint32_t i = 0 ; i < REPLAY_CHAN_NUM ; i++){
+		if(!_chan_list[i].found || _chan_list[i].msg_id != msg_id)
+			continue;
+		if(_chan_list[i].offset + sizeof(float) > size)
+			continue;
+		memcpy(_chan_list[i].dst, &payload[_chan_list[i].offset], sizeof(float));
+		_updated_topic |= _chan_list[i].topic;
+	}
+}
+
+static void _publish_gps(uint32_t now_ms)
+{
+	struct vehicle_gps_position_s gps_pos;
+	bool valid = _input.gps_hdop > 0.0f && _input.gps_lat != 0.0f;
+	
+	memset(&gps_pos, 0, sizeof(gps_pos));
+	gps_pos.timestamp_position = now_ms;
+	gps_pos.timestamp_velocity = now_ms;
+	gps_pos.lat = (int32_t)((double)_input.gps_lat*1e7);
+	gps_pos.lon = (int32_t)((double)_input.gps_lon*1e7);
+	gps_pos.vel_n_m_s = _input.gps_vel[0];
+	gps_pos.vel_e_m_s = _input.gps_vel[1];
+	gps_pos.vel_d_m_s = _input.gps_vel[2];
+	gps_pos.vel_ned_valid = valid;
+	gps_pos.hdop = _input.gps_hdop;
+	gps_pos.eph = _input.gps_hdop;
+	gps_pos.fix_type = valid ? 3 : 0;
+	/* satellite number is not logged */
+	gps_pos.satellites_used = valid ? 10 : 0;
+	mcn_publish(MCN_ID(GPS_POSITION), &gps_pos);
+	
+	/* same availability check as sensor_collect() */
+	if(_gps_status.status != GPS_AVAILABLE && valid){
+		if(++_gps_status.fix_cnt >= REPLAY_GPS_FIX_CNT){
+			_gps_status.status = GPS_AVAILABLE;
+			mcn_publish(MCN_ID(GPS_STATUS), &_gps_status);
+		}
+	}
+	if(_gps_status.status != GPS_INAVAILABLE && !valid){
+		_gps_status.status = GPS_INAVAILABLE;
+		_gps_status.fix_cnt = 0;
+		mcn_publish(MCN_ID(GPS_STATUS), &_gps_status);
+	}
+}
+
+static void _publish_input(uint32_t now_ms)
+{
+	if(_updated_topic & REPLAY_TOPIC_GYR)
+		mcn_publish(MCN_ID(SENSOR_FILTER_GYR), _input.gyr);
+	if(_updated_topic & REPLAY_TOPIC_ACC)
+		mcn_publish(MCN_ID(SENSOR_FILTER_ACC), _input.acc);
+	if(_updated_topic & REPLAY_TOPIC_MAG)
+		mcn_publish(MCN_ID(SENSOR_FILTER_MAG), _input.mag);
+	if(_updated_topic & REPLAY_TOPIC_RAW_ACC)
+		mcn_publish(MCN_ID(SENSOR_ACC), _input.raw_acc);
+	if(_updated_topic & REPLAY_TOPIC_RAW_MAG)
+		mcn_publish(MCN_ID(SENSOR_MAG), _input.raw_mag);
+	if(_updated_topic & REPLAY_TOPIC_BARO){
+		BaroPosition baro_pos;
+		baro_pos.altitude = _input.baro_alt;
+		baro_pos.velocity = _input.baro_vel;
+		baro_pos.time_stamp = now_ms;
+		mcn_publish(MCN_ID(BARO_POSITION), &baro_pos);
+	}
+	if(_updated_topic & REPLAY_TOPIC_GPS)
+		_publish_gps(now_ms);
+	
+	/* start attitude from the first logged acc and mag */
+	if(!_att_reset && (_updated_topic & REPLAY_TOPIC_RAW_ACC) && (_updated_topic & REPLAY_TOPIC_RAW_MAG)){
+		attitude_est_reset();
+		_att_reset = true;
+	}
+	
+	_updated_topic = 0;
+}
+
+static uint8_t _write_msg(uint8_t msg_id, const void* payload)
+{
+	LOG_RecordHeaderDef header;
+	LOG_MsgInfoDef* msg = &_out_msg_list[msg_id-1];
+	
+	header.sync = LOG_RECORD_SYNC;
+	header.msg_id = msg_id;
+	header.payload_size = msg->payload_size;
+	header.timestamp = (uint32_t)_now_us;
+	msg->record_cnt++;
+	
+	if(fwrite(&header, sizeof(header), 1, _out_fp) != 1)
+		return 1;
+	if(fwrite(payload, msg->payload_size, 1, _out_fp) != 1)
+		return 1;
+	
+	return 0;
+}
+
+static uint8_t _write_header(void)
+{
+	LOG_HeaderDef header;
+	LOG_FormatDef format;
+	uint8_t res = 0;
+	
+	header.magic = LOG_MAGIC;
+	header.version = LOG_VERSION;
+	header.msg_num = REPLAY_MSG_NUM;
+	header.start_time = (uint32_t)(_now_us/1000);
+	header.header_size = sizeof(LOG_HeaderDef);
+	for(int i = 0 ; i < REPLAY_MSG_NUM ; i++){
+		header.header_size += sizeof(LOG_FormatDef) + _out_msg_list[i].element_num*sizeof(LOG_ElementInfoDef);
+	}
+	res |= fwrite(&header, sizeof(header), 1, _out_fp) != 1;
+	
+	for(int i = 0 ; i < REPLAY_MSG_NUM ; i++){
+		LOG_MsgInfoDef* msg = &_out_msg_list[i];
+	
+		memset(&format, 0, sizeof(format));
+		format.msg_id = msg->msg_id;
+		format.element_num = msg->element_num;
+		format.payload_size = msg->payload_size;
+		format.period = msg->period;
+		strncpy(format.name, msg->name, LOG_MAX_NAME_LENGTH-1);
+	
+		res |= fwrite(&format, sizeof(format), 1, _out_fp) != 1;
+		res |= fwrite(msg->element_info, sizeof(LOG_ElementInfoDef), msg->element_num, _out_fp) != msg->element_num;
+	}
+	
+	return res;
+}
+
+/* same periods as the copter rate groups, but every estimator is run so they can be compared */
+static uint8_t _run_estimator(uint32_t now_ms)
+{
+	static uint32_t ahrs_time, pos_est_time, state_est_time;
+	uint8_t res = 0;
+	
+	if(TIME_GAP(state_est_time, now_ms) >= EKF_PERIOD){
+		REPLAY_EkfDef msg;
+		quaternion q;
+		Vector3f_t pos, vel;
+	
+		state_est_time = now_ms;
+		state_est_update();
+	
+		state_est_get_quaternion(&q);
+		state_est_get_position(&pos);
+		state_est_get_velocity(&vel);
+		LOG_SET_ELEMENT(msg, QUATERNION_W, q.w);
+		LOG_SET_ELEMENT(msg, QUATERNION_X, q.x);
+		LOG_SET_ELEMENT(msg, QUATERNION_Y, q.y);
+		LOG_SET_ELEMENT(msg, QUATERNION_Z, q.z);
+		LOG_SET_ELEMENT(msg, X, pos.x);
+		LOG_SET_ELEMENT(msg, Y, pos.y);
+		LOG_SET_ELEMENT(msg, Z, pos.z);
+		LOG_SET_ELEMENT(msg, VX, vel.x);
+		LOG_SET_ELEMENT(msg, VY, vel.y);
+		LOG_SET_ELEMENT(msg, VZ, vel.z);
+		res |= _write_msg(REPLAY_MSG_EKF, &msg);
+		_status.est_cnt++;
+	}
+	
+	if(TIME_GAP(ahrs_time, now_ms) >= AHRS_PERIOD){
+		LOG_AttDef msg;
+		quaternion q;
+		Euler e;
+	
+		ahrs_time = now_ms;
+		attitude_est_run(0.001f*AHRS_PERIOD);
+	
+		mcn_copy_from_hub(MCN_ID(ATT_QUATERNION), &q);
+		mcn_copy_from_hub(MCN_ID(ATT_EULER), &e);
+		LOG_SET_ELEMENT(msg, QUATERNION_W, q.w);
+		LOG_SET_ELEMENT(msg, QUATERNION_X, q.x);
+		LOG_SET_ELEMENT(msg, QUATERNION_Y, q.y);
+		LOG_SET_ELEMENT(msg, QUATERNION_Z, q.z);
+		LOG_SET_ELEMENT(msg, ROLL, Rad2Deg(e.roll));
+		LOG_SET_ELEMENT(msg, PITCH, Rad2Deg(e.pitch));
+		LOG_SET_ELEMENT(msg, YAW, Rad2Deg(e.yaw));
+		res |= _write_msg(REPLAY_MSG_ATT, &msg);
+		_status.est_cnt++;
+	}
+	
+	if(TIME_GAP(pos_est_time, now_ms) >= POS_EST_PERIOD){
+		LOG_PosDef msg;
+		POS_KF_Log pos_kf;
+	
+		pos_est_time = now_ms;
+		pos_est_update(0.001f*POS_EST_PERIOD);
+	
+		mcn_copy_from_hub(MCN_ID(POS_KF), &pos_kf);
+		LOG_SET_ELEMENT(msg, X, pos_kf.est_x);
+		LOG_SET_ELEMENT(msg, Y, pos_kf.est_y);
+		LOG_SET_ELEMENT(msg, Z, pos_kf.est_z);
+		LOG_SET_ELEMENT(msg, VX, pos_kf.est_vx);
+		LOG_SET_ELEMENT(msg, VY, pos_kf.est_vy);
+		LOG_SET_ELEMENT(msg, VZ, pos_kf.est_vz);
+		res |= _write_msg(REPLAY_MSG_POS, &msg);
+		_status.est_cnt++;
+	}
+	
+	return res;
+}
+
+static void _show_status(void)
+{
+	double wall_s = _status.wall_time_us*1e-6;
+	double log_s = _status.log_time_us*1e-6;
+	
+	Console.print("replay %s -> %s\n", _in_file, _out_file);
+	Console.print("records: %d, skipped: %d, estimator steps: %d\n", _status.record_cnt, _status.skip_cnt, _status.est_cnt);
+	Console.print("log time: %.3f s, wall time: %.3f s\n", log_s, wall_s);
+	if(wall_s > 0.0){
+		Console.print("throughput: %.0f records/s, %.1fx real time\n", _status.record_cnt/wall_s, log_s/wall_s);
+	}
+}
+
+void log_replay_set_file(const char* in_file, const char* out_file)
+{
+	_in_file = in_file;
+	_out_file = out_file;
+}
+
+bool log_replay_enabled(void)
+{
+	return _in_file != NULL;
+}
+
+uint8_t log_replay_run(void)
+{
+	uint8_t payload[LOG_MAX_ELEMENT_NUM*sizeof(double)];
+	uint8_t msg_id;
+	uint64_t start_time_us, wall_start;
+	uint8_t res = 0;
+	
+	if(_in_file == NULL || _out_file == NULL){
+		Console.e(TAG, "no replay file\n");
+		return 1;
+	}
+	
+	_in_fp = fopen(_in_file, "rb");
+	if(_in_fp == NULL){
+		Console.e(TAG, "%s open fail\n", _in_file);
+		return 2;
+	}
+	setvbuf(_in_fp, _in_io_buffer, _IOFBF, sizeof(_in_io_buffer));
+	
+	if(_parse_header()){
+		Console.e(TAG, "%s is not a valid log file\n", _in_file);
+		fclose(_in_fp);
+		return 3;
+	}
+	
+	_out_fp = fopen(_out_file, "wb");
+	if(_out_fp == NULL){
+		Console.e(TAG, "%s create fail\n", _out_file);
+		fclose(_in_fp);
+		return 2;
+	}
+	setvbuf(_out_fp, _out_io_buffer, _IOFBF, sizeof(_out_io_buffer));
+	
+	for(uint32_t i = 0 ; i < REPLAY_CHAN_NUM ; i++){
+		if(!_chan_list[i].found)
+			Console.print("%s is not in log, keep zero\n", _chan_list[i].name);
+	}
+	
+	/* estimators run in replay thread, with the same init as copter_entry() */
+	memset(&_status, 0, sizeof(_status));
+	memset(&_input, 0, sizeof(_input));
+	_gps_status.status = GPS_UNDETECTED;
+	_gps_status.fix_cnt = 0;
+	mcn_publish(MCN_ID(GPS_STATUS), &_gps_status);
+	attitude_est_init();
+	state_est_init(1e-3f*EKF_PERIOD);
+	pos_est_init(1e-3f*POS_EST_PERIOD);
+	
+	_now_us = _time_base_us;
+	time_set_virtual(_now_us);
+	res |= _write_header();
+	
+	start_time_us = 0;
+	wall_start = time_wallUs();
+	while(_read_record(&msg_id, payload)){
+		if(_status.record_cnt == 0)
+			start_time_us = _now_us;
+		_status.record_cnt++;
+	
+		_apply_record(msg_id, payload);
+		time_set_virtual(_now_us);
+		_publish_input((uint32_t)(_now_us/1000));
+		res |= _run_estimator((uint32_t)(_now_us/1000));
+	}
+	_status.wall_time_us = time_wallUs() - wall_start;
+	_status.log_time_us = _now_us - start_time_us;
+	
+	time_clear_virtual();
+	fclose(_in_fp);
+	if(fclose(_out_fp) != 0)
+		res |= 1;
+	
+	if(res)
+		Console.e(TAG, "write %s fail\n", _out_file);
+	_show_status();
+	
+	return res;
+}
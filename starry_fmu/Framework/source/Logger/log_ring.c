@@ -0,0 +1,110 @@
+/*
+ * File      : log_ring.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <string.h>
+#include "log_ring.h"
+
+static void _ring_write(log_ring_t* ring, uint32_t pos, const void* data, uint32_t len)
+{
+	uint32_t n = ring->size - pos;
+	
+	if(n > len)
+		n = len;
+	memcpy(&ring->buff[pos], data, n);
+	if(len > n)
+		memcpy(ring->buff, (const uint8_t*)data + n, len - n);
+}
+
+static void _ring_read(const log_ring_t* ring, uint32_t pos, void* data, uint32_t len)
+{
+	uint32_t n = ring->size - pos;
+	
+	if(n > len)
+		n = len;
+	memcpy(data, &ring->buff[pos], n);
+	if(len > n)
+		memcpy((uint8_t*)data + n, ring->buff, len - n);
+}
+
+static uint16_t _ring_record_len(const log_ring_t* ring)
+{
+	uint16_t len;
+	
+	_ring_read(ring, ring->tail, &len, sizeof(len));
+	
+	return len;
+}
+
+void log_ring_init(log_ring_t* ring, uint8_t* buff, uint32_t size)
+{
+	ring->buff = buff;
+	ring->size = size;
+	ring->evict_cnt = 0;
+	log_ring_clear(ring);
+}
+
+void log_ring_clear(log_ring_t* ring)
+{
+	ring->head = 0;
+	ring->tail = 0;
+	ring->used = 0;
+	ring->record_num = 0;
+}
+
+/* append a record, the oldest records are dropped to make room for it */
+uint8_t log_ring_push(log_ring_t* ring, const void* data, uint32_t len)
+{
+	uint16_t rec_len = len;
+	
+	if(len == 0 || len > 0xFFFF || len + LOG_RING_OVERHEAD > ring->size)
+		return 1;
+	
+	while(ring->size - ring->used < len + LOG_RING_OVERHEAD){
+		log_ring_drop(ring);
+		ring->evict_cnt++;
+	}
+	
+	_ring_write(ring, ring->head, &rec_len, sizeof(rec_len));
+	_ring_write(ring, (ring->head + LOG_RING_OVERHEAD) % ring->size, data, len);
+	ring->head = (ring->head + LOG_RING_OVERHEAD + len) % ring->size;
+	ring->used += LOG_RING_OVERHEAD + len;
+	ring->record_num++;
+	
+	return 0;
+}
+
+/* copy the oldest record without removing it. Return its length, 0 if ring is
+ * empty or size is too small for it */
+uint32_t log_ring_peek(const log_ring_t* ring, void* data, uint32_t size)
+{
+	uint16_t len;
+	
+	if(ring->record_num == 0)
+		return 0;
+	
+	len = _ring_record_len(ring);
+	if(len > size)
+		return 0;
+	_ring_read(ring, (ring->tail + LOG_RING_OVERHEAD) % ring->size, data, len);
+	
+	return len;
+}
+
+/* remove the oldest record */
+void log_ring_drop(log_ring_t* ring)
+{
+	uint32_t len;
+	
+	if(ring->record_num == 0)
+		return;
+	
+	len = LOG_RING_OVERHEAD + _ring_record_len(ring);
+	ring->tail = (ring->tail + len) % ring->size;
+	ring->used -= len;
+	ring->record_num--;
+}
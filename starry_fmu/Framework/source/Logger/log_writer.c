@@ -0,0 +1,481 @@
+/*
+ * File      : log_writer.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <string.h>
+#include "log_writer.h"
+#include "log_compress.h"
+#include "logger.h"
+#include "global.h"
+#include "console.h"
+#include "delay.h"
+
+static char* TAG = "LogWriter";
+
+/* producers fill buffer[head], writer thread flushes buffer[tail]. Each
+ * buffer is flushed as a whole, so every f_write is sector aligned */
+ALIGN(4) static uint8_t _buffer[LOG_BUFFER_NUM][LOG_BUFFER_SIZE];
+static uint32_t _buffer_len[LOG_BUFFER_NUM];
+static uint32_t _head;
+static uint32_t _tail;
+static uint32_t _fill_len;
+static volatile uint32_t _full_cnt;
+
+static FIL* _fp = NULL;
+static volatile bool _running = false;
+static volatile bool _stop_req = false;
+static bool _stopping = false;			// stop is requested, footer is not written yet
+
+static struct rt_semaphore _sem_write;
+static struct rt_semaphore _sem_done;
+static struct rt_mutex _push_lock;
+
+static LOG_WriterStatusDef _status;
+
+/* compressed block is built here by writer thread, allocated when compression is used */
+static uint8_t _compress = LOG_COMPRESS_NONE;
+static uint8_t* _block = NULL;
+static uint32_t _raw_offset;
+#define BLOCK_SIZE				(sizeof(LOG_BlockHeaderDef) + LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE))
+
+/* Seek index of sync markers, written as footer when log stops. Producers add
+ * entries, the writer thread fills their file offset in compressed log once
+ * their block is written. When it is full every second entry is dropped, so
+ * it always covers the whole log with fixed memory.
+ */
+static LOG_IndexEntryDef* _index = NULL;
+static uint32_t _index_num;
+static uint32_t _index_resolved;
+static uint32_t _index_stride;
+static uint32_t _mark_cnt;
+static uint32_t _mark_offset;
+static uint64_t _mark_time;
+static uint32_t _push_offset;			// raw bytes pushed
+static uint32_t _file_offset;			// bytes written to file
+static uint32_t _sync_time;
+
+static void _log_writer_write(const void* data, uint32_t len)
+{
+	UINT bw;
+	FRESULT fres;
+	uint32_t start, latency;
+	
+	start = (uint32_t)time_nowUs();
+	fres = f_write(_fp, data, len, &bw);
+	latency = (uint32_t)time_nowUs() - start;
+	
+	if(fres != FR_OK || bw != len){
+		_status.write_err++;
+	}
+	_file_offset += bw;
+	_status.write_cnt++;
+	_status.write_bytes += bw;
+	_status.latency_last = latency;
+	_status.latency_sum += latency;
+	if(latency > _status.latency_max)
+		_status.latency_max = latency;
+}
+
+static void _log_writer_write_block(const uint8_t* data, uint32_t len)
+{
+	LOG_BlockHeaderDef* header = (LOG_BlockHeaderDef*)_block;
+	uint8_t* block_data = &_block[sizeof(LOG_BlockHeaderDef)];
+	uint32_t start, cost, size;
+	
+	start = (uint32_t)time_nowUs();
+	size = log_compress_block(data, len, block_data, LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE));
+	cost = (uint32_t)time_nowUs() - start;
+	
+	header->magic = LOG_BLOCK_MAGIC;
+	header->method = size ? _compress : LOG_COMPRESS_NONE;
+	header->reserved = 0;
+	header->raw_size = len;
+	header->raw_offset = _raw_offset;
+	if(size == 0){
+		/* incompressible, store as it is */
+		memcpy(block_data, data, len);
+		size = len;
+	}
+	header->data_size = size;
+	
+	/* markers in this block are found from the block start */
+	rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+	while(_index_resolved < _index_num && _index[_index_resolved].raw_offset < _raw_offset + len){
+		_index[_index_resolved++].file_offset = _file_offset;
+	}
+	rt_mutex_release(&_push_lock);
+	_raw_offset += len;
+	
+	_status.block_cnt++;
+	_status.raw_bytes += len;
+	_status.compress_last = cost;
+	_status.compress_sum += cost;
+	if(cost > _status.compress_max)
+		_status.compress_max = cost;
+	
+	_log_writer_write(_block, sizeof(LOG_BlockHeaderDef) + size);
+}
+
+static void _log_writer_flush_full(void)
+{
+	uint32_t len;
+	
+	while(_full_cnt){
+		len = _buffer_len[_tail];
+	
+		if(_compress != LOG_COMPRESS_NONE){
+			_log_writer_write_block(_buffer[_tail], len);
+		}else{
+			_log_writer_write(_buffer[_tail], len);
+		}
+	
+		_tail = (_tail+1) % LOG_BUFFER_NUM;
+		OS_ENTER_CRITICAL;
+		_full_cnt--;
+		OS_EXIT_CRITICAL;
+	}
+}
+
+/* update FAT directory entry, so a power loss only loses data since last sync */
+static void _log_writer_sync(void)
+{
+	uint32_t start, latency;
+	
+	start = (uint32_t)time_nowUs();
+	if(f_sync(_fp) != FR_OK){
+		_status.fsync_err++;
+	}
+	latency = (uint32_t)time_nowUs() - start;
+	
+	_status.fsync_cnt++;
+	if(latency > _status.fsync_max)
+		_status.fsync_max = latency;
+	_sync_time = time_nowMs();
+}
+
+/* must hold push lock */
+static void _log_writer_add_index(uint64_t timestamp, uint32_t raw_offset)
+{
+	if(_index_num == LOG_INDEX_MAX_NUM){
+		/* kept entries and the new one are all multiples of the doubled stride */
+		for(uint32_t i = 0 ; i < LOG_INDEX_MAX_NUM/2 ; i++){
+			_index[i] = _index[2*i];
+		}
+		_index_num = LOG_INDEX_MAX_NUM/2;
+		_index_resolved = (_index_resolved+1)/2;
+		_index_stride *= 2;
+	}
+	
+	_index[_index_num].timestamp = timestamp;
+	_index[_index_num].raw_offset = raw_offset;
+	_index[_index_num].file_offset = raw_offset;
+	_index_num++;
+	
+	_status.index_num = _index_num;
+	_status.index_stride = _index_stride;
+}
+
+/* write index footer after all data, writer thread must be idle */
+static void _log_writer_write_index(void)
+{
+	/* buffers are free now */
+	uint8_t* footer = _buffer[0];
+	LOG_IndexHeaderDef* header = (LOG_IndexHeaderDef*)footer;
+	LOG_IndexTailDef* tail;
+	uint32_t size = sizeof(LOG_IndexHeaderDef) + _index_num*sizeof(LOG_IndexEntryDef) + sizeof(LOG_IndexTailDef);
+	
+	header->sync = LOG_RECORD_SYNC_INDEX;
+	header->reserved = 0;
+	header->stride = _index_stride;
+	header->entry_num = _index_num;
+	memcpy(&footer[sizeof(LOG_IndexHeaderDef)], _index, _index_num*sizeof(LOG_IndexEntryDef));
+	tail = (LOG_IndexTailDef*)&footer[size - sizeof(LOG_IndexTailDef)];
+	tail->magic = LOG_INDEX_MAGIC;
+	tail->entry_num = _index_num;
+	tail->index_size = size;
+	tail->raw_offset = _push_offset;
+	
+	if(_compress != LOG_COMPRESS_NONE){
+		/* stored block, so footer is plain at the end of file */
+		LOG_BlockHeaderDef block;
+	
+		block.magic = LOG_BLOCK_MAGIC;
+		block.method = LOG_COMPRESS_NONE;
+		block.reserved = 0;
+		block.raw_size = size;
+		block.data_size = size;
+		block.raw_offset = _raw_offset;
+		_log_writer_write(&block, sizeof(block));
+	}
+	_log_writer_write(footer, size);
+}
+
+/* hand over current buffer to writer thread, must hold push lock */
+static void _log_writer_commit(void)
+{
+	_buffer_len[_head] = _fill_len;
+	_head = (_head+1) % LOG_BUFFER_NUM;
+	_fill_len = 0;
+	OS_ENTER_CRITICAL;
+	_full_cnt++;
+	OS_EXIT_CRITICAL;
+	
+	rt_sem_release(&_sem_write);
+}
+
+rt_err_t log_writer_init(void)
+{
+	rt_err_t res;
+	
+	res = rt_sem_init(&_sem_write, "log_wr", 0, RT_IPC_FLAG_FIFO);
+	if(res != RT_EOK)
+		return res;
+	res = rt_sem_init(&_sem_done, "log_done", 0, RT_IPC_FLAG_FIFO);
+	if(res != RT_EOK)
+		return res;
+	res = rt_mutex_init(&_push_lock, "log_push", RT_IPC_FLAG_FIFO);
+	
+	return res;
+}
+
+uint8_t log_writer_start(FIL* fp, uint8_t compress)
+{
+	if(_running || _stopping){
+		return 1;
+	}
+	
+	if(log_compress_open(compress)){
+		return 1;
+	}
+	if(compress != LOG_COMPRESS_NONE && _block == NULL){
+		_block = (uint8_t*)rt_malloc(BLOCK_SIZE);
+		if(_block == NULL){
+			Console.e(TAG, "fail to malloc block buffer:%d\n", BLOCK_SIZE);
+			log_compress_close();
+			return 1;
+		}
+	}
+	if(_index == NULL){
+		_index = (LOG_IndexEntryDef*)rt_malloc(LOG_INDEX_MAX_NUM*sizeof(LOG_IndexEntryDef));
+		/* markers are still written, logidx can rebuild the footer */
+		if(_index == NULL)
+			Console.print("log index is disabled, fail to malloc %d byte\n", LOG_INDEX_MAX_NUM*sizeof(LOG_IndexEntryDef));
+	}
+	
+	rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+	_fp = fp;
+	_head = _tail = 0;
+	_fill_len = 0;
+	_full_cnt = 0;
+	_compress = compress;
+	_raw_offset = 0;
+	_index_num = 0;
+	_index_resolved = 0;
+	_index_stride = 1;
+	_mark_cnt = 0;
+	_mark_offset = 0;
+	_push_offset = 0;
+	_file_offset = 0;
+	_sync_time = time_nowMs();
+	memset(&_status, 0, sizeof(_status));
+	_status.compress = compress;
+	_status.index_stride = 1;
+	_running = true;
+	rt_mutex_release(&_push_lock);
+	
+	return 0;
+}
+
+uint8_t log_writer_stop(void)
+{
+	if(!_running && !_stopping){
+		return 0;
+	}
+	
+	if(_running){
+		rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+		_running = false;
+		/* flush the partial buffer as well */
+		if(_fill_len){
+			_log_writer_commit();
+		}
+		_stop_req = true;
+		_stopping = true;
+		rt_mutex_release(&_push_lock);
+	
+		rt_sem_release(&_sem_write);
+	}
+	
+	/* After a timeout the writer thread still owns file and buffers, nothing is
+	 * released and caller must keep file open. Calling stop again waits for it. */
+	if(rt_sem_take(&_sem_done, WRITER_STOP_TIMEOUT) != RT_EOK){
+		Console.e(TAG, "wait log writer timeout\n");
+		return 1;
+	}
+	_stopping = false;
+	
+	/* writer thread is idle, write footer and release buffers */
+	if(_index){
+		_log_writer_write_index();
+		rt_free(_index);
+		_index = NULL;
+	}
+	log_compress_close();
+	if(_block){
+		rt_free(_block);
+		_block = NULL;
+	}
+	
+	return 0;
+}
+
+uint8_t log_writer_push(const void* data, uint32_t size)
+{
+	const uint8_t* pdata = (const uint8_t*)data;
+	uint32_t free_size, n, pending;
+	
+	if(!_running){
+		return 1;
+	}
+	
+	rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+	
+	free_size = (LOG_BUFFER_NUM - _full_cnt)*LOG_BUFFER_SIZE - _fill_len;
+	if(size > free_size){
+		/* drop the whole record, never write a partial one */
+		_status.drop_cnt++;
+		_status.drop_bytes += size;
+		rt_mutex_release(&_push_lock);
+		return 1;
+	}
+	
+	while(size){
+		n = LOG_BUFFER_SIZE - _fill_len;
+		n = size < n ? size : n;
+		memcpy(&_buffer[_head][_fill_len], pdata, n);
+		_fill_len += n;
+		pdata += n;
+		size -= n;
+	
+		if(_fill_len == LOG_BUFFER_SIZE){
+			_log_writer_commit();
+		}
+	}
+	_push_offset += pdata - (const uint8_t*)data;
+	
+	pending = _full_cnt*LOG_BUFFER_SIZE + _fill_len;
+	if(pending > _status.high_water)
+		_status.high_water = pending;
+	
+	rt_mutex_release(&_push_lock);
+	
+	return 0;
+}
+
+/* bytes which can be pushed without drop */
+uint32_t log_writer_free(void)
+{
+	uint32_t free_size;
+	
+	if(!_running)
+		return 0;
+	
+	rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+	free_size = (LOG_BUFFER_NUM - _full_cnt)*LOG_BUFFER_SIZE - _fill_len;
+	rt_mutex_release(&_push_lock);
+	
+	return free_size;
+}
+
+/* Write a sync marker in front of the record with timestamp, if LOG_SYNC_INTERVAL
+ * bytes have been pushed since the last one. Return 1 if marker is written, then
+ * caller must restart delta coding.
+ */
+uint8_t log_writer_mark(uint32_t timestamp)
+{
+	LOG_SyncDef mark;
+	
+	/* only producer thread moves the offset, check it without lock for each record */
+	if(!_running || _push_offset - _mark_offset < LOG_SYNC_INTERVAL)
+		return 0;
+	
+	rt_mutex_take(&_push_lock, RT_WAITING_FOREVER);
+	mark.sync = LOG_RECORD_SYNC_MARK;
+	mark.reserved = 0;
+	mark.seq = _mark_cnt;
+	mark.magic = LOG_SYNC_MAGIC;
+	mark.timestamp = timestamp;
+	mark.raw_offset = _push_offset;
+	if(log_writer_push(&mark, sizeof(mark))){
+		rt_mutex_release(&_push_lock);
+		return 0;
+	}
+	
+	/* record timestamp wraps around, the difference to last marker does not */
+	if(_mark_cnt == 0)
+		_mark_time = timestamp;
+	else
+		_mark_time += (int32_t)(timestamp - (uint32_t)_mark_time);
+	if(_index && _mark_cnt % _index_stride == 0){
+		_log_writer_add_index(_mark_time, mark.raw_offset);
+	}
+	_mark_offset = mark.raw_offset;
+	_mark_cnt++;
+	_status.mark_cnt = _mark_cnt;
+	rt_mutex_release(&_push_lock);
+	
+	return 1;
+}
+
+LOG_WriterStatusDef log_writer_get_status(void)
+{
+	return _status;
+}
+
+void log_writer_show_status(void)
+{
+	LOG_WriterStatusDef status = log_writer_get_status();
+	
+	Console.print("buffer: %d x %d byte\n", LOG_BUFFER_NUM, LOG_BUFFER_SIZE);
+	Console.print("high water: %d byte\n", status.high_water);
+	Console.print("write: %d times, %d byte, err:%d\n", status.write_cnt, status.write_bytes, status.write_err);
+	Console.print("drop: %d records, %d byte\n", status.drop_cnt, status.drop_bytes);
+	Console.print("write latency(us): last:%d max:%d avg:%d\n", status.latency_last, status.latency_max,
+					status.write_cnt ? (uint32_t)(status.latency_sum/status.write_cnt) : 0);
+	if(status.compress != LOG_COMPRESS_NONE){
+		Console.print("compress: %s, %d blocks, %d -> %d byte, ratio:%.2f\n", log_compress_name(status.compress),
+						status.block_cnt, status.raw_bytes, status.write_bytes,
+						status.write_bytes ? (float)status.raw_bytes/status.write_bytes : 0.0f);
+		Console.print("compress time per block(us): last:%d max:%d avg:%d\n", status.compress_last, status.compress_max,
+						status.block_cnt ? (uint32_t)(status.compress_sum/status.block_cnt) : 0);
+	}
+	Console.print("sync: %d markers, index: %d entries, stride:%d\n", status.mark_cnt, status.index_num, status.index_stride);
+	Console.print("f_sync: %d times, err:%d, max:%d us\n", status.fsync_cnt, status.fsync_err, status.fsync_max);
+}
+
+void log_writer_entry(void *parameter)
+{
+	while(1)
+	{
+		rt_sem_take(&_sem_write, RT_WAITING_FOREVER);
+	
+		_log_writer_flush_full();
+	
+		if(_fp && !_stop_req && time_nowMs() - _sync_time >= LOG_SYNC_PERIOD){
+			_log_writer_sync();
+		}
+	
+		if(_stop_req){
+			/* stop may commit the partial buffer after the flush above has
+			 * seen no full buffer, flush again so nothing is left pending */
+			_log_writer_flush_full();
+			_stop_req = false;
+			rt_sem_release(&_sem_done);
+		}
+	}
+}
@@ -8,6 +8,10 @@
  */
 
 #include "logger.h"
+#include "log_writer.h"
+#include "log_compress.h"
+#include "log_delta.h"
+#include "log_ring.h"
 #include "global.h"
 #include "ff.h"
 #include "file_manager.h"
@@ -22,13 +26,17 @@
 #include "global.h"
 #include "gps.h"
 #include "sensor_manager.h"
+#include "statistic.h"
 #include <string.h>
 #include <stdlib.h>
+#include <stdio.h>
 
-#define LOGGER_DEFAULT_PERIOD		100
+#define LOGGER_DEFAULT_PERIOD		2
 #define EVENT_LOG_RECORD			(1<<0)
-
-LOG_HeaderDef* log_header_t = NULL;
+/* trigger reasons are carried in event bits from this one */
+#define EVENT_LOG_TRIGGER_SHIFT		8
+#define EVENT_LOG_TRIGGER			(LOG_TRIGGER_ALL << EVENT_LOG_TRIGGER_SHIFT)
+#define LOG_TRIGGER_FILE_MAX		999
 
 static char* TAG = "Logger";
 FIL logger_fp;
@@ -36,6 +44,18 @@ LOGGER_InfoDef _logger_info;
 static struct rt_timer _timer_logger;
 static struct rt_event event_log;
 
+static McnNode_t _gyr_node_t;
+static McnNode_t _acc_node_t;
+static McnNode_t _mag_node_t;
+static McnNode_t _filter_gyr_node_t;
+static McnNode_t _att_node_t;
+static McnNode_t _pos_node_t;
+static McnNode_t _motor_node_t;
+static McnNode_t _adrc_node_t;
+static McnNode_t _gps_node_t;
+static McnNode_t _baro_node_t;
+static McnNode_t _load_node_t;
+
 MCN_DECLARE(ATT_QUATERNION);
 MCN_DECLARE(ATT_EULER);
 MCN_DECLARE(SENSOR_GYR);
@@ -47,11 +67,46 @@ MCN_DECLARE(SENSOR_FILTER_MAG);
 MCN_DECLARE(MOTOR_THROTTLE);
 MCN_DECLARE(ADRC);
 MCN_DECLARE(BARO_POSITION);
-MCN_DECLARE(POS_KF);
 MCN_DECLARE(ALT_INFO);
 MCN_DECLARE(POS_INFO);
+MCN_DECLARE(GPS_POSITION);
+MCN_DECLARE(SYS_LOAD);
+
+static const LOG_ElementInfoDef gyr_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(GYR_X),
+	LOG_ELEMENT_INFO_FLOAT(GYR_Y),
+	LOG_ELEMENT_INFO_FLOAT(GYR_Z),
+};
+
+static const LOG_ElementInfoDef acc_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(ACC_X),
+	LOG_ELEMENT_INFO_FLOAT(ACC_Y),
+	LOG_ELEMENT_INFO_FLOAT(ACC_Z),
+};
 
-LOG_ElementInfoDef element_info_list[] =
+static const LOG_ElementInfoDef mag_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(MAG_X),
+	LOG_ELEMENT_INFO_FLOAT(MAG_Y),
+	LOG_ELEMENT_INFO_FLOAT(MAG_Z),
+	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_X),
+	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_Y),
+	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_Z),
+};
+
+static const LOG_ElementInfoDef filter_element_list[] =
+{
+	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_X),
+	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_Y),
+	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_Z),
+	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_X),
+	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_Y),
+	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_Z),
+};
+
+static const LOG_ElementInfoDef att_element_list[] =
 {
 	LOG_ELEMENT_INFO_FLOAT(QUATERNION_W),
 	LOG_ELEMENT_INFO_FLOAT(QUATERNION_X),
@@ -60,40 +115,38 @@ LOG_ElementInfoDef element_info_list[] =
 	LOG_ELEMENT_INFO_FLOAT(ROLL),
 	LOG_ELEMENT_INFO_FLOAT(PITCH),
 	LOG_ELEMENT_INFO_FLOAT(YAW),
+};
+
+static const LOG_ElementInfoDef pos_element_list[] =
+{
 	LOG_ELEMENT_INFO_FLOAT(X),
 	LOG_ELEMENT_INFO_FLOAT(Y),
 	LOG_ELEMENT_INFO_FLOAT(Z),
 	LOG_ELEMENT_INFO_FLOAT(VX),
 	LOG_ELEMENT_INFO_FLOAT(VY),
 	LOG_ELEMENT_INFO_FLOAT(VZ),
-	LOG_ELEMENT_INFO_FLOAT(GYR_X),
-	LOG_ELEMENT_INFO_FLOAT(GYR_Y),
-	LOG_ELEMENT_INFO_FLOAT(GYR_Z),
-	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_X),
-	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_Y),
-	LOG_ELEMENT_INFO_FLOAT(GYR_FILTER_Z),
-	LOG_ELEMENT_INFO_FLOAT(ACC_X),
-	LOG_ELEMENT_INFO_FLOAT(ACC_Y),
-	LOG_ELEMENT_INFO_FLOAT(ACC_Z),
-	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_X),
-	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_Y),
-	LOG_ELEMENT_INFO_FLOAT(ACC_FILTER_Z),
-	LOG_ELEMENT_INFO_FLOAT(MAG_X),
-	LOG_ELEMENT_INFO_FLOAT(MAG_Y),
-	LOG_ELEMENT_INFO_FLOAT(MAG_Z),
-	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_X),
-	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_Y),
-	LOG_ELEMENT_INFO_FLOAT(MAG_FILTER_Z),
+};
+
+static const LOG_ElementInfoDef motor_element_list[] =
+{
 	LOG_ELEMENT_INFO_FLOAT(MOTOR_1),
 	LOG_ELEMENT_INFO_FLOAT(MOTOR_2),
 	LOG_ELEMENT_INFO_FLOAT(MOTOR_3),
 	LOG_ELEMENT_INFO_FLOAT(MOTOR_4),
+};
+
+static const LOG_ElementInfoDef adrc_element_list[] =
+{
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_SP_RATE),
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_V),
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_V1),
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_V2),
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_Z1),
 	LOG_ELEMENT_INFO_FLOAT(ADRC_PITCH_Z2),
+};
+
+static const LOG_ElementInfoDef gps_element_list[] =
+{
 	LOG_ELEMENT_INFO_FLOAT(GPS_LAT),
 	LOG_ELEMENT_INFO_FLOAT(GPS_LON),
 	LOG_ELEMENT_INFO_FLOAT(GPS_X),
@@ -103,64 +156,258 @@ LOG_ElementInfoDef element_info_list[] =
 	LOG_ELEMENT_INFO_FLOAT(GPS_VE),
 	LOG_ELEMENT_INFO_FLOAT(GPS_VD),
 	LOG_ELEMENT_INFO_FLOAT(GPS_HDOP),
+};
+
+static const LOG_ElementInfoDef baro_element_list[] =
+{
 	LOG_ELEMENT_INFO_FLOAT(BARO_ALT),
 	LOG_ELEMENT_INFO_FLOAT(BARO_VEL),
-//	LOG_ELEMENT_INFO_FLOAT(KF_U_X),
-//	LOG_ELEMENT_INFO_FLOAT(KF_U_Y),
-//	LOG_ELEMENT_INFO_FLOAT(KF_U_Z),
-//	LOG_ELEMENT_INFO_FLOAT(KF_X),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Y),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z),
-//	LOG_ELEMENT_INFO_FLOAT(KF_VX),
-//	LOG_ELEMENT_INFO_FLOAT(KF_VY),
-//	LOG_ELEMENT_INFO_FLOAT(KF_VZ),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_X),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_Y),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_Z),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_VX),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_VY),
-//	LOG_ELEMENT_INFO_FLOAT(KF_Z_VZ),
 };
 
-uint8_t logger_create_header(uint32_t log_period)
+static const LOG_ElementInfoDef load_element_list[] =
 {
-	log_header_t = (LOG_HeaderDef*)rt_malloc(sizeof(LOG_HeaderDef));
-	if(log_header_t == NULL){
-		Console.e(TAG, "err, can not create log header\n");
-		return 1;
+	LOG_ELEMENT_INFO_FLOAT(CPU),
+	LOG_ELEMENT_INFO_FLOAT(FASTLOOP_LOAD),
+	LOG_ELEMENT_INFO_FLOAT(FASTLOOP_LAT),
+	LOG_ELEMENT_INFO_FLOAT(COPTER_LOAD),
+	LOG_ELEMENT_INFO_FLOAT(COPTER_LAT),
+	LOG_ELEMENT_INFO_FLOAT(MAVPROXY_LOAD),
+	LOG_ELEMENT_INFO_FLOAT(MAVPROXY_LAT),
+	LOG_ELEMENT_INFO_FLOAT(LOGGER_LOAD),
+	LOG_ELEMENT_INFO_FLOAT(LOGGER_LAT),
+	LOG_ELEMENT_INFO_FLOAT(LOG_WRITER_LOAD),
+	LOG_ELEMENT_INFO_FLOAT(LOG_WRITER_LAT),
+};
+
+/* message list, must be in the same order as message id */
+LOG_MsgInfoDef log_msg_list[] =
+{
+	LOG_MSG_INFO(LOG_MSG_GYR, GYR, LOG_GyrDef, gyr_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_ACC, ACC, LOG_AccDef, acc_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_MAG, MAG, LOG_MagDef, mag_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_FILTER, FILTER, LOG_FilterDef, filter_element_list, 4),
+	LOG_MSG_INFO(LOG_MSG_ATT, ATT, LOG_AttDef, att_element_list, 4),
+	LOG_MSG_INFO(LOG_MSG_POS, POS, LOG_PosDef, pos_element_list, 10),
+	LOG_MSG_INFO(LOG_MSG_MOTOR, MOTOR, LOG_MotorDef, motor_element_list, 4),
+	LOG_MSG_INFO(LOG_MSG_ADRC, ADRC, LOG_AdrcDef, adrc_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_GPS, GPS, LOG_GpsDef, gps_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_BARO, BARO, LOG_BaroDef, baro_element_list, 0),
+	LOG_MSG_INFO(LOG_MSG_LOAD, LOAD, LOG_LoadDef, load_element_list, 0),
+};
+
+#define LOG_MSG_NUM		(sizeof(log_msg_list)/sizeof(LOG_MsgInfoDef))
+#define LOG_MSG(_id)	(&log_msg_list[(_id)-1])
+
+/* delta coding state of each message */
+static log_delta_t _delta[LOG_MSG_NUM];
+static uint32_t* _delta_prev = NULL;
+
+/* Pre-trigger ring. While capturing, records go to ring and the oldest are
+ * overwritten. When a log starts, records keep going through ring until it is
+ * drained to log writer, so the file has no gap between ring and live data.
+ * _ring_lock serializes logger thread with shell commands which change ring or start/stop log.
+ */
+static log_ring_t _ring;
+static uint8_t _ring_capture = 0;
+static uint32_t _ring_trigger = 0;			// enabled trigger reasons
+static uint8_t _ring_compress = LOG_COMPRESS_NONE;
+static uint8_t _ring_delta = 0;
+static struct rt_mutex _ring_lock;
+static uint8_t _logger_ready = 0;
+
+static const char* _trigger_name[] =
+{
+	"arm", "estimator reset", "error", "shell"
+};
+
+static void _logger_delta_reset(void)
+{
+	for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+		log_delta_reset(&_delta[i]);
 	}
+}
+
+/* data is buffered and written to file by log writer thread */
+static uint8_t _logger_write(const void* data, uint32_t size)
+{
+	if(_ring_capture)
+		return log_ring_push(&_ring, data, size);
 	
-	log_header_t->start_time = time_nowMs();
-	log_header_t->log_period = log_period;
-	log_header_t->element_num = sizeof(element_info_list)/sizeof(LOG_ElementInfoDef);
-	log_header_t->header_size = sizeof(LOG_HeaderDef) - sizeof(LOG_ElementInfoDef*) + sizeof(element_info_list);
-	log_header_t->field_size = sizeof(LOG_FieldDef);
-	if(log_header_t->element_num > LOG_MAX_ELEMENT_NUM){
-		Console.print("log element num is larger than maximal element num\n");
-		rt_free(log_header_t);
-		return 2;
+	return log_writer_push(data, size);
+}
+
+static uint8_t _logger_write_msg(uint8_t msg_id, uint32_t timestamp, const void* payload)
+{
+	uint8_t buffer[sizeof(LOG_RecordHeaderDef)+LOG_MAX_PAYLOAD_SIZE];
+	LOG_RecordHeaderDef* header = (LOG_RecordHeaderDef*)buffer;
+	LOG_MsgInfoDef* msg = LOG_MSG(msg_id);
+	/* ring may overwrite its oldest records, so only plain records go to it */
+	log_delta_t* delta = _logger_info.delta && !_ring_capture ? &_delta[msg_id-1] : NULL;
+	uint32_t size = 0;
+	uint8_t res;
+	
+	msg->record_cnt++;
+	_logger_info.record_cnt++;
+	
+	/* decoding can start from a marker, records after it do not refer to earlier ones */
+	if(!_ring_capture && log_writer_mark(timestamp))
+		_logger_delta_reset();
+	
+	if(delta && delta->word_num){
+		size = log_delta_encode(delta, timestamp, payload, &buffer[sizeof(LOG_DeltaHeaderDef)],
+								sizeof(buffer)-sizeof(LOG_DeltaHeaderDef));
 	}
 	
-	log_header_t->element_info = (LOG_ElementInfoDef*)rt_malloc(log_header_t->element_num*sizeof(LOG_ElementInfoDef));
-	if(log_header_t->element_info == NULL){
-		Console.e(TAG, "err, fail to malloc for element_info\n");
-		rt_free(log_header_t);
-		return 1;
+	if(size){
+		LOG_DeltaHeaderDef* delta_header = (LOG_DeltaHeaderDef*)buffer;
+	
+		delta_header->sync = LOG_RECORD_SYNC_DELTA;
+		delta_header->msg_id = msg_id;
+		delta_header->body_size = size;
+		_logger_info.delta_cnt++;
+		res = _logger_write(buffer, sizeof(LOG_DeltaHeaderDef)+size);
+	}else{
+		header->sync = LOG_RECORD_SYNC;
+		header->msg_id = msg_id;
+		header->payload_size = msg->payload_size;
+		header->timestamp = timestamp;
+		memcpy(&buffer[sizeof(LOG_RecordHeaderDef)], payload, msg->payload_size);
+		if(delta && delta->word_num)
+			log_delta_key(delta, timestamp, payload);
+		res = _logger_write(buffer, sizeof(LOG_RecordHeaderDef)+msg->payload_size);
+	}
+	
+	/* a dropped record breaks the delta chain, restart it from a plain record */
+	if(res && delta)
+		log_delta_reset(delta);
+	
+	return res;
+}
+
+static uint8_t _logger_delta_start(void)
+{
+	uint32_t word_num = 0;
+	
+	/* only payload made of 32-bit elements is delta coded */
+	if(_delta_prev == NULL){
+		for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+			if(log_msg_list[i].payload_size % 4 == 0)
+				word_num += log_msg_list[i].payload_size/4;
+		}
+		/* kept after stop, logger thread may still be recording when log stops */
+		_delta_prev = rt_malloc(word_num*sizeof(uint32_t));
+		if(_delta_prev == NULL){
+			Console.e(TAG, "fail to malloc delta buffer:%d\n", word_num*sizeof(uint32_t));
+			return 1;
+		}
+	}
+	
+	word_num = 0;
+	for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+		uint16_t n = log_msg_list[i].payload_size % 4 == 0 ? log_msg_list[i].payload_size/4 : 0;
+		log_delta_init(&_delta[i], &_delta_prev[word_num], n);
+		word_num += n;
 	}
-	for(int i = 0 ; i < log_header_t->element_num ; i++)
-		log_header_t->element_info[i] = element_info_list[i];
 	
 	return 0;
 }
 
-void logger_release_header(void)
+/* check if message reaches its record interval and topic is updated */
+static bool _logger_msg_ready(uint8_t msg_id, McnNode_t node_t, uint32_t now)
+{
+	LOG_MsgInfoDef* msg = LOG_MSG(msg_id);
+	
+	if(!mcn_poll(node_t))
+		return false;
+	if(msg->period && TIME_GAP(msg->last_record_time, now) < msg->period)
+		return false;
+	
+	msg->last_record_time = now;
+	return true;
+}
+
+/* move records from ring to log writer as long as it has room */
+static void _logger_ring_drain(void)
+{
+	static uint8_t record[sizeof(LOG_RecordHeaderDef)+LOG_MAX_PAYLOAD_SIZE];
+	LOG_RecordHeaderDef* header = (LOG_RecordHeaderDef*)record;
+	uint32_t free_size = log_writer_free();
+	uint32_t len;
+	
+	while((len = log_ring_peek(&_ring, record, sizeof(record))) != 0){
+		/* leave room for a marker in front of it */
+		if(len + sizeof(LOG_SyncDef) > free_size)
+			return;
+		if(log_writer_mark(header->timestamp))
+			free_size -= sizeof(LOG_SyncDef);
+		log_writer_push(record, len);
+		free_size -= len;
+		log_ring_drop(&_ring);
+	}
+	
+	/* records written directly are dropped when writer is full, keep them in ring
+	 * until writer has a buffer of room */
+	if(free_size < LOG_BUFFER_SIZE)
+		return;
+	
+	/* ring is empty, write directly from now on. Delta coding restarts from plain records */
+	_ring_capture = 0;
+	_logger_delta_reset();
+}
+
+static void _logger_lock(void)
+{
+	if(_logger_ready)
+		rt_mutex_take(&_ring_lock, RT_WAITING_FOREVER);
+}
+
+static void _logger_unlock(void)
+{
+	if(_logger_ready)
+		rt_mutex_release(&_ring_lock);
+}
+
+uint8_t logger_write_header(void)
 {
-	rt_free(log_header_t->element_info);
-	rt_free(log_header_t);
-	log_header_t = NULL;
+	LOG_HeaderDef header;
+	LOG_FormatDef format;
+	uint8_t res = 0;
+	
+	header.magic = LOG_MAGIC;
+	header.version = LOG_VERSION;
+	header.msg_num = LOG_MSG_NUM;
+	header.start_time = time_nowMs();
+	header.header_size = sizeof(LOG_HeaderDef);
+	for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+		header.header_size += sizeof(LOG_FormatDef) + log_msg_list[i].element_num*sizeof(LOG_ElementInfoDef);
+	}
+	
+	/* header goes to file ahead of records buffered in ring */
+	res |= log_writer_push(&header, sizeof(header));
+	
+	for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+		LOG_MsgInfoDef* msg = &log_msg_list[i];
+	
+		if(msg->element_num > LOG_MAX_ELEMENT_NUM || msg->payload_size > LOG_MAX_PAYLOAD_SIZE){
+			Console.e(TAG, "invalid log msg format:%s\n", msg->name);
+			return 2;
+		}
+	
+		memset(&format, 0, sizeof(format));
+		format.msg_id = msg->msg_id;
+		format.element_num = msg->element_num;
+		format.payload_size = msg->payload_size;
+		format.period = msg->period;
+		strncpy(format.name, msg->name, LOG_MAX_NAME_LENGTH-1);
+	
+		res |= log_writer_push(&format, sizeof(format));
+		res |= log_writer_push(msg->element_info, msg->element_num*sizeof(LOG_ElementInfoDef));
+	}
+	
+	return res;
 }
 
-uint8_t logger_start(char* file_name, uint32_t log_period)
+static uint8_t _logger_start(char* file_name, uint32_t log_period, uint8_t compress, uint8_t delta)
 {
 	uint8_t res = 0;
 	if(!fm_init_complete()){
@@ -173,246 +420,573 @@ uint8_t logger_start(char* file_name, uint32_t log_period)
 		return 2;
 	}
 	
-	if(logger_create_header(log_period>0 ? log_period : LOGGER_DEFAULT_PERIOD))
-		return 3;
-	
 	/* create log file */
-	UINT bw;
-	FRESULT fres = f_open(&logger_fp, file_name, FA_OPEN_ALWAYS | FA_WRITE);
-	if(fres == FR_OK){
-		fres = f_write(&logger_fp, log_header_t, sizeof(LOG_HeaderDef)-sizeof(LOG_ElementInfoDef*), &bw);
-		if(fres == FR_OK && bw == sizeof(LOG_HeaderDef)-sizeof(LOG_ElementInfoDef*)){
-			fres = f_write(&logger_fp, log_header_t->element_info, log_header_t->element_num*sizeof(LOG_ElementInfoDef), &bw);
-			if(fres != FR_OK || bw!= log_header_t->element_num*sizeof(LOG_ElementInfoDef)){
-				Console.e(TAG, "log header write fail:%d bw:%d\n", fres, bw);
-				res = 4;
-				goto error;
-			}
-			
-			rt_tick_t tick = log_period>0 ? log_period : LOGGER_DEFAULT_PERIOD;
+	FRESULT fres = f_open(&logger_fp, file_name, FA_CREATE_ALWAYS | FA_WRITE);
+	if(fres != FR_OK){
+		Console.e(TAG, "log file create fail:%d\n", fres);
+		return 4;
+	}
+	
+	_logger_info.record_cnt = 0;
+	_logger_info.delta_cnt = 0;
+	_logger_info.ring_drop_cnt = 0;
+	if(delta && _logger_delta_start()){
+		f_close(&logger_fp);
+		return 4;
+	}
+	if(log_writer_start(&logger_fp, compress)){
+		Console.e(TAG, "log writer start fail\n");
+		f_close(&logger_fp);
+		return 4;
+	}
+	if(logger_write_header()){
+		Console.e(TAG, "log header write fail\n");
+		if(log_writer_stop()){
+			/* writer still uses the file, next logger stop closes it. Ring
+			 * can not be drained to a stopped writer, it restarts after stop */
 			_logger_info.status = LOGGER_BUSY;
-			_logger_info.last_record_time = 0;
-			_logger_info.log_period = tick;
-			
-			/* start logger timer */
-			rt_timer_control(&_timer_logger, RT_TIMER_CTRL_SET_TIME, &tick);
-			rt_timer_start(&_timer_logger);
-			
-			Console.print("log file create successful, start to log... tick=%d\n", tick);
-		}else{
-			Console.e(TAG, "log header write fail:%d bw:%d\n", fres, bw);
-			res = 4;
+			_ring_capture = 0;
+			return 4;
 		}
-	}else{
-		Console.e(TAG, "log file create fail:%d\n", fres);
-		res = 4;
+		f_close(&logger_fp);
+		return 4;
+	}
+	
+	/* only record data published after start, unless ring has been capturing it */
+	if(!_ring_capture){
+		mcn_clear(MCN_ID(SENSOR_GYR), _gyr_node_t);
+		mcn_clear(MCN_ID(SENSOR_ACC), _acc_node_t);
+		mcn_clear(MCN_ID(ADRC), _adrc_node_t);
+	}
+	for(uint32_t i = 0 ; i < LOG_MSG_NUM ; i++){
+		log_msg_list[i].last_record_time = 0;
+		log_msg_list[i].record_cnt = 0;
 	}
 	
-error:	
-	logger_release_header();
+	rt_tick_t tick = log_period>0 ? log_period : LOGGER_DEFAULT_PERIOD;
+	_logger_info.status = LOGGER_BUSY;
+	_logger_info.delta = delta;
+	_logger_info.last_record_time = 0;
+	_logger_info.log_period = tick;
+	
+	/* start logger timer */
+	rt_timer_control(&_timer_logger, RT_TIMER_CTRL_SET_TIME, &tick);
+	rt_timer_start(&_timer_logger);
+	
+	Console.print("log file create successful, start to log... tick=%d compress:%s delta:%s\n", tick,
+					log_compress_name(compress), delta ? "on" : "off");
+	if(_ring_capture){
+		Console.print("%d records before start are in ring\n", _ring.record_num);
+	}
+	
+	return res;
+}
+
+uint8_t logger_start(char* file_name, uint32_t log_period, uint8_t compress, uint8_t delta)
+{
+	uint8_t res;
+	
+	_logger_lock();
+	res = _logger_start(file_name, log_period, compress, delta);
+	_logger_unlock();
 	
 	return res;
 }
 
 void logger_stop(void)
 {
+	rt_tick_t tick = LOGGER_DEFAULT_PERIOD;
+	uint32_t wait;
+	
+	_logger_lock();
+	
+	if(_logger_info.status != LOGGER_BUSY){
+		_logger_unlock();
+		return;
+	}
+	
 	rt_timer_stop(&_timer_logger);
-	f_close(&logger_fp);
+	/* records captured before start may not be drained yet. A stalled writer
+	 * never makes room, drop what is left after the writer stop timeout */
+	for(wait = 0 ; _ring_capture ; wait++){
+		_logger_ring_drain();
+		if(!_ring_capture)
+			break;
+		if(wait >= WRITER_STOP_TIMEOUT){
+			Console.e(TAG, "ring drain timeout, %d records dropped\n", _ring.record_num);
+			_logger_info.ring_drop_cnt += _ring.record_num;
+			log_ring_clear(&_ring);
+			_ring_capture = 0;
+			break;
+		}
+		rt_thread_delay(1);
+	}
+	/* write out all buffered data before closing file */
+	if(log_writer_stop()){
+		/* writer thread may still write to the file, keep it open and busy */
+		Console.e(TAG, "log writer is busy, stop log again later\n");
+		_logger_unlock();
+		return;
+	}
 	_logger_info.status = LOGGER_IDLE;
-	Console.print("logger stop successful\n");
+	_logger_info.delta = 0;
+	f_close(&logger_fp);
+	Console.print("logger stop successful, %d records\n", _logger_info.record_cnt);
+	
+	/* go back to capture */
+	if(_ring.buff){
+		log_ring_clear(&_ring);
+		_ring_capture = 1;
+		rt_timer_control(&_timer_logger, RT_TIMER_CTRL_SET_TIME, &tick);
+		rt_timer_start(&_timer_logger);
+	}
+	
+	_logger_unlock();
+}
+
+static uint8_t logger_ring_enable(uint32_t size, uint8_t compress, uint8_t delta)
+{
+	rt_tick_t tick = LOGGER_DEFAULT_PERIOD;
+	uint8_t* buff;
+	
+	if(_logger_info.status == LOGGER_BUSY){
+		Console.print("logger is busy, please first stop log\n");
+		return 2;
+	}
+	
+	_logger_lock();
+	if(_ring.buff){
+		rt_free(_ring.buff);
+		_ring.buff = NULL;
+	}
+	buff = rt_malloc(size);
+	if(buff == NULL){
+		_ring_capture = 0;
+		_ring_trigger = 0;
+		rt_timer_stop(&_timer_logger);
+		_logger_unlock();
+		Console.e(TAG, "fail to malloc ring buffer:%d\n", size);
+		return 1;
+	}
+	log_ring_init(&_ring, buff, size);
+	_ring_compress = compress;
+	_ring_delta = delta;
+	_ring_trigger = LOG_TRIGGER_ALL;
+	
+	mcn_clear(MCN_ID(SENSOR_GYR), _gyr_node_t);
+	mcn_clear(MCN_ID(SENSOR_ACC), _acc_node_t);
+	mcn_clear(MCN_ID(ADRC), _adrc_node_t);
+	_ring_capture = 1;
+	rt_timer_control(&_timer_logger, RT_TIMER_CTRL_SET_TIME, &tick);
+	rt_timer_start(&_timer_logger);
+	_logger_unlock();
+	
+	Console.print("pre-trigger ring of %d bytes is capturing\n", size);
+	
+	return 0;
+}
+
+static void logger_ring_disable(void)
+{
+	if(_logger_info.status == LOGGER_BUSY){
+		Console.print("logger is busy, please first stop log\n");
+		return;
+	}
+	
+	_logger_lock();
+	rt_timer_stop(&_timer_logger);
+	_ring_capture = 0;
+	_ring_trigger = 0;
+	if(_ring.buff){
+		rt_free(_ring.buff);
+		_ring.buff = NULL;
+	}
+	_logger_unlock();
+}
+
+static void logger_ring_show_status(void)
+{
+	uint8_t record[sizeof(LOG_RecordHeaderDef)+LOG_MAX_PAYLOAD_SIZE];
+	LOG_RecordHeaderDef* oldest = (LOG_RecordHeaderDef*)record;
+	
+	if(_ring.buff == NULL){
+		Console.print("ring: off\n");
+		return;
+	}
+	
+	_logger_lock();
+	Console.print("ring: %s, %d/%d bytes, %d records, %d overwritten\n", _ring_capture ? "capturing" : "idle",
+					_ring.used, _ring.size, _ring.record_num, _ring.evict_cnt);
+	/* ring only holds plain records */
+	if(log_ring_peek(&_ring, record, sizeof(record)) >= sizeof(LOG_RecordHeaderDef)){
+		Console.print("ring span: %d ms\n", ((uint32_t)time_nowUs() - oldest->timestamp)/1000);
+	}
+	_logger_unlock();
+}
+
+/* can be called from any thread or isr, the log is started in logger thread */
+void logger_trigger(uint32_t reason)
+{
+	if(!_logger_ready || !(_ring_trigger & reason) || _logger_info.status == LOGGER_BUSY)
+		return;
+	
+	rt_event_send(&event_log, (reason & LOG_TRIGGER_ALL) << EVENT_LOG_TRIGGER_SHIFT);
+}
+
+static void _logger_error_hook(char* tag)
+{
+	/* errors of logger itself would trigger again and again */
+	if(strncmp(tag, "Log", 3) == 0)
+		return;
+	
+	logger_trigger(LOG_TRIGGER_ERROR);
+}
+
+static void _logger_handle_trigger(uint32_t reason)
+{
+	char file_name[16];
+	FILINFO info;
+	uint16_t n;
+	uint8_t i;
+	
+	if(_logger_info.status == LOGGER_BUSY || !_ring_capture)
+		return;
+	
+	for(n = 0 ; n <= LOG_TRIGGER_FILE_MAX ; n++){
+		sprintf(file_name, "TRIG%03d.LOG", n);
+		if(f_stat(file_name, &info) == FR_NO_FILE)
+			break;
+	}
+	if(n > LOG_TRIGGER_FILE_MAX){
+		Console.e(TAG, "no free trigger log name, trigger is disabled\n");
+		_ring_trigger = 0;
+		return;
+	}
+	
+	for(i = 0 ; !(reason & (1<<i)) ; i++);
+	Console.print("log is triggered by %s\n", _trigger_name[i]);
+	if(_logger_start(file_name, 0, _ring_compress, _ring_delta)){
+		Console.e(TAG, "triggered log start fail, trigger is disabled\n");
+		_ring_trigger = 0;
+	}
+}
+
+/* load of the named thread, all zero if it is not in the statistic */
+static const thread_load_t* _logger_thread_load(const sys_load_t* sys_load, const char* name)
+{
+	static const thread_load_t none;
+	
+	for(uint8_t n = 0 ; n < sys_load->thread_num ; n++){
+		if(strncmp(sys_load->thread[n].name, name, RT_NAME_MAX) == 0)
+			return &sys_load->thread[n];
+	}
+	
+	return &none;
 }
 
 uint8_t logger_record(void)
 {
-	float gyr[3], acc[3], filter_gyr[3], filter_acc[3], mag[3], filter_mag[3];
+	float gyr[3], acc[3], mag[3], filter_gyr[3], filter_acc[3], filter_mag[3];
 	float throttle[MOTOR_NUM];
 	Euler euler;
 	quaternion quat;
 	ADRC_Log adrc_log;
 	BaroPosition baro_pos;
-	POS_KF_Log pos_kf_log;
 	Altitude_Info alt_info;
 	Position_Info pos_info;
+	struct vehicle_gps_position_s gps_report;
+	/* keep it off the logger stack */
+	static sys_load_t sys_load;
+	uint32_t now = time_nowMs();
+	uint32_t now_us = (uint32_t)time_nowUs();
+	uint8_t res = 0;
+	
+	/* high rate topics are queued, record every sample with its publish time */
+	while(mcn_pop(MCN_ID(SENSOR_GYR), _gyr_node_t, gyr) == 0){
+		LOG_GyrDef msg;
+		LOG_SET_ELEMENT(msg, GYR_X, gyr[0]);
+		LOG_SET_ELEMENT(msg, GYR_Y, gyr[1]);
+		LOG_SET_ELEMENT(msg, GYR_Z, gyr[2]);
+		res |= _logger_write_msg(LOG_MSG_GYR, _gyr_node_t->stamp, &msg);
+	}
+	
+	while(mcn_pop(MCN_ID(SENSOR_ACC), _acc_node_t, acc) == 0){
+		LOG_AccDef msg;
+		LOG_SET_ELEMENT(msg, ACC_X, acc[0]);
+		LOG_SET_ELEMENT(msg, ACC_Y, acc[1]);
+		LOG_SET_ELEMENT(msg, ACC_Z, acc[2]);
+		res |= _logger_write_msg(LOG_MSG_ACC, _acc_node_t->stamp, &msg);
+	}
+	
+	while(mcn_pop(MCN_ID(ADRC), _adrc_node_t, &adrc_log) == 0){
+		LOG_AdrcDef msg;
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_SP_RATE, adrc_log.sp_rate);
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_V, adrc_log.v);
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_V1, adrc_log.v1);
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_V2, adrc_log.v2);
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_Z1, adrc_log.z1);
+		LOG_SET_ELEMENT(msg, ADRC_PITCH_Z2, adrc_log.z2);
+		res |= _logger_write_msg(LOG_MSG_ADRC, _adrc_node_t->stamp, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_MAG, _mag_node_t, now)){
+		LOG_MagDef msg;
+		mcn_copy(MCN_ID(SENSOR_MAG), _mag_node_t, mag);
+		mcn_copy_from_hub(MCN_ID(SENSOR_FILTER_MAG), filter_mag);
+		LOG_SET_ELEMENT(msg, MAG_X, mag[0]);
+		LOG_SET_ELEMENT(msg, MAG_Y, mag[1]);
+		LOG_SET_ELEMENT(msg, MAG_Z, mag[2]);
+		LOG_SET_ELEMENT(msg, MAG_FILTER_X, filter_mag[0]);
+		LOG_SET_ELEMENT(msg, MAG_FILTER_Y, filter_mag[1]);
+		LOG_SET_ELEMENT(msg, MAG_FILTER_Z, filter_mag[2]);
+		res |= _logger_write_msg(LOG_MSG_MAG, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_FILTER, _filter_gyr_node_t, now)){
+		LOG_FilterDef msg;
+		mcn_copy(MCN_ID(SENSOR_FILTER_GYR), _filter_gyr_node_t, filter_gyr);
+		mcn_copy_from_hub(MCN_ID(SENSOR_FILTER_ACC), filter_acc);
+		LOG_SET_ELEMENT(msg, GYR_FILTER_X, filter_gyr[0]);
+		LOG_SET_ELEMENT(msg, GYR_FILTER_Y, filter_gyr[1]);
+		LOG_SET_ELEMENT(msg, GYR_FILTER_Z, filter_gyr[2]);
+		LOG_SET_ELEMENT(msg, ACC_FILTER_X, filter_acc[0]);
+		LOG_SET_ELEMENT(msg, ACC_FILTER_Y, filter_acc[1]);
+		LOG_SET_ELEMENT(msg, ACC_FILTER_Z, filter_acc[2]);
+		res |= _logger_write_msg(LOG_MSG_FILTER, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_ATT, _att_node_t, now)){
+		LOG_AttDef msg;
+		mcn_copy(MCN_ID(ATT_QUATERNION), _att_node_t, &quat);
+		mcn_copy_from_hub(MCN_ID(ATT_EULER), &euler);
+		LOG_SET_ELEMENT(msg, QUATERNION_W, quat.w);
+		LOG_SET_ELEMENT(msg, QUATERNION_X, quat.x);
+		LOG_SET_ELEMENT(msg, QUATERNION_Y, quat.y);
+		LOG_SET_ELEMENT(msg, QUATERNION_Z, quat.z);
+		LOG_SET_ELEMENT(msg, ROLL, Rad2Deg(euler.roll));
+		LOG_SET_ELEMENT(msg, PITCH, Rad2Deg(euler.pitch));
+		LOG_SET_ELEMENT(msg, YAW, Rad2Deg(euler.yaw));
+		res |= _logger_write_msg(LOG_MSG_ATT, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_POS, _pos_node_t, now)){
+		LOG_PosDef msg;
+		mcn_copy(MCN_ID(POS_INFO), _pos_node_t, &pos_info);
+		mcn_copy_from_hub(MCN_ID(ALT_INFO), &alt_info);
+		LOG_SET_ELEMENT(msg, X, pos_info.x);
+		LOG_SET_ELEMENT(msg, Y, pos_info.y);
+		LOG_SET_ELEMENT(msg, Z, alt_info.alt);
+		LOG_SET_ELEMENT(msg, VX, pos_info.vx);
+		LOG_SET_ELEMENT(msg, VY, pos_info.vy);
+		LOG_SET_ELEMENT(msg, VZ, alt_info.vz);
+		res |= _logger_write_msg(LOG_MSG_POS, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_MOTOR, _motor_node_t, now)){
+		LOG_MotorDef msg;
+		mcn_copy(MCN_ID(MOTOR_THROTTLE), _motor_node_t, throttle);
+		LOG_SET_ELEMENT(msg, MOTOR_1, throttle[0]);
+		LOG_SET_ELEMENT(msg, MOTOR_2, throttle[1]);
+		LOG_SET_ELEMENT(msg, MOTOR_3, throttle[2]);
+		LOG_SET_ELEMENT(msg, MOTOR_4, throttle[3]);
+		res |= _logger_write_msg(LOG_MSG_MOTOR, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_GPS, _gps_node_t, now)){
+		LOG_GpsDef msg;
+		Vector3f_t pos, vel;
+		mcn_copy(MCN_ID(GPS_POSITION), _gps_node_t, &gps_report);
+		gps_get_position(&pos, gps_report);
+		gps_get_velocity(&vel, gps_report);
+		LOG_SET_ELEMENT(msg, GPS_LAT, (float)gps_report.lat*1e-7);
+		LOG_SET_ELEMENT(msg, GPS_LON, (float)gps_report.lon*1e-7);
+		LOG_SET_ELEMENT(msg, GPS_X, pos.x);
+		LOG_SET_ELEMENT(msg, GPS_Y, pos.y);
+		LOG_SET_ELEMENT(msg, GPS_Z, pos.z);
+		LOG_SET_ELEMENT(msg, GPS_VN, vel.x);
+		LOG_SET_ELEMENT(msg, GPS_VE, vel.y);
+		LOG_SET_ELEMENT(msg, GPS_VD, vel.z);
+		LOG_SET_ELEMENT(msg, GPS_HDOP, gps_report.hdop);
+		res |= _logger_write_msg(LOG_MSG_GPS, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_BARO, _baro_node_t, now)){
+		LOG_BaroDef msg;
+		mcn_copy(MCN_ID(BARO_POSITION), _baro_node_t, &baro_pos);
+		LOG_SET_ELEMENT(msg, BARO_ALT, baro_pos.altitude);
+		LOG_SET_ELEMENT(msg, BARO_VEL, baro_pos.velocity);
+		res |= _logger_write_msg(LOG_MSG_BARO, now_us, &msg);
+	}
+	
+	if(_logger_msg_ready(LOG_MSG_LOAD, _load_node_t, now)){
+		LOG_LoadDef msg;
+		const thread_load_t* load;
+		mcn_copy(MCN_ID(SYS_LOAD), _load_node_t, &sys_load);
+		LOG_SET_ELEMENT(msg, CPU, sys_load.cpu_usage);
+		load = _logger_thread_load(&sys_load, "fastloop");
+		LOG_SET_ELEMENT(msg, FASTLOOP_LOAD, load->load*0.01f);
+		LOG_SET_ELEMENT(msg, FASTLOOP_LAT, load->latency_max);
+		load = _logger_thread_load(&sys_load, "copter");
+		LOG_SET_ELEMENT(msg, COPTER_LOAD, load->load*0.01f);
+		LOG_SET_ELEMENT(msg, COPTER_LAT, load->latency_max);
+		load = _logger_thread_load(&sys_load, "mavproxy");
+		LOG_SET_ELEMENT(msg, MAVPROXY_LOAD, load->load*0.01f);
+		LOG_SET_ELEMENT(msg, MAVPROXY_LAT, load->latency_max);
+		load = _logger_thread_load(&sys_load, "logger");
+		LOG_SET_ELEMENT(msg, LOGGER_LOAD, load->load*0.01f);
+		LOG_SET_ELEMENT(msg, LOGGER_LAT, load->latency_max);
+		load = _logger_thread_load(&sys_load, "log_writer");
+		LOG_SET_ELEMENT(msg, LOG_WRITER_LOAD, load->load*0.01f);
+		LOG_SET_ELEMENT(msg, LOG_WRITER_LAT, load->latency_max);
+		res |= _logger_write_msg(LOG_MSG_LOAD, now_us, &msg);
+	}
 	
-	mcn_copy_from_hub(MCN_ID(ATT_QUATERNION), &quat);
-	mcn_copy_from_hub(MCN_ID(ATT_EULER), &euler);
-	mcn_copy_from_hub(MCN_ID(SENSOR_GYR), gyr);
-	mcn_copy_from_hub(MCN_ID(SENSOR_FILTER_GYR), filter_gyr);
-	mcn_copy_from_hub(MCN_ID(SENSOR_ACC), acc);
-	mcn_copy_from_hub(MCN_ID(SENSOR_FILTER_ACC), filter_acc);
-	mcn_copy_from_hub(MCN_ID(SENSOR_MAG), mag);
-	mcn_copy_from_hub(MCN_ID(SENSOR_FILTER_MAG), filter_mag);
-	mcn_copy_from_hub(MCN_ID(MOTOR_THROTTLE), throttle);
-	mcn_copy_from_hub(MCN_ID(ADRC), &adrc_log);
-	mcn_copy_from_hub(MCN_ID(BARO_POSITION), &baro_pos);
-	mcn_copy_from_hub(MCN_ID(POS_KF), &pos_kf_log);
-	mcn_copy_from_hub(MCN_ID(ALT_INFO), &alt_info);
-	mcn_copy_from_hub(MCN_ID(POS_INFO), &pos_info);
-	struct vehicle_gps_position_s gps_report = gps_get_report();
-	Vector3f_t pos, vel;
-	gps_get_position(&pos, gps_report);
-	gps_get_velocity(&vel, gps_report);
-	
-	LOG_SET_ELEMENT(_logger_info, QUATERNION_W, quat.w);
-	LOG_SET_ELEMENT(_logger_info, QUATERNION_X, quat.x);
-	LOG_SET_ELEMENT(_logger_info, QUATERNION_Y, quat.y);
-	LOG_SET_ELEMENT(_logger_info, QUATERNION_Z, quat.z);
-	LOG_SET_ELEMENT(_logger_info, ROLL, Rad2Deg(euler.roll));
-	LOG_SET_ELEMENT(_logger_info, PITCH, Rad2Deg(euler.pitch));
-	LOG_SET_ELEMENT(_logger_info, YAW, Rad2Deg(euler.yaw));
-	LOG_SET_ELEMENT(_logger_info, X, pos_info.x);
-	LOG_SET_ELEMENT(_logger_info, Y, pos_info.y);
-	LOG_SET_ELEMENT(_logger_info, Z, alt_info.alt);
-	LOG_SET_ELEMENT(_logger_info, VX, pos_info.vx);
-	LOG_SET_ELEMENT(_logger_info, VY, pos_info.vy);
-	LOG_SET_ELEMENT(_logger_info, VZ, alt_info.vz);
-	LOG_SET_ELEMENT(_logger_info, GYR_X, gyr[0]);
-	LOG_SET_ELEMENT(_logger_info, GYR_Y, gyr[1]);
-	LOG_SET_ELEMENT(_logger_info, GYR_Z, gyr[2]);
-	LOG_SET_ELEMENT(_logger_info, GYR_FILTER_X, filter_gyr[0]);
-	LOG_SET_ELEMENT(_logger_info, GYR_FILTER_Y, filter_gyr[1]);
-	LOG_SET_ELEMENT(_logger_info, GYR_FILTER_Z, filter_gyr[2]);
-	LOG_SET_ELEMENT(_logger_info, ACC_X, acc[0]);
-	LOG_SET_ELEMENT(_logger_info, ACC_Y, acc[1]);
-	LOG_SET_ELEMENT(_logger_info, ACC_Z, acc[2]);
-	LOG_SET_ELEMENT(_logger_info, ACC_FILTER_X, filter_acc[0]);
-	LOG_SET_ELEMENT(_logger_info, ACC_FILTER_Y, filter_acc[1]);
-	LOG_SET_ELEMENT(_logger_info, ACC_FILTER_Z, filter_acc[2]);
-	LOG_SET_ELEMENT(_logger_info, MAG_X, mag[0]);
-	LOG_SET_ELEMENT(_logger_info, MAG_Y, mag[1]);
-	LOG_SET_ELEMENT(_logger_info, MAG_Z, mag[2]);
-	LOG_SET_ELEMENT(_logger_info, MAG_FILTER_X, filter_mag[0]);
-	LOG_SET_ELEMENT(_logger_info, MAG_FILTER_Y, filter_mag[1]);
-	LOG_SET_ELEMENT(_logger_info, MAG_FILTER_Z, filter_mag[2]);
-	LOG_SET_ELEMENT(_logger_info, MOTOR_1, throttle[0]);
-	LOG_SET_ELEMENT(_logger_info, MOTOR_2, throttle[1]);
-	LOG_SET_ELEMENT(_logger_info, MOTOR_3, throttle[2]);
-	LOG_SET_ELEMENT(_logger_info, MOTOR_4, throttle[3]);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_SP_RATE, adrc_log.sp_rate);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_V, adrc_log.v);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_V1, adrc_log.v1);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_V2, adrc_log.v2);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_Z1, adrc_log.z1);
-	LOG_SET_ELEMENT(_logger_info, ADRC_PITCH_Z2, adrc_log.z2);
-	LOG_SET_ELEMENT(_logger_info, GPS_LAT, (float)gps_report.lat*1e-7);
-	LOG_SET_ELEMENT(_logger_info, GPS_LON, (float)gps_report.lon*1e-7);
-	LOG_SET_ELEMENT(_logger_info, GPS_X, pos.x);
-	LOG_SET_ELEMENT(_logger_info, GPS_Y, pos.y);
-	LOG_SET_ELEMENT(_logger_info, GPS_Z, pos.z);
-	LOG_SET_ELEMENT(_logger_info, GPS_VN, vel.x);
-	LOG_SET_ELEMENT(_logger_info, GPS_VE, vel.y);
-	LOG_SET_ELEMENT(_logger_info, GPS_VD, vel.z);
-	LOG_SET_ELEMENT(_logger_info, GPS_HDOP, gps_report.hdop);
-	LOG_SET_ELEMENT(_logger_info, BARO_ALT, baro_pos.altitude);
-	LOG_SET_ELEMENT(_logger_info, BARO_VEL, baro_pos.velocity);
-//	LOG_SET_ELEMENT(_logger_info, KF_U_X, pos_kf_log.u_x);
-//	LOG_SET_ELEMENT(_logger_info, KF_U_Y, pos_kf_log.u_y);
-//	LOG_SET_ELEMENT(_logger_info, KF_U_Z, pos_kf_log.u_z);
-//	LOG_SET_ELEMENT(_logger_info, KF_X, pos_kf_log.est_x);
-//	LOG_SET_ELEMENT(_logger_info, KF_Y, pos_kf_log.est_y);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z, pos_kf_log.est_z);
-//	LOG_SET_ELEMENT(_logger_info, KF_VX, pos_kf_log.est_vx);
-//	LOG_SET_ELEMENT(_logger_info, KF_VY, pos_kf_log.est_vy);
-//	LOG_SET_ELEMENT(_logger_info, KF_VZ, pos_kf_log.est_vz);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_X, pos_kf_log.obs_x);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_Y, pos_kf_log.obs_y);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_Z, pos_kf_log.obs_z);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_VX, pos_kf_log.obs_vx);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_VY, pos_kf_log.obs_vy);
-//	LOG_SET_ELEMENT(_logger_info, KF_Z_VZ, pos_kf_log.obs_vz);
-	
-	UINT bw;
-	f_write(&logger_fp, &_logger_info.log_field, sizeof(_logger_info.log_field), &bw);
-	
-	return (bw == sizeof(_logger_info.log_field)) ? 0 : 1;
+	_logger_info.last_record_time = now;
+	
+	return res;
 }
 
-void logger_show_element_info(uint32_t element_num, const LOG_ElementInfoDef* element_info)
-{
-	Console.print("%-20s %-10s\n", "Name", "Type");
-	for(uint32_t i = 0 ; i < element_num ; i++){
-		char ele_type[10];
-		switch(element_info[i].type)
-		{
-			case LOG_INT8:
-			{
-				strcpy(ele_type, "INT8");
-			}break;
-			case LOG_UINT8:
-			{
-				strcpy(ele_type, "UINT8");
-			}break;
-			case LOG_INT16:
-			{
-				strcpy(ele_type, "INT16");
-			}break;
-			case LOG_UINT16:
-			{
-				strcpy(ele_type, "UINT16");
-			}break;
-			case LOG_INT32:
-			{
-				strcpy(ele_type, "INT32");
-			}break;
-			case LOG_UINT32:
-			{
-				strcpy(ele_type, "UINT32");
-			}break;
-			case LOG_FLOAT:
-			{
-				strcpy(ele_type, "FLOAT");
-			}break;
-			case LOG_DOUBLE:
-			{
-				strcpy(ele_type, "DOUBLE");
-			}break;
-		}
-		Console.print("%-20s %-10s\n", element_info[i].name, ele_type);
+static const char* logger_type_name(uint32_t type)
+{
+	switch(type)
+	{
+		case LOG_INT8:
+			return "INT8";
+		case LOG_UINT8:
+			return "UINT8";
+		case LOG_INT16:
+			return "INT16";
+		case LOG_UINT16:
+			return "UINT16";
+		case LOG_INT32:
+			return "INT32";
+		case LOG_UINT32:
+			return "UINT32";
+		case LOG_FLOAT:
+			return "FLOAT";
+		case LOG_DOUBLE:
+			return "DOUBLE";
+		default:
+			return "UNKNOWN";
 	}
 }
 
-uint8_t logger_parse_header(char* file_name)
+/* index footer is at the end of both plain and compressed log */
+static void logger_show_index(FIL* fp)
 {
-	FIL fp;
 	UINT br;
+	LOG_IndexTailDef tail;
+	LOG_IndexHeaderDef header;
 	
-	if(log_header_t != NULL){
-		Console.print("logger is busy now\n");
-		return 1;
+	if(f_size(fp) < sizeof(tail) || f_lseek(fp, f_size(fp) - sizeof(tail)) != FR_OK
+		|| f_read(fp, &tail, sizeof(tail), &br) != FR_OK || br != sizeof(tail)
+		|| tail.magic != LOG_INDEX_MAGIC || tail.index_size > f_size(fp)
+		|| tail.index_size != sizeof(header) + tail.entry_num*sizeof(LOG_IndexEntryDef) + sizeof(tail)){
+		Console.print("Index: none, rebuild it with tool/LogIndex/logidx\n");
+		return;
 	}
-	log_header_t = (LOG_HeaderDef*)rt_malloc(sizeof(LOG_HeaderDef));
-	if(log_header_t == NULL){
-		return 1;
+	
+	f_lseek(fp, f_size(fp) - tail.index_size);
+	if(f_read(fp, &header, sizeof(header), &br) != FR_OK || br != sizeof(header) || header.sync != LOG_RECORD_SYNC_INDEX){
+		Console.print("Index: broken\n");
+		return;
+	}
+	Console.print("Index: %d entries, one per %d byte\n", tail.entry_num, header.stride*LOG_SYNC_INTERVAL);
+}
+
+/* compressed log can not be parsed on board, only show its block statistic */
+static uint8_t logger_parse_blocks(FIL* fp)
+{
+	UINT br;
+	LOG_BlockHeaderDef block;
+	uint32_t block_cnt[LOG_COMPRESS_NUM] = {0};
+	uint32_t raw_size = 0;
+	uint8_t res = 0;
+	
+	f_lseek(fp, 0);
+	while(f_read(fp, &block, sizeof(block), &br) == FR_OK && br == sizeof(block)){
+		if(block.magic != LOG_BLOCK_MAGIC || block.method >= LOG_COMPRESS_NUM){
+			Console.print("invalid block at %d\n", f_tell(fp)-sizeof(block));
+			res = 3;
+			break;
+		}
+		block_cnt[block.method]++;
+		raw_size = block.raw_offset + block.raw_size;
+		if(f_lseek(fp, f_tell(fp) + block.data_size) != FR_OK || f_tell(fp) > f_size(fp)){
+			Console.print("truncated block at %d\n", f_tell(fp));
+			break;
+		}
 	}
 	
+	Console.print("Compressed Log\n");
+	Console.print("File Size: %d byte\n", f_size(fp));
+	Console.print("Raw Size: %d byte\n", raw_size);
+	for(uint8_t i = 0 ; i < LOG_COMPRESS_NUM ; i++){
+		Console.print("%s blocks: %d\n", log_compress_name(i), block_cnt[i]);
+	}
+	logger_show_index(fp);
+	
+	return res;
+}
+
+uint8_t logger_parse_header(char* file_name)
+{
+	FIL fp;
+	UINT br;
+	LOG_HeaderDef header;
+	LOG_FormatDef format;
+	LOG_ElementInfoDef element;
+	uint8_t res = 0;
+	
 	FRESULT fres = f_open(&fp, file_name, FA_OPEN_EXISTING | FA_READ);
 	if(fres != FR_OK){
 		Console.print("%s open fail!\n", file_name);
 		return 2;
 	}
 	
-	fres = f_read(&fp, &log_header_t->start_time, sizeof(log_header_t->start_time), &br);
-	fres = f_read(&fp, &log_header_t->log_period, sizeof(log_header_t->log_period), &br);
-	fres = f_read(&fp, &log_header_t->element_num, sizeof(log_header_t->element_num), &br);
-	fres = f_read(&fp, &log_header_t->header_size, sizeof(log_header_t->header_size), &br);
-	fres = f_read(&fp, &log_header_t->field_size, sizeof(log_header_t->field_size), &br);
-	log_header_t->element_info = (LOG_ElementInfoDef*)rt_malloc(log_header_t->element_num*sizeof(LOG_ElementInfoDef));
-	if(log_header_t->element_info == NULL){
-		logger_release_header();
-		return 0;
+	fres = f_read(&fp, &header, sizeof(header), &br);
+	if(fres == FR_OK && br == sizeof(header) && header.magic == LOG_BLOCK_MAGIC){
+		res = logger_parse_blocks(&fp);
+		f_close(&fp);
+		return res;
+	}
+	if(fres != FR_OK || br != sizeof(header) || header.magic != LOG_MAGIC){
+		Console.print("%s is not a valid log file\n", file_name);
+		f_close(&fp);
+		return 3;
 	}
-	f_read(&fp, log_header_t->element_info, log_header_t->element_num*sizeof(LOG_ElementInfoDef), &br);
-	f_close(&fp);
 	
-	Console.print("Start Time: %d\n", log_header_t->start_time);
-	Console.print("Log Period: %d\n", log_header_t->log_period);
-	Console.print("Element Number: %d\n", log_header_t->element_num);
-	Console.print("Header Size: %d byte\n", log_header_t->header_size);
-	Console.print("Field Size: %d byte\n", log_header_t->field_size);
-	logger_show_element_info(log_header_t->element_num, log_header_t->element_info);
+	Console.print("Version: %d\n", header.version);
+	Console.print("Start Time: %d\n", header.start_time);
+	Console.print("Message Number: %d\n", header.msg_num);
+	Console.print("Header Size: %d byte\n", header.header_size);
+	Console.print("Data Size: %d byte\n", f_size(&fp)-header.header_size);
+	logger_show_index(&fp);
+	f_lseek(&fp, sizeof(header));
 	
-	logger_release_header();
-	return 0;
+	for(uint32_t n = 0 ; n < header.msg_num ; n++){
+		fres = f_read(&fp, &format, sizeof(format), &br);
+		if(fres != FR_OK || br != sizeof(format)){
+			res = 3;
+			break;
+		}
+		format.name[LOG_MAX_NAME_LENGTH-1] = '\0';
+		Console.print("\n[%d] %s, period:%dms, payload:%d byte\n", format.msg_id, format.name, format.period, format.payload_size);
+		Console.print("%-20s %-10s\n", "Name", "Type");
+		for(uint32_t i = 0 ; i < format.element_num ; i++){
+			fres = f_read(&fp, &element, sizeof(element), &br);
+			if(fres != FR_OK || br != sizeof(element)){
+				res = 3;
+				break;
+			}
+			element.name[LOG_MAX_NAME_LENGTH-1] = '\0';
+			Console.print("%-20s %-10s\n", element.name, logger_type_name(element.type));
+		}
+	}
+	
+	f_close(&fp);
+	
+	return res;
 }
 
 int handle_logger_shell_cmd(int argc, char** argv)
@@ -421,16 +995,72 @@ int handle_logger_shell_cmd(int argc, char** argv)
 	
 	if(argc > 1){
 		if(strcmp(argv[1], "start") == 0){
-			if(argc == 3)
-				res = logger_start(argv[2], 0);	// default period
-			if(argc == 4)
-				res = logger_start(argv[2], atoi(argv[3]));
+			uint32_t period = 0;	// default period
+			uint8_t compress = LOG_COMPRESS_NONE;
+			uint8_t delta = 0;
+			for(int i = 3 ; i < argc ; i++){
+				if(argv[i][0] >= '0' && argv[i][0] <= '9'){
+					period = atoi(argv[i]);
+				}else if(strcmp(argv[i], "delta") == 0){
+					delta = 1;
+				}else{
+					compress = log_compress_method(argv[i]);
+				}
+			}
+			if(argc < 3){
+				Console.print("usage: logger start <file> [period] [none|lzo|deflate] [delta]\n");
+			}else if(compress >= LOG_COMPRESS_NUM){
+				Console.print("unknown compress method\n");
+				res = 1;
+			}else{
+				res = logger_start(argv[2], period, compress, delta);
+			}
 		}
 		if(strcmp(argv[1], "stop") == 0){
 			logger_stop();
 		}
-		if(strcmp(argv[1], "info") == 0 && argc == 3){
-			res = logger_parse_header(argv[2]);
+		if(strcmp(argv[1], "info") == 0){
+			if(argc == 3){
+				res = logger_parse_header(argv[2]);
+			}else{
+				Console.print("status: %s, %d records, %d delta coded, %d ring records dropped\n",
+								_logger_info.status==LOGGER_BUSY ? "busy" : "idle", _logger_info.record_cnt,
+								_logger_info.delta_cnt, _logger_info.ring_drop_cnt);
+				log_writer_show_status();
+				logger_ring_show_status();
+			}
+		}
+		if(strcmp(argv[1], "ring") == 0){
+			uint32_t size = 0;
+			uint8_t compress = LOG_COMPRESS_NONE;
+			uint8_t delta = 0;
+			for(int i = 3 ; i < argc ; i++){
+				if(strcmp(argv[i], "delta") == 0){
+					delta = 1;
+				}else{
+					compress = log_compress_method(argv[i]);
+				}
+			}
+			if(argc >= 3)
+				size = atoi(argv[2])*1024;
+			if(argc >= 3 && strcmp(argv[2], "off") == 0){
+				logger_ring_disable();
+			}else if(size == 0){
+				Console.print("usage: logger ring <size KB> [none|lzo|deflate] [delta]\n");
+				Console.print("       logger ring off\n");
+			}else if(compress >= LOG_COMPRESS_NUM){
+				Console.print("unknown compress method\n");
+				res = 1;
+			}else{
+				res = logger_ring_enable(size, compress, delta);
+			}
+		}
+		if(strcmp(argv[1], "trigger") == 0){
+			if(_ring_capture && _logger_info.status != LOGGER_BUSY){
+				logger_trigger(LOG_TRIGGER_SHELL);
+			}else{
+				Console.print("ring is not capturing\n");
+			}
 		}
 	}
 	
@@ -446,10 +1076,11 @@ void logger_entry(void *parameter)
 {
 	rt_err_t res;
 	rt_uint32_t recv_set = 0;
-	rt_uint32_t wait_set = EVENT_LOG_RECORD;
+	rt_uint32_t wait_set = EVENT_LOG_RECORD | EVENT_LOG_TRIGGER;
 	
 	/* create event */
 	res = rt_event_init(&event_log, "logger_event", RT_IPC_FLAG_FIFO);
+	rt_mutex_init(&_ring_lock, "log_ring", RT_IPC_FLAG_FIFO);
 	
 	rt_timer_init(&_timer_logger, "logger",
 					timer_logger_record,
@@ -457,18 +1088,47 @@ void logger_entry(void *parameter)
 					LOGGER_DEFAULT_PERIOD,
 					RT_TIMER_FLAG_PERIODIC | RT_TIMER_FLAG_SOFT_TIMER);
 	
+	/* subscribe logged topics */
+	_gyr_node_t = mcn_subscribe(MCN_ID(SENSOR_GYR), NULL);
+	_acc_node_t = mcn_subscribe(MCN_ID(SENSOR_ACC), NULL);
+	_mag_node_t = mcn_subscribe(MCN_ID(SENSOR_MAG), NULL);
+	_filter_gyr_node_t = mcn_subscribe(MCN_ID(SENSOR_FILTER_GYR), NULL);
+	_att_node_t = mcn_subscribe(MCN_ID(ATT_QUATERNION), NULL);
+	_pos_node_t = mcn_subscribe(MCN_ID(POS_INFO), NULL);
+	_motor_node_t = mcn_subscribe(MCN_ID(MOTOR_THROTTLE), NULL);
+	_adrc_node_t = mcn_subscribe(MCN_ID(ADRC), NULL);
+	_gps_node_t = mcn_subscribe(MCN_ID(GPS_POSITION), NULL);
+	_baro_node_t = mcn_subscribe(MCN_ID(BARO_POSITION), NULL);
+	_load_node_t = mcn_subscribe(MCN_ID(SYS_LOAD), NULL);
+	if(_gyr_node_t == NULL || _acc_node_t == NULL || _mag_node_t == NULL || _filter_gyr_node_t == NULL
+		|| _att_node_t == NULL || _pos_node_t == NULL || _motor_node_t == NULL || _adrc_node_t == NULL
+		|| _gps_node_t == NULL || _baro_node_t == NULL || _load_node_t == NULL){
+		Console.e(TAG, "log topic subscribe err\n");
+	}
+	
+	_logger_ready = 1;
+	console_set_error_hook(_logger_error_hook);
+	
 	while(1)
 	{
 		/* wait event occur */
-		res = rt_event_recv(&event_log, wait_set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR, 
+		res = rt_event_recv(&event_log, wait_set, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
 								RT_WAITING_FOREVER, &recv_set);
-		
+	
 		if(res == RT_EOK){
-			logger_record();
+			_logger_lock();
+			if(recv_set & EVENT_LOG_TRIGGER){
+				_logger_handle_trigger(recv_set >> EVENT_LOG_TRIGGER_SHIFT);
+			}
+			if(recv_set & EVENT_LOG_RECORD){
+				logger_record();
+				if(_ring_capture && _logger_info.status == LOGGER_BUSY)
+					_logger_ring_drain();
+			}
+			_logger_unlock();
 		}else{
 			/* some error happens */
 			Console.e(TAG, "logger loop, err:%d\r\n" , res);
 		}
 	}
 }
-
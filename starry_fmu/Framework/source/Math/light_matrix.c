@@ -25,57 +25,6 @@
 #define MAT_LEGAL_CHECKING
 
 #define min(a, b) ((a) > (b) ? (b) : (a))
-//#define equal(a, b)	((a-b)<1e-7 && (a-b)>-(1e-7))
-#define equal(a, b)	(((a)-(b))<(1e-15) && ((a)-(b))>-(1e-15))
-
-/************************************************************************/
-/*                          Private Function                            */
-/************************************************************************/
-
-void swap(int *a, int *b)
-{
-	int m;
-	m = *a;
-	*a = *b;
-	*b = m;
-}
- 
-void perm(int list[], int k, int m, int* p, Mat* mat, LIGHT_MATRIX_TYPE* det) 
-{
-	int i;
-
-	if(k > m){
-		LIGHT_MATRIX_TYPE res = mat->element[0][list[0]];
-
-		for(i = 1; i < mat->row ; i++){
-			res *= mat->element[i][list[i]];
-		}
-
-		if(*p%2){
-			//odd is negative
-			*det -= res;
-		}else{
-			//even is positive
-			*det += res;
-		}
-	}
-	else{
-		// if the element is 0, we don't need to calculate the value for this permutation
-//		if(!equal(mat->element[k][list[k]], 0.0f))
-//			perm(list, k + 1, m, p, mat, det);
-		perm(list, k + 1, m, p, mat, det);
-		for(i = k+1; i <= m; i++)
-		{
-//			if(equal(mat->element[k][list[i]], 0.0f))
-//				continue;
-			swap(&list[k], &list[i]);
-			*p += 1;
-			perm(list, k + 1, m, p, mat, det);
-			swap(&list[k], &list[i]);
-			*p -= 1; 
-		}
-	}
-}
 
 /************************************************************************/
 /*                           Public Function                            */
@@ -278,10 +227,10 @@ Mat* MatTrans(Mat* src, Mat* dst)
 // return det(mat)
 LIGHT_MATRIX_TYPE MatDet(Mat* mat)
 {
+	Mat lu;
+	int *pivot;
+	int sign, i;
 	LIGHT_MATRIX_TYPE det = 0.0f;
-	int plarity = 0;
-	int *list;
-	int i;
 
 #ifdef MAT_LEGAL_CHECKING
 	if( mat->row != mat->col){
@@ -291,16 +240,26 @@ LIGHT_MATRIX_TYPE MatDet(Mat* mat)
 	}
 #endif
 
-	list = (int*)rt_malloc(sizeof(int)*mat->col);
-	if(list == NULL){
-		printf("malloc list fail\n");
+	if(MatCreate(&lu, mat->row, mat->col) == NULL){
 		return 0.0f;
 	}
-	for(i = 0 ; i < mat->col ; i++)
-		list[i] = i;
+	pivot = (int*)rt_malloc(sizeof(int)*mat->row);
+	if(pivot == NULL){
+		printf("malloc pivot fail\n");
+		MatDelete(&lu);
+		return 0.0f;
+	}
+
+	MatCopy(mat, &lu);
+	/* det(A) = sign * det(U), singular matrix has zero determinant */
+	if(MatLU(&lu, pivot, &sign) == 0){
+		det = (LIGHT_MATRIX_TYPE)sign;
+		for(i = 0 ; i < lu.row ; i++)
+			det *= lu.element[i][i];
+	}
 
-	perm(list, 0, mat->row-1, &plarity, mat, &det);
-	rt_free(list);
+	rt_free(pivot);
+	MatDelete(&lu);
 
 	return det;
 }
@@ -354,9 +313,10 @@ Mat* MatAdj(Mat* src, Mat* dst)
 // dst = src^(-1)
 Mat* MatInv(Mat* src, Mat* dst)
 {
-	Mat adj_mat;
-	LIGHT_MATRIX_TYPE det;
-	int row, col;
+	Mat lu;
+	int *pivot;
+	int sign, row, col;
+	Mat* res = dst;
 
 #ifdef MAT_LEGAL_CHECKING
 	if( src->row != src->col || src->row != dst->row || src->col != dst->col){
@@ -366,25 +326,284 @@ Mat* MatInv(Mat* src, Mat* dst)
 		return NULL;
 	}
 #endif
-	//printf("create\n");
-	MatCreate(&adj_mat, src->row, src->col);
-	//printf("create finish\n");
-	MatAdj(src, &adj_mat);
-	//printf("adj\n");
-	det = MatDet(src);
-	//printf("inv det:%f\n", det);
-
-	if(equal(det, 0.0f)){
+
+	if(MatCreate(&lu, src->row, src->col) == NULL){
+		return NULL;
+	}
+	pivot = (int*)rt_malloc(sizeof(int)*src->row);
+	if(pivot == NULL){
+		printf("malloc pivot fail\n");
+		MatDelete(&lu);
+		return NULL;
+	}
+
+	MatCopy(src, &lu);
+	if(MatLU(&lu, pivot, &sign)){
 		printf("err, determinate is 0 for MatInv\n");
+		res = NULL;
+	}else{
+		/* solve A*X = I, right hand side is the permuted identity */
+		for(row = 0 ; row < dst->row ; row++){
+			for(col = 0 ; col < dst->col ; col++)
+				dst->element[row][col] = (pivot[row] == col) ? 1.0f : 0.0f;
+		}
+		MatForwardSub(&lu, dst, dst, 1);
+		MatBackSub(&lu, dst, dst);
+	}
+
+	rt_free(pivot);
+	MatDelete(&lu);
+
+	return res;
+}
+
+// solve src1*dst = src2
+Mat* MatSolve(Mat* src1, Mat* src2, Mat* dst)
+{
+	Mat lu;
+	int *pivot;
+	int sign;
+	Mat* res = dst;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( src1->row != src1->col || src1->row != src2->row || src2->row != dst->row || src2->col != dst->col){
+		printf("err check, unmatch matrix for MatSolve\n");
+		MatDump(src1);
+		MatDump(src2);
+		MatDump(dst);
 		return NULL;
 	}
-	
-	for(row = 0 ; row < src->row ; row++){
-		for(col = 0 ; col < src->col ; col++)
-			dst->element[row][col] = adj_mat.element[row][col]/det;
+#endif
+
+	if(MatCreate(&lu, src1->row, src1->col) == NULL){
+		return NULL;
+	}
+	pivot = (int*)rt_malloc(sizeof(int)*src1->row);
+	if(pivot == NULL){
+		printf("malloc pivot fail\n");
+		MatDelete(&lu);
+		return NULL;
+	}
+
+	MatCopy(src1, &lu);
+	if(MatLU(&lu, pivot, &sign)){
+		printf("err, singular matrix for MatSolve\n");
+		res = NULL;
+	}else{
+		res = MatLUSolve(&lu, pivot, src2, dst);
+	}
+
+	rt_free(pivot);
+	MatDelete(&lu);
+
+	return res;
+}
+
+// LU decomposition with partial pivoting, P*mat = L*U
+// mat is overwritten by L (unit diagonal, not stored) and U. Rows are swapped
+// by pointer, pivot[i] is the original row index of row i.
+// return 0 if success, 1 if mat is singular
+int MatLU(Mat* mat, int* pivot, int* sign)
+{
+	int i, j, k, p;
+	LIGHT_MATRIX_TYPE max, factor;
+	LIGHT_MATRIX_TYPE *row_ptr;
+	int n = mat->row;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( mat->row != mat->col){
+		printf("err check, not a square matrix for MatLU\n");
+		MatDump(mat);
+		return 1;
+	}
+#endif
+
+	for(i = 0 ; i < n ; i++)
+		pivot[i] = i;
+	*sign = 1;
+
+	for(k = 0 ; k < n ; k++){
+		/* find pivot in column k */
+		p = k;
+		max = fabs(mat->element[k][k]);
+		for(i = k+1 ; i < n ; i++){
+			if(fabs(mat->element[i][k]) > max){
+				max = fabs(mat->element[i][k]);
+				p = i;
+			}
+		}
+		if(max == 0.0f){
+			return 1;
+		}
+
+		if(p != k){
+			row_ptr = mat->element[k];
+			mat->element[k] = mat->element[p];
+			mat->element[p] = row_ptr;
+			i = pivot[k];
+			pivot[k] = pivot[p];
+			pivot[p] = i;
+			*sign = -*sign;
+		}
+
+		for(i = k+1 ; i < n ; i++){
+			factor = mat->element[i][k] / mat->element[k][k];
+			mat->element[i][k] = factor;
+			for(j = k+1 ; j < n ; j++)
+				mat->element[i][j] -= factor * mat->element[k][j];
+		}
+	}
+
+	return 0;
+}
+
+// solve A*dst = src with lu and pivot from MatLU, dst can not be src
+Mat* MatLUSolve(Mat* lu, int* pivot, Mat* src, Mat* dst)
+{
+	int row, col;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( lu->row != src->row || src->row != dst->row || src->col != dst->col || src == dst){
+		printf("err check, unmatch matrix for MatLUSolve\n");
+		MatDump(lu);
+		MatDump(src);
+		MatDump(dst);
+		return NULL;
+	}
+#endif
+
+	for(row = 0 ; row < dst->row ; row++){
+		for(col = 0 ; col < dst->col ; col++)
+			dst->element[row][col] = src->element[pivot[row]][col];
+	}
+	MatForwardSub(lu, dst, dst, 1);
+	MatBackSub(lu, dst, dst);
+
+	return dst;
+}
+
+// Cholesky decomposition of symmetric positive definite mat, mat = L*L'
+// mat is overwritten by L, only lower triangle of mat is read.
+// return 0 if success, 1 if mat is not positive definite
+int MatCholesky(Mat* mat)
+{
+	int i, j, k;
+	LIGHT_MATRIX_TYPE sum;
+	int n = mat->row;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( mat->row != mat->col){
+		printf("err check, not a square matrix for MatCholesky\n");
+		MatDump(mat);
+		return 1;
+	}
+#endif
+
+	for(j = 0 ; j < n ; j++){
+		sum = mat->element[j][j];
+		for(k = 0 ; k < j ; k++)
+			sum -= mat->element[j][k] * mat->element[j][k];
+		if(sum <= 0.0f){
+			return 1;
+		}
+		mat->element[j][j] = sqrtf(sum);
+
+		for(i = j+1 ; i < n ; i++){
+			sum = mat->element[i][j];
+			for(k = 0 ; k < j ; k++)
+				sum -= mat->element[i][k] * mat->element[j][k];
+			mat->element[i][j] = sum / mat->element[j][j];
+			mat->element[j][i] = 0.0f;
+		}
+	}
+
+	return 0;
+}
+
+// solve L*L'*dst = src with L from MatCholesky, dst can be src
+Mat* MatCholeskySolve(Mat* L, Mat* src, Mat* dst)
+{
+	int i, k, col;
+	LIGHT_MATRIX_TYPE sum;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( L->row != L->col || L->row != src->row || src->row != dst->row || src->col != dst->col){
+		printf("err check, unmatch matrix for MatCholeskySolve\n");
+		MatDump(L);
+		MatDump(src);
+		MatDump(dst);
+		return NULL;
+	}
+#endif
+
+	/* L*y = src */
+	MatForwardSub(L, src, dst, 0);
+	/* L'*dst = y */
+	for(col = 0 ; col < dst->col ; col++){
+		for(i = L->row-1 ; i >= 0 ; i--){
+			sum = dst->element[i][col];
+			for(k = i+1 ; k < L->row ; k++)
+				sum -= L->element[k][i] * dst->element[k][col];
+			dst->element[i][col] = sum / L->element[i][i];
+		}
+	}
+
+	return dst;
+}
+
+// solve L*dst = src, L is lower triangular, dst can be src
+// unit_diag: diagonal of L is treated as 1 and not read
+Mat* MatForwardSub(Mat* L, Mat* src, Mat* dst, int unit_diag)
+{
+	int i, k, col;
+	LIGHT_MATRIX_TYPE sum;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( L->row != L->col || L->row != src->row || src->row != dst->row || src->col != dst->col){
+		printf("err check, unmatch matrix for MatForwardSub\n");
+		MatDump(L);
+		MatDump(src);
+		MatDump(dst);
+		return NULL;
+	}
+#endif
+
+	for(col = 0 ; col < dst->col ; col++){
+		for(i = 0 ; i < L->row ; i++){
+			sum = src->element[i][col];
+			for(k = 0 ; k < i ; k++)
+				sum -= L->element[i][k] * dst->element[k][col];
+			dst->element[i][col] = unit_diag ? sum : sum / L->element[i][i];
+		}
+	}
+
+	return dst;
+}
+
+// solve U*dst = src, U is upper triangular, dst can be src
+Mat* MatBackSub(Mat* U, Mat* src, Mat* dst)
+{
+	int i, k, col;
+	LIGHT_MATRIX_TYPE sum;
+
+#ifdef MAT_LEGAL_CHECKING
+	if( U->row != U->col || U->row != src->row || src->row != dst->row || src->col != dst->col){
+		printf("err check, unmatch matrix for MatBackSub\n");
+		MatDump(U);
+		MatDump(src);
+		MatDump(dst);
+		return NULL;
+	}
+#endif
+
+	for(col = 0 ; col < dst->col ; col++){
+		for(i = U->row-1 ; i >= 0 ; i--){
+			sum = src->element[i][col];
+			for(k = i+1 ; k < U->row ; k++)
+				sum -= U->element[i][k] * dst->element[k][col];
+			dst->element[i][col] = sum / U->element[i][i];
+		}
 	}
-	
-	MatDelete(&adj_mat);
 
 	return dst;
 }
@@ -12,6 +12,11 @@
 #include "console.h"
 #include "mavlink_param.h"
 
+/* power of 2, at least twice of MAV_PARAM_NUM */
+#define MAV_PARAM_INDEX_SLOT_NUM		512
+
+static char* TAG = "MAV_PARAM";
+
 static mavlink_param_t mavlink_param = {
 	MAVLINK_PARAM_DEFINE(SYS_AUTOSTART, 4001),
 	MAVLINK_PARAM_DEFINE(SYS_AUTOCONFIG, 0),
@@ -273,6 +278,17 @@ static mavlink_param_t mavlink_param = {
 	MAVLINK_PARAM_DEFINE(MPC_XY_VEL_D, 0.0),
 };
 
+/* name -> mavlink_param index */
+static uint16_t _mav_param_index_slot[MAV_PARAM_INDEX_SLOT_NUM];
+static param_name_index_t _mav_param_index;
+
+static const char* _mav_param_get_name(uint16_t item)
+{
+	param_t *mav_param = &mavlink_param;
+
+	return mav_param[item].name;
+}
+
 void mavlink_param_init(void)
 {
 	param_info_t *param;
@@ -318,40 +334,43 @@ void mavlink_param_init(void)
 		}
 	}
 
+	param_name_index_init(&_mav_param_index, _mav_param_index_slot, MAV_PARAM_INDEX_SLOT_NUM, _mav_param_get_name);
+	for (int i = 0; i < MAV_PARAM_NUM; i++) {
+		if (param_name_index_add(&_mav_param_index, i)) {
+			Console.e(TAG, "param index is full\n");
+			break;
+		}
+	}
+
 }
 
 param_t *mavlink_param_get_by_name(const char *name)
 {
-	int i = 0;
+	int i = param_name_index_find(&_mav_param_index, name);
 	param_t *mav_param = &mavlink_param;
-	for(i = 0 ; i < MAV_PARAM_NUM ; i++) {
-		if(strncmp(name, mav_param->name, 16) == 0) {
-			if (mav_param->param) {
-				switch (mav_param->param->type) {
-					case PARAM_TYPE_FLOAT:
-						mav_param->value = mav_param->param->val.f;
-						break;
-					case PARAM_TYPE_INT32:
-						memcpy(&(mav_param->value), &(mav_param->param->val.i), sizeof(mav_param->param->val.i));
-						break;
-					case PARAM_TYPE_UINT32:
-						memcpy(&(mav_param->value), &(mav_param->param->val.u), sizeof(mav_param->param->val.u));
-						break;
-					default:
-						mav_param->value = mav_param->param->val.f;
-						break;
-				}
-			}
-			break;
-		}
-		mav_param++;
-	}
 
-	if (i < MAV_PARAM_NUM) {
-		return mav_param;
-	} else {
+	if (i < 0) {
 		return NULL;
 	}
+	mav_param += i;
+	if (mav_param->param) {
+		switch (mav_param->param->type) {
+			case PARAM_TYPE_FLOAT:
+				mav_param->value = mav_param->param->val.f;
+				break;
+			case PARAM_TYPE_INT32:
+				memcpy(&(mav_param->value), &(mav_param->param->val.i), sizeof(mav_param->param->val.i));
+				break;
+			case PARAM_TYPE_UINT32:
+				memcpy(&(mav_param->value), &(mav_param->param->val.u), sizeof(mav_param->param->val.u));
+				break;
+			default:
+				mav_param->value = mav_param->param->val.f;
+				break;
+		}
+	}
+
+	return mav_param;
 }
 
 param_t *mavlink_param_get_by_info(param_info_t *param)
@@ -390,47 +409,18 @@ param_t *mavlink_param_get_by_info(param_info_t *param)
 
 int mavlink_param_set_value(const char *name, float value)
 {
-	int i = 0;
+	int i = param_name_index_find(&_mav_param_index, name);
 	param_info_t* param = NULL;
 
-	param_t *mav_param = &mavlink_param;
-	for(i = 0 ; i < MAV_PARAM_NUM ; i++) {
-		if(strncmp(name, mav_param->name, 16) == 0) {
-			if (mav_param->param) {
-				param_set_by_info(mav_param->param, value);
-				switch (mav_param->param->type) {
-					case PARAM_TYPE_FLOAT:
-						mav_param->value = mav_param->param->val.f;
-						break;
-					case PARAM_TYPE_INT32:
-						memcpy(&(mav_param->value), &(mav_param->param->val.i), sizeof(mav_param->param->val.i));
-						break;
-					case PARAM_TYPE_UINT32:
-						memcpy(&(mav_param->value), &(mav_param->param->val.u), sizeof(mav_param->param->val.u));
-						break;
-					default:
-						mav_param->value = mav_param->param->val.f;
-						break;
-				}
-			} else {
-				mav_param->value = value;
-			}
-			break;
-		}
-		mav_param++;
+	if (i >= 0) {
+		return mavlink_param_set_value_by_index(i, value);
 	}
 
-	if (i < MAV_PARAM_NUM) {
-		return 0;
-	} else {
-		param = param_get_by_name(name);
-		if (param) {
-			param_set_by_info(param, value);
-		}
-		return 0;
+	param = param_get_by_name((char*)name);
+	if (param) {
+		param_set_by_info(param, value);
 	}
-
-	return -1;
+	return 0;
 }
 
 int mavlink_param_set_value_by_index(uint32_t index, float value)
@@ -24,6 +24,7 @@
 #include "statistic.h"
 #include "mavlink_param.h"
 #include "mavlink_status.h"
+#include "mavlink_rx.h"
 #include "calibration.h"
 #include "shell.h"
 
@@ -46,7 +47,7 @@ static char *TAG = "MAV_Proxy";
 static struct rt_timer timer_mavproxy;
 static struct rt_event event_mavproxy;
 
-static mavlink_status_t mav_status;
+static mavlink_rx_t _mav_rx;
 static MAV_PeriodMsg_Queue _period_msg_queue;
 static MAV_TempMsg_Queue _temp_msg_queue;
 static McnNode_t _gps_status_node_t;
@@ -68,6 +69,7 @@ MCN_DECLARE(CORRECT_LIDAR);
 MCN_DECLARE(ATT_EULER);
 MCN_DECLARE(GPS_POSITION);
 MCN_DECLARE(GPS_STATUS);
+MCN_DECLARE(SYS_LOAD);
 
 extern uint8_t mavlink_lowlevel_write(uint8_t* buff, uint16_t len);
 extern int mavlink_lowlevel_read(uint8_t* buff, uint16_t len);
@@ -179,6 +181,31 @@ void mavproxy_msg_altitude_pack(mavlink_message_t *msg_t)
 	mavlink_msg_altitude_encode(mavlink_system.sysid, mavlink_system.compid, msg_t, &altitude);
 }
 
+/* one thread per message in turn, x: cpu load(%), y: switch per second, z: maximal wakeup latency(us) */
+void mavproxy_msg_thread_load_pack(mavlink_message_t *msg_t)
+{
+	static sys_load_t sys_load;
+	static uint8_t index = 0;
+	char name[MAVLINK_MSG_DEBUG_VECT_FIELD_NAME_LEN] = "cpu";
+	float x, y = 0, z = 0;
+
+	mcn_copy_from_hub(MCN_ID(SYS_LOAD), &sys_load);
+	
+	if(sys_load.thread_num){
+		thread_load_t* load;
+		index = index < sys_load.thread_num ? index : 0;
+		load = &sys_load.thread[index++];
+		strncpy(name, load->name, sizeof(name));
+		x = load->load*0.01f;
+		y = load->switch_rate;
+		z = load->latency_max;
+	}else{
+		x = sys_load.cpu_usage;
+	}
+	
+	mavlink_msg_debug_vect_pack(mavlink_system.sysid, mavlink_system.compid, msg_t, name, time_nowUs(), x, y, z);
+}
+
 void mavproxy_msg_global_position_pack(mavlink_message_t *msg_t)
 {
 	mavlink_global_position_int_t global_position;
@@ -465,125 +492,127 @@ static void mavproxy_send_all_param(void)
 	rt_event_send(&event_mavproxy, EVENT_MAVPROXY_SEND_ALL_PARAM);
 }
 
+static void mavproxy_msg_handler(mavlink_message_t* msg)
+{
+	//Console.print("mav msg:%d\n", msg->msgid);
+	/* decode mavlink package */
+	switch(msg->msgid){
+		case MAVLINK_MSG_ID_HEARTBEAT:
+			break;
+		case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
+		{
+			if(mavlink_system.sysid == mavlink_msg_param_request_read_get_target_system(msg)) {
+				mavlink_param_request_read_t request_read;
+				mavlink_msg_param_request_read_decode(msg, &request_read);
+				mavlink_send_single_param(request_read.param_id, msg);
+			}
+			break;
+		}
+		case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
+		{
+			if(mavlink_system.sysid == mavlink_msg_param_request_list_get_target_system(msg)) {
+				mavproxy_send_all_param();
+			}
+			break;
+		}
+		case MAVLINK_MSG_ID_PARAM_SET:
+		{
+			if(mavlink_system.sysid == mavlink_msg_param_set_get_target_system(msg)) {
+				param_info_t* param = NULL;
+				mavlink_param_set_t param_set;
+				mavlink_msg_param_set_decode(msg, &param_set);
+
+				mavlink_param_set_value(param_set.param_id, param_set.param_value);
+				mavlink_send_single_param(param_set.param_id, msg);
+			}
+			break;
+		}
+		case MAVLINK_MSG_ID_COMMAND_LONG:
+		{
+			if(mavlink_system.sysid == mavlink_msg_command_long_get_target_system(msg)) {
+				mavlink_command_long_t command;
+				mavlink_msg_command_long_decode(msg, &command);
+
+				mavproxy_proc_command(&command, msg);
+			}
+			break;
+		}
+		case MAVLINK_MSG_ID_SERIAL_CONTROL:
+		{
+			mavlink_serial_control_t serial_control;
+			mavlink_msg_serial_control_decode(msg, &serial_control);
+			
+			// the last byte for data is '\0', change to '\r'
+			//serial_control.data[serial_control.count] = '\r';	
+
+			for(uint8_t i = 0 ; i < serial_control.count ; i++){
+				if(!ringbuffer_putc(_mav_serial_rb, serial_control.data[i])) break;
+			}
+
+			mavproxy_console_proc(serial_control.count);
+			break;
+		}
+		case MAVLINK_MSG_ID_HIL_SENSOR:
+		{
+			mavlink_hil_sensor_t hil_sensor;
+			mavlink_msg_hil_sensor_decode(msg, &hil_sensor);
+			/* publish */
+			mcn_publish(MCN_ID(HIL_SENSOR), &hil_sensor);
+		}break;
+		case MAVLINK_MSG_ID_HIL_GPS:
+		{
+			mavlink_hil_gps_t hil_gps;
+			mavlink_msg_hil_gps_decode(msg, &hil_gps);
+			//Console.print("lat:%f, vn:%f eph:%f\n", (double)hil_gps.lat*1e-7, (float)hil_gps.vn*1e-2, (float)hil_gps.eph*1e-2);
+			
+			struct vehicle_gps_position_s gps_position;
+			gps_position.lat = hil_gps.lat;
+			gps_position.lon = hil_gps.lon;
+			gps_position.alt = hil_gps.alt;
+			gps_position.eph = (float)hil_gps.eph*1e-2;
+			gps_position.epv = (float)hil_gps.epv*1e-2;
+			gps_position.vel_m_s = (float)hil_gps.vel*1e-2;
+			gps_position.vel_n_m_s = (float)hil_gps.vn*1e-2;
+			gps_position.vel_e_m_s = (float)hil_gps.ve*1e-2;
+			gps_position.vel_d_m_s = (float)hil_gps.vd*1e-2;
+			gps_position.fix_type = hil_gps.fix_type;
+			gps_position.satellites_used = hil_gps.satellites_visible;
+			uint32_t now = time_nowMs();
+			gps_position.timestamp_position = gps_position.timestamp_velocity = now;
+			
+			mcn_publish(MCN_ID(GPS_POSITION), &gps_position);
+		}break;
+		case MAVLINK_MSG_ID_HIL_STATE_QUATERNION:
+		{
+			mavlink_hil_state_quaternion_t	hil_state_q;
+			mavlink_msg_hil_state_quaternion_decode(msg, &hil_state_q);
+			/* publish */
+			mcn_publish(MCN_ID(HIL_STATE_Q), &hil_state_q);
+		}break;
+		default :
+		{
+			//Console.print("mav unknown msg:%d\n", msg->msgid);
+		}break;
+	}
+}
+
 void mavproxy_rx_entry(void *param)
 {
+	static uint8_t rx_buff[MAVLINK_RX_BUFFER_SIZE];
 	mavlink_message_t msg;
-	int chan = 0;
-	char byte;
-	rt_err_t res = RT_EOK;
+
+	mavlink_rx_init(&_mav_rx);
 
 	while (1) {
-		rt_size_t rb = mavlink_lowlevel_read(&byte, 1);
+		/* read all available bytes and parse them in one go */
+		int rb = mavlink_lowlevel_read(rx_buff, sizeof(rx_buff));
 		if(rb <= 0) {
 			continue;
 		}
-		if(mavlink_parse_char(chan, byte, &msg, &mav_status)){
-			//Console.print("mav msg:%d\n", msg.msgid);
-			/* decode mavlink package */
-			switch(msg.msgid){
-				case MAVLINK_MSG_ID_HEARTBEAT:
-					break;
-				case MAVLINK_MSG_ID_PARAM_REQUEST_READ:
-				{
-					if(mavlink_system.sysid == mavlink_msg_param_request_read_get_target_system(&msg)) {
-						mavlink_param_request_read_t request_read;
-						mavlink_msg_param_request_read_decode(&msg, &request_read);
-						mavlink_send_single_param(request_read.param_id, &msg);
-					}
-					break;
-				}
-				case MAVLINK_MSG_ID_PARAM_REQUEST_LIST:
-				{
-					if(mavlink_system.sysid == mavlink_msg_param_request_list_get_target_system(&msg)) {
-						mavproxy_send_all_param();
-					}
-					break;
-				}
-				case MAVLINK_MSG_ID_PARAM_SET:
-				{
-					if(mavlink_system.sysid == mavlink_msg_param_set_get_target_system(&msg)) {
-						param_info_t* param = NULL;
-						mavlink_param_set_t param_set;
-						mavlink_msg_param_set_decode(&msg, &param_set);
-
-						mavlink_param_set_value(param_set.param_id, param_set.param_value);
-						mavlink_send_single_param(param_set.param_id, &msg);
-					}
-					break;
-				}
-				case MAVLINK_MSG_ID_COMMAND_LONG:
-				{
-					if(mavlink_system.sysid == mavlink_msg_command_long_get_target_system(&msg)) {
-						mavlink_command_long_t command;
-						mavlink_msg_command_long_decode(&msg, &command);
-
-						mavproxy_proc_command(&command, &msg);
-					}
-					break;
-				}
-				case MAVLINK_MSG_ID_SERIAL_CONTROL:
-				{
-					mavlink_serial_control_t serial_control;
-					mavlink_msg_serial_control_decode(&msg, &serial_control);
-					
-					// the last byte for data is '\0', change to '\r'
-					//serial_control.data[serial_control.count] = '\r';	
-
-					for(uint8_t i = 0 ; i < serial_control.count ; i++){
-						if(!ringbuffer_putc(_mav_serial_rb, serial_control.data[i])) break;
-					}
-
-					mavproxy_console_proc(serial_control.count);
-					break;
-				}
-				case MAVLINK_MSG_ID_HIL_SENSOR:
-				{
-					mavlink_hil_sensor_t hil_sensor;
-					mavlink_msg_hil_sensor_decode(&msg, &hil_sensor);
-					/* publish */
-					mcn_publish(MCN_ID(HIL_SENSOR), &hil_sensor);
-				}break;
-				case MAVLINK_MSG_ID_HIL_GPS:
-				{
-					mavlink_hil_gps_t hil_gps;
-					mavlink_msg_hil_gps_decode(&msg, &hil_gps);
-					//Console.print("lat:%f, vn:%f eph:%f\n", (double)hil_gps.lat*1e-7, (float)hil_gps.vn*1e-2, (float)hil_gps.eph*1e-2);
-					
-					struct vehicle_gps_position_s gps_position;
-					gps_position.lat = hil_gps.lat;
-					gps_position.lon = hil_gps.lon;
-					gps_position.alt = hil_gps.alt;
-					gps_position.eph = (float)hil_gps.eph*1e-2;
-					gps_position.epv = (float)hil_gps.epv*1e-2;
-					gps_position.vel_m_s = (float)hil_gps.vel*1e-2;
-					gps_position.vel_n_m_s = (float)hil_gps.vn*1e-2;
-					gps_position.vel_e_m_s = (float)hil_gps.ve*1e-2;
-					gps_position.vel_d_m_s = (float)hil_gps.vd*1e-2;
-					gps_position.fix_type = hil_gps.fix_type;
-					gps_position.satellites_used = hil_gps.satellites_visible;
-					uint32_t now = time_nowMs();
-					gps_position.timestamp_position = gps_position.timestamp_velocity = now;
-					
-					mcn_publish(MCN_ID(GPS_POSITION), &gps_position);
-				}break;
-				case MAVLINK_MSG_ID_HIL_STATE_QUATERNION:
-				{
-					mavlink_hil_state_quaternion_t	hil_state_q;
-					mavlink_msg_hil_state_quaternion_decode(&msg, &hil_state_q);
-					/* publish */
-					mcn_publish(MCN_ID(HIL_STATE_Q), &hil_state_q);
-				}break;
-				default :
-				{
-					//Console.print("mav unknown msg:%d\n", msg.msgid);
-				}break;
-			}
-		}
+		mavlink_rx_parse(&_mav_rx, rx_buff, rb, &msg, mavproxy_msg_handler);
 	}
-
 }
 
-
 int handle_mavproxy_shell_cmd(int argc, char** argv)
 {
 	if(argc > 1){
@@ -842,6 +871,7 @@ void mavproxy_entry(void *parameter)
 	mavproxy_period_msg_register(MAVLINK_MSG_ID_SCALED_IMU, 50, mavproxy_msg_scaled_imu_pack, 1);
 	mavproxy_period_msg_register(MAVLINK_MSG_ID_ATTITUDE, 100, mavproxy_msg_attitude_pack, 1);
 	mavproxy_period_msg_register(MAVLINK_MSG_ID_ALTITUDE, 100, mavproxy_msg_altitude_pack, 1);
+	mavproxy_period_msg_register(MAVLINK_MSG_ID_DEBUG_VECT, 100, mavproxy_msg_thread_load_pack, 1);
 	//mavproxy_period_msg_register(MAVLINK_MSG_ID_GLOBAL_POSITION_INT, 100, mavproxy_msg_global_position_pack, 1);
 
 	_gps_status_node_t = mcn_subscribe(MCN_ID(GPS_STATUS), mavproxy_gps_status_cb);
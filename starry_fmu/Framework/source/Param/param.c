@@ -16,9 +16,45 @@
 #include "ff.h"
 #include "file_manager.h"
 #include "yxml.h"
+#include "ap_math.h"
+#include "delay.h"
 
 #define PARAM_FILE_NAME				"/sys/param.xml"
+#define PARAM_BIN_FILE_NAME			"/sys/param.bin"
+#define PARAM_BIN_FILE_NAME_B		"/sys/param_b.bin"
 #define YXML_STACK_SIZE				1024
+#define PARAM_READ_BUFF_SIZE		512		/* one sector, f_read copies whole sectors directly */
+
+#define PARAM_BIN_MAGIC				0x4D524150	/* "PARM" */
+#define PARAM_BIN_VERSION			1
+#define PARAM_MAX_NUM				256
+#define PARAM_FLUSH_QUIET_TIME		1000	/* flush after no param set for 1s */
+#define PARAM_FLUSH_CHECK_PERIOD	100
+/* power of 2, at least twice of PARAM_MAX_NUM to keep probe sequence short */
+#define PARAM_INDEX_SLOT_NUM		(PARAM_MAX_NUM*2)
+
+#define EVENT_PARAM_FLUSH			(1<<0)
+
+#define FNV1_32_INIT				((uint32_t)0x811c9dc5)
+#define FNV1_32_PRIME				((uint32_t)0x01000193)
+
+/* binary param file: header followed by one record per param in param_list
+ * order. Two copies are kept and each flush rewrites the older one, so a
+ * write cut by power loss always leaves the other copy intact */
+typedef struct{
+	uint32_t magic;
+	uint16_t version;
+	uint16_t param_num;
+	uint32_t layout_hash;	/* hash of all param names in list order */
+	uint16_t crc;			/* crc16 of all records */
+	uint16_t seq;			/* write sequence, the valid copy with newer seq is loaded */
+}param_bin_header_t;
+
+typedef struct{
+	uint32_t name_hash;
+	uint32_t type;
+	param_value_t val;
+}param_bin_record_t;
 
 //PARAM_Def global_param;
 //PARAM_Def* global_param_t = &global_param;
@@ -94,6 +130,12 @@ PARAM_GROUP(ATT_CONTROLLER) PARAM_DECLARE_GROUP(ATT_CONTROLLER) = \
 	PARAM_DEFINE_FLOAT(ATT_ROLLR_I_LIM, 0.1), 
 	PARAM_DEFINE_FLOAT(ATT_PITCHR_I_LIM, 0.1), 
 	PARAM_DEFINE_FLOAT(ATT_YAWR_I_LIM, 0.1), 
+#ifdef BLUEJAY
+	PARAM_DEFINE_INT32(ATT_MIX_FRAME, 3),	/* 0:X 1:+ 2:hexa 3:bluejay */
+#else
+	PARAM_DEFINE_INT32(ATT_MIX_FRAME, 0),
+#endif
+	PARAM_DEFINE_INT32(ATT_MIX_DESAT, 0),	/* 0:clip each motor 1:keep attitude authority */
 };
 
 PARAM_GROUP(ALT_CONTROLLER) PARAM_DECLARE_GROUP(ALT_CONTROLLER) = \
@@ -151,6 +193,12 @@ PARAM_GROUP(HIL_SIM) PARAM_DECLARE_GROUP(HIL_SIM) = \
 	PARAM_DEFINE_UINT32(HIL_CONTROL_PRD, 4),  /* CONTROL PERIOD */
 };
 
+PARAM_GROUP(SENSOR_FILTER) PARAM_DECLARE_GROUP(SENSOR_FILTER) = \
+{ \
+	PARAM_DEFINE_INT32(GYR_NOTCH_EN, 0),		/* GYRO DYNAMIC NOTCH */
+	PARAM_DEFINE_FLOAT(GYR_NOTCH_LPF, 60),		/* GYRO LPF CUTOFF FREQ WHEN NOTCH IS ENABLED */
+};
+
 /* step 4: Define param list */
 param_list_t param_list = { \
 	PARAM_DEFINE_GROUP(CALIBRATION),
@@ -158,12 +206,27 @@ param_list_t param_list = { \
 	PARAM_DEFINE_GROUP(ALT_CONTROLLER),
 	PARAM_DEFINE_GROUP(ADRC_ATT),
 	PARAM_DEFINE_GROUP(HIL_SIM),
+	PARAM_DEFINE_GROUP(SENSOR_FILTER),
 };
 /* Define Parameter End */
 
 static char* TAG = "PARAM";
 
-void param_store(void);
+static uint32_t _dirty_bitmap[(PARAM_MAX_NUM+31)/32];
+static volatile uint32_t _dirty_cnt;
+static volatile uint32_t _last_set_time;
+/* binary copy written last and its sequence, next flush goes to the other one */
+static const char* _bin_file_name[2] = {PARAM_BIN_FILE_NAME, PARAM_BIN_FILE_NAME_B};
+static uint8_t _bin_slot = 1;
+static uint16_t _bin_seq = 0;
+
+static struct rt_mutex _param_lock;
+static struct rt_event _param_event;
+static param_store_status_t _store_status;
+
+/* name -> param_list index */
+static uint16_t _param_index_slot[PARAM_INDEX_SLOT_NUM];
+static param_name_index_t _param_index;
 
 void param_traverse(void (*param_ops)(param_info_t* param))
 {
@@ -181,53 +244,182 @@ void param_traverse(void (*param_ops)(param_info_t* param))
 	}
 }
 
-param_info_t* param_get_by_name(char* param_name)
+uint32_t param_get_info_count(void)
 {
+	uint32_t count = 0;
 	param_info_t* p;
 	param_group_info* gp = (param_group_info*)&param_list;
 	for(int j = 0 ; j < sizeof(param_list)/sizeof(param_group_info) ; j++) {
-		p = gp->content;
-		for(int i= 0 ; i < gp->param_num ; i++) {
-			if(strcmp(param_name, p->name) == 0)
-				return p;
-			p++;
-		}
+		count += gp->param_num;
 		gp++;
 	}
 	
-	return NULL;
+	return count;
 }
 
-uint32_t param_get_info_count(void)
+/* FNV-1a hash of a param name continued from hval. Names are bounded at
+ * PARAM_NAME_MAX_LEN, mavlink param_id is not null terminated when it has
+ * 16 chars */
+static uint32_t _param_hash(const char* name, uint32_t hval)
 {
-	uint32_t count = 0;
-	param_info_t* p;
+	const uint8_t* s = (const uint8_t*)name;
+	
+	for(uint8_t i = 0 ; i < PARAM_NAME_MAX_LEN && s[i] ; i++){
+		hval ^= (uint32_t)s[i];
+		hval *= FNV1_32_PRIME;
+	}
+	
+	return hval;
+}
+
+static int _param_get_index_by_info(param_info_t* param)
+{
+	int index = 0;
 	param_group_info* gp = (param_group_info*)&param_list;
 	for(int j = 0 ; j < sizeof(param_list)/sizeof(param_group_info) ; j++) {
-		count += gp->param_num;
+		if(param >= gp->content && param < gp->content + gp->param_num)
+			return index + (param - gp->content);
+		index += gp->param_num;
 		gp++;
 	}
 	
-	return count;
+	return -1;
 }
 
-uint32_t param_get_info_index(char* param_name)
+static param_info_t* _param_get_info_by_index(uint32_t index)
 {
-	uint32_t index = 0;
-	param_info_t* p;
 	param_group_info* gp = (param_group_info*)&param_list;
 	for(int j = 0 ; j < sizeof(param_list)/sizeof(param_group_info) ; j++) {
-		p = gp->content;
-		for(int i= 0 ; i < gp->param_num ; i++) {
-			if(strcmp(param_name, p->name) == 0)
-				return index;
-			p++;
-			index++;
-		}
+		if(index < gp->param_num)
+			return &gp->content[index];
+		index -= gp->param_num;
 		gp++;
 	}
 	
-	return index;
+	return NULL;
+}
+
+uint32_t param_name_hash(const char* name)
+{
+	return _param_hash(name, FNV1_32_INIT);
+}
+
+void param_name_index_init(param_name_index_t* index, uint16_t* slot, uint16_t slot_num, const char* (*get_name)(uint16_t item))
+{
+	memset(slot, 0, slot_num*sizeof(uint16_t));
+	index->slot = slot;
+	index->mask = slot_num - 1;
+	index->item_num = 0;
+	index->get_name = get_name;
+}
+
+int param_name_index_add(param_name_index_t* index, uint16_t item)
+{
+	uint16_t pos;
+	
+	/* keep at least one slot empty, so a failed search always terminates */
+	if(index->item_num >= index->mask)
+		return -1;
+	
+	/* linear probing */
+	pos = param_name_hash(index->get_name(item)) & index->mask;
+	while(index->slot[pos]){
+		pos = (pos+1) & index->mask;
+	}
+	index->slot[pos] = item + 1;
+	index->item_num++;
+	
+	return 0;
+}
+
+int param_name_index_find(const param_name_index_t* index, const char* name)
+{
+	uint16_t pos, item;
+	
+	if(index->slot == NULL)
+		return -1;
+	
+	pos = param_name_hash(name) & index->mask;
+	while(index->slot[pos]){
+		item = index->slot[pos] - 1;
+		if(strncmp(name, index->get_name(item), PARAM_NAME_MAX_LEN) == 0)
+			return item;
+		pos = (pos+1) & index->mask;
+	}
+	
+	return -1;
+}
+
+static const char* _param_index_get_name(uint16_t item)
+{
+	return _param_get_info_by_index(item)->name;
+}
+
+static uint8_t _param_build_index(void)
+{
+	uint32_t count = param_get_info_count();
+	
+	param_name_index_init(&_param_index, _param_index_slot, PARAM_INDEX_SLOT_NUM, _param_index_get_name);
+	for(uint32_t i = 0 ; i < count ; i++){
+		const char* name = _param_index_get_name(i);
+		
+		if(strlen(name) > PARAM_NAME_MAX_LEN){
+			Console.e(TAG, "param name %s is longer than %d\n", name, PARAM_NAME_MAX_LEN);
+			return 1;
+		}
+		if(param_name_index_find(&_param_index, name) >= 0){
+			Console.e(TAG, "duplicated param name %s\n", name);
+			return 1;
+		}
+		param_name_index_add(&_param_index, i);
+	}
+	
+	return 0;
+}
+
+param_info_t* param_get_by_name(char* param_name)
+{
+	int index = param_name_index_find(&_param_index, param_name);
+	
+	return index < 0 ? NULL : _param_get_info_by_index(index);
+}
+
+uint32_t param_get_info_index(char* param_name)
+{
+	int index = param_name_index_find(&_param_index, param_name);
+	
+	/* param count is returned if not found */
+	return index < 0 ? param_get_info_count() : index;
+}
+
+void param_mark_dirty(param_info_t* param)
+{
+	int index = _param_get_index_by_info(param);
+	
+	if(index < 0 || index >= PARAM_MAX_NUM)
+		return;
+	
+	OS_ENTER_CRITICAL;
+	if(!(_dirty_bitmap[index/32] & (1u<<(index%32)))){
+		_dirty_bitmap[index/32] |= 1u<<(index%32);
+		_dirty_cnt++;
+	}
+	_last_set_time = time_nowMs();
+	_store_status.set_cnt++;
+	OS_EXIT_CRITICAL;
+}
+
+static void _param_mark_all_dirty(void)
+{
+	uint32_t count = param_get_info_count();
+	
+	OS_ENTER_CRITICAL;
+	for(uint32_t i = 0 ; i < count && i < PARAM_MAX_NUM ; i++){
+		_dirty_bitmap[i/32] |= 1u<<(i%32);
+	}
+	_dirty_cnt = count;
+	_last_set_time = time_nowMs();
+	OS_EXIT_CRITICAL;
 }
 
 int param_set_by_info(param_info_t* param, float val)
@@ -247,7 +439,8 @@ int param_set_by_info(param_info_t* param, float val)
 			break;
 	}
 
-	param_store();
+	/* only mark dirty here, param thread flushes them to disk in batch */
+	param_mark_dirty(param);
 
 	return 0;
 }
@@ -259,10 +452,10 @@ int param_get_by_info(param_info_t* param, float *val)
 			*val = param->val.f;
 			break;
 		case PARAM_TYPE_INT32:
-			memcpy(&val, &(param->val.i), sizeof(param->val.i));
+			memcpy(val, &(param->val.i), sizeof(param->val.i));
 			break;
 		case PARAM_TYPE_UINT32:
-			memcpy(&val, &(param->val.u), sizeof(param->val.u));
+			memcpy(val, &(param->val.u), sizeof(param->val.u));
 			break;
 		default:
 			*val = param->val.f;
@@ -359,18 +552,16 @@ int param_dump_param(char* group_name, char* param_name)
 
 param_info_t* param_get(char* group_name, char* param_name)
 {
-	param_info_t* p;
+	param_info_t* p = param_get_by_name(param_name);
 	param_group_info* gp = (param_group_info*)&param_list;
+	
+	if(p == NULL)
+		return NULL;
+	
+	/* param names are unique, only check it belongs to the group */
 	for(int j = 0 ; j < sizeof(param_list)/sizeof(param_group_info) ; j++){
-		if( strcmp(group_name, gp->name)==0 ){
-			p = gp->content;
-			for(int i= 0 ; i < gp->param_num ; i++){
-				if( strcmp(param_name, p->name)==0 )
-					return p;
-				
-				p++;
-			}
-		}
+		if(p >= gp->content && p < gp->content + gp->param_num)
+			return strcmp(group_name, gp->name) == 0 ? p : NULL;
 		gp++;
 	}
 	
@@ -532,11 +723,184 @@ int param_parse_state_machine(yxml_t *x, yxml_ret_t r, PARAM_PARSE_STATE* status
 	return 1;
 }
 
+static void _param_make_record(param_info_t* p, param_bin_record_t* rec)
+{
+	rec->name_hash = param_name_hash(p->name);
+	rec->type = p->type;
+	rec->val = p->val;
+}
+
+static uint32_t _param_layout_hash(void)
+{
+	uint32_t count = param_get_info_count();
+	uint32_t layout_hash = FNV1_32_INIT;
+	
+	for(uint32_t i = 0 ; i < count ; i++){
+		layout_hash = _param_hash(_param_get_info_by_index(i)->name, layout_hash);
+	}
+	
+	return layout_hash;
+}
+
+/* rewrite the older binary copy. Records are written first and the crc is
+ * taken from the same bytes, header is written last and then synced */
+static uint8_t _param_write_bin(uint32_t* write_bytes)
+{
+	FIL fp;
+	UINT bw;
+	FRESULT res;
+	param_bin_header_t header;
+	param_bin_record_t rec;
+	uint32_t count = param_get_info_count();
+	uint8_t slot = _bin_slot ^ 1;
+	uint16_t crc = 0;
+	uint8_t err = 0;
+	
+	res = f_open(&fp, _bin_file_name[slot], FA_CREATE_ALWAYS | FA_WRITE);
+	if(res != FR_OK){
+		Console.e(TAG, "%s open fail:%d\n", _bin_file_name[slot], res);
+		return 1;
+	}
+	
+	res = f_lseek(&fp, sizeof(header));
+	if(res != FR_OK)
+		err = 1;
+	
+	for(uint32_t i = 0 ; i < count && !err ; i++){
+		_param_make_record(_param_get_info_by_index(i), &rec);
+		crc = math_crc16(crc, &rec, sizeof(rec));
+		res = f_write(&fp, &rec, sizeof(rec), &bw);
+		if(res != FR_OK || bw != sizeof(rec))
+			err = 1;
+		*write_bytes += bw;
+	}
+	
+	if(!err){
+		header.magic = PARAM_BIN_MAGIC;
+		header.version = PARAM_BIN_VERSION;
+		header.param_num = count;
+		header.layout_hash = _param_layout_hash();
+		header.crc = crc;
+		header.seq = _bin_seq + 1;
+	
+		res = f_lseek(&fp, 0);
+		if(res == FR_OK)
+			res = f_write(&fp, &header, sizeof(header), &bw);
+		if(res != FR_OK || bw != sizeof(header))
+			err = 1;
+		*write_bytes += bw;
+	}
+	
+	if(!err && f_sync(&fp) != FR_OK)
+		err = 1;
+	f_close(&fp);
+	
+	if(!err){
+		_bin_slot = slot;
+		_bin_seq = header.seq;
+	}
+	
+	return err;
+}
+
+uint8_t param_flush(void)
+{
+	uint32_t dirty_bitmap[(PARAM_MAX_NUM+31)/32];
+	uint32_t dirty_cnt;
+	uint32_t write_bytes = 0;
+	uint32_t start;
+	uint8_t err;
+	
+	if(!fm_init_complete()){
+		return 1;
+	}
+	
+	rt_mutex_take(&_param_lock, RT_WAITING_FOREVER);
+	
+	/* take the dirty set, params changed during writing will be flushed next time */
+	OS_ENTER_CRITICAL;
+	memcpy(dirty_bitmap, _dirty_bitmap, sizeof(dirty_bitmap));
+	memset(_dirty_bitmap, 0, sizeof(_dirty_bitmap));
+	dirty_cnt = _dirty_cnt;
+	_dirty_cnt = 0;
+	OS_EXIT_CRITICAL;
+	
+	if(dirty_cnt == 0){
+		rt_mutex_release(&_param_lock);
+		return 0;
+	}
+	
+	start = (uint32_t)time_nowUs();
+	
+	err = _param_write_bin(&write_bytes);
+	
+	_store_status.flush_time_last = (uint32_t)time_nowUs() - start;
+	_store_status.write_bytes += write_bytes;
+	if(err){
+		_store_status.err_cnt++;
+		/* put dirty flags back and retry next time */
+		OS_ENTER_CRITICAL;
+		for(int i = 0 ; i < (PARAM_MAX_NUM+31)/32 ; i++){
+			_dirty_bitmap[i] |= dirty_bitmap[i];
+		}
+		_dirty_cnt += dirty_cnt;
+		OS_EXIT_CRITICAL;
+	}else{
+		_store_status.flush_cnt++;
+		_store_status.flush_record += dirty_cnt;
+	}
+	
+	rt_mutex_release(&_param_lock);
+	
+	return err;
+}
+
+void param_flush_request(void)
+{
+	rt_event_send(&_param_event, EVENT_PARAM_FLUSH);
+}
+
 void param_store(void)
 {
+	_param_mark_all_dirty();
+	
+	if(param_flush() == 0){
+		Console.print("parameter store success\n");
+	}else{
+		Console.e(TAG, "parameter store fail\n");
+	}
+}
+
+param_store_status_t param_get_store_status(void)
+{
+	param_store_status_t status = _store_status;
+	
+	status.dirty_cnt = _dirty_cnt;
+	
+	return status;
+}
+
+static const char* _load_src_name[] = {"default", "bin", "xml"};
+
+void param_show_store_status(void)
+{
+	param_store_status_t status = param_get_store_status();
+	
+	Console.print("dirty: %d\n", status.dirty_cnt);
+	Console.print("set: %d times\n", status.set_cnt);
+	Console.print("flush: %d times, %d records, %d byte, err:%d\n", status.flush_cnt, status.flush_record,
+					status.write_bytes, status.err_cnt);
+	Console.print("last flush time(us): %d\n", status.flush_time_last);
+	Console.print("load from %s, time(us): %d\n", _load_src_name[status.load_src], status.load_time);
+}
+
+uint8_t param_export(void)
+{
+	uint8_t err = 1;
+	
 	if(fm_init_complete()){
 		FIL fp;
-		FRESULT res = f_open(&fp, PARAM_FILE_NAME, FA_OPEN_ALWAYS | FA_WRITE);
+		FRESULT res = f_open(&fp, PARAM_FILE_NAME, FA_CREATE_ALWAYS | FA_WRITE);
 		if(res == FR_OK){
 			/* add title */
 			f_printf (&fp, "<?xml version=\"1.0\"?>\n");
@@ -577,35 +941,142 @@ void param_store(void)
 				f_printf (&fp, "\x20\x20</group>\n");
 			}
 			f_printf (&fp, "</param_list>\n");
+			f_close(&fp);
+			err = 0;
+			Console.print("parameter export success\n");
 		}
+	}
+	
+	return err;
+}
+
+/* read one binary copy, rec_buf is allocated only if header and crc are valid */
+static uint8_t _param_read_bin(const char* file_name, param_bin_header_t* header, param_bin_record_t** rec_buf)
+{
+	FIL fp;
+	UINT br;
+	FRESULT res;
+	uint32_t size;
+	
+	res = f_open(&fp, file_name, FA_OPEN_EXISTING | FA_READ);
+	if(res != FR_OK){
+		return 1;
+	}
+	
+	res = f_read(&fp, header, sizeof(*header), &br);
+	if(res != FR_OK || br != sizeof(*header) || header->magic != PARAM_BIN_MAGIC
+		|| header->version != PARAM_BIN_VERSION || header->param_num == 0){
+		Console.e(TAG, "%s invalid header\n", file_name);
 		f_close(&fp);
-		Console.print("parameter store success\n");
+		return 1;
 	}
+	
+	size = header->param_num*sizeof(param_bin_record_t);
+	*rec_buf = (param_bin_record_t*)rt_malloc(size);
+	if(*rec_buf == NULL){
+		Console.e(TAG, "param malloc fail\n");
+		f_close(&fp);
+		return 1;
+	}
+	
+	res = f_read(&fp, *rec_buf, size, &br);
+	f_close(&fp);
+	if(res != FR_OK || br != size || math_crc16(0, *rec_buf, br) != header->crc){
+		Console.e(TAG, "%s crc err\n", file_name);
+		rt_free(*rec_buf);
+		*rec_buf = NULL;
+		return 1;
+	}
+	
+	return 0;
 }
 
-void param_load(void)
+static uint8_t _param_load_bin(void)
+{
+	param_bin_header_t header, slot_header;
+	param_bin_record_t* rec_buf = NULL;
+	param_bin_record_t* slot_buf;
+	param_info_t* p;
+	uint32_t count = param_get_info_count();
+	uint8_t layout_valid;
+	int slot = -1;
+	
+	/* take the valid copy with newer sequence */
+	for(int n = 0 ; n < 2 ; n++){
+		if(_param_read_bin(_bin_file_name[n], &slot_header, &slot_buf))
+			continue;
+		if(slot >= 0 && (int16_t)(slot_header.seq - header.seq) <= 0){
+			rt_free(slot_buf);
+			continue;
+		}
+		if(rec_buf != NULL)
+			rt_free(rec_buf);
+		rec_buf = slot_buf;
+		header = slot_header;
+		slot = n;
+	}
+	if(slot < 0){
+		return 1;
+	}
+	/* next flush overwrites the other copy */
+	_bin_slot = slot;
+	_bin_seq = header.seq;
+	
+	/* same layout, records are in param_list order */
+	layout_valid = (header.param_num == count && header.layout_hash == _param_layout_hash());
+	
+	for(uint32_t i = 0 ; i < count ; i++){
+		p = _param_get_info_by_index(i);
+		uint32_t hash = param_name_hash(p->name);
+	
+		if(layout_valid){
+			if(rec_buf[i].name_hash == hash && rec_buf[i].type == p->type)
+				p->val = rec_buf[i].val;
+			continue;
+		}
+		/* param list has changed, match records by name */
+		for(uint32_t n = 0 ; n < header.param_num ; n++){
+			if(rec_buf[n].name_hash == hash && rec_buf[n].type == p->type){
+				p->val = rec_buf[n].val;
+				break;
+			}
+		}
+	}
+	
+	/* rewrite file with the new layout */
+	if(!layout_valid)
+		_param_mark_all_dirty();
+	
+	rt_free(rec_buf);
+	
+	return 0;
+}
+
+static uint8_t _param_load_xml(void)
 {
 	FIL fp;
 	UINT br;
 	yxml_ret_t yxml_r;
-	char c;
+	uint8_t err = 1;
 	FRESULT res = f_open(&fp, PARAM_FILE_NAME, FA_OPEN_EXISTING | FA_READ);
 	
 	PARAM_PARSE_STATE status = PARAM_PARSE_START;
 	
 	if(res == FR_OK){
-		char *yxml_stack = (char*)rt_malloc(YXML_STACK_SIZE);
+		/* yxml stack followed by read buffer */
+		char *yxml_stack = (char*)rt_malloc(YXML_STACK_SIZE + PARAM_READ_BUFF_SIZE);
 		if(yxml_stack != NULL){
+			char *read_buff = yxml_stack + YXML_STACK_SIZE;
 			yxml_t yxml_handle;
 			yxml_init(&yxml_handle, yxml_stack, YXML_STACK_SIZE);
 			while(!f_eof(&fp)){
-				OS_ENTER_CRITICAL;
-				res = f_read(&fp, &c, 1, &br);
-				OS_EXIT_CRITICAL;
+				res = f_read(&fp, read_buff, PARAM_READ_BUFF_SIZE, &br);
 				
-				if(res == FR_OK && br == 1){
-					yxml_r = yxml_parse(&yxml_handle, c);
-					param_parse_state_machine(&yxml_handle, yxml_r, &status);
+				if(res == FR_OK && br > 0){
+					for(UINT i = 0 ; i < br ; i++){
+						yxml_r = yxml_parse(&yxml_handle, read_buff[i]);
+						param_parse_state_machine(&yxml_handle, yxml_r, &status);
+					}
 				}
 				else{
 					Console.e(TAG, "xml file read err\n");
@@ -617,6 +1088,7 @@ void param_load(void)
 				Console.print("xml parse err\n");
 			else{
 				//Console.print("parameter load success!\n");
+				err = 0;
 			}
 		}else{
 			Console.e(TAG, "param malloc fail\n");
@@ -626,6 +1098,30 @@ void param_load(void)
 		//Console.print("can not find %s, use default parameters.\n", PARAM_FILE_NAME);
 	}
 	f_close(&fp);
+	
+	return err;
+}
+
+void param_load(void)
+{
+	uint32_t start;
+	
+	rt_mutex_take(&_param_lock, RT_WAITING_FOREVER);
+	
+	start = (uint32_t)time_nowUs();
+	if(_param_load_bin() == 0){
+		_store_status.load_src = PARAM_LOAD_SRC_BIN;
+	}else{
+		_store_status.load_src = PARAM_LOAD_SRC_DEFAULT;
+		/* fall back to xml file, and migrate it to binary file */
+		if(_param_load_xml() == 0){
+			_store_status.load_src = PARAM_LOAD_SRC_XML;
+			_param_mark_all_dirty();
+		}
+	}
+	_store_status.load_time = (uint32_t)time_nowUs() - start;
+	
+	rt_mutex_release(&_param_lock);
 }
 
 int handle_param_shell_cmd(int argc, char** argv)
@@ -653,6 +1149,16 @@ int handle_param_shell_cmd(int argc, char** argv)
 			//store_param(global_param_t);
 			param_store();
 		}
+		if(strcmp(argv[1], "flush") == 0){
+			if(param_flush())
+				Console.print("parameter flush fail\n");
+		}
+		if(strcmp(argv[1], "export") == 0){
+			param_export();
+		}
+		if(strcmp(argv[1], "status") == 0){
+			param_show_store_status();
+		}
 		if(strcmp(argv[1], "get") == 0 && param_num == 2){
 			if(group_flag)
 				param_show_group_list();
@@ -668,19 +1174,54 @@ int handle_param_shell_cmd(int argc, char** argv)
 		if(strcmp(argv[1], "set") == 0 && argc == 5){
 			if(param_set(argv[2], argv[3], argv[4]))
 				Console.print("fail, can not find %s in group %s\n", argv[3], argv[2]);
-			else
+			else{
+				param_mark_dirty(param_get(argv[2], argv[3]));
 				Console.print("success, %s in group %s is set to %s\n", argv[3], argv[2], argv[4]);
+			}
 		}
 	}
 	
 	return 0;
 }
 
+void param_entry(void *parameter)
+{
+	rt_err_t res;
+	rt_uint32_t recv_set = 0;
+	
+	while(1)
+	{
+		res = rt_event_recv(&_param_event, EVENT_PARAM_FLUSH, RT_EVENT_FLAG_OR | RT_EVENT_FLAG_CLEAR,
+								PARAM_FLUSH_CHECK_PERIOD, &recv_set);
+		
+		if(res == RT_EOK){
+			/* flush requested, e.g, vehicle disarmed */
+			param_flush();
+		}else if(_dirty_cnt && time_nowMs() - _last_set_time >= PARAM_FLUSH_QUIET_TIME){
+			/* coalesce burst of param set, flush after quiet period */
+			param_flush();
+		}
+	}
+}
+
 uint8_t param_init(void)
 {
 	//_param_user_cnt = 0;
 	//load_param(global_param_t);
+	/* param thread, param_flush() and param_flush_request() use them even if init fails */
+	rt_mutex_init(&_param_lock, "param", RT_IPC_FLAG_FIFO);
+	rt_event_init(&_param_event, "param", RT_IPC_FLAG_FIFO);
+	
+	if(param_get_info_count() > PARAM_MAX_NUM){
+		Console.e(TAG, "param number exceed %d\n", PARAM_MAX_NUM);
+		return 1;
+	}
+	if(_param_build_index()){
+		return 1;
+	}
+	
 	param_load();
+	Console.print("param load from %s, %d us\n", _load_src_name[_store_status.load_src], _store_status.load_time);
 	
 	return 0;
 }
@@ -21,6 +21,10 @@ struct rt_semaphore starryio_dbg_rx_sem;
 struct rt_semaphore starryio_rx_pack_sem;
 struct rt_semaphore starryio_tx_pack_sem;
 static rt_device_t serial_dev;
+/* packages are encoded into the static tx buffer, the lock is held until dma finishes sending it */
+static struct rt_mutex starryio_tx_lock;
+static uint8_t tx_buff[STARRYIO_FRAME_MAX_SIZE];
+#define STARRYIO_RX_CHUNK_SIZE	64
 #define MSEC_TO_TICKS(ms) ((ms) * RT_TICK_PER_SECOND / 1000)
 #define STARRYIO_DTX_TIMEOUT MSEC_TO_TICKS(30)
 
@@ -95,20 +99,18 @@ void px4io_reset_rx_ind(void)
 
 uint8_t send_package(uint8_t cmd, uint8_t* data, uint16_t len)
 {
-	Package_Def pack;
-	SendPackage_Def send_pack;
+	uint16_t size;
 	
-	if(!make_package(data , cmd , len , &pack)){
-		return 0;
-	}
+	rt_mutex_take(&starryio_tx_lock, RT_WAITING_FOREVER);
 	
-	package2sendpack(pack , &send_pack);
-	send(send_pack.send_buff, send_pack.buff_size);
+	size = make_package(tx_buff, sizeof(tx_buff), cmd, data, len);
+	if(size){
+		send(tx_buff, size);
+	}
 	
-	free_pack(&pack);
-	free_sendpack(&send_pack);
+	rt_mutex_release(&starryio_tx_lock);
 	
-	return 1;
+	return size ? 1 : 0;
 }
 
 rt_err_t set_ppm_freq(uint8_t freq)
@@ -166,6 +168,8 @@ void starryio_entry(void *parameter)
 	
 	rt_sem_init(&starryio_rx_pack_sem, "rxpack", 0, 0);
 	rt_sem_init(&starryio_tx_pack_sem, "txpack", 0, RT_IPC_FLAG_FIFO);
+	rt_mutex_init(&starryio_tx_lock, "txlock", RT_IPC_FLAG_FIFO);
+	starryio_protocol_init();
 	
 	rt_device_set_rx_indicate(serial_dev, starryio_serial_rx_ind);
 	rt_device_set_tx_complete(serial_dev, starryio_serial_tx_done);
@@ -188,10 +192,10 @@ void starryio_entry(void *parameter)
 #endif
 	
 		if (rt_sem_take(&starryio_rx_pack_sem, 20) == RT_EOK){
-			uint8_t ch;
-			while(rt_device_read(serial_dev , 0 , &ch , 1)){
-				if(wait_complete_pack(ch))
-					process_recv_pack();
+			uint8_t rx_buff[STARRYIO_RX_CHUNK_SIZE];
+			rt_size_t size;
+			while((size = rt_device_read(serial_dev , 0 , rx_buff , sizeof(rx_buff))) > 0){
+				starryio_protocol_input(rx_buff, size);
 			}
 		}
 	}
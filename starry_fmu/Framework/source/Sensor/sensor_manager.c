@@ -39,6 +39,8 @@
 
 #define EARTH_RADIUS			6371000
 
+#define SENSOR_QUEUE_DEPTH		16	/* samples kept for gyr/acc topic, let slow consumers pop every sample */
+
 static char *TAG = "Sensor";
 
 static uint32_t gyr_read_time_stamp = 0;
@@ -78,12 +80,12 @@ static bool _gps_connected = false;
 MCN_DEFINE(SENSOR_MEASURE_GYR, 12);	
 MCN_DEFINE(SENSOR_MEASURE_ACC, 12);
 MCN_DEFINE(SENSOR_MEASURE_MAG, 12);
-MCN_DEFINE(SENSOR_GYR, 12);	
+MCN_DEFINE(SENSOR_GYR, 12);
 MCN_DEFINE(SENSOR_ACC, 12);
-MCN_DEFINE(SENSOR_MAG, 12);
-MCN_DEFINE(SENSOR_FILTER_GYR, 12);	
-MCN_DEFINE(SENSOR_FILTER_ACC, 12);
-MCN_DEFINE(SENSOR_FILTER_MAG, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_MAG, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_GYR, 12);	
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_ACC, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_MAG, 12);
 MCN_DEFINE(SENSOR_BARO, sizeof(MS5611_REPORT_Def));
 MCN_DEFINE(SENSOR_LIDAR, sizeof(float));
 MCN_DEFINE(CORRECT_LIDAR, sizeof(float));
@@ -732,11 +734,11 @@ rt_err_t device_sensor_init(void)
 	if(mcn_res != 0){
 		Console.e(TAG, "err:%d, SENSOR_MEASURE_MAG advertise fail!\n", mcn_res);
 	}
-	mcn_res = mcn_advertise(MCN_ID(SENSOR_GYR));
+	mcn_res = mcn_advertise_queue(MCN_ID(SENSOR_GYR), SENSOR_QUEUE_DEPTH);
 	if(mcn_res != 0){
 		Console.e(TAG, "err:%d, sensor_gyr advertise fail!\n", mcn_res);
 	}
-	mcn_res = mcn_advertise(MCN_ID(SENSOR_ACC));
+	mcn_res = mcn_advertise_queue(MCN_ID(SENSOR_ACC), SENSOR_QUEUE_DEPTH);
 	if(mcn_res != 0){
 		Console.e(TAG, "err:%d, sensor_acc advertise fail!\n", mcn_res);
 	}
@@ -28,6 +28,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 *******************************************************************************/
 
 #include "state_est.h"
+#include "logger.h"
 #include "ekf.h"
 #include "uMCN.h"
 #include "console.h"
@@ -36,6 +37,7 @@ OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
 #include "sensor_manager.h"
 #include "gps.h"
 #include "fifo.h"
+#include "trace.h"
 
 #define EKF_MAX_DELAY_OFFFSET		20
 #define EKF_STATE_X_DELAY			100
@@ -124,6 +126,7 @@ uint8_t state_est_init(float dT)
 uint8_t state_est_reset(void)
 {
 	EKF14_Reset(&ekf_14);
+	logger_trigger(LOG_TRIGGER_EST_RESET);
 	
 	return 0;
 }
@@ -201,7 +204,9 @@ uint8_t state_est_update(void)
 	
 	//EKF14_Prediction(&ekf_14);
 	
+	TRACE_ZONE_BEGIN(TRACE_ZONE_EKF_PREDICT);
 	EKF14_SerialPrediction(&ekf_14, 0xFFFF);
+	TRACE_ZONE_END(TRACE_ZONE_EKF_PREDICT);
 	
 	// store history state
 	// for(uint8_t n = 0 ; n < 14 ; n++){
@@ -231,7 +236,9 @@ uint8_t state_est_update(void)
 	}
 	else{
 		//EKF14_SerialCorrect(&ekf_14, enable);
+		TRACE_ZONE_BEGIN(TRACE_ZONE_EKF_CORRECT);
 		EKF14_Correct(&ekf_14);
+		TRACE_ZONE_END(TRACE_ZONE_EKF_CORRECT);
 	}
 //	EKF14_SerialCorrect(&ekf_14, enable);
 	
@@ -9,8 +9,12 @@
 
 #include <rtthread.h>
 #include <rthw.h>
+#include <string.h>
 #include "statistic.h"
 #include "console.h"
+#include "delay.h"
+#include "uMCN.h"
+#include "trace.h"
 
 /* calculate CPU usage each 100ms */
 #define OS_STATISTIC_INTERVAL		500
@@ -21,6 +25,180 @@ static float _cpu_usage = 0;
 
 static struct rt_timer timer_sta;
 
+/* per-thread accounting, written by scheduler hooks with interrupt disabled */
+static thread_stat_t _thread_stat[STAT_THREAD_MAX_NUM];
+static uint8_t _thread_num;
+static uint32_t _untracked_switch;
+static uint64_t _switch_time;
+static thread_stat_t* _running_stat;
+
+/* snapshot of last statistic interval, used to calculate the per-interval load */
+static uint64_t _last_run_time[STAT_THREAD_MAX_NUM];
+static uint32_t _last_switch_cnt[STAT_THREAD_MAX_NUM];
+static uint32_t _last_wakeup_cnt[STAT_THREAD_MAX_NUM];
+static uint64_t _last_latency_sum[STAT_THREAD_MAX_NUM];
+static uint64_t _last_stat_time;
+
+static sys_load_t _sys_load;
+
+MCN_DEFINE(SYS_LOAD, sizeof(sys_load_t));
+
+static char* TAG = "Statistic";
+
+static uint8_t _hist_bin(uint32_t val)
+{
+	uint8_t bin = 0;
+	
+	while(val && bin < STAT_HIST_BIN_NUM-1){
+		val >>= 1;
+		bin++;
+	}
+	
+	return bin;
+}
+
+static thread_stat_t* _find_thread_stat(rt_thread_t thread)
+{
+	thread_stat_t* stat;
+	
+	for(uint8_t i = 0 ; i < _thread_num ; i++){
+		if(_thread_stat[i].thread == thread)
+			return &_thread_stat[i];
+	}
+	
+	if(_thread_num >= STAT_THREAD_MAX_NUM)
+		return NULL;
+	
+	/* first time seen, allocate a slot */
+	stat = &_thread_stat[_thread_num];
+	memset(stat, 0, sizeof(thread_stat_t));
+	stat->thread = thread;
+	strncpy(stat->name, thread->name, RT_NAME_MAX);
+	_thread_num++;
+	
+	return stat;
+}
+
+/* elapsed time since the last switch, charged to the running thread */
+static void _settle_run_time(uint64_t now)
+{
+	/* us timer may step back a little when systick is pending */
+	if(now > _switch_time){
+		if(_running_stat)
+			_running_stat->run_time += now - _switch_time;
+		_switch_time = now;
+	}
+}
+
+/* called with interrupt disabled */
+static void _sched_switch_hook(rt_thread_t from, rt_thread_t to)
+{
+	uint64_t now = time_nowUs();
+	thread_stat_t* stat;
+	uint32_t latency;
+	
+	_settle_run_time(now);
+	trace_sched_switch(from, to);
+	
+	stat = _find_thread_stat(to);
+	_running_stat = stat;
+	if(stat == NULL){
+		_untracked_switch++;
+		return;
+	}
+	
+	stat->switch_cnt++;
+	if(stat->ready_time){
+		latency = now > stat->ready_time ? (uint32_t)(now - stat->ready_time) : 0;
+		stat->ready_time = 0;
+		stat->wakeup_cnt++;
+		stat->latency_sum += latency;
+		if(latency > stat->latency_max)
+			stat->latency_max = latency;
+		if(latency > stat->latency_peak)
+			stat->latency_peak = latency;
+		stat->latency_hist[_hist_bin(latency)]++;
+	}
+}
+
+/* called with interrupt disabled, thread is made ready (resume, timeout or priority change) */
+static void _sched_insert_hook(rt_thread_t thread)
+{
+	thread_stat_t* stat;
+	
+	trace_sched_ready(thread);
+	
+	/* running thread is re-inserted when its priority changes, it is not waiting for cpu */
+	if(thread == rt_thread_self())
+		return;
+	
+	stat = _find_thread_stat(thread);
+	if(stat && stat->ready_time == 0){
+		stat->ready_time = time_nowUs();
+	}
+}
+
+static uint16_t _sat_u16(uint64_t val)
+{
+	return val > 0xFFFF ? 0xFFFF : (uint16_t)val;
+}
+
+static void _statistic_update_load(void)
+{
+	register rt_base_t level;
+	uint64_t now, interval;
+	uint64_t run_time, latency_sum;
+	uint32_t switch_cnt, wakeup_cnt, latency_peak;
+	uint8_t thread_num;
+	thread_load_t* load;
+	
+	level = rt_hw_interrupt_disable();
+	now = time_nowUs();
+	_settle_run_time(now);
+	thread_num = _thread_num;
+	_sys_load.untracked_switch = _untracked_switch;
+	rt_hw_interrupt_enable(level);
+	
+	interval = now - _last_stat_time;
+	_last_stat_time = now;
+	if(interval == 0)
+		return;
+	
+	_sys_load.timestamp_ms = (uint32_t)(now/1000);
+	_sys_load.interval_ms = (uint32_t)(interval/1000);
+	_sys_load.cpu_usage = _cpu_usage;
+	_sys_load.thread_num = thread_num;
+	
+	for(uint8_t i = 0 ; i < thread_num ; i++){
+		level = rt_hw_interrupt_disable();
+		run_time = _thread_stat[i].run_time;
+		switch_cnt = _thread_stat[i].switch_cnt;
+		wakeup_cnt = _thread_stat[i].wakeup_cnt;
+		latency_sum = _thread_stat[i].latency_sum;
+		latency_peak = _thread_stat[i].latency_peak;
+		_thread_stat[i].latency_peak = 0;
+		rt_hw_interrupt_enable(level);
+	
+		load = &_sys_load.thread[i];
+		strncpy(load->name, _thread_stat[i].name, RT_NAME_MAX);
+		load->load = _sat_u16((run_time - _last_run_time[i]) * 10000 / interval);
+		load->switch_rate = _sat_u16((uint64_t)(switch_cnt - _last_switch_cnt[i]) * 1000000 / interval);
+		if(wakeup_cnt != _last_wakeup_cnt[i]){
+			load->latency_avg = _sat_u16((latency_sum - _last_latency_sum[i]) / (wakeup_cnt - _last_wakeup_cnt[i]));
+		}else{
+			load->latency_avg = 0;
+		}
+		load->latency_max = _sat_u16(latency_peak);
+	
+		_last_run_time[i] = run_time;
+		_last_switch_cnt[i] = switch_cnt;
+		_last_wakeup_cnt[i] = wakeup_cnt;
+		_last_latency_sum[i] = latency_sum;
+	}
+	
+	mcn_publish(MCN_ID(SYS_LOAD), &_sys_load);
+}
+
 void _thread_idle_hook_func(void)
 {
 	rt_enter_critical();
@@ -33,6 +211,8 @@ static void timer_sta_entry(void* parameter)
 	/* calculate cpu usage */
 	_cpu_usage = 100.0f * (1.0f - ((float)_os_idle_ctr)/_os_ctr_max);
 	_os_idle_ctr = 0;
+	
+	_statistic_update_load();
 }
 
 float get_cpu_usage(void)
@@ -46,8 +226,113 @@ float get_cpu_usage(void)
 	return usage;
 }
 
+uint8_t statistic_get_thread_load(const char* name, thread_load_t* load)
+{
+	sys_load_t* sys_load = &_sys_load;
+	
+	for(uint8_t i = 0 ; i < sys_load->thread_num ; i++){
+		if(strncmp(sys_load->thread[i].name, name, RT_NAME_MAX) == 0){
+			rt_enter_critical();
+			*load = sys_load->thread[i];
+			rt_exit_critical();
+			return 0;
+		}
+	}
+	
+	return 1;
+}
+
+uint8_t statistic_get_thread_stat(uint8_t index, thread_stat_t* stat)
+{
+	register rt_base_t level;
+	
+	if(index >= _thread_num)
+		return 1;
+	
+	level = rt_hw_interrupt_disable();
+	*stat = _thread_stat[index];
+	rt_hw_interrupt_enable(level);
+	
+	return 0;
+}
+
+void statistic_reset(void)
+{
+	register rt_base_t level;
+	
+	level = rt_hw_interrupt_disable();
+	for(uint8_t i = 0 ; i < _thread_num ; i++){
+		_thread_stat[i].run_time = 0;
+		_thread_stat[i].switch_cnt = 0;
+		_thread_stat[i].wakeup_cnt = 0;
+		_thread_stat[i].latency_sum = 0;
+		_thread_stat[i].latency_max = 0;
+		_thread_stat[i].latency_peak = 0;
+		memset(_thread_stat[i].latency_hist, 0, sizeof(_thread_stat[i].latency_hist));
+	
+		_last_run_time[i] = 0;
+		_last_switch_cnt[i] = 0;
+		_last_wakeup_cnt[i] = 0;
+		_last_latency_sum[i] = 0;
+	}
+	_untracked_switch = 0;
+	rt_hw_interrupt_enable(level);
+}
+
+void statistic_show_thread(void)
+{
+	thread_stat_t stat;
+	thread_load_t load;
+	
+	Console.print("%-12s %7s %8s %8s %8s %10s %10s\n", "thread", "load(%)", "sw/s", "lat_avg", "lat_max", "total(ms)", "switch");
+	for(uint8_t i = 0 ; statistic_get_thread_stat(i, &stat) == 0 ; i++){
+		if(statistic_get_thread_load(stat.name, &load) != 0)
+			memset(&load, 0, sizeof(load));
+		Console.print("%-12.12s %7.2f %8d %8d %8d %10d %10d\n", stat.name, load.load*0.01f, load.switch_rate,
+						load.latency_avg, stat.latency_max, (uint32_t)(stat.run_time/1000), stat.switch_cnt);
+	}
+	if(_untracked_switch)
+		Console.print("untracked switch: %d\n", _untracked_switch);
+}
+
+void statistic_show_histogram(void)
+{
+	thread_stat_t stat;
+	
+	Console.print("wakeup latency (us):\n");
+	for(uint8_t i = 0 ; statistic_get_thread_stat(i, &stat) == 0 ; i++){
+		if(stat.wakeup_cnt == 0)
+			continue;
+		Console.print("%-12.12s", stat.name);
+		for(uint8_t n = 0 ; n < STAT_HIST_BIN_NUM ; n++){
+			if(stat.latency_hist[n] == 0)
+				continue;
+			if(n == 0)
+				Console.print(" [%d]:%d", n, stat.latency_hist[n]);
+			else if(n == STAT_HIST_BIN_NUM-1)
+				Console.print(" [%d+]:%d", 1<<(n-1), stat.latency_hist[n]);
+			else
+				Console.print(" [%d-%d]:%d", 1<<(n-1), (1<<n)-1, stat.latency_hist[n]);
+		}
+		Console.print("\n");
+	}
+}
+
 void statistic_init(void)
 {
+	int mcn_res;
+	
+	mcn_res = mcn_advertise(MCN_ID(SYS_LOAD));
+	if(mcn_res != 0){
+		Console.e(TAG, "err:%d, SYS_LOAD advertise fail!\n", mcn_res);
+	}
+	
+	/* account run time and wakeup latency of each thread */
+	_switch_time = _last_stat_time = time_nowUs();
+	_running_stat = _find_thread_stat(rt_thread_self());
+	rt_scheduler_insert_sethook(_sched_insert_hook);
+	rt_scheduler_sethook(_sched_switch_hook);
+	
 	/* we increment idle counter in idle thread */
 	rt_thread_idle_sethook(_thread_idle_hook_func);
 	
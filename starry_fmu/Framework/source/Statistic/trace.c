@@ -0,0 +1,334 @@
+/*
+ * File      : trace.c
+ *
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <rtthread.h>
+#include <rthw.h>
+#include <string.h>
+#include <stdlib.h>
+#include "trace.h"
+#include "global.h"
+#include "console.h"
+#include "delay.h"
+#include "ff.h"
+
+static char* TAG = "Trace";
+
+static const char* _zone_name[TRACE_ZONE_NUM] =
+{
+	"sensor_collect",
+	"att_control",
+	"ekf_predict",
+	"ekf_correct",
+};
+
+static const char* _mark_name[TRACE_MARK_NUM] =
+{
+	"fastloop_miss",
+	"user",
+};
+
+/* ring of fixed size records, allocated when trace starts */
+static trace_record_t* _ring = NULL;
+static uint32_t _capacity;
+static uint32_t _head;
+static uint32_t _record_cnt;
+static volatile uint8_t _running;
+static uint8_t _trigger;
+static uint32_t _post_cnt;
+
+/* thread id is the index in this table, names are kept in case thread is deleted */
+static rt_thread_t _thread[TRACE_THREAD_MAX_NUM];
+static char _thread_name[TRACE_THREAD_MAX_NUM][TRACE_NAME_LEN];
+static uint8_t _thread_num;
+
+static uint8_t _trace_thread_id(rt_thread_t thread)
+{
+	for(uint8_t i = 0 ; i < _thread_num ; i++){
+		if(_thread[i] == thread)
+			return i;
+	}
+	
+	if(_thread_num >= TRACE_THREAD_MAX_NUM)
+		return 0xFF;
+	
+	_thread[_thread_num] = thread;
+	strncpy(_thread_name[_thread_num], thread->name, TRACE_NAME_LEN-1);
+	_thread_name[_thread_num][TRACE_NAME_LEN-1] = '\0';
+	
+	return _thread_num++;
+}
+
+/* must be called with interrupt disabled */
+static void _trace_push(uint8_t type, uint8_t id, uint16_t arg)
+{
+	trace_record_t* rec = &_ring[_head];
+	
+	rec->timestamp = (uint32_t)time_nowUs();
+	rec->type = type;
+	rec->id = id;
+	rec->arg = arg;
+	
+	_head = (_head+1) % _capacity;
+	_record_cnt++;
+	
+	if(_post_cnt){
+		if(--_post_cnt == 0)
+			_running = 0;
+	}
+}
+
+void trace_record(uint8_t type, uint8_t id, uint16_t arg)
+{
+	register rt_base_t level;
+	
+	if(!_running)
+		return;
+	
+	level = rt_hw_interrupt_disable();
+	if(_running)
+		_trace_push(type, id, arg);
+	rt_hw_interrupt_enable(level);
+}
+
+/* called from scheduler hook with interrupt disabled */
+void trace_sched_switch(rt_thread_t from, rt_thread_t to)
+{
+	if(!_running)
+		return;
+	
+	_trace_push(TRACE_EVT_SWITCH, _trace_thread_id(to), _trace_thread_id(from));
+}
+
+/* called from scheduler hook with interrupt disabled */
+void trace_sched_ready(rt_thread_t thread)
+{
+	if(!_running)
+		return;
+	
+	_trace_push(TRACE_EVT_READY, _trace_thread_id(thread), 0);
+}
+
+void trace_mark(uint8_t mark, uint16_t arg)
+{
+	register rt_base_t level;
+	
+	if(!_running)
+		return;
+	
+	level = rt_hw_interrupt_disable();
+	if(_running){
+		_trace_push(TRACE_EVT_MARK, mark, arg);
+		/* keep the second half of ring for what happens after the mark */
+		if(_trigger && _post_cnt == 0)
+			_post_cnt = _capacity/2;
+	}
+	rt_hw_interrupt_enable(level);
+}
+
+static uint8_t _trace_irq_num(void)
+{
+#ifdef SITL_SIMULATION
+	return 0;
+#else
+	return (uint8_t)__get_IPSR();
+#endif
+}
+
+static void _trace_irq_enter_hook(void)
+{
+	if(!_running)
+		return;
+	
+	_trace_push(TRACE_EVT_IRQ_ENTER, _trace_irq_num(), 0);
+}
+
+static void _trace_irq_leave_hook(void)
+{
+	if(!_running)
+		return;
+	
+	_trace_push(TRACE_EVT_IRQ_LEAVE, _trace_irq_num(), 0);
+}
+
+uint8_t trace_start(uint32_t record_num, uint8_t trigger)
+{
+	trace_record_t* ring;
+	register rt_base_t level;
+	
+	if(_running){
+		Console.print("trace is running\n");
+		return 1;
+	}
+	
+	if(record_num == 0)
+		record_num = TRACE_DEFAULT_RECORD_NUM;
+	
+	if(_ring == NULL || _capacity != record_num){
+		if(_ring){
+			rt_free(_ring);
+			_ring = NULL;
+		}
+		ring = (trace_record_t*)rt_malloc(record_num * sizeof(trace_record_t));
+		if(ring == NULL){
+			Console.e(TAG, "fail to malloc %d records\n", record_num);
+			return 1;
+		}
+		_ring = ring;
+		_capacity = record_num;
+	}
+	
+	level = rt_hw_interrupt_disable();
+	_head = 0;
+	_record_cnt = 0;
+	_post_cnt = 0;
+	_trigger = trigger;
+	/* running thread is known before the first switch */
+	_thread_num = 0;
+	_trace_thread_id(rt_thread_self());
+	_running = 1;
+	rt_hw_interrupt_enable(level);
+	
+	return 0;
+}
+
+void trace_stop(void)
+{
+	_running = 0;
+}
+
+trace_status_t trace_get_status(void)
+{
+	trace_status_t status;
+	
+	status.running = _running;
+	status.trigger = _trigger;
+	status.capacity = _capacity;
+	status.record_cnt = _record_cnt;
+	status.post_cnt = _post_cnt;
+	
+	return status;
+}
+
+static FRESULT _trace_write_name(FIL* fp, const char* name)
+{
+	char buff[TRACE_NAME_LEN];
+	UINT bw;
+	
+	memset(buff, 0, sizeof(buff));
+	strncpy(buff, name, TRACE_NAME_LEN-1);
+	
+	return f_write(fp, buff, TRACE_NAME_LEN, &bw);
+}
+
+uint8_t trace_dump(const char* file_name)
+{
+	FIL fp;
+	FRESULT res;
+	UINT bw;
+	trace_file_header_t header;
+	uint32_t num, start;
+	
+	if(_ring == NULL || _record_cnt == 0){
+		Console.print("no trace record\n");
+		return 1;
+	}
+	/* freeze the ring while writing it out */
+	trace_stop();
+	
+	res = f_open(&fp, file_name, FA_CREATE_ALWAYS | FA_WRITE);
+	if(res != FR_OK){
+		Console.e(TAG, "fail to create %s, err:%d\n", file_name, res);
+		return 1;
+	}
+	
+	num = _record_cnt < _capacity ? _record_cnt : _capacity;
+	start = _record_cnt < _capacity ? 0 : _head;
+	
+	header.magic = TRACE_FILE_MAGIC;
+	header.version = TRACE_FILE_VERSION;
+	header.record_size = sizeof(trace_record_t);
+	header.record_num = num;
+	header.lost_num = _record_cnt - num;
+	header.thread_num = _thread_num;
+	header.zone_num = TRACE_ZONE_NUM;
+	header.mark_num = TRACE_MARK_NUM;
+	header.reserved = 0;
+	res = f_write(&fp, &header, sizeof(header), &bw);
+	
+	for(uint8_t i = 0 ; i < _thread_num && res == FR_OK ; i++){
+		res = _trace_write_name(&fp, _thread_name[i]);
+	}
+	for(uint8_t i = 0 ; i < TRACE_ZONE_NUM && res == FR_OK ; i++){
+		res = _trace_write_name(&fp, _zone_name[i]);
+	}
+	for(uint8_t i = 0 ; i < TRACE_MARK_NUM && res == FR_OK ; i++){
+		res = _trace_write_name(&fp, _mark_name[i]);
+	}
+	
+	/* oldest part is from head to the end of ring */
+	if(res == FR_OK && start){
+		res = f_write(&fp, &_ring[start], (_capacity-start)*sizeof(trace_record_t), &bw);
+	}
+	if(res == FR_OK){
+		res = f_write(&fp, &_ring[0], (num-(start ? _capacity-start : 0))*sizeof(trace_record_t), &bw);
+	}
+	
+	f_close(&fp);
+	
+	if(res != FR_OK){
+		Console.e(TAG, "fail to write %s, err:%d\n", file_name, res);
+		return 1;
+	}
+	Console.print("%d records (%d lost) are written to %s\n", num, header.lost_num, file_name);
+	
+	return 0;
+}
+
+void trace_init(void)
+{
+	rt_interrupt_enter_sethook(_trace_irq_enter_hook);
+	rt_interrupt_leave_sethook(_trace_irq_leave_hook);
+}
+
+int handle_trace_shell_cmd(int argc, char** argv)
+{
+	int res = 0;
+	
+	if(argc > 1){
+		if(strcmp(argv[1], "start") == 0){
+			uint32_t num = 0;
+			uint8_t trigger = 0;
+			for(int i = 2 ; i < argc ; i++){
+				if(strcmp(argv[i], "trig") == 0)
+					trigger = 1;
+				else
+					num = atoi(argv[i]);
+			}
+			res = trace_start(num, trigger);
+		}
+		if(strcmp(argv[1], "stop") == 0){
+			trace_stop();
+		}
+		if(strcmp(argv[1], "mark") == 0){
+			trace_mark(TRACE_MARK_USER, 0);
+		}
+		if(strcmp(argv[1], "dump") == 0){
+			if(argc > 2)
+				res = trace_dump(argv[2]);
+			else
+				Console.print("usage: trace dump <file>\n");
+		}
+	}else{
+		trace_status_t status = trace_get_status();
+		Console.print("status: %s%s, %d/%d records\n", status.running ? "running" : "stopped",
+						status.trigger ? " (trigger)" : "", status.record_cnt, status.capacity);
+	}
+	
+	return res;
+}
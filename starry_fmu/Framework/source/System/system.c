@@ -340,7 +340,19 @@ int handle_sys_shell_cmd(int argc, char** argv)
 {
 	float cpu_usage = get_cpu_usage();
 	
-	Console.print("CPU Usage: %.2f\n", cpu_usage);
+	if(argc > 1){
+		if(strcmp(argv[1], "thread") == 0){
+			statistic_show_thread();
+		}
+		if(strcmp(argv[1], "hist") == 0){
+			statistic_show_histogram();
+		}
+		if(strcmp(argv[1], "reset") == 0){
+			statistic_reset();
+		}
+	}else{
+		Console.print("CPU Usage: %.2f\n", cpu_usage);
+	}
 	
 	return 0;
 }
@@ -9,9 +9,53 @@
 
 #include <rtthread.h>
 #include "delay.h"
+#ifdef SITL_SIMULATION
+#include <time.h>
+#include <stdbool.h>
+#endif
 
 DELAY_TIME_Def _delay_t;
 
+#ifdef SITL_SIMULATION
+/* SITL has no SysTick, use host monotonic clock since boot */
+static struct timespec _boot_time;
+/* log replay drives the clock with record time stamp */
+static volatile bool _virtual_clock = false;
+static uint64_t _virtual_time_us;
+
+void time_set_virtual(uint64_t time_us)
+{
+	_virtual_time_us = time_us;
+	_virtual_clock = true;
+}
+
+void time_clear_virtual(void)
+{
+	_virtual_clock = false;
+}
+
+/* host time since boot, not affected by virtual clock */
+uint64_t time_wallUs(void)
+{
+	struct timespec now;
+	
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return (uint64_t)(now.tv_sec - _boot_time.tv_sec)*1000000 + (now.tv_nsec - _boot_time.tv_nsec)/1000;
+}
+
+uint64_t time_nowUs(void)
+{
+	if(_virtual_clock)
+		return _virtual_time_us;
+	
+	return time_wallUs();
+}
+
+uint32_t time_nowMs(void)
+{
+	return (uint32_t)(time_nowUs()/1000);
+}
+#else
 // 获取当前时间，us。
 uint64_t time_nowUs(void)
 {
@@ -23,6 +67,7 @@ uint32_t time_nowMs(void)
 {
     return _delay_t.msPeriod + (SysTick->LOAD - SysTick->VAL) / _delay_t.ticksPerMs;
 }
+#endif
 
 // 延时delay us，delay>=4时才准确。
 void time_waitUs(uint32_t delay)
@@ -40,6 +85,11 @@ void time_waitMs(uint32_t delay)
 
 void device_delay_init(void)
 {
+#ifdef SITL_SIMULATION
+	clock_gettime(CLOCK_MONOTONIC, &_boot_time);
+	_delay_t.msPeriod = 0;
+	_delay_t.msPerPeriod = 1000/RT_TICK_PER_SECOND;
+#else
 	RCC_ClocksTypeDef  rcc_clocks;
 
     RCC_GetClocksFreq(&rcc_clocks);
@@ -48,4 +98,5 @@ void device_delay_init(void)
     _delay_t.ticksPerUs = rcc_clocks.HCLK_Frequency/8 / 1e6;    	
     _delay_t.ticksPerMs = rcc_clocks.HCLK_Frequency/8 / 1e3;    	
     _delay_t.msPerPeriod = 1000/RT_TICK_PER_SECOND;  	
+#endif
 }
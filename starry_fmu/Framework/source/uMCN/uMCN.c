@@ -13,6 +13,78 @@
 
 static char* TAG = "uMCN";
 
+/* seqlock hub keeps two copies of topic data. Publisher updates copy 0 while
+ * sequence is odd and copy 1 while sequence is even, so readers always have
+ * one stable copy to read from, even when they preempt the publisher */
+static void _mcn_seqlock_write(McnHub* hub, const void* data)
+{
+	uint8_t* pbuf = (uint8_t*)hub->pdata;
+	
+	hub->seq++;
+	MCN_MEM_BARRIER();
+	memcpy(pbuf, data, hub->obj_size);
+	MCN_MEM_BARRIER();
+	hub->seq++;
+	MCN_MEM_BARRIER();
+	memcpy(pbuf+hub->obj_size, data, hub->obj_size);
+	MCN_MEM_BARRIER();
+}
+
+static void _mcn_seqlock_read(McnHub* hub, void* buffer)
+{
+	uint8_t* pbuf = (uint8_t*)hub->pdata;
+	uint32_t seq;
+	
+	while(1){
+		seq = hub->seq;
+		MCN_MEM_BARRIER();
+		memcpy(buffer, pbuf+(seq&1)*hub->obj_size, hub->obj_size);
+		MCN_MEM_BARRIER();
+		if(seq == hub->seq)
+			break;
+		/* publisher modified the copy during reading, try again */
+		hub->retry++;
+	}
+}
+
+/* queued hub keeps queue_depth+1 slots, one slot is reserved for the
+ * sample being written so readers never have to wait for the publisher */
+#define QUEUE_INDEX(_hub, _idx)		((_idx)%((_hub)->queue_depth+1))
+#define QUEUE_SLOT(_hub, _idx)		((uint8_t*)(_hub)->pdata + QUEUE_INDEX(_hub, _idx)*(_hub)->obj_size)
+
+static void _mcn_queue_write(McnHub* hub, const void* data)
+{
+	uint32_t cnt = hub->pub_cnt;
+	
+	memcpy(QUEUE_SLOT(hub, cnt), data, hub->obj_size);
+	hub->pstamp[QUEUE_INDEX(hub, cnt)] = MCN_TIME_STAMP();
+	MCN_MEM_BARRIER();
+	hub->pub_cnt = cnt+1;
+}
+
+/* return 0 if sample idx was not overwritten during reading */
+static int _mcn_queue_read(McnHub* hub, uint32_t idx, void* buffer, uint32_t* stamp)
+{
+	memcpy(buffer, QUEUE_SLOT(hub, idx), hub->obj_size);
+	*stamp = hub->pstamp[QUEUE_INDEX(hub, idx)];
+	MCN_MEM_BARRIER();
+	/* slot of sample idx is reused by sample idx+queue_depth+1 */
+	return (hub->pub_cnt - idx) <= hub->queue_depth ? 0 : 1;
+}
+
+static void _mcn_queue_read_latest(McnHub* hub, void* buffer, uint32_t* stamp)
+{
+	uint32_t cnt;
+	
+	while(1){
+		cnt = hub->pub_cnt;
+		MCN_MEM_BARRIER();
+		if(_mcn_queue_read(hub, cnt-1, buffer, stamp) == 0)
+			break;
+		hub->retry++;
+	}
+}
+
 int mcn_advertise(McnHub* hub)
 {
 	int res = 0;
@@ -23,7 +95,11 @@ int mcn_advertise(McnHub* hub)
 	}
 	
 	MCN_ENTER_CRITICAL;
-	hub->pdata = MCN_MALLOC(hub->obj_size);
+	if(hub->mode == MCN_MODE_SEQLOCK){
+		hub->pdata = MCN_MALLOC(2*hub->obj_size);
+	}else{
+		hub->pdata = MCN_MALLOC(hub->obj_size);
+	}
 	if(hub->pdata == NULL){
 		res = -1;
 	}
@@ -32,6 +108,41 @@ int mcn_advertise(McnHub* hub)
 	return res;
 }
 
+int mcn_advertise_queue(McnHub* hub, uint32_t depth)
+{
+	int res = 0;
+	
+	if(depth == 0){
+		return mcn_advertise(hub);
+	}
+	
+	if(hub->pdata != NULL){
+		// already advertised
+		return 0;
+	}
+	
+	MCN_ENTER_CRITICAL;
+	hub->pdata = MCN_MALLOC((depth+1)*hub->obj_size);
+	hub->pstamp = (uint32_t*)MCN_MALLOC((depth+1)*sizeof(uint32_t));
+	if(hub->pdata == NULL || hub->pstamp == NULL){
+		if(hub->pdata != NULL){
+			MCN_FREE(hub->pdata);
+			hub->pdata = NULL;
+		}
+		if(hub->pstamp != NULL){
+			MCN_FREE(hub->pstamp);
+			hub->pstamp = NULL;
+		}
+		res = -1;
+	}else{
+		hub->queue_depth = depth;
+		hub->pub_cnt = 0;
+	}
+	MCN_EXIT_CRITICAL;
+	
+	return res;
+}
+
 McnNode_t mcn_subscribe(McnHub* hub, void (*cb)(void *parameter))
 {
 	if(hub->link_num >= MCN_MAX_LINK_NUM){
@@ -47,6 +158,9 @@ McnNode_t mcn_subscribe(McnHub* hub, void (*cb)(void *parameter))
 	node->renewal = 0;
 	node->cb = cb;
 	node->next = NULL;
+	node->cursor = hub->pub_cnt;
+	node->lost = 0;
+	node->stamp = 0;
 	
 	MCN_ENTER_CRITICAL;
 	/* no node link yet */
@@ -74,23 +188,47 @@ int mcn_publish(McnHub* hub, const void* data)
 		return -1;
 	}
 	
-	MCN_ENTER_CRITICAL;
-	/* copy data to hub */
-	memcpy(hub->pdata, data, hub->obj_size);
-	/* update each node's renewal flag */
-	McnNode_t node = hub->link_head;
-	while(node != NULL){
-		node->renewal = 1;
-		node = node->next;
+	McnNode_t node;
+	void* pdata = hub->pdata;
+	
+	if(hub->queue_depth){
+		_mcn_queue_write(hub, data);
+		pdata = QUEUE_SLOT(hub, hub->pub_cnt-1);
+		/* update each node's renewal flag */
+		node = hub->link_head;
+		while(node != NULL){
+			node->renewal = 1;
+			node = node->next;
+		}
+		hub->published = 1;
+	}else if(hub->mode == MCN_MODE_SEQLOCK){
+		_mcn_seqlock_write(hub, data);
+		/* update each node's renewal flag */
+		node = hub->link_head;
+		while(node != NULL){
+			node->renewal = 1;
+			node = node->next;
+		}
+		hub->published = 1;
+	}else{
+		MCN_ENTER_CRITICAL;
+		/* copy data to hub */
+		memcpy(hub->pdata, data, hub->obj_size);
+		/* update each node's renewal flag */
+		node = hub->link_head;
+		while(node != NULL){
+			node->renewal = 1;
+			node = node->next;
+		}
+		hub->published = 1;
+		MCN_EXIT_CRITICAL;
 	}
-	hub->published = 1;
-	MCN_EXIT_CRITICAL;
 	
 	/* invoke callback func */
 	node = hub->link_head;
 	while(node != NULL){
 		if(node->cb != NULL){
-			node->cb(hub->pdata);
+			node->cb(pdata);
 		}
 		node = node->next;
 	}
@@ -121,10 +259,21 @@ int mcn_copy(McnHub* hub, McnNode_t node_t, void* buffer)
 		return 2;
 	}
 	
-	MCN_ENTER_CRITICAL;
-	memcpy(buffer, hub->pdata, hub->obj_size);
-	node_t->renewal = 0;
-	MCN_EXIT_CRITICAL;
+	if(hub->queue_depth){
+		/* copy the newest sample and skip all pending ones */
+		node_t->renewal = 0;
+		node_t->cursor = hub->pub_cnt;
+		_mcn_queue_read_latest(hub, buffer, &node_t->stamp);
+	}else if(hub->mode == MCN_MODE_SEQLOCK){
+		/* clear flag before reading, a publish during reading will set it again */
+		node_t->renewal = 0;
+		_mcn_seqlock_read(hub, buffer);
+	}else{
+		MCN_ENTER_CRITICAL;
+		memcpy(buffer, hub->pdata, hub->obj_size);
+		node_t->renewal = 0;
+		MCN_EXIT_CRITICAL;
+	}
 	
 	return 0;
 }
@@ -141,13 +290,85 @@ int mcn_copy_from_hub(McnHub* hub, void* buffer)
 		return 2;
 	}
 	
-	MCN_ENTER_CRITICAL;
-	memcpy(buffer, hub->pdata, hub->obj_size);
-	MCN_EXIT_CRITICAL;
+	if(hub->queue_depth){
+		uint32_t stamp;
+		_mcn_queue_read_latest(hub, buffer, &stamp);
+	}else if(hub->mode == MCN_MODE_SEQLOCK){
+		_mcn_seqlock_read(hub, buffer);
+	}else{
+		MCN_ENTER_CRITICAL;
+		memcpy(buffer, hub->pdata, hub->obj_size);
+		MCN_EXIT_CRITICAL;
+	}
+	
+	return 0;
+}
+
+int mcn_pop(McnHub* hub, McnNode_t node_t, void* buffer)
+{
+	uint32_t cnt;
+	
+	if(hub->pdata == NULL){
+		// not advertised yet
+		Console.e(TAG, "uMCN, pop from null hub:%s\n", hub->obj_name);
+		return 1;
+	}
+	
+	if(hub->queue_depth == 0){
+		/* single-slot hub, only the newest sample can be read */
+		if(!node_t->renewal){
+			return 2;
+		}
+		return mcn_copy(hub, node_t, buffer);
+	}
+	
+	/* clear flag before reading, it's set again if samples remain */
+	node_t->renewal = 0;
+	while(1){
+		cnt = hub->pub_cnt;
+		if(cnt == node_t->cursor){
+			// no new sample
+			return 2;
+		}
+		if(cnt - node_t->cursor > hub->queue_depth){
+			/* reader is too slow, skip the overwritten samples */
+			node_t->lost += cnt - node_t->cursor - hub->queue_depth;
+			node_t->cursor = cnt - hub->queue_depth;
+		}
+		MCN_MEM_BARRIER();
+		if(_mcn_queue_read(hub, node_t->cursor, buffer, &node_t->stamp) == 0)
+			break;
+		hub->retry++;
+	}
+	node_t->cursor++;
+	
+	if(node_t->cursor != hub->pub_cnt){
+		node_t->renewal = 1;
+	}
 	
 	return 0;
 }
 
+uint32_t mcn_pending(McnHub* hub, McnNode_t node_t)
+{
+	uint32_t num;
+	
+	if(hub->queue_depth == 0){
+		return node_t->renewal ? 1 : 0;
+	}
+	
+	num = hub->pub_cnt - node_t->cursor;
+	
+	return num > hub->queue_depth ? hub->queue_depth : num;
+}
+
+void mcn_clear(McnHub* hub, McnNode_t node_t)
+{
+	/* discard all pending samples */
+	node_t->renewal = 0;
+	node_t->cursor = hub->pub_cnt;
+}
+
 int handle_uMCN_cmd(int argc, char** argv)
 {
 	if(argc > 1){
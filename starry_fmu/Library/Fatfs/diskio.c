@@ -13,8 +13,12 @@
 #include "sdio.h"		/* Example: MMC/SDC contorl */
 
 #include "stdio.h"
+#include <string.h>
 
 #define SECTOR_SIZE		512
+/* SDIO DMA needs 4 bytes aligned buffer, unaligned requests are copied
+ * through this buffer in multi-sector chunks */
+#define BOUNCE_SECTOR_NUM	4
 
 /* Definitions of physical drive number for each drive */
 #define MMC		0	/* Example: Map MMC/SD card to drive number 0 */
@@ -71,10 +75,51 @@ DSTATUS disk_initialize (
 	return STA_NOINIT;
 }
 
-//#include <string.h>
-//static uint32_t dma_buffer[SECTOR_SIZE/sizeof(uint32_t)];
-extern SD_Error SD_ReadDisk(uint8_t *readbuff, uint32_t sector, uint32_t count);
-extern SD_Error SD_WriteDisk(const uint8_t *writebuff, uint32_t sector, uint32_t count);
+/* disk_read/disk_write are serialized by FatFs volume lock */
+static uint32_t bounce_buffer[BOUNCE_SECTOR_NUM*SECTOR_SIZE/sizeof(uint32_t)];
+
+static SD_Error mmc_read (BYTE *buff, DWORD sector, UINT count)
+{
+	SD_Error Status = SD_OK;
+	UINT n;
+	
+	if(((uintptr_t)buff & 0x03) == 0)
+		return SD_ReadDisk(buff, sector, count);
+	
+	while(count && Status == SD_OK){
+		n = count < BOUNCE_SECTOR_NUM ? count : BOUNCE_SECTOR_NUM;
+		Status = SD_ReadDisk((uint8_t*)bounce_buffer, sector, n);
+		if(Status == SD_OK){
+			memcpy(buff, bounce_buffer, n*SECTOR_SIZE);
+			buff += n*SECTOR_SIZE;
+			sector += n;
+			count -= n;
+		}
+	}
+	
+	return Status;
+}
+
+static SD_Error mmc_write (const BYTE *buff, DWORD sector, UINT count)
+{
+	SD_Error Status = SD_OK;
+	UINT n;
+	
+	if(((uintptr_t)buff & 0x03) == 0)
+		return SD_WriteDisk(buff, sector, count);
+	
+	while(count && Status == SD_OK){
+		n = count < BOUNCE_SECTOR_NUM ? count : BOUNCE_SECTOR_NUM;
+		memcpy(bounce_buffer, buff, n*SECTOR_SIZE);
+		Status = SD_WriteDisk((uint8_t*)bounce_buffer, sector, n);
+		buff += n*SECTOR_SIZE;
+		sector += n;
+		count -= n;
+	}
+	
+	return Status;
+}
+
 /*-----------------------------------------------------------------------*/
 /* Read Sector(s)                                                        */
 /*-----------------------------------------------------------------------*/
@@ -93,7 +138,7 @@ DRESULT disk_read (
 	case MMC :
 		{
 			SD_Error Status = SD_OK;
-			Status = SD_ReadDisk(buff, sector, count);
+			Status = mmc_read(buff, sector, count);
 			if(Status != SD_OK)
 				return RES_ERROR;
 			
@@ -125,7 +170,7 @@ DRESULT disk_write (
 	case MMC :
 		{
 			SD_Error Status = SD_OK;
-			Status = SD_WriteDisk(buff, sector, count);
+			Status = mmc_write(buff, sector, count);
 			if(Status != SD_OK)
 				return RES_ERROR;
 			
@@ -0,0 +1,59 @@
+/*
+ * File      : starryio_frame.h
+ *
+ * Frame codec of the link between starry_fmu and starry_io. It is shared by
+ * both firmwares and depends on nothing but libc, so it also builds on host.
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __STARRYIO_FRAME_H__
+#define __STARRYIO_FRAME_H__
+
+#include <stdint.h>
+
+/* Frame layout, multi-byte fields are little-endian:
+ * | 0xFA | head | len(2) | cmd | data(len) | crc(2) | 0xFC |
+ * head tells the direction, crc is CRC-16/CCITT (0x1021, init 0xFFFF)
+ * over all bytes before it.
+ */
+#define STARRYIO_FRAME_HEAD				0xFA
+#define STARRYIO_FRAME_END				0xFC
+#define STARRYIO_HEAD_FMU				0x5A		/* sent by fmu */
+#define STARRYIO_HEAD_IO				0x5B		/* sent by io */
+
+#define STARRYIO_FRAME_HEADER_SIZE		5
+#define STARRYIO_FRAME_OVERHEAD			8
+#define STARRYIO_FRAME_MAX_SIZE			256
+#define STARRYIO_FRAME_MAX_DATA			(STARRYIO_FRAME_MAX_SIZE - STARRYIO_FRAME_OVERHEAD)
+
+typedef struct
+{
+	uint8_t			cmd;
+	uint16_t		len;
+	const uint8_t*	data;			/* word aligned, valid only inside frame handler */
+}starryio_frame_t;
+
+typedef void (*starryio_frame_handler_t)(const starryio_frame_t* frame);
+
+typedef struct
+{
+	uint8_t		head;				/* head byte of frames to accept */
+	uint16_t	idx;				/* bytes of current frame received, 0 means hunting for 0xFA */
+	uint16_t	size;				/* size of current frame, valid after header is received */
+	uint32_t	frame_cnt;
+	uint32_t	err_cnt;			/* frames dropped by crc or end flag */
+	uint32_t	drop_cnt;			/* bytes skipped while hunting for frame head */
+	/* frame is stored from byte 3, so its data (byte 5 of frame) is word aligned
+	 * and can be read as float/uint32_t in place */
+	uint32_t	buff[(STARRYIO_FRAME_MAX_SIZE + 3 + 3) / 4];
+}starryio_decoder_t;
+
+uint16_t starryio_crc16(uint16_t crc, const uint8_t* data, uint32_t len);
+uint16_t starryio_frame_encode(uint8_t* buff, uint16_t buff_size, uint8_t head, uint8_t cmd, const void* data, uint16_t len);
+void starryio_decoder_init(starryio_decoder_t* dec, uint8_t head);
+void starryio_frame_input(starryio_decoder_t* dec, const uint8_t* data, uint32_t size, starryio_frame_handler_t handler);
+
+#endif
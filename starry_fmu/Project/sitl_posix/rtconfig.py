@@ -0,0 +1,44 @@
+import os
+
+# toolchains options
+ARCH='sim'
+CPU='posix'
+CROSS_TOOL='gcc'
+PLATFORM='gcc'
+
+# host toolchain
+EXEC_PATH = '/usr/bin'
+
+if os.getenv('RTT_EXEC_PATH'):
+	EXEC_PATH = os.getenv('RTT_EXEC_PATH')
+
+BUILD = ''
+
+# toolchains
+PREFIX = ''
+CC = PREFIX + 'gcc'
+AS = PREFIX + 'gcc'
+AR = PREFIX + 'ar'
+LINK = PREFIX + 'gcc'
+TARGET_EXT = 'elf'
+SIZE = PREFIX + 'size'
+OBJDUMP = PREFIX + 'objdump'
+OBJCPY = PREFIX + 'objcopy'
+
+# the posix cpu port keeps thread pointers in rt_uint32_t, so build 32-bit
+DEVICE = ' -m32 -ffunction-sections -fdata-sections'
+CFLAGS = DEVICE + ' -g -Wall -DUSE_STDPERIPH_DRIVER -DSTM32F427X -DARM_MATH_MATRIX_CHECK -DARM_MATH_CM4 -D__FPU_PRESENT="1"'
+CFLAGS += ' -std=gnu99'
+AFLAGS = ' -c' + DEVICE + ' -x assembler-with-cpp'
+LFLAGS = DEVICE + ' -Wl,--gc-sections,-Map=starry_sitl.map,-cref -T sitl.lds'
+LIBS = ['pthread', 'm']
+
+CPATH = ''
+LPATH = ''
+
+if BUILD == 'debug':
+    CFLAGS += ' -O0 -gdwarf-2'
+else:
+    CFLAGS += ' -O2 -fno-omit-frame-pointer'
+
+POST_ACTION = SIZE + ' $TARGET \n'
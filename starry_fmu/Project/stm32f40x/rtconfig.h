@@ -117,6 +117,10 @@
 #define RT_USING_LIBC
 //#define RT_USING_PTHREADS
 
+/* SECTION: compression, used by logger */
+#define RT_USING_LZO
+#define RT_USING_LIBZ
+
 /* SECTION: lwip, a lighwight TCP/IP protocol stack */
 /* #define RT_USING_LWIP */
 /* LwIP uses RT-Thread Memory Management */
@@ -36,6 +36,33 @@
 
 volatile rt_uint8_t rt_interrupt_nest;
 
+#ifdef RT_USING_HOOK
+static void (*rt_interrupt_enter_hook)(void);
+static void (*rt_interrupt_leave_hook)(void);
+
+/**
+ * @ingroup Hook
+ * This function set a hook function when the system enter a interrupt
+ *
+ * @note the hook function must be simple and never be blocked or suspend.
+ */
+void rt_interrupt_enter_sethook(void (*hook)(void))
+{
+    rt_interrupt_enter_hook = hook;
+}
+
+/**
+ * @ingroup Hook
+ * This function set a hook function when the system exit a interrupt.
+ *
+ * @note the hook function must be simple and never be blocked or suspend.
+ */
+void rt_interrupt_leave_sethook(void (*hook)(void))
+{
+    rt_interrupt_leave_hook = hook;
+}
+#endif
+
 /**
  * This function will be invoked by BSP, when enter interrupt service routine
  *
@@ -52,6 +79,7 @@ void rt_interrupt_enter(void)
 
     level = rt_hw_interrupt_disable();
     rt_interrupt_nest ++;
+    RT_OBJECT_HOOK_CALL(rt_interrupt_enter_hook,());
     rt_hw_interrupt_enable(level);
 }
 RTM_EXPORT(rt_interrupt_enter);
@@ -71,6 +99,7 @@ void rt_interrupt_leave(void)
                                 rt_interrupt_nest));
 
     level = rt_hw_interrupt_disable();
+    RT_OBJECT_HOOK_CALL(rt_interrupt_leave_hook,());
     rt_interrupt_nest --;
     rt_hw_interrupt_enable(level);
 }
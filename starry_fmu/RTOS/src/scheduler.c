@@ -62,6 +62,7 @@ rt_list_t rt_thread_defunct;
 
 #ifdef RT_USING_HOOK
 static void (*rt_scheduler_hook)(struct rt_thread *from, struct rt_thread *to);
+static void (*rt_scheduler_insert_hook)(struct rt_thread *thread);
 
 /**
  * @addtogroup Hook
@@ -81,6 +82,18 @@ rt_scheduler_sethook(void (*hook)(struct rt_thread *from, struct rt_thread *to))
     rt_scheduler_hook = hook;
 }
 
+/**
+ * This function will set a hook function, which will be invoked when a thread
+ * is inserted to the ready queue.
+ *
+ * @param hook the hook function
+ */
+void
+rt_scheduler_insert_sethook(void (*hook)(struct rt_thread *thread))
+{
+    rt_scheduler_insert_hook = hook;
+}
+
 /*@}*/
 #endif
 
@@ -299,6 +312,8 @@ void rt_schedule_insert_thread(struct rt_thread *thread)
 #endif
     rt_thread_ready_priority_group |= thread->number_mask;
 
+    RT_OBJECT_HOOK_CALL(rt_scheduler_insert_hook, (thread));
+
     /* enable interrupt */
     rt_hw_interrupt_enable(temp);
 }
@@ -20,11 +20,13 @@
 
 int main(void)
 {
-	uint8_t ch;
+	uint8_t rx_buff[64];
+	uint16_t rx_size;
 	uint32_t time_led, time_sync;
 	uint32_t now;
 	
 	usart_init();
+	protocol_init();
 #ifdef USE_PWM_OUTPUT
 	pwm_init();
 #endif
@@ -44,8 +46,9 @@ int main(void)
 
 	while (1)
 	{
-		if(read_ch(&ch)){
-			protocol_input_byte(ch);
+		rx_size = read_buff(rx_buff, sizeof(rx_buff));
+		if(rx_size){
+			protocol_input(rx_buff, rx_size);
 		}
 		
 		if(sync_finish()){
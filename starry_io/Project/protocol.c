@@ -13,319 +13,49 @@
 #include "usart.h"
 #include "pwm.h"
 #include <stdio.h>
-#include <stdlib.h>
 
-static uint8_t pack_buff[MAX_PACKAGE_SIZE];
-static uint8_t pack_usr_buff[MAX_PACKAGE_SIZE];
+static starryio_decoder_t decoder;
+static uint8_t tx_buff[STARRYIO_FRAME_MAX_SIZE];
 static uint8_t sync_ack = 0;
-Package_Def Recv_Package;
-
-#define min(a, b) ((a) > (b) ? (b) : (a))
 
 #ifdef PROTOCOL_SERVER
-static uint8_t s_head = 0x5A;
-static uint8_t r_head = 0x5B;
+static uint8_t s_head = STARRYIO_HEAD_FMU;
+static uint8_t r_head = STARRYIO_HEAD_IO;
 #else
-static uint8_t s_head = 0x5B;
-static uint8_t r_head = 0x5A;
+static uint8_t s_head = STARRYIO_HEAD_IO;
+static uint8_t r_head = STARRYIO_HEAD_FMU;
 #endif
 
-void _fill_head(Package_Def* package)
-{
-	package->head[0] = 0xFA;
-	package->head[1] = s_head;
-}
-
-void _fill_endflag(Package_Def* package)
-{
-	package->endflag = 0xFC;
-}
-
-uint16_t _calc_checksum(const Package_Def* package)
+/* encode a package into caller's buffer, return package size or 0 if it does not fit */
+uint16_t make_package(uint8_t* buff, uint16_t buff_size, uint8_t cmd, const void* data, uint16_t len)
 {
-	uint16_t cheksum = 0;
-	uint16_t i;
+	uint16_t size = starryio_frame_encode(buff, buff_size, s_head, cmd, data, len);
 	
-	cheksum = package->head[0]+package->head[1]+((package->len&0xFF)+((package->len>>8)&0xFF))+package->cmd;
-	
-	for(i=0 ; i<package->len ; i++){
-		cheksum += (uint8_t)package->usr_data[i];
+	if(size == 0){
+		printf("package too long:%d\n" , len);
 	}
 	
-	return cheksum;
-}
-
-void free_pack(Package_Def* package)
-{
-	if(package->len > 0 && package->usr_data != NULL){
-		free(package->usr_data);
-	}
-}
-
-void free_sendpack(SendPackage_Def* send_pack)
-{
-	if(send_pack->send_buff != NULL){
-		free(send_pack->send_buff);
-	}
-}
-
-//Noticed: need to adjust heap size to suit the package size
-uint8_t make_package(uint8_t* data , char cmd , uint16_t len , Package_Def* package)
-{
-	uint16_t i;
-	
-	_fill_head(package);
-	
-	package->len = len;
-	package->cmd = cmd;
-
-	//copy data
-	if(len>0){
-		package->usr_data = malloc(len);
-		if(package->usr_data == NULL){
-			printf("Make_Package Heap is not enough:%d\n" , len);
-			return 0;
-		}
-	}
-	for(i=0 ; i<len ; i++){
-		package->usr_data[i] = data[i];
-	}
-	
-	//calculate checksum
-	package->checksum = _calc_checksum(package);
-	
-	_fill_endflag(package);
-
-	return 1;
-}
-
-uint8_t package2sendpack(const Package_Def package , SendPackage_Def* send_pack)
-{
-	int i;
-	send_pack->buff_size = package.len+PACK_SIZE_EXCEPT_DATA;
-	//When sending finish, should involke FreeSendPack() to free memory.
-	send_pack->send_buff = malloc(send_pack->buff_size);
-	if(send_pack->send_buff == NULL){
-		printf("Package2SendPack Heap is not enough:%d\n" , send_pack->buff_size);
-		return 0;
-	}
-	
-	send_pack->send_buff[0] = package.head[0];
-	send_pack->send_buff[1] = package.head[1];
-	//little-endian 
-	*((uint16_t*)&send_pack->send_buff[2]) = package.len;
-	send_pack->send_buff[4] = package.cmd;
-	for(i=0 ; i<package.len ; i++){
-		send_pack->send_buff[5+i] = package.usr_data[i];
-	}
-	*((uint16_t*)&send_pack->send_buff[5+package.len]) = package.checksum;
-	send_pack->send_buff[7+package.len] = package.endflag;
-	
-	return 1;
-}
-
-uint8_t parse_package(const uint8_t* data , Package_Def* package)
-{
-	static Package_Def tempPack;
-	uint16_t correct_checksum;
-	int i;
-	
-	if(data == NULL){
-		printf("ParsePackage data NULL\n");
-		return 0x01;
-	}
-	
-	tempPack.head[0] = data[0];
-	tempPack.head[1] = data[1];
-	tempPack.len = *((uint16_t*)&data[2]);
-	tempPack.cmd = data[4];
-	
-	if(tempPack.head[0] != 0xFA || tempPack.head[1] != r_head){
-		printf("ParsePackage pack head illegal\n");
-		return 0x02;
-	}
-	
-	if(data[7+tempPack.len] != 0xFC){
-		printf("ParsePackage tail illegal\n");
-		return 0x03;
-	}
-	
-	if(tempPack.len > 0){
-		tempPack.usr_data = pack_usr_buff;
-		
-		for(i = 0 ; i<min(sizeof(pack_usr_buff), tempPack.len) ; i++){
-			tempPack.usr_data[i] = (uint8_t)data[5+i];
-		}
-	}
-
-	tempPack.checksum = *((uint16_t*)&data[5+tempPack.len]);
-	tempPack.endflag = data[7+tempPack.len];
-
-	correct_checksum = _calc_checksum(&tempPack);
-	if(tempPack.checksum != correct_checksum){
-		printf("checksum not correct %x\n" , correct_checksum);
-		return 0x04;
-	}
-	
-	if(tempPack.len > 0){
-		package->usr_data = tempPack.usr_data;
-	}
-
-	package->head[0] = tempPack.head[0];
-	package->head[1] = tempPack.head[1];
-	package->len = tempPack.len;
-	package->cmd = tempPack.cmd;
-
-	package->checksum = tempPack.checksum;
-	package->endflag = tempPack.endflag;
-	
-	return 0;
-}
-
-uint8_t wait_complete_pack(uint8_t c, uint8_t* pack_buff)
-{
-	#define WAIT_HEAD_1	0x00
-	#define WAIT_HEAD_2	0x01
-	#define WAIT_LEN_1	0x02
-	#define WAIT_LEN_2	0x03
-	#define WAIT_CMD	0x04
-	#define WAIT_DATA	0x05
-	#define WAIT_CS_1	0x06
-	#define WAIT_CS_2	0x07
-	#define WAIT_0xFC	0x08
-	
-	uint8_t res = 0;
-	static uint8_t status = WAIT_HEAD_1;
-	static uint16_t data_cnt = 0;
-	
-	switch(status)
-	{
-		case WAIT_HEAD_1:
-		{
-			if(c == 0xFA){
-				pack_buff[0] = c;
-				status = WAIT_HEAD_2;
-			}
-			
-			res = 0;
-		}break;
-		case WAIT_HEAD_2:
-		{
-			if(c == r_head)
-			{
-				pack_buff[1] = c;
-				status = WAIT_LEN_1;
-			}
-			else if(c != 0xFA)
-			{
-				status = WAIT_HEAD_1;
-			}
-			
-			res = 0;
-		}break;
-		case WAIT_LEN_1:
-		{
-			pack_buff[2] = c;
-			status = WAIT_LEN_2;
-			
-			res = 0;
-		}break;
-		case WAIT_LEN_2:
-		{
-			pack_buff[3] = c;
-			if(*(uint16_t*)&pack_buff[2] > (MAX_PACKAGE_SIZE-PACK_SIZE_EXCEPT_DATA)){
-				printf("err,pack len exceed max value:%d\n" , *(uint16_t*)&pack_buff[2]);
-				status = WAIT_HEAD_1;
-			}else{
-				status = WAIT_CMD;
-			}
-			
-			res = 0;
-		}break;
-		case WAIT_CMD:
-		{
-			pack_buff[4] = c;
-			if(*(uint16_t*)&pack_buff[2] > 0){
-				status = WAIT_DATA;
-			}else{
-				status = WAIT_CS_1;
-			}
-			data_cnt = 0;
-			
-			res = 0;
-		}break;
-		case WAIT_DATA:
-		{
-			pack_buff[5+data_cnt] = c;
-			data_cnt++;
-			
-			if(data_cnt >= *(uint16_t*)&pack_buff[2]){
-				status = WAIT_CS_1;
-			}
-			
-			res = 0;
-		}break;
-		case WAIT_CS_1:
-		{
-			pack_buff[5+data_cnt] = c;
-			status = WAIT_CS_2;
-			
-			res = 0;
-		}break;
-		case WAIT_CS_2:
-		{
-			pack_buff[6+data_cnt] = c;
-			status = WAIT_0xFC;
-			
-			res = 0;
-		}break;
-		case WAIT_0xFC:
-		{
-			if(c == 0xFC)
-			{
-				pack_buff[7+data_cnt] = c;	
-				status = WAIT_HEAD_1;
-				res = 1;		
-			}
-			else if(c == 0xFA)
-			{
-				status = WAIT_HEAD_2;
-				res = 0;
-			}
-			else
-			{
-				status = WAIT_HEAD_1;
-				res = 0;
-			}
-			
-			
-		}break;
-	}
-	
-	return res;
+	return size;
 }
 
+/* all packages are sent from main loop, so one static tx buffer is enough */
 uint8_t send_package(uint8_t cmd, uint8_t* data, uint16_t len)
 {
-	Package_Def pack;
-	SendPackage_Def send_pack;
+	uint16_t size;
 	
-	if(!make_package(data , cmd , len , &pack)){
+	size = make_package(tx_buff, sizeof(tx_buff), cmd, data, len);
+	if(size == 0){
 		return 0;
 	}
 	
-	package2sendpack(pack , &send_pack);
-	send(send_pack.send_buff, send_pack.buff_size);
-	
-	free_pack(&pack);
-	free_sendpack(&send_pack);
+	send(tx_buff, size);
 	
 	return 1;
 }
 
-void handle_package(const Package_Def package)
+static void handle_package(const starryio_frame_t* package)
 {
-	switch(package.cmd){
+	switch(package->cmd){
 		case ACK_SYNC:
 		{
 			sync_ack = 1;
@@ -337,14 +67,14 @@ void handle_package(const Package_Def package)
 		}break;
 		case CMD_CONFIG_CHANNEL:
 		{
-			if( config_ppm_send_freq(*package.usr_data) ){
-				send_package(ACK_CONFIG_CHANNEL, package.usr_data, 1);
+			if( config_ppm_send_freq(*package->data) ){
+				send_package(ACK_CONFIG_CHANNEL, (uint8_t*)package->data, 1);
 			}
 		}break;
 #ifdef USE_PWM_OUTPUT
 		case CMD_SET_PWM_CHANNEL:
 		{
-			PWM_CHAN_MSG pwm_msg = *((PWM_CHAN_MSG*)package.usr_data);
+			PWM_CHAN_MSG pwm_msg = *((const PWM_CHAN_MSG*)package->data);
 			pwm_write(pwm_msg.duty_cyc, pwm_msg.chan_id);
 		}break;
 		case CMD_GET_PWM_CHANNEL:
@@ -356,7 +86,7 @@ void handle_package(const Package_Def package)
 		}break;
 		case CMD_CONFIG_PWM_CHANNEL:
 		{
-			PWM_CONFIG_MSG pwm_conf_msg = *((PWM_CONFIG_MSG*)package.usr_data);
+			PWM_CONFIG_MSG pwm_conf_msg = *((const PWM_CONFIG_MSG*)package->data);
 			if(pwm_configure(pwm_conf_msg.cmd, &pwm_conf_msg.val) == 0){
 				send_package(ACK_CONFIG_PWM_CHANNEL, NULL, 0);
 			}
@@ -372,19 +102,18 @@ uint8_t sync_finish(void)
 	return sync_ack;
 }
 
-void protocol_input_byte(uint8_t ch)
+void protocol_init(void)
+{
+	starryio_decoder_init(&decoder, r_head);
+}
+
+void protocol_input(const uint8_t* data, uint16_t size)
 {
-	uint8_t ret;
+	uint32_t err_cnt = decoder.err_cnt;
+	
+	starryio_frame_input(&decoder, data, size, handle_package);
 	
-	if(wait_complete_pack(ch, pack_buff))
-	{
-		ret = parse_package(pack_buff , &Recv_Package);
-		
-		if(ret){
-			printf("parse packake error:%d" , ret);
-		}else{				
-			handle_package(Recv_Package);
-		}	
+	if(decoder.err_cnt != err_cnt){
+		printf("package checksum error:%d\n" , decoder.err_cnt - err_cnt);
 	}
 }
-
@@ -12,29 +12,11 @@
 #define  _PROTOCOL_H_
 
 #include "stm32f10x.h"
-
-#define		PACK_SIZE_EXCEPT_DATA		8
-#define		MAX_PACKAGE_SIZE			256
+#include "starryio_frame.h"
 
 //#define		PROTOCOL_SERVER
 #define		PROTOCOL_CLIENT
 
-typedef struct
-{
-	uint8_t		head[2];
-	uint16_t	len;
-	uint8_t		cmd;
-	uint8_t* 	usr_data;
-	uint16_t 	checksum;
-	uint8_t		endflag;
-}Package_Def;
-
-typedef struct
-{
-	uint8_t* 	send_buff;
-	uint16_t 	buff_size;
-}SendPackage_Def;
-
 typedef enum
 {
 	ACK_SYNC = 0x01,
@@ -57,11 +39,9 @@ typedef enum
 	ACK_CONFIG_PWM_CHANNEL = 0x08,
 }CLIENT_CMD_Def;
 
-uint8_t make_package(uint8_t* data , char cmd , uint16_t len , Package_Def* package);
-uint8_t package2sendpack(const Package_Def package , SendPackage_Def* send_pack);
-void free_pack(Package_Def* package);
-void free_sendpack(SendPackage_Def* send_pack);
-void protocol_input_byte(uint8_t ch);
+uint16_t make_package(uint8_t* buff, uint16_t buff_size, uint8_t cmd, const void* data, uint16_t len);
+void protocol_init(void);
+void protocol_input(const uint8_t* data, uint16_t size);
 //uint8_t sync(void);
 uint8_t sync_finish(void);
 uint8_t send_package(uint8_t cmd, uint8_t* data, uint16_t len);
@@ -10,6 +10,7 @@
 
 #include "usart.h"
 #include <stdio.h>
+#include <string.h>
 
 RING_BUFFER_Def rb;
 
@@ -44,6 +45,25 @@ uint8_t read_ch(uint8_t* ch)
 	return 0;
 }
 
+/* move received bytes out of ring buffer in at most two copies */
+uint16_t read_buff(uint8_t* buff, uint16_t size)
+{
+	uint16_t head = rb.head;
+	uint16_t cnt = 0;
+	uint16_t n;
+	
+	while(cnt < size && rb.tail != head){
+		n = (head > rb.tail ? head : RING_BUFFER_SIZE) - rb.tail;
+		if(n > size - cnt)
+			n = size - cnt;
+		memcpy(&buff[cnt], &rb.buff[rb.tail], n);
+		cnt += n;
+		rb.tail = ( rb.tail + n ) % RING_BUFFER_SIZE;
+	}
+	
+	return cnt;
+}
+
 uint8_t usart_init(void)
 {
 	GPIO_InitTypeDef GPIO_InitStructure;
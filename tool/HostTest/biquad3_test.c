@@ -0,0 +1,213 @@
+/*
+ * File      : biquad3_test.c
+ *
+ * Host test and benchmark of the three axis biquad bank. With stage_num 1
+ * biquad3_filter_process() must give bit for bit the output of three
+ * butter2_filter_process() over random gyro and acc like input, for several
+ * cutoffs and after reset to the same sample. The gain of 1 and 2 stages is
+ * measured on sines at 1 kHz and compared with the butterworth magnitude of
+ * the prewarped design. Then 3 x Butter2 and Biquad3 are timed.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o biquad3_test biquad3_test.c $S/Framework/source/Filter/biquad3.c $S/Framework/source/Filter/butter.c -lm
+ * usage: biquad3_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include "butter.h"
+#include "biquad3.h"
+#include "console.h"
+
+#define SAMPLE_FREQ		1000.0f
+#define SAMPLE_NUM		1000000
+#define BENCH_NUM		4000000
+#define GAIN_TOL_DB		0.05
+
+static uint32_t _fail;
+static float _in[SAMPLE_NUM][3];
+static volatile float _sink;
+
+/* framework calls used by butter.c */
+void* rt_malloc(rt_size_t nbytes)
+{
+	return malloc(nbytes);
+}
+
+static void _print(const char* fmt, ...)
+{
+	(void)fmt;
+}
+
+CONSOLE_Typedef Console = {.print = _print};
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static float _rand_float(float range)
+{
+	return (rand()/(float)RAND_MAX - 0.5f)*2.0f*range;
+}
+
+static void _gen_input(void)
+{
+	srand(3);
+	for(int n = 0 ; n < SAMPLE_NUM ; n++){
+		/* gyro in rad/s with vibration, and acc with gravity on z */
+		_in[n][0] = _rand_float(8.0f) + 0.3f*sinf(n*0.9f);
+		_in[n][1] = _rand_float(20.0f);
+		_in[n][2] = _rand_float(20.0f) - 9.8f;
+	}
+}
+
+static void _test_bit_exact(float cutoff_freq)
+{
+	const float init[3] = {0.01f, 0.7071f, -9.8f};
+	Butter2 butter[3];
+	Biquad3 bq;
+	float out_butter[3], out_bq[3];
+	uint32_t mismatch = 0;
+
+	for(int i = 0 ; i < 3 ; i++){
+		butter2_set_cutoff_frequency(&butter[i], SAMPLE_FREQ, cutoff_freq);
+		out_butter[i] = butter2_reset(&butter[i], init[i]);
+	}
+	biquad3_init(&bq, SAMPLE_FREQ, cutoff_freq, 1);
+	biquad3_reset(&bq, init, out_bq);
+	mismatch += memcmp(out_butter, out_bq, sizeof(out_bq)) != 0;
+
+	for(int n = 0 ; n < SAMPLE_NUM ; n++){
+		for(int i = 0 ; i < 3 ; i++)
+			out_butter[i] = butter2_filter_process(&butter[i], _in[n][i]);
+		biquad3_filter_process(&bq, _in[n], out_bq);
+		mismatch += memcmp(out_butter, out_bq, sizeof(out_bq)) != 0;
+	}
+
+	printf("cutoff %5.1f Hz: %u of %d samples differ from 3 x Butter2\n", cutoff_freq, mismatch, SAMPLE_NUM);
+	if(mismatch)
+		_fail++;
+}
+
+/* gain at freq from one second of steady state output */
+static double _measure_gain(Biquad3* bq, float freq)
+{
+	const int n_sample = (int)SAMPLE_FREQ;
+	double re = 0.0, im = 0.0;
+	float in[3], out[3];
+
+	memset(bq->w1, 0, sizeof(bq->w1));
+	memset(bq->w2, 0, sizeof(bq->w2));
+	for(int n = 0 ; n < 2*n_sample ; n++){
+		double phase = 2.0*M_PI*freq*n/SAMPLE_FREQ;
+
+		in[0] = in[1] = in[2] = (float)cos(phase);
+		biquad3_filter_process(bq, in, out);
+		if(n >= n_sample){
+			re += out[0]*cos(phase);
+			im += out[0]*sin(phase);
+		}
+	}
+
+	return 2.0*sqrt(re*re + im*im)/n_sample;
+}
+
+static void _test_response(uint8_t stage_num, float cutoff_freq)
+{
+	const float freq[] = {5.0f, cutoff_freq, 2.0f*cutoff_freq, 4.0f*cutoff_freq};
+	Biquad3 bq;
+	double gain_db, expect_db, err_max = 0.0;
+
+	biquad3_init(&bq, SAMPLE_FREQ, cutoff_freq, stage_num);
+	printf("%u stage, cutoff %.0f Hz:", stage_num, cutoff_freq);
+	for(uint32_t k = 0 ; k < sizeof(freq)/sizeof(freq[0]) ; k++){
+		/* bilinear transform maps tan(pi*f/fs) to the analog frequency */
+		double r = tan(M_PI*freq[k]/SAMPLE_FREQ)/tan(M_PI*cutoff_freq/SAMPLE_FREQ);
+
+		expect_db = -10.0*log10(1.0 + pow(r, 4*stage_num));
+		gain_db = 20.0*log10(_measure_gain(&bq, freq[k]));
+		if(fabs(gain_db - expect_db) > err_max)
+			err_max = fabs(gain_db - expect_db);
+		printf("  %.0f Hz %.2f dB", freq[k], gain_db);
+	}
+	printf(", max error %.4f dB\n", err_max);
+	if(err_max > GAIN_TOL_DB)
+		_fail++;
+}
+
+static void _bench(void)
+{
+	Butter2 butter[3];
+	Biquad3 bq1, bq2;
+	float out[3];
+	double butter_ns, bq1_ns, bq2_ns;
+	uint64_t start;
+
+	for(int i = 0 ; i < 3 ; i++)
+		butter2_set_cutoff_frequency(&butter[i], SAMPLE_FREQ, 30.0f);
+	biquad3_init(&bq1, SAMPLE_FREQ, 30.0f, 1);
+	biquad3_init(&bq2, SAMPLE_FREQ, 30.0f, 2);
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		const float* in = _in[n % SAMPLE_NUM];
+
+		for(int i = 0 ; i < 3 ; i++)
+			out[i] = butter2_filter_process(&butter[i], in[i]);
+		_sink = out[0] + out[1] + out[2];
+	}
+	butter_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		biquad3_filter_process(&bq1, _in[n % SAMPLE_NUM], out);
+		_sink = out[0] + out[1] + out[2];
+	}
+	bq1_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		biquad3_filter_process(&bq2, _in[n % SAMPLE_NUM], out);
+		_sink = out[0] + out[1] + out[2];
+	}
+	bq2_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	printf("\nper 3 axis sample:\n");
+	printf("3 x Butter2       %6.2f ns, %6.1f M samples/s\n", butter_ns, 1e3/butter_ns);
+	printf("Biquad3 1 stage   %6.2f ns, %6.1f M samples/s\n", bq1_ns, 1e3/bq1_ns);
+	printf("Biquad3 2 stage   %6.2f ns, %6.1f M samples/s\n", bq2_ns, 1e3/bq2_ns);
+}
+
+int main(void)
+{
+	_gen_input();
+	_test_bit_exact(30.0f);
+	_test_bit_exact(60.0f);
+	_test_bit_exact(100.0f);
+	_test_bit_exact(250.0f);
+
+	_test_response(1, 30.0f);
+	_test_response(2, 30.0f);
+	_test_response(2, 100.0f);
+	_bench();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
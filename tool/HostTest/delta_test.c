@@ -0,0 +1,471 @@
+/*
+ * File      : delta_test.c
+ *
+ * Host round trip test and benchmark of the log delta codec on recorded
+ * flight data. The 52 fields of HIL.LOG are split into the topics the logger
+ * writes and each row is published as one sample per topic, 4ms apart.
+ * Records are framed as the logger does: a plain record (sync, id, size,
+ * timestamp, payload) when log_delta_encode() returns 0, otherwise a delta
+ * record (sync, id, body size, body). Checked:
+ *   every sample decodes exactly, also when random records are dropped
+ *   before reaching the file (the encoder is reset as the logger does)
+ *   random walk signals with sign flips, nan, big jumps and a timestamp
+ *   wrap, payloads of 1..64 words
+ *   random bit flips never make the decoder read out of a record
+ * Then bytes/sample per topic, ns/sample and the size with lzo blocks on top
+ * are printed.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -I$S/Framework/include -I$S/RTOS/components/external/lzo
+ *            -o delta_test delta_test.c $S/Framework/source/Logger/log_delta.c
+ *            $S/RTOS/components/external/lzo/minilzo.c
+ * usage: delta_test [HIL.LOG]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include "log_delta.h"
+#include "minilzo.h"
+
+#define RECORD_SYNC			0xA5
+#define RECORD_SYNC_DELTA	0xA6
+#define MAX_WORD			64
+#define MAX_RECORD_SIZE		(8 + 4*MAX_WORD)
+#define TOPIC_NUM			10
+#define RANDOM_SAMPLE_NUM	200000
+#define CORRUPT_RUN_NUM		200
+#define BENCH_LOOP			20
+#define LZO_BLOCK_SIZE		8192
+
+#pragma pack(push, 1)
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	payload_size;
+	uint32_t	timestamp;
+}record_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	body_size;
+}delta_record_t;
+#pragma pack(pop)
+
+typedef struct
+{
+	uint8_t		msg_id;
+	uint32_t	timestamp;
+	uint32_t	payload[MAX_WORD];
+}sample_t;
+
+/* HIL.LOG field index of each topic, -1 ends the list */
+static const int _topic_field[TOPIC_NUM][12] =
+{
+	{0, 1, 2, 3, 4, 5, 6, -1},
+	{7, 8, 9, 10, 11, 12, -1},
+	{13, 14, 15, -1},
+	{16, 17, 18, 22, 23, 24, -1},
+	{19, 20, 21, -1},
+	{25, 26, 27, 28, 29, 30, -1},
+	{31, 32, 33, 34, -1},
+	{35, 36, 37, 38, 39, 40, -1},
+	{41, 42, 43, 44, 45, 46, 47, 48, 49, -1},
+	{50, 51, -1},
+};
+static const char* _topic_name[TOPIC_NUM] = {"ATT", "POS", "GYR", "FILTER", "ACC", "MAG", "MOTOR", "ADRC", "GPS", "BARO"};
+
+static uint32_t _fail;
+static log_delta_t _enc[TOPIC_NUM];
+static uint32_t _enc_prev[TOPIC_NUM][MAX_WORD];
+static log_delta_t _dec[TOPIC_NUM+1];
+static uint32_t _dec_prev[TOPIC_NUM+1][MAX_WORD];
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void _init_encoder(const int* word_num)
+{
+	for(int t = 0 ; t < TOPIC_NUM ; t++)
+		log_delta_init(&_enc[t], _enc_prev[t], word_num[t]);
+}
+
+/* write a record as _logger_write_msg() does, a dropped record resets the encoder */
+static uint32_t _put(const sample_t* s, const int* word_num, uint8_t* out, uint8_t use_delta, uint8_t drop)
+{
+	log_delta_t* d = &_enc[s->msg_id-1];
+	uint16_t payload_size = 4*word_num[s->msg_id-1];
+	uint32_t size = 0;
+
+	if(use_delta)
+		size = log_delta_encode(d, s->timestamp, s->payload, out + sizeof(delta_record_t), MAX_RECORD_SIZE - sizeof(delta_record_t));
+	if(size){
+		delta_record_t* header = (delta_record_t*)out;
+
+		header->sync = RECORD_SYNC_DELTA;
+		header->msg_id = s->msg_id;
+		header->body_size = size;
+		size += sizeof(delta_record_t);
+	}else{
+		record_t* header = (record_t*)out;
+
+		header->sync = RECORD_SYNC;
+		header->msg_id = s->msg_id;
+		header->payload_size = payload_size;
+		header->timestamp = s->timestamp;
+		memcpy(out + sizeof(record_t), s->payload, payload_size);
+		if(use_delta)
+			log_delta_key(d, s->timestamp, s->payload);
+		size = sizeof(record_t) + payload_size;
+	}
+	if(drop){
+		if(use_delta)
+			log_delta_reset(d);
+		return 0;
+	}
+
+	return size;
+}
+
+static uint32_t _put_all(const sample_t* sample, int num, const int* word_num, uint8_t* out, uint8_t use_delta)
+{
+	uint32_t size = 0;
+
+	_init_encoder(word_num);
+	for(int k = 0 ; k < num ; k++)
+		size += _put(&sample[k], word_num, out + size, use_delta, 0);
+
+	return size;
+}
+
+/* decode the stream and compare with the expected samples. Strict: the first
+ * mismatch fails, otherwise broken records are counted and skipped */
+static int _check(const uint8_t* stream, uint32_t size, const sample_t* expect, int num, const int* word_num, uint8_t strict)
+{
+	uint32_t payload[MAX_WORD];
+	uint32_t timestamp;
+	uint32_t pos = 0;
+	int k = 0, bad = 0;
+
+	for(int t = 0 ; t < TOPIC_NUM ; t++)
+		log_delta_init(&_dec[t+1], _dec_prev[t+1], word_num[t]);
+
+	while(pos + sizeof(delta_record_t) <= size){
+		uint8_t msg_id = stream[pos+1];
+		uint8_t ok;
+
+		if(msg_id < 1 || msg_id > TOPIC_NUM || (stream[pos] != RECORD_SYNC && stream[pos] != RECORD_SYNC_DELTA)){
+			if(strict){
+				printf("sync lost at %u\n", pos);
+				return -1;
+			}
+			pos++;
+			continue;
+		}
+		if(stream[pos] == RECORD_SYNC_DELTA){
+			const delta_record_t* header = (const delta_record_t*)&stream[pos];
+
+			if(pos + sizeof(delta_record_t) + header->body_size > size)
+				break;
+			pos += sizeof(delta_record_t);
+			if(log_delta_decode(&_dec[msg_id], &stream[pos], header->body_size, &timestamp, payload) != header->body_size){
+				bad++;
+				pos += header->body_size;
+				continue;
+			}
+			pos += header->body_size;
+		}else{
+			const record_t* header = (const record_t*)&stream[pos];
+
+			if(pos + sizeof(record_t) + header->payload_size > size)
+				break;
+			if(header->payload_size != 4*word_num[msg_id-1]){
+				bad++;
+				pos++;
+				continue;
+			}
+			pos += sizeof(record_t);
+			timestamp = header->timestamp;
+			memcpy(payload, &stream[pos], header->payload_size);
+			log_delta_key(&_dec[msg_id], timestamp, payload);
+			pos += header->payload_size;
+		}
+
+		ok = k < num && expect[k].msg_id == msg_id && expect[k].timestamp == timestamp
+			&& memcmp(expect[k].payload, payload, 4*word_num[msg_id-1]) == 0;
+		if(!ok){
+			if(strict){
+				printf("record %d mismatch\n", k);
+				return -1;
+			}
+			bad++;
+		}
+		k++;
+	}
+	if(strict && k != num){
+		printf("%d records decoded, expect %d\n", k, num);
+		return -1;
+	}
+
+	return bad;
+}
+
+/* samples of HIL.LOG, one per topic and row */
+static sample_t* _load_hil(const char* file_name, int* sample_num, int* row_num, int* word_num)
+{
+	FILE* fp = fopen(file_name, "rb");
+	uint32_t field_num, data_offset, row_size;
+	uint8_t* raw;
+	sample_t* sample;
+	long size;
+
+	if(fp == NULL){
+		printf("can not open %s\n", file_name);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	size = ftell(fp);
+	rewind(fp);
+	raw = malloc(size);
+	if(fread(raw, 1, size, fp) != (size_t)size){
+		fclose(fp);
+		free(raw);
+		return NULL;
+	}
+	fclose(fp);
+
+	/* header: magic, version, reserved, field num, data offset, row size */
+	memcpy(&field_num, &raw[8], 4);
+	memcpy(&data_offset, &raw[12], 4);
+	memcpy(&row_size, &raw[16], 4);
+	if(field_num != 52 || row_size != 4*field_num || data_offset > size){
+		printf("unexpected %s header\n", file_name);
+		free(raw);
+		return NULL;
+	}
+
+	for(int t = 0 ; t < TOPIC_NUM ; t++){
+		word_num[t] = 0;
+		while(_topic_field[t][word_num[t]] >= 0)
+			word_num[t]++;
+	}
+	*row_num = (size - data_offset)/row_size;
+	*sample_num = *row_num*TOPIC_NUM;
+	sample = malloc(sizeof(sample_t)*(*sample_num));
+	for(int r = 0, k = 0 ; r < *row_num ; r++){
+		const uint8_t* row = &raw[data_offset + r*row_size];
+
+		for(int t = 0 ; t < TOPIC_NUM ; t++, k++){
+			sample[k].msg_id = t + 1;
+			sample[k].timestamp = r*4000 + t*37;
+			for(int i = 0 ; i < word_num[t] ; i++)
+				memcpy(&sample[k].payload[i], &row[4*_topic_field[t][i]], 4);
+		}
+	}
+	free(raw);
+
+	return sample;
+}
+
+static void _test_drop(const sample_t* sample, int num, const int* word_num, uint8_t* stream)
+{
+	sample_t* expect = malloc(sizeof(sample_t)*num);
+	uint32_t size = 0;
+	int expect_num = 0;
+
+	srand(1);
+	_init_encoder(word_num);
+	for(int k = 0 ; k < num ; k++){
+		uint8_t drop = rand() % 50 == 0;
+
+		size += _put(&sample[k], word_num, stream + size, 1, drop);
+		if(!drop)
+			expect[expect_num++] = sample[k];
+	}
+	if(_check(stream, size, expect, expect_num, word_num, 1)){
+		printf("drop round trip FAIL\n");
+		_fail++;
+	}else{
+		printf("drop round trip ok: %d of %d kept\n", expect_num, num);
+	}
+	free(expect);
+}
+
+static void _test_random(void)
+{
+	static float val[TOPIC_NUM][MAX_WORD];
+	sample_t* sample = malloc(sizeof(sample_t)*RANDOM_SAMPLE_NUM);
+	uint8_t* stream = malloc((size_t)RANDOM_SAMPLE_NUM*MAX_RECORD_SIZE);
+	uint8_t* corrupt = malloc((size_t)RANDOM_SAMPLE_NUM*MAX_RECORD_SIZE);
+	int word_num[TOPIC_NUM];
+	uint32_t timestamp = 0xFFF00000u;
+	uint32_t size;
+
+	srand(2);
+	for(int t = 0 ; t < TOPIC_NUM ; t++)
+		word_num[t] = 1 + rand() % MAX_WORD;
+	for(int k = 0 ; k < RANDOM_SAMPLE_NUM ; k++){
+		int t = rand() % TOPIC_NUM;
+
+		timestamp += rand() % 3000;
+		sample[k].msg_id = t + 1;
+		sample[k].timestamp = timestamp;
+		for(int i = 0 ; i < word_num[t] ; i++){
+			int r = rand() % 1000;
+
+			if(r == 0)
+				val[t][i] = -val[t][i];
+			else if(r == 1)
+				val[t][i] = (float)rand()*1e10f;
+			else if(r == 2)
+				val[t][i] = 0.0f/0.0f;
+			else
+				val[t][i] += (rand() % 2001 - 1000)*1e-4f;
+			memcpy(&sample[k].payload[i], &val[t][i], 4);
+		}
+	}
+	size = _put_all(sample, RANDOM_SAMPLE_NUM, word_num, stream, 1);
+	if(_check(stream, size, sample, RANDOM_SAMPLE_NUM, word_num, 1)){
+		printf("random round trip FAIL\n");
+		_fail++;
+	}else{
+		printf("random round trip ok: %d samples, 1..%d words\n", RANDOM_SAMPLE_NUM, MAX_WORD);
+	}
+
+	/* run under a sanitizer to catch reads out of a broken record */
+	for(int n = 0 ; n < CORRUPT_RUN_NUM ; n++){
+		memcpy(corrupt, stream, size);
+		for(int j = 0 ; j < 20 ; j++)
+			corrupt[rand() % size] ^= 1 << (rand() % 8);
+		_check(corrupt, size, sample, RANDOM_SAMPLE_NUM, word_num, 0);
+	}
+	printf("corruption: %d runs of 20 bit flips decoded\n", CORRUPT_RUN_NUM);
+
+	free(sample);
+	free(stream);
+	free(corrupt);
+}
+
+static uint32_t _lzo_size(const uint8_t* stream, uint32_t size)
+{
+	static uint8_t wrkmem[LZO1X_1_MEM_COMPRESS];
+	static uint8_t out[LZO_BLOCK_SIZE + LZO_BLOCK_SIZE/16 + 64 + 3];
+	uint32_t total = 0, block;
+	lzo_uint out_len;
+
+	for(uint32_t pos = 0 ; pos < size ; pos += block){
+		block = size - pos < LZO_BLOCK_SIZE ? size - pos : LZO_BLOCK_SIZE;
+		lzo1x_1_compress(stream + pos, block, out, &out_len, wrkmem);
+		/* block header, raw copy if it does not shrink */
+		total += 16 + (out_len < block ? out_len : block);
+	}
+
+	return total;
+}
+
+static void _bench(const sample_t* sample, int num, int row_num, const int* word_num, uint8_t* plain, uint8_t* stream)
+{
+	uint32_t plain_size = _put_all(sample, num, word_num, plain, 0);
+	uint32_t delta_size = 0;
+	uint32_t payload[MAX_WORD];
+	uint32_t timestamp;
+	volatile uint32_t sink = 0;
+	uint64_t start, encode_ns, decode_ns;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_LOOP ; n++)
+		delta_size = _put_all(sample, num, word_num, stream, 1);
+	encode_ns = _now_ns() - start;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_LOOP ; n++){
+		uint32_t pos = 0;
+
+		for(int t = 0 ; t < TOPIC_NUM ; t++)
+			log_delta_init(&_dec[t+1], _dec_prev[t+1], word_num[t]);
+		while(pos < delta_size){
+			if(stream[pos] == RECORD_SYNC_DELTA){
+				const delta_record_t* header = (const delta_record_t*)&stream[pos];
+
+				log_delta_decode(&_dec[header->msg_id], &stream[pos+sizeof(delta_record_t)], header->body_size, &timestamp, payload);
+				sink += payload[0];
+				pos += sizeof(delta_record_t) + header->body_size;
+			}else{
+				const record_t* header = (const record_t*)&stream[pos];
+
+				log_delta_key(&_dec[header->msg_id], header->timestamp, &stream[pos+sizeof(record_t)]);
+				pos += sizeof(record_t) + header->payload_size;
+			}
+		}
+	}
+	decode_ns = _now_ns() - start;
+
+	printf("\n%-8s %6s %12s %12s\n", "topic", "words", "plain B/smp", "delta B/smp");
+	for(int t = 0 ; t < TOPIC_NUM ; t++){
+		uint32_t topic_plain = 0, topic_delta = 0;
+		uint8_t record[MAX_RECORD_SIZE];
+
+		_init_encoder(word_num);
+		for(int k = t ; k < num ; k += TOPIC_NUM){
+			topic_plain += sizeof(record_t) + 4*word_num[t];
+			topic_delta += _put(&sample[k], word_num, record, 1, 0);
+		}
+		printf("%-8s %6d %12.2f %12.2f\n", _topic_name[t], word_num[t], (double)topic_plain/row_num, (double)topic_delta/row_num);
+	}
+	printf("\nall topics: plain %.2f B/sample, delta %.2f B/sample (%.1f%%)\n",
+			(double)plain_size/num, (double)delta_size/num, 100.0*delta_size/plain_size);
+	printf("encode %.1f ns/sample, decode %.1f ns/sample\n",
+			(double)encode_ns/BENCH_LOOP/num, (double)decode_ns/BENCH_LOOP/num);
+	lzo_init();
+	printf("plain + lzo: %.1f%% of plain\n", 100.0*_lzo_size(plain, plain_size)/plain_size);
+	printf("delta + lzo: %.1f%% of plain\n", 100.0*_lzo_size(stream, delta_size)/plain_size);
+}
+
+int main(int argc, char** argv)
+{
+	const char* file_name = argc > 1 ? argv[1] : "../EKF/HIL.LOG";
+	int word_num[TOPIC_NUM];
+	int sample_num, row_num;
+	sample_t* sample = _load_hil(file_name, &sample_num, &row_num, word_num);
+	uint8_t* plain;
+	uint8_t* stream;
+	uint32_t size;
+
+	if(sample == NULL)
+		return 1;
+	plain = malloc((size_t)sample_num*MAX_RECORD_SIZE);
+	stream = malloc((size_t)sample_num*MAX_RECORD_SIZE);
+
+	size = _put_all(sample, sample_num, word_num, stream, 1);
+	if(_check(stream, size, sample, sample_num, word_num, 1)){
+		printf("HIL round trip FAIL\n");
+		_fail++;
+	}else{
+		printf("HIL round trip ok: %d samples\n", sample_num);
+	}
+	_test_drop(sample, sample_num, word_num, stream);
+	_test_random();
+	_bench(sample, sample_num, row_num, word_num, plain, stream);
+
+	free(sample);
+	free(plain);
+	free(stream);
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
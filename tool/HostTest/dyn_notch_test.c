@@ -0,0 +1,233 @@
+/*
+ * File      : dyn_notch_test.c
+ *
+ * Host test and benchmark of the FFT tracked gyro notch. At 1 kHz the x axis
+ * carries a 2 Hz motion, a motor vibration of 1.0 at 180 Hz and its 0.5
+ * harmonic at 263.7 Hz plus noise, y the motor line only and z noise only.
+ * Checked:
+ *   disabled: output is the input bit for bit
+ *   tracking: the notches of each axis sit on its vibration lines. The noise
+ *   of 0.01 rms is below the peak floor of dyn_notch.c (a 0.02 sine), so the
+ *   noise only axis keeps its notches in bypass all the time
+ *   sweep: the motor line moving 180 -> 230 Hz in 10 s is followed
+ *   attenuation: vibration left in x output, against the input
+ *   release: with the vibration gone all notches go back to bypass
+ * Then the filter per 3 axis sample and one analysis (FFT and peak search)
+ * are timed.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o dyn_notch_test dyn_notch_test.c $S/Framework/source/Filter/dyn_notch.c -lm
+ * usage: dyn_notch_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include "dyn_notch.h"
+
+#define SAMPLE_FREQ		1000.0f
+#define MIN_FREQ		80.0f
+#define MAX_FREQ		400.0f
+#define NOTCH_Q			3.0f
+#define ANALYSE_FREQ	100.0f
+#define MOTOR_FREQ		180.0f
+#define MOTOR_SWEEP		50.0f
+#define HARMONIC_FREQ	263.7f
+#define NOISE_AMP		0.01f
+#define SETTLE_NUM		2000				/* 2s */
+#define RUN_NUM			20000				/* 20s, sweep in the second half */
+#define FREQ_TOL		4.0f				/* Hz */
+#define ATTEN_MIN_DB	25.0
+#define RELEASE_MS		300
+#define BENCH_NUM		10000000
+#define BENCH_FFT_NUM	1000000
+
+static uint32_t _fail;
+static volatile float _sink;
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static float _gauss(void)
+{
+	float u = (rand() + 1.0f)/(RAND_MAX + 2.0f);
+	float v = rand()/(float)RAND_MAX;
+
+	return sqrtf(-2.0f*logf(u))*cosf(2.0f*(float)M_PI*v);
+}
+
+static void _check(int cond, const char* what)
+{
+	if(!cond){
+		printf("  fail: %s\n", what);
+		_fail++;
+	}
+}
+
+/* a notch of axis within FREQ_TOL of freq */
+static int _has_notch(const DynNotch* dn, uint8_t axis, float freq)
+{
+	for(int n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++){
+		if(dn->center_freq[axis][n] > 0.0f && fabsf(dn->center_freq[axis][n] - freq) < FREQ_TOL)
+			return 1;
+	}
+
+	return 0;
+}
+
+static int _notch_num(const DynNotch* dn, uint8_t axis)
+{
+	int num = 0;
+
+	for(int n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++)
+		num += dn->center_freq[axis][n] > 0.0f;
+
+	return num;
+}
+
+static void _show(const DynNotch* dn, const char* title)
+{
+	printf("%-28s", title);
+	for(int i = 0 ; i < 3 ; i++)
+		printf("  %c %5.1f %5.1f", 'x' + i, dn->center_freq[i][0], dn->center_freq[i][1]);
+	printf("\n");
+}
+
+static void _test_disabled(void)
+{
+	static DynNotch dn;
+	float in[3], out[3];
+	uint32_t differ = 0;
+
+	dyn_notch_init(&dn, SAMPLE_FREQ, MIN_FREQ, MAX_FREQ, NOTCH_Q, ANALYSE_FREQ);
+	for(int i = 0 ; i < SETTLE_NUM ; i++){
+		in[0] = in[1] = in[2] = sinf(2.0f*(float)M_PI*MOTOR_FREQ*i/SAMPLE_FREQ);
+		dyn_notch_filter_process(&dn, in, out);
+		differ += out[0] != in[0] || out[1] != in[1] || out[2] != in[2];
+	}
+	printf("disabled: %u of %d samples changed, %u fft\n", differ, SETTLE_NUM, dn.fft_cnt);
+	_check(differ == 0 && dn.fft_cnt == 0, "disabled notch passes input");
+}
+
+static void _test_track(void)
+{
+	static DynNotch dn;
+	float in[3], out[3];
+	float motor_freq = MOTOR_FREQ, motor_phase = 0.0f;
+	double err_in = 0.0, err_out = 0.0, atten_db;
+	uint32_t noise_notch = 0;
+
+	srand(5);
+	dyn_notch_init(&dn, SAMPLE_FREQ, MIN_FREQ, MAX_FREQ, NOTCH_Q, ANALYSE_FREQ);
+	dyn_notch_enable(&dn, 1);
+	for(int i = 0 ; i < RUN_NUM ; i++){
+		float t = i/SAMPLE_FREQ;
+		float motion = 0.3f*sinf(2.0f*(float)M_PI*2.0f*t);
+		float motor;
+
+		if(i >= RUN_NUM/2)
+			motor_freq = MOTOR_FREQ + MOTOR_SWEEP*(i - RUN_NUM/2)/(RUN_NUM/2);
+		motor_phase += 2.0f*(float)M_PI*motor_freq/SAMPLE_FREQ;
+		if(motor_phase > 2.0f*(float)M_PI)
+			motor_phase -= 2.0f*(float)M_PI;
+		motor = sinf(motor_phase);
+
+		in[0] = motion + motor + 0.5f*sinf(2.0f*(float)M_PI*HARMONIC_FREQ*t) + NOISE_AMP*_gauss();
+		in[1] = motion + 0.7f*motor + NOISE_AMP*_gauss();
+		in[2] = motion + NOISE_AMP*_gauss();
+		dyn_notch_filter_process(&dn, in, out);
+
+		/* vibration and noise left on x, motion passes */
+		if(i >= SETTLE_NUM){
+			err_in += (in[0] - motion)*(in[0] - motion);
+			err_out += (out[0] - motion)*(out[0] - motion);
+			noise_notch += _notch_num(&dn, 2) > 0;
+		}
+		if(i == RUN_NUM/2 - 1){
+			_show(&dn, "tracking 180.0 and 263.7 Hz:");
+			_check(_has_notch(&dn, 0, MOTOR_FREQ) && _has_notch(&dn, 0, HARMONIC_FREQ), "x notches on both lines");
+			_check(_has_notch(&dn, 1, MOTOR_FREQ) && _notch_num(&dn, 1) == 1, "y one notch on motor line");
+		}
+	}
+	_show(&dn, "sweep end 230.0 and 263.7 Hz:");
+	_check(_has_notch(&dn, 0, motor_freq) && _has_notch(&dn, 0, HARMONIC_FREQ), "x follows the sweep");
+	_check(_has_notch(&dn, 1, motor_freq), "y follows the sweep");
+
+	atten_db = 10.0*log10(err_out/err_in);
+	printf("attenuation: x vibration rms in %.3f, out %.3f, %.1f dB, %u fft\n", sqrt(err_in/(RUN_NUM - SETTLE_NUM)),
+			sqrt(err_out/(RUN_NUM - SETTLE_NUM)), atten_db, dn.fft_cnt);
+	_check(atten_db < -ATTEN_MIN_DB, "x vibration attenuation");
+	printf("z noise only: a notch active in %u of %d samples\n", noise_notch, RUN_NUM - SETTLE_NUM);
+	_check(noise_notch == 0, "z notches bypassed");
+
+	/* vibration stops, only small noise is left */
+	for(int i = 0 ; i < RELEASE_MS*SAMPLE_FREQ/1000 ; i++){
+		in[0] = in[1] = in[2] = NOISE_AMP*_gauss();
+		dyn_notch_filter_process(&dn, in, out);
+	}
+	_show(&dn, "release after 300 ms:");
+	_check(_notch_num(&dn, 0) + _notch_num(&dn, 1) + _notch_num(&dn, 2) == 0, "notches released");
+}
+
+static void _bench(void)
+{
+	static DynNotch dn;
+	float in[3] = {0.1f, 0.2f, 0.3f}, out[3];
+	double sample_ns, fft_us;
+	uint64_t start;
+
+	/* all notches active, analysis only where timed */
+	dyn_notch_init(&dn, SAMPLE_FREQ, MIN_FREQ, MAX_FREQ, NOTCH_Q, ANALYSE_FREQ);
+	dyn_notch_enable(&dn, 1);
+	for(int i = 0 ; i < 3 ; i++){
+		for(int n = 0 ; n < DYN_NOTCH_PEAK_NUM ; n++)
+			dyn_notch_set_center_frequency(&dn, i, n, 150.0f + 50.0f*n);
+	}
+	dn.update_div = UINT16_MAX;
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_NUM ; i++){
+		in[0] += 1e-7f;
+		dyn_notch_filter_process(&dn, in, out);
+		_sink = out[0];
+	}
+	sample_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	for(int i = 0 ; i < DYN_NOTCH_FFT_SIZE ; i++){
+		in[0] = in[1] = in[2] = sinf(2.0f*(float)M_PI*MOTOR_FREQ*i/SAMPLE_FREQ) + NOISE_AMP*_gauss();
+		dyn_notch_filter_process(&dn, in, out);
+	}
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_FFT_NUM ; i++)
+		dyn_notch_analyse(&dn, i % 3);
+	fft_us = (double)(_now_ns() - start)/BENCH_FFT_NUM*1e-3;
+
+	printf("\nper 3 axis sample, %d notch per axis: %6.2f ns\n", DYN_NOTCH_PEAK_NUM, sample_ns);
+	printf("per analysis, %d point fft and peak search: %6.2f us, %.3f%% cpu at %.0f Hz\n",
+			DYN_NOTCH_FFT_SIZE, fft_us, fft_us*ANALYSE_FREQ/1e4, ANALYSE_FREQ);
+}
+
+int main(void)
+{
+	_test_disabled();
+	_test_track();
+	_bench();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
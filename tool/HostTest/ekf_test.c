@@ -0,0 +1,258 @@
+/*
+ * File      : ekf_test.c
+ *
+ * Host test of the sparse covariance prediction in ekf.c. The filter is run
+ * over a moving trajectory with EKF14_Prediction, EKF14_SerialPrediction
+ * (all enable masks) and EKF14_Correct. After every prediction P is checked
+ * against a double precision (I+F*T)*P*(I+F*T)' + T^2*G*Q*G' computed from
+ * the same P, F, G and Q, and so is the former dense CMSIS path (kept here).
+ * The error is scaled by sqrt(Pii*Pjj). Then the time of both paths is
+ * measured.
+ *
+ * build: S=../../starry_fmu; M=$S/Library/STM_Lib/CMSIS/DSP_Lib/Source/MatrixFunctions
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/Framework/source/KF -I$S/RTOS/include
+ *            -I$S/RTOS/components/drivers/include -I$S/HAL/include -I$S/Driver/include
+ *            -I$S/Library/STM_Lib/CMSIS/Include -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include
+ *            -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o ekf_test ekf_test.c $M/arm_mat_init_f32.c $M/arm_mat_add_f32.c $M/arm_mat_sub_f32.c
+ *            $M/arm_mat_mult_f32.c $M/arm_mat_trans_f32.c $M/arm_mat_scale_f32.c $M/arm_mat_inverse_f32.c -lm
+ * usage: ekf_test [steps per mode]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+/* static _ekf14_predict_cov is tested directly */
+#include "ekf.c"
+
+#define DT				0.004f
+#define COV_TOL			1e-4
+
+static uint32_t _fail;
+static float _acc[3] = {0.0f, 0.0f, -9.8f};
+static float _mag[3] = {0.8f, 0.1f, 0.5f};
+
+rt_err_t sensor_acc_get_calibrated_data(float acc[3])
+{
+	memcpy(acc, _acc, sizeof(_acc));
+	return RT_EOK;
+}
+
+rt_err_t sensor_mag_get_calibrated_data(float mag[3])
+{
+	memcpy(mag, _mag, sizeof(_mag));
+	return RT_EOK;
+}
+
+/* slightly tilted start, so that every F entry is non zero */
+void AHRS_reset(quaternion * q, const float acc[3],const float mag[3])
+{
+	(void)acc;
+	(void)mag;
+	q->w = 0.98f;
+	q->x = 0.1f;
+	q->y = -0.15f;
+	q->z = 0.08f;
+}
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static float _rand(void)
+{
+	return 2.0f*rand()/RAND_MAX - 1.0f;
+}
+
+/* covariance prediction before the sparse version */
+static arm_status _dense_predict_cov(EKF_Def* ekf_t)
+{
+	arm_status res = ARM_MATH_SUCCESS;
+
+	res |= arm_mat_scale_f32(&ekf_t->F, ekf_t->dT, &ekf_t->IFT);
+	for(uint8_t n = 0 ; n < NUM_X ; n++){
+		MAT_ELEMENT(ekf_t->IFT, n, n) += 1.0f;
+	}
+	res |= arm_mat_trans_f32(&ekf_t->IFT, &ekf_t->IFTT);
+	res |= arm_mat_mult_f32(&ekf_t->IFT, &ekf_t->P, &ekf_t->IFTP);
+	res |= arm_mat_mult_f32(&ekf_t->IFTP, &ekf_t->IFTT, &ekf_t->IFTPIFTT);
+
+	res |= arm_mat_mult_f32(&ekf_t->G, &ekf_t->Q, &ekf_t->GQ);
+	res |= arm_mat_trans_f32(&ekf_t->G, &ekf_t->GT);
+	res |= arm_mat_mult_f32(&ekf_t->GQ, &ekf_t->GT, &ekf_t->GQGT);
+	res |= arm_mat_scale_f32(&ekf_t->GQGT, ekf_t->dT*ekf_t->dT, &ekf_t->GQGT);
+
+	res |= arm_mat_add_f32(&ekf_t->IFTPIFTT, &ekf_t->GQGT, &ekf_t->P);
+
+	return res;
+}
+
+static void _ref_predict_cov(const EKF_Def* ekf_t, const float* P0, double* ref)
+{
+	double A[NUM_X][NUM_X], AP[NUM_X][NUM_X], GQGT;
+	double T = ekf_t->dT;
+	int i, j, k;
+
+	for(i = 0 ; i < NUM_X ; i++){
+		for(j = 0 ; j < NUM_X ; j++)
+			A[i][j] = (i == j) + T*ekf_t->F.pData[i*NUM_X + j];
+	}
+	for(i = 0 ; i < NUM_X ; i++){
+		for(j = 0 ; j < NUM_X ; j++){
+			AP[i][j] = 0.0;
+			for(k = 0 ; k < NUM_X ; k++)
+				AP[i][j] += A[i][k] * P0[k*NUM_X + j];
+		}
+	}
+	for(i = 0 ; i < NUM_X ; i++){
+		for(j = 0 ; j < NUM_X ; j++){
+			ref[i*NUM_X + j] = 0.0;
+			for(k = 0 ; k < NUM_X ; k++)
+				ref[i*NUM_X + j] += AP[i][k] * A[j][k];
+			GQGT = 0.0;
+			for(k = 0 ; k < NUM_W ; k++)
+				GQGT += ekf_t->G.pData[i*NUM_W + k] * ekf_t->Q.pData[k*NUM_W + k] * ekf_t->G.pData[j*NUM_W + k];
+			ref[i*NUM_X + j] += T*T*GQGT;
+		}
+	}
+}
+
+/* max |P-ref|/sqrt(ref_ii*ref_jj) */
+static double _cov_err(const float* P, const double* ref)
+{
+	double err = 0.0, e;
+
+	for(int i = 0 ; i < NUM_X ; i++){
+		for(int j = 0 ; j < NUM_X ; j++){
+			e = fabs(P[i*NUM_X + j] - ref[i*NUM_X + j]) / sqrt(ref[i*NUM_X + i]*ref[j*NUM_X + j]);
+			if(e > err)
+				err = e;
+		}
+	}
+	return err;
+}
+
+static void _set_input(EKF_Def* ekf_t, int k)
+{
+	float t = k*DT;
+
+	MAT_ELEMENT(ekf_t->U, 0, 0) = 0.8f*sinf(1.3f*t) + 0.01f*_rand();
+	MAT_ELEMENT(ekf_t->U, 1, 0) = 0.6f*cosf(0.7f*t) + 0.01f*_rand();
+	MAT_ELEMENT(ekf_t->U, 2, 0) = 0.4f*sinf(0.3f*t) + 0.01f*_rand();
+	MAT_ELEMENT(ekf_t->U, 3, 0) = 1.5f*sinf(0.9f*t) + 0.2f*_rand();
+	MAT_ELEMENT(ekf_t->U, 4, 0) = 1.2f*cosf(1.1f*t) + 0.2f*_rand();
+	MAT_ELEMENT(ekf_t->U, 5, 0) = -9.8f + 0.5f*sinf(2.0f*t) + 0.2f*_rand();
+	MAT_ELEMENT(ekf_t->U, 6, 0) = _mag[0] + 0.01f*_rand();
+	MAT_ELEMENT(ekf_t->U, 7, 0) = _mag[1] + 0.01f*_rand();
+	MAT_ELEMENT(ekf_t->U, 8, 0) = _mag[2] + 0.01f*_rand();
+	/* same measurement constants as state_est */
+	MAT_ELEMENT(ekf_t->Z, 0, 0) = 0.0f;
+	MAT_ELEMENT(ekf_t->Z, 1, 0) = 0.0f;
+	MAT_ELEMENT(ekf_t->Z, 2, 0) = 0.0f;
+	MAT_ELEMENT(ekf_t->Z, 3, 0) = 0.0f;
+	MAT_ELEMENT(ekf_t->Z, 4, 0) = 0.0f;
+	MAT_ELEMENT(ekf_t->Z, 5, 0) = -1.0f;
+	MAT_ELEMENT(ekf_t->Z, 6, 0) = 1.0f;
+	MAT_ELEMENT(ekf_t->Z, 7, 0) = 0.0f;
+}
+
+/* mask < 0 runs EKF14_Prediction, otherwise EKF14_SerialPrediction(mask) */
+static void _equivalence(EKF_Def* ekf_t, int mask, int steps)
+{
+	float P0[NUM_X*NUM_X], P[NUM_X*NUM_X];
+	double ref[NUM_X*NUM_X];
+	double err = 0.0, dense_err = 0.0, e;
+	int asym = 0;
+	char name[32];
+
+	EKF14_Reset(ekf_t);
+	for(int k = 0 ; k < steps ; k++){
+		_set_input(ekf_t, k);
+		memcpy(P0, ekf_t->P.pData, sizeof(P0));
+		if(mask < 0)
+			EKF14_Prediction(ekf_t);
+		else
+			EKF14_SerialPrediction(ekf_t, mask);
+		memcpy(P, ekf_t->P.pData, sizeof(P));
+		_ref_predict_cov(ekf_t, P0, ref);
+
+		e = _cov_err(P, ref);
+		if(e > err)
+			err = e;
+		for(int i = 0 ; i < NUM_X ; i++){
+			for(int j = 0 ; j < i ; j++)
+				asym |= P[i*NUM_X + j] != P[j*NUM_X + i];
+		}
+
+		/* former path from the same P, F and G */
+		memcpy(ekf_t->P.pData, P0, sizeof(P0));
+		_dense_predict_cov(ekf_t);
+		e = _cov_err(ekf_t->P.pData, ref);
+		if(e > dense_err)
+			dense_err = e;
+
+		memcpy(ekf_t->P.pData, P, sizeof(P));
+		EKF14_Correct(ekf_t);
+	}
+
+	if(mask < 0)
+		sprintf(name, "Prediction");
+	else
+		sprintf(name, "SerialPrediction %02x", mask);
+	printf("%-22s %9.2e  %9.2e  %s\n", name, err, dense_err, asym ? "not symmetric" : "");
+	if(err > COV_TOL || asym || isnan(err))
+		_fail++;
+}
+
+static double _bench(EKF_Def* ekf_t, int dense, int loops)
+{
+	float P0[NUM_X*NUM_X];
+	uint64_t start;
+
+	memcpy(P0, ekf_t->P.pData, sizeof(P0));
+	start = _now_ns();
+	for(int k = 0 ; k < loops ; k++){
+		/* keep P bounded, the copy is part of both times */
+		memcpy(ekf_t->P.pData, P0, sizeof(P0));
+		if(dense)
+			_dense_predict_cov(ekf_t);
+		else
+			_ekf14_predict_cov(ekf_t);
+	}
+	return (double)(_now_ns() - start)/loops;
+}
+
+int main(int argc, char** argv)
+{
+	int steps = argc > 1 ? atoi(argv[1]) : 5000;
+	int masks[] = {-1, 0xFFFF, 0x03, 0x04, 0x00};
+	EKF_Def ekf;
+
+	srand(1);
+	EKF14_Init(&ekf, DT);
+
+	printf("max covariance error over %d steps, scaled by sqrt(Pii*Pjj)\n", steps);
+	printf("                          sparse      dense\n");
+	for(uint32_t i = 0 ; i < sizeof(masks)/sizeof(masks[0]) ; i++)
+		_equivalence(&ekf, masks[i], steps);
+
+	printf("\ntime per covariance prediction (ns)\n");
+	printf("sparse %9.0f\n", _bench(&ekf, 0, 200000));
+	printf("dense  %9.0f\n", _bench(&ekf, 1, 200000));
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,971 @@
+/*
+ * File      : log_test.c
+ *
+ * Host round trip test of the log format. The real logger, log writer and
+ * uMCN run on the rt_host shim, topics are published with known samples at
+ * their flight rates in virtual time, and the log file is decoded again here
+ * for each compress method with and without delta coding.
+ * Checked on the decoded file:
+ *   header and format section match log_msg_list
+ *   queued topics (GYR, ACC, ADRC) have every sample published after start,
+ *   in order, with its publish time
+ *   other topics hold the latest sample at record time, never a repeated
+ *   one, and respect the message period
+ *   no unknown bytes between records, markers point at themselves, the
+ *   index footer only refers to markers, no record dropped by the writer
+ * Each log is also cut in the middle of a block, two thirds in. The records
+ * before the cut must decode and its markers rebuild the index. Decoding
+ * from 7 damaged offsets must resync at the next marker, and seeking to each
+ * index entry must give the records of the whole log from there.
+ * A last log is stopped while the writer is blocked in f_write. Stop must
+ * time out and keep the log busy with the file open, a second stop after
+ * the writer is released must finish a valid log.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -pthread -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -I$S/Library/Fatfs -I$S/RTOS/components/external/lzo -I$S/RTOS/components/external/libz
+ *            -o log_test log_test.c rt_host.c $S/Framework/source/Logger/logger.c
+ *            $S/Framework/source/Logger/log_writer.c $S/Framework/source/Logger/log_compress.c
+ *            $S/Framework/source/Logger/log_delta.c $S/Framework/source/Logger/log_ring.c
+ *            $S/Framework/source/uMCN/uMCN.c $S/RTOS/components/external/lzo/minilzo.c -lz -lm
+ * usage: log_test [seconds of each log]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "rt_host.h"
+#include "logger.h"
+#include "log_writer.h"
+#include "log_compress.h"
+#include "log_delta.h"
+#include "global.h"
+#include "uMCN.h"
+#include "motor.h"
+#include "adrc_att.h"
+#include "quaternion.h"
+#include "pos_estimator.h"
+#include "sensor_manager.h"
+#include "statistic.h"
+#include "gps.h"
+#include "minilzo.h"
+#include "zlib.h"
+
+#define LOG_FILE			"log_test.log"
+#define QUEUE_DEPTH			16
+#define PRE_START_MS		50
+#define RECORD_PERIOD_MS	2			// LOGGER_DEFAULT_PERIOD
+#define MSG_NUM				LOG_MSG_LOAD
+
+/* logger.c has no header for these */
+extern LOG_MsgInfoDef log_msg_list[];
+extern LOGGER_InfoDef _logger_info;
+uint8_t logger_start(char* file_name, uint32_t log_period, uint8_t compress, uint8_t delta);
+void logger_stop(void);
+
+MCN_DEFINE_SEQLOCK(SENSOR_GYR, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_ACC, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_MAG, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_GYR, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_ACC, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_MAG, 12);
+MCN_DEFINE(ATT_EULER, sizeof(Euler));
+MCN_DEFINE(ATT_QUATERNION, sizeof(quaternion));
+MCN_DEFINE(ALT_INFO, sizeof(Altitude_Info));
+MCN_DEFINE(POS_INFO, sizeof(Position_Info));
+MCN_DEFINE(MOTOR_THROTTLE, MOTOR_NUM*sizeof(float));
+MCN_DEFINE(ADRC, sizeof(ADRC_Log));
+MCN_DEFINE(GPS_POSITION, sizeof(struct vehicle_gps_position_s));
+MCN_DEFINE(BARO_POSITION, sizeof(BaroPosition));
+MCN_DEFINE(SYS_LOAD, sizeof(sys_load_t));
+
+/* all topics behind one message */
+typedef struct
+{
+	float a[3];
+	float b[3];
+	quaternion quat;
+	Euler euler;
+	Position_Info pos;
+	Altitude_Info alt;
+	float throttle[MOTOR_NUM];
+	ADRC_Log adrc;
+	struct vehicle_gps_position_s gps;
+	BaroPosition baro;
+	sys_load_t load;
+}sample_t;
+
+typedef struct
+{
+	uint32_t pub_ms;			// publish period
+	uint8_t queued;
+	/* publish history */
+	uint32_t* stamp;
+	uint32_t pub_num;
+	uint32_t start_seq;			// first sample published after log start
+	/* decode state */
+	log_delta_t delta;
+	uint32_t delta_prev[LOG_MAX_PAYLOAD_SIZE/4];
+	uint32_t next_seq;
+	int64_t last_seq;
+	uint32_t last_time;
+	uint32_t record_cnt;
+}topic_t;
+
+typedef struct
+{
+	uint32_t file_offset;
+	uint32_t raw_offset;
+	uint32_t raw_size;
+}block_t;
+
+/* a decoded record, as seen by a decoder which starts at a marker */
+typedef struct
+{
+	uint32_t raw_offset;
+	uint32_t raw_end;
+	uint32_t msg_id;
+	uint32_t timestamp;
+	uint32_t hash;
+}rec_t;
+
+static topic_t _topic[MSG_NUM+1] =
+{
+	[LOG_MSG_GYR] = {.pub_ms = 1, .queued = 1},
+	[LOG_MSG_ACC] = {.pub_ms = 1, .queued = 1},
+	[LOG_MSG_MAG] = {.pub_ms = 10},
+	[LOG_MSG_FILTER] = {.pub_ms = 1},
+	[LOG_MSG_ATT] = {.pub_ms = 2},
+	[LOG_MSG_POS] = {.pub_ms = 10},
+	[LOG_MSG_MOTOR] = {.pub_ms = 2},
+	[LOG_MSG_ADRC] = {.pub_ms = 2, .queued = 1},
+	[LOG_MSG_GPS] = {.pub_ms = 100},
+	[LOG_MSG_BARO] = {.pub_ms = 20},
+	[LOG_MSG_LOAD] = {.pub_ms = 500},
+};
+
+static const char* _load_thread[] =
+{
+	"fastloop", "copter", "mavproxy", "logger", "log_writer", "idle"
+};
+
+static uint32_t _start_us;
+static uint32_t _stop_us;
+static uint32_t _err_cnt;
+static uint32_t _marker_offset[1<<16];
+static uint32_t _marker_num;
+static block_t _block[1<<16];
+static uint32_t _block_num;
+
+#define FAIL(...)		do{ if(_err_cnt++ < 10) printf("  fail: " __VA_ARGS__); }while(0)
+
+/* framework calls made by logger */
+void console_set_error_hook(void (*hook)(char* tag))
+{
+	(void)hook;
+}
+
+int gps_get_position(Vector3f_t* gps_pos, struct vehicle_gps_position_s gps_report)
+{
+	gps_pos->x = gps_report.lat*1e-3f;
+	gps_pos->y = gps_report.lon*1e-3f;
+	gps_pos->z = -gps_report.alt*1e-3f;
+
+	return 0;
+}
+
+int gps_get_velocity(Vector3f_t* gps_vel, struct vehicle_gps_position_s gps_report)
+{
+	gps_vel->x = gps_report.vel_n_m_s;
+	gps_vel->y = gps_report.vel_e_m_s;
+	gps_vel->z = gps_report.vel_d_m_s;
+
+	return 0;
+}
+
+/* smooth signal like flight data, so delta coding sees small changes */
+static float _val(uint8_t msg_id, uint32_t seq, uint8_t i)
+{
+	return 10.0f*sinf(seq*0.003f*(i+1) + msg_id) + 0.01f*(seq % 7);
+}
+
+static void _sample(uint8_t msg_id, uint32_t seq, sample_t* s)
+{
+	uint8_t i;
+
+	memset(s, 0, sizeof(sample_t));
+	for(i = 0 ; i < 3 ; i++){
+		s->a[i] = _val(msg_id, seq, i);
+		s->b[i] = _val(msg_id, seq, i+3);
+	}
+	s->quat = (quaternion){_val(msg_id, seq, 0), _val(msg_id, seq, 1), _val(msg_id, seq, 2), _val(msg_id, seq, 3)};
+	s->euler = (Euler){_val(msg_id, seq, 4), _val(msg_id, seq, 5), _val(msg_id, seq, 6)};
+	s->pos = (Position_Info){.x = s->a[0], .y = s->a[1], .vx = s->b[0], .vy = s->b[1], .ax = 1.0f};
+	s->alt = (Altitude_Info){.alt = s->a[2], .vz = s->b[2], .az = 1.0f};
+	for(i = 0 ; i < MOTOR_NUM ; i++){
+		s->throttle[i] = _val(msg_id, seq, i);
+	}
+	s->adrc = (ADRC_Log){s->a[0], s->a[1], s->a[2], s->b[0], s->b[1], s->b[2]};
+	s->gps.lat = 300000000 + seq*13;
+	s->gps.lon = 1200000000 - seq*7;
+	s->gps.alt = 50000 + seq;
+	s->gps.vel_n_m_s = s->a[0];
+	s->gps.vel_e_m_s = s->a[1];
+	s->gps.vel_d_m_s = s->a[2];
+	s->gps.hdop = 0.8f;
+	s->baro = (BaroPosition){s->a[0], s->a[1], seq};
+	s->load.cpu_usage = 20.0f + s->a[0];
+	s->load.thread_num = sizeof(_load_thread)/sizeof(_load_thread[0]);
+	/* not in the order of LOAD message */
+	for(i = 0 ; i < s->load.thread_num ; i++){
+		thread_load_t* load = &s->load.thread[s->load.thread_num-1-i];
+		strncpy(load->name, _load_thread[i], RT_NAME_MAX);
+		load->load = (seq*(i+1)) % 10000;
+		load->latency_max = seq % 300 + i;
+	}
+}
+
+static void _publish(uint8_t msg_id, const sample_t* s)
+{
+	switch(msg_id)
+	{
+		case LOG_MSG_GYR:
+			mcn_publish(MCN_ID(SENSOR_GYR), s->a);
+			break;
+		case LOG_MSG_ACC:
+			mcn_publish(MCN_ID(SENSOR_ACC), s->a);
+			break;
+		case LOG_MSG_MAG:
+			mcn_publish(MCN_ID(SENSOR_FILTER_MAG), s->b);
+			mcn_publish(MCN_ID(SENSOR_MAG), s->a);
+			break;
+		case LOG_MSG_FILTER:
+			mcn_publish(MCN_ID(SENSOR_FILTER_ACC), s->b);
+			mcn_publish(MCN_ID(SENSOR_FILTER_GYR), s->a);
+			break;
+		case LOG_MSG_ATT:
+			mcn_publish(MCN_ID(ATT_EULER), &s->euler);
+			mcn_publish(MCN_ID(ATT_QUATERNION), &s->quat);
+			break;
+		case LOG_MSG_POS:
+			mcn_publish(MCN_ID(ALT_INFO), &s->alt);
+			mcn_publish(MCN_ID(POS_INFO), &s->pos);
+			break;
+		case LOG_MSG_MOTOR:
+			mcn_publish(MCN_ID(MOTOR_THROTTLE), s->throttle);
+			break;
+		case LOG_MSG_ADRC:
+			mcn_publish(MCN_ID(ADRC), &s->adrc);
+			break;
+		case LOG_MSG_GPS:
+			mcn_publish(MCN_ID(GPS_POSITION), &s->gps);
+			break;
+		case LOG_MSG_BARO:
+			mcn_publish(MCN_ID(BARO_POSITION), &s->baro);
+			break;
+		case LOG_MSG_LOAD:
+			mcn_publish(MCN_ID(SYS_LOAD), &s->load);
+			break;
+	}
+}
+
+/* payload logger should write for sample seq, same conversions as logger_record */
+static void _expect(uint8_t msg_id, uint32_t seq, void* payload)
+{
+	sample_t s;
+	float* p = (float*)payload;
+	Vector3f_t pos, vel;
+
+	_sample(msg_id, seq, &s);
+	switch(msg_id)
+	{
+		case LOG_MSG_GYR:
+		case LOG_MSG_ACC:
+			memcpy(p, s.a, 12);
+			break;
+		case LOG_MSG_MAG:
+		case LOG_MSG_FILTER:
+			memcpy(p, s.a, 12);
+			memcpy(&p[3], s.b, 12);
+			break;
+		case LOG_MSG_ATT:
+			memcpy(p, &s.quat, 16);
+			p[4] = Rad2Deg(s.euler.roll);
+			p[5] = Rad2Deg(s.euler.pitch);
+			p[6] = Rad2Deg(s.euler.yaw);
+			break;
+		case LOG_MSG_POS:
+			p[0] = s.pos.x;
+			p[1] = s.pos.y;
+			p[2] = s.alt.alt;
+			p[3] = s.pos.vx;
+			p[4] = s.pos.vy;
+			p[5] = s.alt.vz;
+			break;
+		case LOG_MSG_MOTOR:
+			memcpy(p, s.throttle, 16);
+			break;
+		case LOG_MSG_ADRC:
+			memcpy(p, &s.adrc, 24);
+			break;
+		case LOG_MSG_GPS:
+			gps_get_position(&pos, s.gps);
+			gps_get_velocity(&vel, s.gps);
+			p[0] = (float)s.gps.lat*1e-7;
+			p[1] = (float)s.gps.lon*1e-7;
+			p[2] = pos.x;
+			p[3] = pos.y;
+			p[4] = pos.z;
+			p[5] = vel.x;
+			p[6] = vel.y;
+			p[7] = vel.z;
+			p[8] = s.gps.hdop;
+			break;
+		case LOG_MSG_BARO:
+			p[0] = s.baro.altitude;
+			p[1] = s.baro.velocity;
+			break;
+		case LOG_MSG_LOAD:
+			p[0] = s.load.cpu_usage;
+			for(uint8_t i = 0 ; i < 5 ; i++){
+				thread_load_t* load = &s.load.thread[s.load.thread_num-1-i];
+				p[1+2*i] = load->load*0.01f;
+				p[2+2*i] = load->latency_max;
+			}
+			break;
+	}
+}
+
+static void _publish_due(uint32_t ms)
+{
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		topic_t* t = &_topic[id];
+		sample_t s;
+
+		if(ms % t->pub_ms)
+			continue;
+		_sample(id, t->pub_num, &s);
+		t->stamp[t->pub_num++] = (uint32_t)time_nowUs();
+		_publish(id, &s);
+	}
+}
+
+/* run virtual time, logger thread records on each timer tick */
+static void _run(uint32_t ms)
+{
+	for(uint32_t i = 0 ; i < ms ; i++){
+		_publish_due(time_nowMs());
+		rt_host_advance(1000);
+		rt_host_wait_idle();
+	}
+}
+
+/* latest sample published before time */
+static int64_t _latest(const topic_t* t, uint32_t time)
+{
+	int64_t lo = 0, hi = (int64_t)t->pub_num-1, res = -1;
+
+	while(lo <= hi){
+		int64_t mid = (lo+hi)/2;
+		if(t->stamp[mid] < time){
+			res = mid;
+			lo = mid+1;
+		}else{
+			hi = mid-1;
+		}
+	}
+	return res;
+}
+
+static void _check_record(uint8_t msg_id, uint32_t timestamp, const void* payload)
+{
+	topic_t* t = &_topic[msg_id];
+	const LOG_MsgInfoDef* msg = &log_msg_list[msg_id-1];
+	uint8_t expect[LOG_MAX_PAYLOAD_SIZE];
+	uint32_t bound = ((msg->period > t->pub_ms ? msg->period : t->pub_ms) + RECORD_PERIOD_MS)*1000;
+	int64_t seq;
+
+	if(t->queued){
+		seq = t->next_seq++;
+		if(seq >= t->pub_num){
+			FAIL("%s record %u was never published\n", msg->name, (uint32_t)seq);
+			return;
+		}
+		if(timestamp != t->stamp[seq])
+			FAIL("%s sample %u stamp %u, published at %u\n", msg->name, (uint32_t)seq, timestamp, t->stamp[seq]);
+	}else{
+		seq = _latest(t, timestamp);
+		if(seq < 0 || seq <= t->last_seq){
+			FAIL("%s record at %u has no new sample\n", msg->name, timestamp);
+			return;
+		}
+		if(msg->period && t->record_cnt && timestamp - t->last_time < msg->period*1000)
+			FAIL("%s records %u us apart, period %u ms\n", msg->name, timestamp - t->last_time, msg->period);
+		if(timestamp - (t->record_cnt ? t->last_time : _start_us) > bound)
+			FAIL("%s missing records between %u and %u\n", msg->name, t->last_time, timestamp);
+	}
+
+	_expect(msg_id, seq, expect);
+	if(memcmp(payload, expect, msg->payload_size) != 0)
+		FAIL("%s sample %u payload differs\n", msg->name, (uint32_t)seq);
+	t->last_seq = seq;
+	t->last_time = timestamp;
+	t->record_cnt++;
+}
+
+/* decompress one block to out, 0 on success */
+static uint8_t _unpack(const LOG_BlockHeaderDef* block, uint8_t* out)
+{
+	const uint8_t* data = (const uint8_t*)block + sizeof(LOG_BlockHeaderDef);
+	lzo_uint out_len = block->raw_size;
+	z_stream zs;
+	uint8_t res;
+
+	if(block->method == LOG_COMPRESS_NONE){
+		memcpy(out, data, block->raw_size);
+		return 0;
+	}
+	if(block->method == LOG_COMPRESS_LZO)
+		return lzo1x_decompress_safe(data, block->data_size, out, &out_len, NULL) != LZO_E_OK || out_len != block->raw_size;
+
+	memset(&zs, 0, sizeof(zs));
+	inflateInit2(&zs, -15);
+	zs.next_in = (Bytef*)data;
+	zs.avail_in = block->data_size;
+	zs.next_out = out;
+	zs.avail_out = block->raw_size;
+	res = inflate(&zs, Z_FINISH) != Z_STREAM_END || zs.total_out != block->raw_size;
+	inflateEnd(&zs);
+
+	return res;
+}
+
+/* uncompressed log from file, NULL on error */
+static uint8_t* _load(const uint8_t* file, uint32_t file_size, uint32_t* raw_size)
+{
+	uint8_t* raw;
+	uint32_t pos = 0, size = 0;
+
+	_block_num = 0;
+	if(file_size < 4 || *(const uint32_t*)file != LOG_BLOCK_MAGIC){
+		raw = malloc(file_size);
+		memcpy(raw, file, file_size);
+		*raw_size = file_size;
+		return raw;
+	}
+
+	raw = malloc(file_size*16 + 65536);
+	while(pos < file_size){
+		const LOG_BlockHeaderDef* block = (const LOG_BlockHeaderDef*)&file[pos];
+
+		if(pos + sizeof(LOG_BlockHeaderDef) > file_size || block->magic != LOG_BLOCK_MAGIC
+			|| pos + sizeof(LOG_BlockHeaderDef) + block->data_size > file_size){
+			FAIL("bad block at %u\n", pos);
+			break;
+		}
+		if(block->raw_offset != size)
+			FAIL("block at %u has raw offset %u, expect %u\n", pos, block->raw_offset, size);
+		if(_unpack(block, &raw[size]))
+			FAIL("%s block at %u does not decompress\n", log_compress_name(block->method), pos);
+		_block[_block_num++] = (block_t){pos, size, block->raw_size};
+		size += block->raw_size;
+		pos += sizeof(LOG_BlockHeaderDef) + block->data_size;
+	}
+	*raw_size = size;
+
+	return raw;
+}
+
+/* complete blocks from file offset pos on, each at its raw offset in raw. Return end of raw data */
+static uint32_t _load_blocks(const uint8_t* file, uint32_t pos, uint32_t file_size, uint8_t* raw)
+{
+	uint32_t end = 0;
+
+	while(pos + sizeof(LOG_BlockHeaderDef) <= file_size){
+		const LOG_BlockHeaderDef* block = (const LOG_BlockHeaderDef*)&file[pos];
+
+		if(block->magic != LOG_BLOCK_MAGIC || pos + sizeof(LOG_BlockHeaderDef) + block->data_size > file_size
+			|| _unpack(block, &raw[block->raw_offset]))
+			break;
+		end = block->raw_offset + block->raw_size;
+		pos += sizeof(LOG_BlockHeaderDef) + block->data_size;
+	}
+
+	return end;
+}
+
+static uint32_t _check_header(const uint8_t* raw, uint32_t size)
+{
+	const LOG_HeaderDef* header = (const LOG_HeaderDef*)raw;
+	uint32_t pos = sizeof(LOG_HeaderDef);
+
+	if(size < sizeof(LOG_HeaderDef) || header->magic != LOG_MAGIC || header->version != LOG_VERSION
+		|| header->msg_num != MSG_NUM){
+		FAIL("bad log header\n");
+		return 0;
+	}
+	for(uint8_t i = 0 ; i < MSG_NUM ; i++){
+		const LOG_FormatDef* format = (const LOG_FormatDef*)&raw[pos];
+		const LOG_MsgInfoDef* msg = &log_msg_list[i];
+
+		if(format->msg_id != msg->msg_id || format->element_num != msg->element_num
+			|| format->payload_size != msg->payload_size || format->period != msg->period
+			|| strcmp(format->name, msg->name) != 0
+			|| memcmp(&raw[pos + sizeof(LOG_FormatDef)], msg->element_info, msg->element_num*sizeof(LOG_ElementInfoDef)) != 0)
+			FAIL("format of %s differs\n", msg->name);
+		pos += sizeof(LOG_FormatDef) + msg->element_num*sizeof(LOG_ElementInfoDef);
+	}
+	if(pos != header->header_size)
+		FAIL("header size %u, expect %u\n", header->header_size, pos);
+
+	return pos;
+}
+
+static int _marker_cmp(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+static void _check_footer(const uint8_t* raw, uint32_t pos, uint32_t size, uint8_t compressed)
+{
+	const LOG_IndexHeaderDef* header = (const LOG_IndexHeaderDef*)&raw[pos];
+	const LOG_IndexEntryDef* entry = (const LOG_IndexEntryDef*)&raw[pos + sizeof(LOG_IndexHeaderDef)];
+	const LOG_IndexTailDef* tail = (const LOG_IndexTailDef*)&raw[size - sizeof(LOG_IndexTailDef)];
+
+	if(size - pos != sizeof(LOG_IndexHeaderDef) + header->entry_num*sizeof(LOG_IndexEntryDef) + sizeof(LOG_IndexTailDef)
+		|| tail->magic != LOG_INDEX_MAGIC || tail->entry_num != header->entry_num
+		|| tail->index_size != size - pos || tail->raw_offset != pos){
+		FAIL("bad index footer at %u\n", pos);
+		return;
+	}
+	for(uint32_t i = 0 ; i < header->entry_num ; i++){
+		uint32_t file_offset = entry[i].raw_offset;
+
+		if(!bsearch(&entry[i].raw_offset, _marker_offset, _marker_num, sizeof(uint32_t), _marker_cmp))
+			FAIL("index entry %u is not a marker\n", i);
+		if(i && entry[i].raw_offset <= entry[i-1].raw_offset)
+			FAIL("index entry %u goes backward\n", i);
+		if(compressed){
+			for(uint32_t n = 0 ; n < _block_num ; n++){
+				if(entry[i].raw_offset < _block[n].raw_offset + _block[n].raw_size){
+					file_offset = _block[n].file_offset;
+					break;
+				}
+			}
+		}
+		if(entry[i].file_offset != file_offset)
+			FAIL("index entry %u file offset %u, expect %u\n", i, entry[i].file_offset, file_offset);
+	}
+}
+
+static void _check_log(const char* file_name, uint8_t delta, uint32_t* file_size, uint32_t* raw_size)
+{
+	FILE* f = fopen(file_name, "rb");
+	uint8_t* file;
+	uint8_t* raw;
+	uint32_t pos, size, footer = 0;
+	uint16_t mark_seq = 0;
+
+	fseek(f, 0, SEEK_END);
+	*file_size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	file = malloc(*file_size);
+	if(fread(file, 1, *file_size, f) != *file_size)
+		FAIL("read %s\n", file_name);
+	fclose(f);
+
+	raw = _load(file, *file_size, &size);
+	*raw_size = size;
+	pos = _check_header(raw, size);
+	_marker_num = 0;
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		log_delta_init(&_topic[id].delta, _topic[id].delta_prev, log_msg_list[id-1].payload_size/4);
+	}
+
+	while(pos && pos < size){
+		uint8_t payload[LOG_MAX_PAYLOAD_SIZE];
+		uint8_t msg_id = raw[pos+1];
+		uint32_t timestamp;
+
+		if(raw[pos] == LOG_RECORD_SYNC){
+			const LOG_RecordHeaderDef* header = (const LOG_RecordHeaderDef*)&raw[pos];
+
+			if(msg_id < 1 || msg_id > MSG_NUM || header->payload_size != log_msg_list[msg_id-1].payload_size){
+				FAIL("bad record at %u\n", pos);
+				break;
+			}
+			pos += sizeof(LOG_RecordHeaderDef);
+			log_delta_key(&_topic[msg_id].delta, header->timestamp, &raw[pos]);
+			_check_record(msg_id, header->timestamp, &raw[pos]);
+			pos += header->payload_size;
+		}else if(raw[pos] == LOG_RECORD_SYNC_DELTA && delta){
+			const LOG_DeltaHeaderDef* header = (const LOG_DeltaHeaderDef*)&raw[pos];
+
+			pos += sizeof(LOG_DeltaHeaderDef);
+			if(msg_id < 1 || msg_id > MSG_NUM
+				|| log_delta_decode(&_topic[msg_id].delta, &raw[pos], header->body_size, &timestamp, payload) != header->body_size){
+				FAIL("bad delta record at %u\n", pos);
+				break;
+			}
+			_check_record(msg_id, timestamp, payload);
+			pos += header->body_size;
+		}else if(raw[pos] == LOG_RECORD_SYNC_MARK){
+			const LOG_SyncDef* mark = (const LOG_SyncDef*)&raw[pos];
+
+			if(mark->magic != LOG_SYNC_MAGIC || mark->raw_offset != pos || mark->seq != mark_seq++)
+				FAIL("bad marker at %u\n", pos);
+			/* delta coding restarts from here */
+			for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+				log_delta_reset(&_topic[id].delta);
+			}
+			_marker_offset[_marker_num++] = pos;
+			pos += sizeof(LOG_SyncDef);
+		}else if(raw[pos] == LOG_RECORD_SYNC_INDEX){
+			footer = pos;
+			_check_footer(raw, pos, size, _block_num > 0);
+			break;
+		}else{
+			FAIL("unknown byte 0x%02x at %u\n", raw[pos], pos);
+			break;
+		}
+	}
+	if(!footer)
+		FAIL("no index footer\n");
+
+	free(raw);
+	free(file);
+}
+
+static uint32_t _hash(const uint8_t* data, uint32_t size)
+{
+	uint32_t h = 2166136261u;
+
+	for(uint32_t i = 0 ; i < size ; i++)
+		h = (h ^ data[i])*16777619u;
+
+	return h;
+}
+
+/* next marker at or after pos. A 0xA7 byte is a marker only with its magic and own offset */
+static uint32_t _next_marker(const uint8_t* raw, uint32_t pos, uint32_t end)
+{
+	for( ; pos + sizeof(LOG_SyncDef) <= end ; pos++){
+		const LOG_SyncDef* mark = (const LOG_SyncDef*)&raw[pos];
+
+		if(raw[pos] == LOG_RECORD_SYNC_MARK && mark->magic == LOG_SYNC_MAGIC && mark->raw_offset == pos)
+			return pos;
+	}
+
+	return end;
+}
+
+/* records from a marker or the first record at pos, up to the footer or a record cut by end */
+static uint32_t _decode(const uint8_t* raw, uint32_t pos, uint32_t end, rec_t* rec)
+{
+	static log_delta_t delta[MSG_NUM+1];
+	static uint32_t delta_prev[MSG_NUM+1][LOG_MAX_PAYLOAD_SIZE/4];
+	uint32_t num = 0;
+
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		log_delta_init(&delta[id], delta_prev[id], log_msg_list[id-1].payload_size/4);
+	}
+	while(pos + sizeof(LOG_RecordHeaderDef) <= end){
+		uint8_t payload[LOG_MAX_PAYLOAD_SIZE];
+		uint8_t msg_id = raw[pos+1];
+		uint32_t len, timestamp;
+
+		if(raw[pos] == LOG_RECORD_SYNC){
+			const LOG_RecordHeaderDef* header = (const LOG_RecordHeaderDef*)&raw[pos];
+
+			len = sizeof(LOG_RecordHeaderDef) + header->payload_size;
+			if(pos + len > end)
+				break;
+			if(msg_id < 1 || msg_id > MSG_NUM || header->payload_size != log_msg_list[msg_id-1].payload_size){
+				FAIL("bad record at %u after resync\n", pos);
+				break;
+			}
+			timestamp = header->timestamp;
+			memcpy(payload, &raw[pos + sizeof(LOG_RecordHeaderDef)], header->payload_size);
+			log_delta_key(&delta[msg_id], timestamp, payload);
+		}else if(raw[pos] == LOG_RECORD_SYNC_DELTA){
+			const LOG_DeltaHeaderDef* header = (const LOG_DeltaHeaderDef*)&raw[pos];
+
+			len = sizeof(LOG_DeltaHeaderDef) + header->body_size;
+			if(pos + len > end)
+				break;
+			if(msg_id < 1 || msg_id > MSG_NUM || log_delta_decode(&delta[msg_id], &raw[pos + sizeof(LOG_DeltaHeaderDef)],
+				header->body_size, &timestamp, payload) != header->body_size){
+				FAIL("bad delta record at %u after resync\n", pos);
+				break;
+			}
+		}else if(raw[pos] == LOG_RECORD_SYNC_MARK){
+			for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+				log_delta_reset(&delta[id]);
+			}
+			pos += sizeof(LOG_SyncDef);
+			continue;
+		}else{
+			if(raw[pos] != LOG_RECORD_SYNC_INDEX)
+				FAIL("unknown byte 0x%02x at %u after resync\n", raw[pos], pos);
+			break;
+		}
+		rec[num++] = (rec_t){pos, pos + len, msg_id, timestamp, _hash(payload, log_msg_list[msg_id-1].payload_size)};
+		pos += len;
+	}
+
+	return num;
+}
+
+/* rec must be the records of the whole log from offset from on, which end before end */
+static void _match(const rec_t* full, uint32_t full_num, const rec_t* rec, uint32_t num, uint32_t from, uint32_t end,
+					const char* what)
+{
+	uint32_t k = 0, n;
+
+	while(k < full_num && full[k].raw_offset < from)
+		k++;
+	for(n = 0 ; k+n < full_num && full[k+n].raw_end <= end ; n++){
+		if(n >= num || memcmp(&full[k+n], &rec[n], sizeof(rec_t)) != 0){
+			FAIL("%s at %u: record %u differs from the whole log\n", what, from, n);
+			return;
+		}
+	}
+	if(n == 0 || n != num)
+		FAIL("%s at %u: %u records, expect %u\n", what, from, num, n);
+}
+
+/* A log cut in the middle of a block must decode up to the cut and its markers rebuild
+ * the index. Decoding from a damaged offset resyncs at the next marker, and decoding from
+ * each index entry of the whole log gives the same records as from the start. */
+static void _check_cut(const char* file_name)
+{
+	FILE* f = fopen(file_name, "rb");
+	const LOG_IndexTailDef* tail;
+	const LOG_IndexEntryDef* entry;
+	uint8_t* file;
+	uint8_t* raw;
+	uint8_t* part;
+	rec_t* full;
+	rec_t* rec;
+	uint32_t file_size, raw_size, header_size, footer, full_num, num;
+	uint32_t cut, cut_end, cut_num, marker_num = 0, resync_num = 0, err_cnt = _err_cnt;
+
+	fseek(f, 0, SEEK_END);
+	file_size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	file = malloc(file_size);
+	if(fread(file, 1, file_size, f) != file_size)
+		FAIL("read %s\n", file_name);
+	fclose(f);
+
+	raw = _load(file, file_size, &raw_size);
+	header_size = ((const LOG_HeaderDef*)raw)->header_size;
+	tail = (const LOG_IndexTailDef*)&raw[raw_size - sizeof(LOG_IndexTailDef)];
+	footer = tail->raw_offset;
+	entry = (const LOG_IndexEntryDef*)&raw[footer + sizeof(LOG_IndexHeaderDef)];
+	/* a record is at least a delta header and one byte */
+	full = malloc((raw_size/(sizeof(LOG_DeltaHeaderDef)+1) + 1)*sizeof(rec_t));
+	rec = malloc((raw_size/(sizeof(LOG_DeltaHeaderDef)+1) + 1)*sizeof(rec_t));
+	part = malloc(raw_size + 64);
+	full_num = _decode(raw, header_size, footer, full);
+
+	/* cut inside a block two thirds in, it and the blocks after are lost */
+	if(_block_num){
+		uint32_t n = _block_num*2/3;
+
+		cut = (_block[n].file_offset + _block[n+1].file_offset)/2;
+		cut_end = _block[n].raw_offset;
+		memset(part, 0, raw_size + 64);
+		if(_load_blocks(file, 0, cut, part) != cut_end)
+			FAIL("cut log decompresses to %u, expect %u\n", _load_blocks(file, 0, cut, part), cut_end);
+	}else{
+		cut = footer*2/3 + 1;
+		cut_end = cut;
+		memcpy(part, raw, cut);
+	}
+	cut_num = _decode(part, header_size, cut_end, rec);
+	_match(full, full_num, rec, cut_num, header_size, cut_end, "cut log");
+	/* no footer, index is rebuilt from markers */
+	for(uint32_t pos = _next_marker(part, header_size, cut_end) ; pos < cut_end ;
+		pos = _next_marker(part, pos + 1, cut_end)){
+		if(marker_num >= _marker_num || pos != _marker_offset[marker_num])
+			FAIL("cut log marker at %u is not in the whole log\n", pos);
+		marker_num++;
+	}
+	if(marker_num == 0 || marker_num >= _marker_num || _marker_offset[marker_num] + sizeof(LOG_SyncDef) <= cut_end)
+		FAIL("cut log has %u markers\n", marker_num);
+
+	/* damage at 7 offsets, in the middle of a record most likely */
+	for(uint32_t k = 1 ; k < 8 ; k++){
+		uint32_t pos = header_size + (footer - header_size)*k/8 + 3;
+		uint32_t mark = _next_marker(raw, pos, footer);
+		uint32_t m = 0;
+
+		while(m < _marker_num && _marker_offset[m] < pos)
+			m++;
+		if(m == _marker_num)
+			break;
+		if(mark != _marker_offset[m]){
+			FAIL("resync from %u at %u, next marker at %u\n", pos, mark, _marker_offset[m]);
+			continue;
+		}
+		num = _decode(raw, mark, footer, rec);
+		_match(full, full_num, rec, num, mark, footer, "resync");
+		resync_num++;
+	}
+
+	/* seek to each index entry, only from its block on in compressed log */
+	for(uint32_t i = 0 ; i < tail->entry_num ; i++){
+		const LOG_SyncDef* mark;
+		const uint8_t* seek = raw;
+		uint32_t end = footer;
+
+		if(_block_num){
+			memset(part, 0, raw_size + 64);
+			end = _load_blocks(file, entry[i].file_offset, file_size, part) ? footer : 0;
+			seek = part;
+		}
+		if(_next_marker(seek, entry[i].raw_offset, end) != entry[i].raw_offset){
+			FAIL("index entry %u does not lead to a marker\n", i);
+			continue;
+		}
+		mark = (const LOG_SyncDef*)&seek[entry[i].raw_offset];
+		num = _decode(seek, entry[i].raw_offset, end, rec);
+		_match(full, full_num, rec, num, entry[i].raw_offset, footer, "index entry");
+		if(num && (rec[0].timestamp != mark->timestamp || (uint32_t)entry[i].timestamp != mark->timestamp))
+			FAIL("index entry %u timestamp %u, marker %u, record %u\n", i, (uint32_t)entry[i].timestamp,
+					mark->timestamp, rec[0].timestamp);
+	}
+
+	printf("         cut at %u of %u byte: %u of %u records, %u markers, resync at %u points and %u index entries  %s\n",
+			cut, file_size, cut_num, full_num, marker_num, resync_num, tail->entry_num,
+			_err_cnt != err_cnt ? "FAIL" : "PASS");
+
+	free(part);
+	free(rec);
+	free(full);
+	free(raw);
+	free(file);
+}
+
+static uint8_t _test(uint8_t compress, uint8_t delta, uint32_t ms, uint8_t hold)
+{
+	LOG_WriterStatusDef status;
+	uint32_t file_size, raw_size, record_cnt = 0;
+
+	_err_cnt = 0;
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		_topic[id].pub_num = 0;
+	}
+
+	/* samples published before start must not be recorded from queued topics */
+	_run(PRE_START_MS);
+	if(logger_start(LOG_FILE, 0, compress, delta)){
+		printf("%-8s %-5s logger start fail\n", log_compress_name(compress), delta ? "delta" : "plain");
+		return 1;
+	}
+	_start_us = (uint32_t)time_nowUs();
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		topic_t* t = &_topic[id];
+
+		t->start_seq = t->pub_num;
+		t->next_seq = t->pub_num;
+		t->last_seq = -1;
+		t->record_cnt = 0;
+	}
+	_run(ms);
+	if(hold){
+		rt_host_fs_set_hold(1);
+		logger_stop();
+		if(_logger_info.status != LOGGER_BUSY)
+			FAIL("log is stopped while writer is blocked\n");
+		rt_host_fs_set_hold(0);
+	}
+	logger_stop();
+	if(_logger_info.status != LOGGER_IDLE)
+		FAIL("log is not stopped\n");
+	_stop_us = (uint32_t)time_nowUs();
+	status = log_writer_get_status();
+
+	_check_log(LOG_FILE, delta, &file_size, &raw_size);
+
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		topic_t* t = &_topic[id];
+		const LOG_MsgInfoDef* msg = &log_msg_list[id-1];
+
+		if(t->queued){
+			/* samples published after the last timer tick are not recorded */
+			if(t->next_seq < t->start_seq || t->pub_num - t->next_seq > RECORD_PERIOD_MS/t->pub_ms + 1)
+				FAIL("%s recorded samples %u..%u of %u..%u\n", msg->name, t->start_seq, t->next_seq,
+						t->start_seq, t->pub_num);
+		}else if(t->record_cnt == 0){
+			FAIL("%s has no record\n", msg->name);
+		}
+		record_cnt += t->record_cnt;
+	}
+	if(status.drop_cnt || status.write_err)
+		FAIL("writer dropped %u records, %u write errors\n", status.drop_cnt, status.write_err);
+
+	printf("%-8s %-5s %7u records %8u -> %8u byte (%4.1f byte/record) markers:%u index:%u  %s%s\n",
+			log_compress_name(compress), delta ? "delta" : "plain", record_cnt, raw_size, file_size,
+			(float)file_size/record_cnt, _marker_num, status.index_num, _err_cnt ? "FAIL" : "PASS",
+			hold ? "  (writer blocked at stop)" : "");
+	_check_cut(LOG_FILE);
+	remove(LOG_FILE);
+
+	return _err_cnt != 0;
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t seconds = argc > 1 ? atoi(argv[1]) : 4;
+	uint32_t ms = seconds*1000;
+	uint8_t fail = 0;
+
+	for(uint8_t id = 1 ; id <= MSG_NUM ; id++){
+		_topic[id].stamp = malloc((ms + PRE_START_MS)*sizeof(uint32_t));
+	}
+
+	mcn_advertise_queue(MCN_ID(SENSOR_GYR), QUEUE_DEPTH);
+	mcn_advertise_queue(MCN_ID(SENSOR_ACC), QUEUE_DEPTH);
+	mcn_advertise_queue(MCN_ID(ADRC), QUEUE_DEPTH);
+	mcn_advertise(MCN_ID(SENSOR_MAG));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_GYR));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_ACC));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_MAG));
+	mcn_advertise(MCN_ID(ATT_EULER));
+	mcn_advertise(MCN_ID(ATT_QUATERNION));
+	mcn_advertise(MCN_ID(ALT_INFO));
+	mcn_advertise(MCN_ID(POS_INFO));
+	mcn_advertise(MCN_ID(MOTOR_THROTTLE));
+	mcn_advertise(MCN_ID(GPS_POSITION));
+	mcn_advertise(MCN_ID(BARO_POSITION));
+	mcn_advertise(MCN_ID(SYS_LOAD));
+
+	rt_host_set_verbose(0);
+	log_writer_init();
+	rt_host_thread_start("logger", logger_entry, NULL);
+	rt_host_thread_start("log_writer", log_writer_entry, NULL);
+	rt_host_advance(1000);
+	rt_host_wait_idle();
+
+	for(uint8_t delta = 0 ; delta < 2 ; delta++){
+		for(uint8_t compress = 0 ; compress < LOG_COMPRESS_NUM ; compress++){
+			fail |= _test(compress, delta, ms, 0);
+		}
+	}
+	fail |= _test(LOG_COMPRESS_LZO, 1, ms, 1);
+	printf("%s\n", fail ? "FAIL" : "PASS");
+
+	return fail;
+}
@@ -0,0 +1,434 @@
+/*
+ * File      : matrix_test.c
+ *
+ * Host test of light_matrix solvers. Random matrices of size 2..14 are
+ * checked against a double precision reference, and against the former
+ * permutation MatDet and adjugate MatInv (kept here, n <= 8 since they are
+ * O(n!)). Singular and not positive definite input must be rejected.
+ * Then the time of each call is measured for the sizes used by the filters.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o matrix_test matrix_test.c $S/Framework/source/Math/light_matrix.c -lm
+ * usage: matrix_test [trials per size]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include <rtthread.h>
+#include "light_matrix.h"
+
+#define N_MIN			2
+#define N_MAX			14
+#define OLD_N_MAX		8
+#define COND_MAX		1000.0
+#define DET_TOL			1e-3
+#define INV_TOL			1e-3
+
+static uint32_t _fail;
+
+/* light_matrix allocates with rt_malloc */
+void* rt_malloc(rt_size_t nbytes)
+{
+	return malloc(nbytes);
+}
+
+void rt_free(void* ptr)
+{
+	free(ptr);
+}
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static double _rand(void)
+{
+	return 2.0*rand()/RAND_MAX - 1.0;
+}
+
+/* MatDet and MatInv before the LU solvers, sum over all permutations */
+static void _old_perm(int list[], int k, int m, int* p, Mat* mat, float* det)
+{
+	int i, t;
+
+	if(k > m){
+		float res = mat->element[0][list[0]];
+
+		for(i = 1; i < mat->row ; i++)
+			res *= mat->element[i][list[i]];
+		if(*p%2)
+			*det -= res;
+		else
+			*det += res;
+	}else{
+		_old_perm(list, k + 1, m, p, mat, det);
+		for(i = k+1; i <= m; i++){
+			t = list[k]; list[k] = list[i]; list[i] = t;
+			*p += 1;
+			_old_perm(list, k + 1, m, p, mat, det);
+			t = list[k]; list[k] = list[i]; list[i] = t;
+			*p -= 1;
+		}
+	}
+}
+
+static float _old_det(Mat* mat)
+{
+	int list[N_MAX];
+	int p = 0;
+	float det = 0.0f;
+
+	for(int i = 0 ; i < mat->col ; i++)
+		list[i] = i;
+	_old_perm(list, 0, mat->row-1, &p, mat, &det);
+
+	return det;
+}
+
+static Mat* _old_inv(Mat* src, Mat* dst)
+{
+	Mat smat;
+	int n = src->row;
+	float det = _old_det(src);
+
+	if(det == 0.0f)
+		return NULL;
+	MatCreate(&smat, n-1, n-1);
+	for(int row = 0 ; row < n ; row++){
+		for(int col = 0 ; col < n ; col++){
+			int r = 0;
+			for(int i = 0 ; i < n ; i++){
+				if(i == row)
+					continue;
+				int c = 0;
+				for(int j = 0; j < n ; j++){
+					if(j == col)
+						continue;
+					smat.element[r][c++] = src->element[i][j];
+				}
+				r++;
+			}
+			float cof = _old_det(&smat);
+			dst->element[col][row] = ((row+col)%2 ? -cof : cof)/det;
+		}
+	}
+	MatDelete(&smat);
+
+	return dst;
+}
+
+/* double precision reference, return det and inverse */
+static double _ref_inv(const double* a, double* inv, int n)
+{
+	double lu[N_MAX*N_MAX];
+	int piv[N_MAX];
+	double det = 1.0;
+
+	memcpy(lu, a, sizeof(double)*n*n);
+	for(int i = 0 ; i < n ; i++)
+		piv[i] = i;
+	for(int k = 0 ; k < n ; k++){
+		int p = k;
+		for(int i = k+1 ; i < n ; i++){
+			if(fabs(lu[i*n+k]) > fabs(lu[p*n+k]))
+				p = i;
+		}
+		if(p != k){
+			for(int j = 0 ; j < n ; j++){
+				double t = lu[k*n+j]; lu[k*n+j] = lu[p*n+j]; lu[p*n+j] = t;
+			}
+			int t = piv[k]; piv[k] = piv[p]; piv[p] = t;
+			det = -det;
+		}
+		det *= lu[k*n+k];
+		for(int i = k+1 ; i < n ; i++){
+			lu[i*n+k] /= lu[k*n+k];
+			for(int j = k+1 ; j < n ; j++)
+				lu[i*n+j] -= lu[i*n+k]*lu[k*n+j];
+		}
+	}
+	for(int c = 0 ; c < n ; c++){
+		double x[N_MAX];
+		for(int i = 0 ; i < n ; i++){
+			x[i] = piv[i] == c;
+			for(int k = 0 ; k < i ; k++)
+				x[i] -= lu[i*n+k]*x[k];
+		}
+		for(int i = n-1 ; i >= 0 ; i--){
+			for(int k = i+1 ; k < n ; k++)
+				x[i] -= lu[i*n+k]*x[k];
+			x[i] /= lu[i*n+i];
+		}
+		for(int i = 0 ; i < n ; i++)
+			inv[i*n+c] = x[i];
+	}
+
+	return det;
+}
+
+static double _norm_inf(const double* a, int n)
+{
+	double max = 0.0;
+
+	for(int i = 0 ; i < n ; i++){
+		double sum = 0.0;
+		for(int j = 0 ; j < n ; j++)
+			sum += fabs(a[i*n+j]);
+		if(sum > max)
+			max = sum;
+	}
+	return max;
+}
+
+/* max |A*X - I| in double, X from float solver */
+static double _inv_residual(const double* a, const Mat* x, int n)
+{
+	double max = 0.0;
+
+	for(int i = 0 ; i < n ; i++){
+		for(int j = 0 ; j < n ; j++){
+			double sum = -(double)(i == j);
+			for(int k = 0 ; k < n ; k++)
+				sum += a[i*n+k]*x->element[k][j];
+			if(fabs(sum) > max)
+				max = fabs(sum);
+		}
+	}
+	return max;
+}
+
+static void _set(Mat* m, const double* a, int n)
+{
+	for(int i = 0 ; i < n ; i++){
+		for(int j = 0 ; j < n ; j++)
+			m->element[i][j] = (float)a[i*n+j];
+	}
+}
+
+static void _accuracy(int n, int trials)
+{
+	Mat A, X, L, B;
+	double a[N_MAX*N_MAX], inv[N_MAX*N_MAX];
+	double det_err = 0, inv_err = 0, old_det_err = 0, old_inv_err = 0, solve_err = 0, chol_err = 0;
+	int used = 0;
+
+	MatCreate(&A, n, n);
+	MatCreate(&X, n, n);
+	MatCreate(&L, n, n);
+	MatCreate(&B, n, 1);
+
+	for(int t = 0 ; t < trials ; t++){
+		double det, cond, err;
+
+		for(int i = 0 ; i < n*n ; i++)
+			a[i] = _rand();
+		/* reference is on the float matrix the solvers see */
+		for(int i = 0 ; i < n*n ; i++)
+			a[i] = (float)a[i];
+		det = _ref_inv(a, inv, n);
+		cond = _norm_inf(a, n)*_norm_inf(inv, n);
+		if(cond > COND_MAX)
+			continue;
+		used++;
+		_set(&A, a, n);
+
+		err = fabs(MatDet(&A) - det)/fabs(det);
+		if(err > det_err)
+			det_err = err;
+		if(MatInv(&A, &X) == NULL){
+			printf("  fail: MatInv rejects a regular %dx%d matrix\n", n, n);
+			_fail++;
+		}else if((err = _inv_residual(a, &X, n)) > inv_err){
+			inv_err = err;
+		}
+		if(n <= OLD_N_MAX){
+			err = fabs(_old_det(&A) - det)/fabs(det);
+			if(err > old_det_err)
+				old_det_err = err;
+			if(_old_inv(&A, &X) && (err = _inv_residual(a, &X, n)) > old_inv_err)
+				old_inv_err = err;
+		}
+
+		/* A*x = b, x is column 0 of the inverse for b = e0 */
+		for(int i = 0 ; i < n ; i++)
+			B.element[i][0] = i == 0;
+		{
+			Mat x;
+			MatCreate(&x, n, 1);
+			if(MatSolve(&A, &B, &x)){
+				for(int i = 0 ; i < n ; i++){
+					err = fabs(x.element[i][0] - inv[i*n])/_norm_inf(inv, n);
+					if(err > solve_err)
+						solve_err = err;
+				}
+			}else{
+				printf("  fail: MatSolve rejects a regular %dx%d matrix\n", n, n);
+				_fail++;
+			}
+			MatDelete(&x);
+		}
+
+		/* S = A*A' + I is positive definite */
+		{
+			double s[N_MAX*N_MAX], sinv[N_MAX*N_MAX];
+			for(int i = 0 ; i < n ; i++){
+				for(int j = 0 ; j < n ; j++){
+					double sum = i == j;
+					for(int k = 0 ; k < n ; k++)
+						sum += a[i*n+k]*a[j*n+k];
+					s[i*n+j] = (float)sum;
+				}
+			}
+			_ref_inv(s, sinv, n);
+			_set(&L, s, n);
+			if(MatCholesky(&L)){
+				printf("  fail: MatCholesky rejects a positive definite %dx%d matrix\n", n, n);
+				_fail++;
+			}else{
+				MatEye(&X);
+				MatCholeskySolve(&L, &X, &X);
+				if((err = _inv_residual(s, &X, n)) > chol_err)
+					chol_err = err;
+			}
+		}
+	}
+
+	if(det_err > DET_TOL || inv_err > INV_TOL || solve_err > INV_TOL || chol_err > INV_TOL)
+		_fail++;
+	printf("%2d  %5d  %9.2e %9.2e  %9.2e %9.2e", n, used, det_err, inv_err, solve_err, chol_err);
+	if(n <= OLD_N_MAX)
+		printf("  %9.2e %9.2e", old_det_err, old_inv_err);
+	printf("\n");
+
+	MatDelete(&A);
+	MatDelete(&X);
+	MatDelete(&L);
+	MatDelete(&B);
+}
+
+static void _reject(void)
+{
+	Mat A, X;
+	float singular[9] = {1, 2, 3, 2, 4, 6, 1, 0, 1};
+	float indefinite[9] = {1, 2, 0, 2, 1, 0, 0, 0, 1};
+
+	MatCreate(&A, 3, 3);
+	MatCreate(&X, 3, 3);
+	MatSetVal(&A, singular);
+	if(MatInv(&A, &X) != NULL || MatDet(&A) != 0.0f){
+		printf("  fail: singular matrix is not rejected\n");
+		_fail++;
+	}
+	MatSetVal(&A, indefinite);
+	if(MatCholesky(&A) == 0){
+		printf("  fail: indefinite matrix is not rejected\n");
+		_fail++;
+	}
+	MatDelete(&A);
+	MatDelete(&X);
+}
+
+/* ns per call */
+static double _bench(int n, int which, int loops)
+{
+	Mat A, X, L, B, Y;
+	float a[N_MAX*N_MAX];
+	volatile float sink = 0.0f;
+	uint64_t start;
+
+	for(int i = 0 ; i < n*n ; i++)
+		a[i] = (float)_rand() + (i % (n+1) == 0 ? n : 0);
+	MatCreate(&A, n, n);
+	MatCreate(&X, n, n);
+	MatCreate(&L, n, n);
+	MatCreate(&B, n, 1);
+	MatCreate(&Y, n, 1);
+	MatSetVal(&A, a);
+	MatZeros(&B);
+
+	start = _now_ns();
+	for(int i = 0 ; i < loops ; i++){
+		switch(which)
+		{
+			case 0:
+				sink += MatDet(&A);
+				break;
+			case 1:
+				MatInv(&A, &X);
+				break;
+			case 2:
+				MatSolve(&A, &B, &Y);
+				break;
+			case 3:
+				/* diagonal dominant A is positive definite after symmetrizing its lower part */
+				MatCopy(&A, &L);
+				MatCholesky(&L);
+				MatCholeskySolve(&L, &B, &B);
+				break;
+			case 4:
+				sink += _old_det(&A);
+				break;
+			case 5:
+				_old_inv(&A, &X);
+				break;
+		}
+	}
+	(void)sink;
+
+	MatDelete(&A);
+	MatDelete(&X);
+	MatDelete(&L);
+	MatDelete(&B);
+	MatDelete(&Y);
+
+	return (double)(_now_ns() - start)/loops;
+}
+
+int main(int argc, char** argv)
+{
+	int trials = argc > 1 ? atoi(argv[1]) : 500;
+	int bench_n[] = {3, 4, 6, 8, 14};
+
+	srand(1);
+	printf("accuracy, max error over matrices with cond < %.0f\n", COND_MAX);
+	printf(" n   used  det(rel)  A*inv-I    solve     chol       old det   old A*inv-I\n");
+	for(int n = N_MIN ; n <= N_MAX ; n++)
+		_accuracy(n, trials);
+	_reject();
+
+	printf("\ntime per call (ns)\n");
+	printf(" n     MatDet    MatInv  MatSolve  Cholesky   old det   old inv\n");
+	for(uint32_t i = 0 ; i < sizeof(bench_n)/sizeof(bench_n[0]) ; i++){
+		int n = bench_n[i];
+		int loops = 200000/(n*n);
+
+		printf("%2d  %9.0f %9.0f %9.0f %9.0f", n, _bench(n, 0, loops), _bench(n, 1, loops),
+				_bench(n, 2, loops), _bench(n, 3, loops));
+		if(n <= OLD_N_MAX){
+			/* n! products per det, n^2 dets per inverse */
+			int old_loops = n <= 4 ? loops : 10;
+			printf(" %9.0f %9.0f", _bench(n, 4, old_loops), _bench(n, 5, n <= 4 ? old_loops : 1));
+		}
+		printf("\n");
+	}
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
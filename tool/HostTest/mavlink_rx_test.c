@@ -0,0 +1,237 @@
+/*
+ * File      : mavlink_rx_test.c
+ *
+ * Host equivalence test and benchmark of the block mavlink receiver. The
+ * stream is a raw capture given on the command line, or a generated ground
+ * station link: HIL_SENSOR, PARAM_SET, COMMAND_LONG and HEARTBEAT with 1% of
+ * frames hit by a flipped byte, truncated frames, stray STX bytes and bad
+ * frames whose last crc byte is STX, followed by a valid frame.
+ * The stream is fed in random 1..512 byte reads to mavlink_rx_parse() and
+ * byte by byte to mavlink_frame_char(). Both must give the same frames,
+ * header, payload and crc bytes, in the same order, and the same number of
+ * crc errors. mavlink_parse_char(), which mavproxy used before, restarts on
+ * a bad crc byte equal to STX and so syncs differently after such frames,
+ * the frames only one of them finds are reported. Then both are timed on
+ * 512 byte reads.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -Wno-unknown-pragmas -I$S/Framework/include -o mavlink_rx_test mavlink_rx_test.c
+ *            $S/Framework/source/Mavproxy/mavlink_rx.c
+ * usage: mavlink_rx_test [capture file]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "mavlink_rx.h"
+
+#define STREAM_SIZE		(16*1024*1024)
+#define CHUNK_MAX_FRAME	(MAVLINK_RX_BUFFER_SIZE/MAVLINK_NUM_NON_PAYLOAD_BYTES + 1)
+
+enum
+{
+	CHAN_FRAME = 0,
+	CHAN_PARSE,
+};
+
+typedef struct
+{
+	mavlink_message_t msg[CHUNK_MAX_FRAME];
+	uint32_t num;
+}frame_list_t;
+
+static uint32_t _fail;
+static uint8_t _stream[STREAM_SIZE];
+static size_t _stream_len;
+static frame_list_t _rx_list;
+static uint32_t _rx_cnt;
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void _gen_stream(void)
+{
+	mavlink_message_t msg;
+	uint8_t buf[MAVLINK_MAX_PACKET_LEN];
+	uint16_t n;
+
+	srand(1);
+	for(uint32_t i = 0 ; _stream_len + 2*MAVLINK_MAX_PACKET_LEN < STREAM_SIZE ; i++){
+		switch(i % 10){
+		case 0:
+			mavlink_msg_heartbeat_pack(255, 190, &msg, MAV_TYPE_GCS, MAV_AUTOPILOT_INVALID, 0, 0, 0);
+			break;
+		case 1:
+			mavlink_msg_param_set_pack(255, 190, &msg, 1, 1, "ATT_ROLL_RATE_P", 0.01f*i, MAV_PARAM_TYPE_REAL32);
+			break;
+		case 2:
+			mavlink_msg_command_long_pack(255, 190, &msg, 1, 1, MAV_CMD_COMPONENT_ARM_DISARM, 0, i & 1, 0, 0, 0, 0, 0, 0);
+			break;
+		default:
+			mavlink_msg_hil_sensor_pack(1, 1, &msg, i*4000ull, 0.1f, 0.2f, 9.8f, 0.01f, 0.02f, 0.03f*i,
+										0.2f, 0.0f, 0.4f, 1013.0f, 0.1f, 10.0f*i, 25.0f, 0x1FFF);
+			break;
+		}
+		n = mavlink_msg_to_send_buffer(buf, &msg);
+
+		if(rand() % 100 == 0)
+			buf[rand() % n] ^= 1 << (rand() % 8);
+		if(rand() % 100 == 0){
+			/* bad frame ending in STX, the next frame follows at once */
+			buf[MAVLINK_NUM_HEADER_BYTES] ^= 0x55;
+			buf[n-1] = MAVLINK_STX;
+		}
+		if(rand() % 200 == 0){
+			_stream[_stream_len++] = MAVLINK_STX;
+			_stream[_stream_len++] = rand();
+		}
+		if(rand() % 300 == 0)
+			n = rand() % n;
+		memcpy(&_stream[_stream_len], buf, n);
+		_stream_len += n;
+	}
+}
+
+static int _load_stream(const char* file_name)
+{
+	FILE* fp = fopen(file_name, "rb");
+
+	if(fp == NULL){
+		printf("can not open %s\n", file_name);
+		return 1;
+	}
+	_stream_len = fread(_stream, 1, STREAM_SIZE, fp);
+	fclose(fp);
+
+	return 0;
+}
+
+static void _rx_handler(mavlink_message_t* msg)
+{
+	if(_rx_list.num < CHUNK_MAX_FRAME)
+		_rx_list.msg[_rx_list.num++] = *msg;
+}
+
+static void _count_handler(mavlink_message_t* msg)
+{
+	(void)msg;
+	_rx_cnt++;
+}
+
+static int _msg_equal(const mavlink_message_t* a, const mavlink_message_t* b)
+{
+	return a->checksum == b->checksum && a->magic == b->magic && a->len == b->len && a->seq == b->seq
+		&& a->sysid == b->sysid && a->compid == b->compid && a->msgid == b->msgid
+		&& memcmp(_MAV_PAYLOAD(a), _MAV_PAYLOAD(b), a->len + MAVLINK_NUM_CHECKSUM_BYTES) == 0;
+}
+
+static void _test_equal(void)
+{
+	static frame_list_t frame_list;
+	mavlink_rx_t rx;
+	mavlink_message_t msg, frame_msg, parse_msg;
+	mavlink_status_t status;
+	uint32_t frame_cnt = 0, crc_err = 0, mismatch = 0, parse_cnt = 0, missed = 0;
+	size_t pos = 0, chunk;
+
+	mavlink_rx_init(&rx);
+	srand(2);
+	while(pos < _stream_len){
+		chunk = 1 + rand() % MAVLINK_RX_BUFFER_SIZE;
+		if(chunk > _stream_len - pos)
+			chunk = _stream_len - pos;
+
+		_rx_list.num = 0;
+		mavlink_rx_parse(&rx, &_stream[pos], chunk, &msg, _rx_handler);
+
+		frame_list.num = 0;
+		for(size_t i = pos ; i < pos + chunk ; i++){
+			uint8_t res = mavlink_frame_char(CHAN_FRAME, _stream[i], &frame_msg, &status);
+
+			if(res == MAVLINK_FRAMING_OK && frame_list.num < CHUNK_MAX_FRAME)
+				frame_list.msg[frame_list.num++] = frame_msg;
+			else if(res == MAVLINK_FRAMING_BAD_CRC)
+				crc_err++;
+
+			if(mavlink_parse_char(CHAN_PARSE, _stream[i], &parse_msg, &status)){
+				uint32_t k;
+
+				for(k = 0 ; k < _rx_list.num && !_msg_equal(&_rx_list.msg[k], &parse_msg) ; k++);
+				missed += k == _rx_list.num;
+				parse_cnt++;
+			}
+		}
+
+		if(frame_list.num != _rx_list.num){
+			mismatch++;
+		}else{
+			for(uint32_t k = 0 ; k < frame_list.num ; k++)
+				mismatch += !_msg_equal(&frame_list.msg[k], &_rx_list.msg[k]);
+		}
+		frame_cnt += frame_list.num;
+		pos += chunk;
+	}
+
+	printf("stream %.1f MB: mavlink_frame_char %u frames, %u crc err; mavlink_rx_parse %u frames, %u crc err, %u mismatch\n",
+			_stream_len/1e6, frame_cnt, crc_err, rx.frame_cnt, rx.crc_err, mismatch);
+	printf("mavlink_parse_char %u frames, %u of them not found by mavlink_rx_parse, %u found only by mavlink_rx_parse\n",
+			parse_cnt, missed, rx.frame_cnt - (parse_cnt - missed));
+	if(mismatch || frame_cnt != rx.frame_cnt || crc_err != rx.crc_err || frame_cnt == 0)
+		_fail++;
+}
+
+static void _bench(void)
+{
+	mavlink_rx_t rx;
+	mavlink_message_t msg;
+	mavlink_status_t status;
+	uint32_t parse_cnt = 0;
+	double parse_s, rx_s;
+	uint64_t start;
+
+	start = _now_ns();
+	for(size_t i = 0 ; i < _stream_len ; i++)
+		parse_cnt += mavlink_parse_char(MAVLINK_COMM_2, _stream[i], &msg, &status);
+	parse_s = (_now_ns() - start)*1e-9;
+
+	mavlink_rx_init(&rx);
+	_rx_cnt = 0;
+	start = _now_ns();
+	for(size_t pos = 0 ; pos < _stream_len ; pos += MAVLINK_RX_BUFFER_SIZE){
+		size_t chunk = _stream_len - pos < MAVLINK_RX_BUFFER_SIZE ? _stream_len - pos : MAVLINK_RX_BUFFER_SIZE;
+
+		mavlink_rx_parse(&rx, &_stream[pos], chunk, &msg, _count_handler);
+	}
+	rx_s = (_now_ns() - start)*1e-9;
+
+	printf("\nmavlink_parse_char: %7.1f MB/s, %9.0f frames/s\n", _stream_len/parse_s/1e6, parse_cnt/parse_s);
+	printf("mavlink_rx_parse  : %7.1f MB/s, %9.0f frames/s (%d byte reads)\n", _stream_len/rx_s/1e6, _rx_cnt/rx_s,
+			MAVLINK_RX_BUFFER_SIZE);
+}
+
+int main(int argc, char** argv)
+{
+	if(argc > 1){
+		if(_load_stream(argv[1]))
+			return 1;
+	}else{
+		_gen_stream();
+	}
+
+	_test_equal();
+	_bench();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
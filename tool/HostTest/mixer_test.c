@@ -0,0 +1,203 @@
+/*
+ * File      : mixer_test.c
+ *
+ * Host test and benchmark of the table driven mixer. The per frame mixing
+ * code that _ctrl_mix_throttle_out() had before mixer.c is kept here as the
+ * reference, followed by the [0, 0.9] clipping of ctrl_constrain_throttle().
+ * For the X, +, hexa and bluejay frames 200k random roll/pitch/yaw commands
+ * and throttles are mixed:
+ *   desat 0: every motor output equals the reference within float rounding
+ *   desat 1: outputs stay in range, and equal the reference whenever no
+ *   reference output saturates. With saturation the error of the achieved
+ *   roll/pitch/yaw, projected back on the mix columns, is reported for both
+ * Then the cost of one mix per control cycle is timed for each frame.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -I$S/Framework/include -o mixer_test mixer_test.c $S/Framework/source/Control/mixer.c -lm
+ * usage: mixer_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <stdint.h>
+#include "mixer.h"
+
+#define THROTTLE_MIN	0.0f
+#define THROTTLE_MAX	0.9f
+#define CMD_NUM			200000
+#define BENCH_NUM		10000000
+#define MIX_TOL			1e-6f
+
+static uint32_t _fail;
+static volatile float _sink;
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static float _rand_float(float range)
+{
+	return (rand()/(float)RAND_MAX - 0.5f)*2.0f*range;
+}
+
+/* the mixing code before mixer.c, with ctrl_constrain_throttle() */
+static void _old_mix(uint8_t frame, float* out, const float* in, float base_throttle)
+{
+	if(frame == MIXER_FRAME_X){
+		out[0] = base_throttle - in[0] + in[1] + in[2];
+		out[1] = base_throttle + in[0] - in[1] + in[2];
+		out[2] = base_throttle + in[0] + in[1] - in[2];
+		out[3] = base_throttle - in[0] - in[1] - in[2];
+	}else if(frame == MIXER_FRAME_PLUS){
+		out[0] = base_throttle - 1.414f*in[0]          			+ 1.414f*in[2];
+		out[1] = base_throttle + 1.414f*in[0]          			+ 1.414f*in[2];
+		out[2] = base_throttle          		+ 1.414f*in[1] 	- 1.414f*in[2];
+		out[3] = base_throttle          		- 1.414f*in[1] 	- 1.414f*in[2];
+	}else if(frame == MIXER_FRAME_HEXA){
+		out[0] = base_throttle                 +      in[1]  - in[2];
+		out[1] = base_throttle                 -      in[1]  + in[2];
+		out[2] = base_throttle + 0.866f*in[0]  - 0.5f*in[1]  - in[2];
+		out[3] = base_throttle - 0.866f*in[0]  + 0.5f*in[1]  + in[2];
+		out[4] = base_throttle + 0.866f*in[0]  + 0.5f*in[1]  + in[2];
+		out[5] = base_throttle - 0.866f*in[0]  - 0.5f*in[1]  - in[2];
+	}else{
+		out[0] = base_throttle+ 1.414f*(-      in[0]                )  - in[2];
+		out[1] = base_throttle+ 1.414f*(+      in[0]                )  + in[2];
+		out[2] = base_throttle+ 1.414f*(+ 0.5f*in[0]  + 0.866f*in[1])  - in[2];
+		out[3] = base_throttle+ 1.414f*(- 0.5f*in[0]  - 0.866f*in[1])  + in[2];
+		out[4] = base_throttle+ 1.414f*(- 0.5f*in[0]  + 0.866f*in[1])  + in[2];
+		out[5] = base_throttle+ 1.414f*(+ 0.5f*in[0]  - 0.866f*in[1])  - in[2];
+	}
+
+	for(int i = 0 ; i < mixer_get_frame(frame)->motor_num ; i++){
+		if(out[i] < THROTTLE_MIN)
+			out[i] = THROTTLE_MIN;
+		if(out[i] > THROTTLE_MAX)
+			out[i] = THROTTLE_MAX;
+	}
+}
+
+/* roll/pitch/yaw the motor outputs make, the mix columns are orthogonal */
+static void _achieved(const mixer_frame_t* f, const float* out, float att[3])
+{
+	for(int j = 0 ; j < 3 ; j++){
+		float num = 0.0f, den = 0.0f;
+
+		for(int i = 0 ; i < f->motor_num ; i++){
+			num += f->mix[i][j]*out[i];
+			den += f->mix[i][j]*f->mix[i][j];
+		}
+		att[j] = num/den;
+	}
+}
+
+static void _test_frame(uint8_t frame)
+{
+	const mixer_frame_t* f = mixer_get_frame(frame);
+	float att[3], ref[MIXER_MAX_MOTOR_NUM], clip[MIXER_MAX_MOTOR_NUM], desat[MIXER_MAX_MOTOR_NUM];
+	float ref_att[3], desat_att[3];
+	double clip_diff = 0.0, desat_diff = 0.0, ref_err[3] = {0}, desat_err[3] = {0};
+	uint32_t sat_num = 0, range_err = 0;
+
+	srand(7 + frame);
+	for(int n = 0 ; n < CMD_NUM ; n++){
+		float throttle = 0.05f + 0.85f*rand()/RAND_MAX;
+		uint8_t sat = 0;
+
+		att[0] = _rand_float(0.3f);
+		att[1] = _rand_float(0.3f);
+		att[2] = _rand_float(0.15f);
+		_old_mix(frame, ref, att, throttle);
+		mixer_mix(frame, att, throttle, clip, MIXER_MAX_MOTOR_NUM, THROTTLE_MIN, THROTTLE_MAX, 0);
+		mixer_mix(frame, att, throttle, desat, MIXER_MAX_MOTOR_NUM, THROTTLE_MIN, THROTTLE_MAX, 1);
+
+		for(int i = 0 ; i < f->motor_num ; i++){
+			if(fabsf(clip[i] - ref[i]) > clip_diff)
+				clip_diff = fabsf(clip[i] - ref[i]);
+			range_err += desat[i] < THROTTLE_MIN || desat[i] > THROTTLE_MAX;
+			sat |= ref[i] <= THROTTLE_MIN || ref[i] >= THROTTLE_MAX;
+		}
+		if(!sat){
+			for(int i = 0 ; i < f->motor_num ; i++){
+				if(fabsf(desat[i] - ref[i]) > desat_diff)
+					desat_diff = fabsf(desat[i] - ref[i]);
+			}
+			continue;
+		}
+		_achieved(f, ref, ref_att);
+		_achieved(f, desat, desat_att);
+		for(int j = 0 ; j < 3 ; j++){
+			ref_err[j] += fabsf(ref_att[j] - att[j]);
+			desat_err[j] += fabsf(desat_att[j] - att[j]);
+		}
+		sat_num++;
+	}
+
+	printf("%-8s desat 0 max diff %.1e, desat 1 unsaturated max diff %.1e, %u out of range\n", f->name,
+			clip_diff, desat_diff, range_err);
+	if(sat_num){
+		printf("         %4.1f%% saturated, mean roll/pitch/yaw error: clip %.4f/%.4f/%.4f, desat %.4f/%.4f/%.4f\n",
+				100.0*sat_num/CMD_NUM, ref_err[0]/sat_num, ref_err[1]/sat_num, ref_err[2]/sat_num,
+				desat_err[0]/sat_num, desat_err[1]/sat_num, desat_err[2]/sat_num);
+	}
+	if(clip_diff > MIX_TOL || desat_diff > MIX_TOL || range_err)
+		_fail++;
+}
+
+static void _bench(uint8_t frame)
+{
+	float att[3] = {0.1f, -0.2f, 0.05f}, out[MIXER_MAX_MOTOR_NUM];
+	double old_ns, clip_ns, desat_ns;
+	uint64_t start;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		att[0] = (n & 255)*0.002f;
+		_old_mix(frame, out, att, 0.5f);
+		_sink = out[0];
+	}
+	old_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		att[0] = (n & 255)*0.002f;
+		mixer_mix(frame, att, 0.5f, out, MIXER_MAX_MOTOR_NUM, THROTTLE_MIN, THROTTLE_MAX, 0);
+		_sink = out[0];
+	}
+	clip_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	start = _now_ns();
+	for(int n = 0 ; n < BENCH_NUM ; n++){
+		att[0] = (n & 255)*0.002f;
+		mixer_mix(frame, att, 0.5f, out, MIXER_MAX_MOTOR_NUM, THROTTLE_MIN, THROTTLE_MAX, 1);
+		_sink = out[0];
+	}
+	desat_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	printf("%-8s old code %6.2f ns, desat 0 %6.2f ns, desat 1 %6.2f ns\n", mixer_get_frame(frame)->name,
+			old_ns, clip_ns, desat_ns);
+}
+
+int main(void)
+{
+	for(uint8_t frame = 0 ; frame < MIXER_FRAME_NUM ; frame++)
+		_test_frame(frame);
+
+	printf("\nper control cycle mix:\n");
+	for(uint8_t frame = 0 ; frame < MIXER_FRAME_NUM ; frame++)
+		_bench(frame);
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,241 @@
+/*
+ * File      : param_test.c
+ *
+ * Host test and benchmark of the parameter store. The real param.c runs on
+ * the rt_host shim, files go to ./sys. N sequential sets of different params
+ * are flushed once and reloaded, every value must come back from the binary
+ * copy. Then N sets are timed three ways, with the bytes passed to f_write:
+ *   xml per set    what param_set_by_info() did before, a full param.xml
+ *                  rewrite on every set
+ *   bin per set    a binary flush after every set
+ *   batched        N sets marked dirty and one flush, as the param thread
+ *                  does after the quiet time
+ * Lookup by name must find every param of the list, also by a 16 char name
+ * without terminator as mavlink sends it, and param_name_hash must equal
+ * plain FNV-1a of the name, which param.bin records hold. Then the name
+ * lookup and hash speed are measured over the full parameter set.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -pthread -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -I$S/Library/Fatfs -o param_test param_test.c rt_host.c $S/Framework/source/Param/param.c
+ *            $S/Framework/source/YXML/yxml.c $S/Framework/source/Math/ap_math.c -lm
+ * usage: param_test [N]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/stat.h>
+#include "rt_host.h"
+#include "param.h"
+
+#define SET_NUM		100
+#define LOOKUP_LOOP	20000
+#define PARAM_MAX_NUM	256		/* same as param.c */
+
+static uint32_t _fail;
+static param_info_t* _param[PARAM_MAX_NUM];
+static uint32_t _param_num;
+static volatile uintptr_t _sink;
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void _collect(param_info_t* param)
+{
+	_param[_param_num++] = param;
+}
+
+/* a distinct value of the param type for set n */
+static void _set(uint32_t n)
+{
+	param_info_t* p = _param[n % _param_num];
+	float val;
+
+	if(p->type == PARAM_TYPE_FLOAT){
+		val = 0.5f + n;
+	}else{
+		uint32_t u = 1000 + n;
+		memcpy(&val, &u, sizeof(val));
+	}
+	param_set_by_info(p, val);
+}
+
+static void _test_reload(uint32_t set_num)
+{
+	param_value_t val[PARAM_MAX_NUM];
+	param_store_status_t status;
+	uint32_t n = set_num < _param_num ? set_num : _param_num;
+	uint32_t bad = 0;
+
+	for(uint32_t i = 0 ; i < n ; i++)
+		_set(i);
+	status = param_get_store_status();
+	if(status.dirty_cnt != n){
+		printf("%u params set, %u dirty\n", n, status.dirty_cnt);
+		_fail++;
+	}
+	if(param_flush() != 0 || param_get_store_status().dirty_cnt != 0){
+		printf("flush fail\n");
+		_fail++;
+	}
+
+	for(uint32_t i = 0 ; i < _param_num ; i++){
+		val[i] = _param[i]->val;
+		_param[i]->val.u = 0;
+	}
+	param_load();
+	for(uint32_t i = 0 ; i < _param_num ; i++)
+		bad += _param[i]->val.u != val[i].u;
+	printf("reload: %u of %u params set, %u wrong after load\n", n, _param_num, bad);
+	if(bad)
+		_fail++;
+}
+
+static uint32_t _fnv1a(const char* name)
+{
+	uint32_t hval = 0x811c9dc5;
+
+	while(*name){
+		hval ^= (uint8_t)*name++;
+		hval *= 0x01000193;
+	}
+
+	return hval;
+}
+
+static void _test_lookup(void)
+{
+	char id[PARAM_NAME_MAX_LEN];
+	uint32_t bad = 0, id_num = 0;
+
+	for(uint32_t i = 0 ; i < _param_num ; i++){
+		const char* name = _param[i]->name;
+
+		if(param_get_by_name((char*)name) != _param[i] || param_get_info_index((char*)name) != i
+			|| param_name_hash(name) != _fnv1a(name)){
+			printf("lookup of %s fail\n", name);
+			bad++;
+		}
+		/* mavlink param_id has no terminator at full length */
+		if(strlen(name) == PARAM_NAME_MAX_LEN){
+			memcpy(id, name, PARAM_NAME_MAX_LEN);
+			if(param_get_by_name(id) != _param[i]){
+				printf("lookup of 16 char id %s fail\n", name);
+				bad++;
+			}
+			id_num++;
+		}
+	}
+	if(param_get_by_name("NOT_A_PARAM") != NULL || param_get_info_index("NOT_A_PARAM") != _param_num){
+		printf("unknown name found\n");
+		bad++;
+	}
+	printf("lookup: %u params, %u with 16 char name, %u fail\n", _param_num, id_num, bad);
+	if(bad)
+		_fail++;
+}
+
+static param_info_t* _linear_find(const char* name)
+{
+	for(uint32_t i = 0 ; i < _param_num ; i++){
+		if(strcmp(name, _param[i]->name) == 0)
+			return _param[i];
+	}
+
+	return NULL;
+}
+
+static void _bench_lookup(void)
+{
+	double linear_ns, index_ns, hash_ns, n = (double)LOOKUP_LOOP*_param_num;
+	uint64_t start;
+
+	start = _now_ns();
+	for(int r = 0 ; r < LOOKUP_LOOP ; r++){
+		for(uint32_t i = 0 ; i < _param_num ; i++)
+			_sink += (uintptr_t)_linear_find(_param[i]->name);
+	}
+	linear_ns = (_now_ns() - start)/n;
+
+	start = _now_ns();
+	for(int r = 0 ; r < LOOKUP_LOOP ; r++){
+		for(uint32_t i = 0 ; i < _param_num ; i++)
+			_sink += (uintptr_t)param_get_by_name((char*)_param[i]->name);
+	}
+	index_ns = (_now_ns() - start)/n;
+
+	start = _now_ns();
+	for(int r = 0 ; r < LOOKUP_LOOP ; r++){
+		for(uint32_t i = 0 ; i < _param_num ; i++)
+			_sink += param_name_hash(_param[i]->name);
+	}
+	hash_ns = (_now_ns() - start)/n;
+
+	printf("lookup of %u names: linear strcmp %.1f ns, hash index %.1f ns, param_name_hash %.1f ns\n",
+			_param_num, linear_ns, index_ns, hash_ns);
+}
+
+static void _bench(const char* name, uint32_t set_num, int mode)
+{
+	uint64_t bytes = rt_host_fs_write_bytes();
+	uint64_t start = _now_ns();
+	double ms;
+
+	for(uint32_t i = 0 ; i < set_num ; i++){
+		_set(i);
+		if(mode == 0)
+			param_export();
+		else if(mode == 1)
+			param_flush();
+	}
+	if(mode == 2)
+		param_flush();
+	ms = (_now_ns() - start)*1e-6;
+	bytes = rt_host_fs_write_bytes() - bytes;
+
+	printf("%-12s %4u sets: %8.3f ms, %8llu bytes, %6.0f bytes/set\n", name, set_num, ms,
+			(unsigned long long)bytes, (double)bytes/set_num);
+}
+
+int main(int argc, char** argv)
+{
+	uint32_t set_num = argc > 1 ? atoi(argv[1]) : SET_NUM;
+
+	mkdir("sys", 0777);
+	remove("sys/param.bin");
+	remove("sys/param_b.bin");
+	remove("sys/param.xml");
+	rt_host_set_verbose(0);
+	if(param_init() != 0){
+		printf("param init fail\n");
+		return 1;
+	}
+	param_traverse(_collect);
+
+	_test_lookup();
+	_test_reload(set_num);
+
+	printf("\n");
+	_bench("xml per set", set_num, 0);
+	_bench("bin per set", set_num, 1);
+	_bench("batched", set_num, 2);
+	_bench_lookup();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,262 @@
+/*
+ * File      : rate_sched_test.c
+ *
+ * Host test of the rate group scheduler on a fake us clock. The copter task
+ * set (att_est 2ms, pos_est 10ms, control 4ms, 500us tolerance) is driven
+ * for 100s by a 1ms tick with wake up noise. Tasks advance the clock by
+ * their execution time. As on target the tick is an event flag, ticks which
+ * pass while a task runs wake the loop only once. Checked on the counters of
+ * sched_get_task():
+ *   nominal: up to 300us early or late wake up, every release runs once,
+ *   no overrun, miss or skip, jitter within the noise plus the tasks that
+ *   run before in the same tick
+ *   no tolerance: early wake ups make tasks run a tick late, but no release
+ *   is lost
+ *   tolerance window: a task runs at release - tolerance, not 1us before
+ *   faults: up to 100us late wake up, pos_est over budget every 100th run,
+ *   control longer than its period every 995th run. Overrun and miss count
+ *   exactly the injected runs, att_est skips the one release that control
+ *   ran over, and the release of every task stays on its phase
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o rate_sched_test rate_sched_test.c $S/Framework/source/Copter/rate_sched.c
+ * usage: rate_sched_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <stdint.h>
+#include "rate_sched.h"
+#include "console.h"
+
+#define TICK_US			1000
+#define TEST_US			100000000ull		/* 100s */
+#define START_US		5000000ull
+#define TOLERANCE_US	500
+#define NOISE_US		300
+#define LATENCY_US		100
+#define EXEC_NOISE_US	20
+
+#define ATT_EST			0
+#define POS_EST			1
+#define CONTROL			2
+#define TASK_NUM		3
+
+typedef struct
+{
+	const char* name;
+	uint32_t period_us;
+	uint32_t budget_us;
+	uint32_t exec_us;				/* nominal execution time */
+	uint32_t fault_every;			/* every n-th run takes fault_us, 0 for none */
+	uint32_t fault_us;
+	uint32_t run_cnt;
+	uint32_t fault_cnt;
+}task_model_t;
+
+static uint32_t _fail;
+static uint64_t _now_us;
+static uint32_t _rand_state;
+static task_model_t _model[TASK_NUM];
+
+/* framework calls used by rate_sched.c */
+static void _print(const char* fmt, ...)
+{
+	(void)fmt;
+}
+
+CONSOLE_Typedef Console = {.print = _print};
+
+static uint64_t _clock(void)
+{
+	return _now_us;
+}
+
+static uint32_t _rand(void)
+{
+	_rand_state ^= _rand_state << 13;
+	_rand_state ^= _rand_state >> 17;
+	_rand_state ^= _rand_state << 5;
+	return _rand_state;
+}
+
+static void _task_run(void* parameter)
+{
+	task_model_t* m = (task_model_t*)parameter;
+
+	m->run_cnt++;
+	if(m->fault_every && m->run_cnt % m->fault_every == 0){
+		_now_us += m->fault_us;
+		m->fault_cnt++;
+	}else{
+		_now_us += m->exec_us + _rand() % EXEC_NOISE_US;
+	}
+}
+
+static void _check(int cond, const char* what, const char* name)
+{
+	if(!cond){
+		printf("  fail: %s %s\n", name, what);
+		_fail++;
+	}
+}
+
+static void _setup(uint32_t tolerance_us, uint8_t fault)
+{
+	const task_model_t model[TASK_NUM] = {
+		{"att_est", 2000, 500, 150, 0, 0, 0, 0},
+		{"pos_est", 10000, 1000, 300, 100, 1500, 0, 0},
+		{"control", 4000, 500, 200, 995, 4600, 0, 0},
+	};
+
+	memcpy(_model, model, sizeof(_model));
+	if(!fault){
+		_model[POS_EST].fault_every = 0;
+		_model[CONTROL].fault_every = 0;
+	}
+	_now_us = START_US;
+	_rand_state = 12345;
+	sched_init(_clock, tolerance_us);
+	for(int i = 0 ; i < TASK_NUM ; i++){
+		sched_task_register(_model[i].name, _task_run, &_model[i], _model[i].period_us, 0, _model[i].budget_us);
+	}
+	sched_start();
+	sched_run();
+}
+
+/* 1ms tick, wake up early_us before to late_us after. Ticks passed during a run are one event */
+static void _drive(int32_t early_us, int32_t late_us)
+{
+	uint64_t tick = START_US;
+	uint64_t wake;
+
+	while(tick < START_US + TEST_US){
+		tick += TICK_US;
+		wake = tick - early_us + _rand() % (early_us + late_us + 1);
+		if(wake <= _now_us)
+			continue;
+		_now_us = wake;
+		sched_run();
+	}
+}
+
+static void _show(const char* title)
+{
+	printf("%s\n", title);
+	for(int i = 0 ; i < TASK_NUM ; i++){
+		const sched_task_t* t = sched_get_task(i);
+
+		printf("  %-8s run %6u overrun %4u miss %4u skip %4u jitter max %4u us\n", t->name, t->run_cnt,
+				t->overrun_cnt, t->miss_cnt, t->skip_cnt, t->jitter_max);
+	}
+}
+
+static void _test_nominal(void)
+{
+	uint32_t jitter_bound = NOISE_US;
+
+	_setup(TOLERANCE_US, 0);
+	_drive(NOISE_US, NOISE_US);
+	_show("nominal, +-300us wake up noise:");
+
+	for(int i = 0 ; i < TASK_NUM ; i++){
+		const sched_task_t* t = sched_get_task(i);
+		uint32_t release_num = TEST_US/t->period_us;
+
+		/* the release at the end of the test may or may not have run */
+		_check(t->run_cnt == release_num || t->run_cnt == release_num + 1, "run count", t->name);
+		_check(t->overrun_cnt == 0 && t->miss_cnt == 0 && t->skip_cnt == 0, "no overrun, miss or skip", t->name);
+		_check(t->jitter_max <= jitter_bound, "jitter within noise", t->name);
+		jitter_bound += _model[i].exec_us + EXEC_NOISE_US;
+	}
+}
+
+static void _test_no_tolerance(void)
+{
+	uint32_t late_max = 0;
+
+	_setup(0, 0);
+	_drive(NOISE_US, NOISE_US);
+	_show("no tolerance, +-300us wake up noise:");
+
+	for(int i = 0 ; i < TASK_NUM ; i++){
+		const sched_task_t* t = sched_get_task(i);
+		uint32_t release_num = TEST_US/t->period_us;
+
+		_check(t->run_cnt == release_num || t->run_cnt == release_num + 1, "run count", t->name);
+		_check(t->skip_cnt == 0 && t->miss_cnt == 0, "no skip or miss", t->name);
+		if(t->jitter_max > late_max)
+			late_max = t->jitter_max;
+	}
+	/* an early wake up leaves the task to the next tick */
+	_check(late_max > TICK_US - NOISE_US, "runs a tick late", "all tasks");
+}
+
+static void _test_window(void)
+{
+	uint64_t release;
+
+	_setup(TOLERANCE_US, 0);
+	release = sched_get_task(ATT_EST)->release;
+
+	_now_us = release - TOLERANCE_US - 1;
+	sched_run();
+	_check(sched_get_task(ATT_EST)->run_cnt == 1, "not run before the window", "att_est");
+
+	_now_us = release - TOLERANCE_US;
+	sched_run();
+	_check(sched_get_task(ATT_EST)->run_cnt == 2, "run at window start", "att_est");
+	_check(sched_get_task(ATT_EST)->release == release + 2000, "release keeps phase", "att_est");
+	_check(sched_get_task(ATT_EST)->jitter_max == 0, "early start counts as 0 jitter", "att_est");
+	printf("tolerance window: ok at release - %d us, not at 1 us before\n", TOLERANCE_US);
+}
+
+static void _test_fault(void)
+{
+	const sched_task_t* att = sched_get_task(ATT_EST);
+	const sched_task_t* pos = sched_get_task(POS_EST);
+	const sched_task_t* ctl = sched_get_task(CONTROL);
+
+	_setup(TOLERANCE_US, 1);
+	_drive(0, LATENCY_US);
+	_show("faults, 100us latency, pos_est 1500us every 100th run, control 4600us every 995th run:");
+	printf("  injected: pos_est %u, control %u\n", _model[POS_EST].fault_cnt, _model[CONTROL].fault_cnt);
+
+	_check(_model[POS_EST].fault_cnt > 0 && _model[CONTROL].fault_cnt > 0, "faults injected", "all tasks");
+	_check(pos->overrun_cnt == _model[POS_EST].fault_cnt, "overrun count", "pos_est");
+	_check(pos->miss_cnt == 0 && pos->skip_cnt == 0, "no miss or skip", "pos_est");
+	_check(ctl->overrun_cnt == _model[CONTROL].fault_cnt, "overrun count", "control");
+	_check(ctl->miss_cnt == _model[CONTROL].fault_cnt, "miss count", "control");
+	/* control ends before the tick after its next release, att_est loses exactly one release */
+	_check(att->skip_cnt == _model[CONTROL].fault_cnt, "skip count", "att_est");
+	_check(att->overrun_cnt == 0 && att->miss_cnt == 0, "no overrun or miss", "att_est");
+	_check(att->jitter_max < att->period_us, "jitter after skip below period", "att_est");
+
+	for(int i = 0 ; i < TASK_NUM ; i++){
+		const sched_task_t* t = sched_get_task(i);
+
+		_check((t->release - START_US) % t->period_us == t->phase_us, "release on phase", t->name);
+		_check(t->run_cnt + t->skip_cnt == (t->release - START_US)/t->period_us, "every release run or skipped", t->name);
+	}
+}
+
+int main(void)
+{
+	_test_nominal();
+	_test_no_tolerance();
+	_test_window();
+	_test_fault();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
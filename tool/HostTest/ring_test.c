@@ -0,0 +1,495 @@
+/*
+ * File      : ring_test.c
+ *
+ * Host test of the pre-trigger log ring. log_ring is first run against a
+ * list model with random push/peek/drop steps. Then the real logger and log
+ * writer run on the rt_host shim with the ring enabled by "logger ring".
+ * GYR and ACC are published every 1ms and ADRC every 2ms, 56 KB/s of
+ * records. The SD card takes a given number of bytes per ms of virtual time,
+ * f_write is held until the card has room for a whole buffer. At the trigger
+ * a log is started, records keep going through the ring while it drains,
+ * and are written directly once it is empty. Each topic must reach the
+ * file in order up to its last sample, with no sample lost while the card
+ * is faster than the records. The file must decode with its markers and
+ * index footer.
+ * Last the card stalls right after the trigger. The first logger stop must
+ * give up the drain after WRITER_STOP_TIMEOUT, count the records left in
+ * the ring as dropped and keep the log busy while the writer is stuck. A
+ * second stop after the card is back must finish a valid log.
+ * Then the ring push speed is measured.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -pthread -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -I$S/Library/Fatfs -I$S/RTOS/components/external/lzo -I$S/RTOS/components/external/libz
+ *            -o ring_test ring_test.c rt_host.c $S/Framework/source/Logger/logger.c
+ *            $S/Framework/source/Logger/log_writer.c $S/Framework/source/Logger/log_compress.c
+ *            $S/Framework/source/Logger/log_delta.c $S/Framework/source/Logger/log_ring.c
+ *            $S/Framework/source/uMCN/uMCN.c $S/RTOS/components/external/lzo/minilzo.c -lz -lm
+ * usage: ring_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include "rt_host.h"
+#include "logger.h"
+#include "log_writer.h"
+#include "log_ring.h"
+#include "global.h"
+#include "uMCN.h"
+#include "motor.h"
+#include "adrc_att.h"
+#include "quaternion.h"
+#include "pos_estimator.h"
+#include "sensor_manager.h"
+#include "statistic.h"
+#include "gps.h"
+
+#define TRIG_FILE			"TRIG000.LOG"
+#define QUEUE_DEPTH			16
+#define RECORD_PERIOD_MS	2			// LOGGER_DEFAULT_PERIOD
+#define TOPIC_NUM			3
+#define MODEL_NUM			100000
+#define MODEL_MAX_LEN		64
+#define UNIT_STEP			1000000
+
+/* logger.c has no header for these */
+extern LOGGER_InfoDef _logger_info;
+void logger_stop(void);
+int handle_logger_shell_cmd(int argc, char** argv);
+
+MCN_DEFINE_SEQLOCK(SENSOR_GYR, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_ACC, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_MAG, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_GYR, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_ACC, 12);
+MCN_DEFINE_SEQLOCK(SENSOR_FILTER_MAG, 12);
+MCN_DEFINE(ATT_EULER, sizeof(Euler));
+MCN_DEFINE(ATT_QUATERNION, sizeof(quaternion));
+MCN_DEFINE(ALT_INFO, sizeof(Altitude_Info));
+MCN_DEFINE(POS_INFO, sizeof(Position_Info));
+MCN_DEFINE(MOTOR_THROTTLE, MOTOR_NUM*sizeof(float));
+MCN_DEFINE(ADRC, sizeof(ADRC_Log));
+MCN_DEFINE(GPS_POSITION, sizeof(struct vehicle_gps_position_s));
+MCN_DEFINE(BARO_POSITION, sizeof(BaroPosition));
+MCN_DEFINE(SYS_LOAD, sizeof(sys_load_t));
+
+/* queued topics, each sample carries its sequence number */
+typedef struct
+{
+	uint8_t msg_id;
+	uint32_t pub_ms;
+	uint32_t pub_num;
+	/* decode state */
+	uint8_t started;
+	uint32_t first;
+	uint32_t next;
+}topic_t;
+
+static topic_t _topic[TOPIC_NUM] =
+{
+	{.msg_id = LOG_MSG_GYR, .pub_ms = 1},
+	{.msg_id = LOG_MSG_ACC, .pub_ms = 1},
+	{.msg_id = LOG_MSG_ADRC, .pub_ms = 2},
+};
+
+static uint32_t _fail;
+static log_ring_t _ring;
+static uint8_t _ring_buff[1 << 20];
+static uint32_t _ms;
+static uint32_t _sd_rate;				/* bytes per ms, 0 for no limit */
+static uint8_t _sd_stall;
+static int64_t _sd_credit;
+static uint64_t _sd_written;
+
+/* framework calls made by logger */
+void console_set_error_hook(void (*hook)(char* tag))
+{
+	(void)hook;
+}
+
+int gps_get_position(Vector3f_t* gps_pos, struct vehicle_gps_position_s gps_report)
+{
+	(void)gps_pos;
+	(void)gps_report;
+	return 0;
+}
+
+int gps_get_velocity(Vector3f_t* gps_vel, struct vehicle_gps_position_s gps_report)
+{
+	(void)gps_vel;
+	(void)gps_report;
+	return 0;
+}
+
+/* gps_ubx.h has its own struct tm, time.h can not be used */
+static uint64_t _now_ns(void)
+{
+	struct timeval t;
+
+	gettimeofday(&t, NULL);
+	return (uint64_t)t.tv_sec*1000000000 + (uint64_t)t.tv_usec*1000;
+}
+
+/* random push/peek/drop against a list of the records expected in the ring */
+static void _test_model(void)
+{
+	static uint8_t model[MODEL_NUM][MODEL_MAX_LEN];
+	static uint32_t model_len[MODEL_NUM];
+	uint8_t buff[1000], data[MODEL_MAX_LEN], out[300];
+	uint32_t head = 0, tail = 0, used = 0, len;
+
+	srand(3);
+	log_ring_init(&_ring, buff, sizeof(buff));
+	for(int step = 0 ; step < UNIT_STEP ; step++){
+		if(rand() % 3){
+			len = 1 + rand() % MODEL_MAX_LEN;
+			for(uint32_t i = 0 ; i < len ; i++)
+				data[i] = rand();
+			log_ring_push(&_ring, data, len);
+			/* oldest records make room */
+			while(used + len + LOG_RING_OVERHEAD > sizeof(buff)){
+				used -= model_len[tail % MODEL_NUM] + LOG_RING_OVERHEAD;
+				tail++;
+			}
+			memcpy(model[head % MODEL_NUM], data, len);
+			model_len[head % MODEL_NUM] = len;
+			head++;
+			used += len + LOG_RING_OVERHEAD;
+		}else{
+			len = log_ring_peek(&_ring, out, sizeof(out));
+			if(head == tail){
+				if(len){
+					printf("peek on empty ring at step %d\n", step);
+					_fail++;
+					return;
+				}
+				continue;
+			}
+			if(len != model_len[tail % MODEL_NUM] || memcmp(out, model[tail % MODEL_NUM], len)){
+				printf("record mismatch at step %d\n", step);
+				_fail++;
+				return;
+			}
+			log_ring_drop(&_ring);
+			used -= len + LOG_RING_OVERHEAD;
+			tail++;
+		}
+		if(_ring.record_num != head - tail || _ring.used != used){
+			printf("count mismatch at step %d\n", step);
+			_fail++;
+			return;
+		}
+	}
+	if(log_ring_push(&_ring, buff, sizeof(buff) - 1) == 0){
+		printf("oversize record accepted\n");
+		_fail++;
+		return;
+	}
+	printf("model: %d random push/peek/drop ok, %u evicted\n", UNIT_STEP, _ring.evict_cnt);
+}
+
+static void _publish_due(void)
+{
+	for(int k = 0 ; k < TOPIC_NUM ; k++){
+		topic_t* t = &_topic[k];
+		float data[6] = {0};
+
+		if(_ms % t->pub_ms)
+			continue;
+		data[0] = (float)t->pub_num++;
+		data[1] = t->msg_id;
+		if(t->msg_id == LOG_MSG_GYR)
+			mcn_publish(MCN_ID(SENSOR_GYR), data);
+		else if(t->msg_id == LOG_MSG_ACC)
+			mcn_publish(MCN_ID(SENSOR_ACC), data);
+		else
+			mcn_publish(MCN_ID(ADRC), data);
+	}
+}
+
+/* run virtual time, the card writes only when it has room for a buffer */
+static void _run(uint32_t ms)
+{
+	for(uint32_t i = 0 ; i < ms ; i++, _ms++){
+		uint64_t written;
+
+		_publish_due();
+		if(_sd_rate)
+			rt_host_fs_set_hold(_sd_stall || _sd_credit < LOG_BUFFER_SIZE);
+		rt_host_advance(1000);
+		rt_host_wait_idle();
+
+		written = rt_host_fs_write_bytes() - _sd_written;
+		_sd_written += written;
+		_sd_credit += _sd_rate - (int64_t)written;
+		if(_sd_credit > 2*LOG_BUFFER_SIZE)
+			_sd_credit = 2*LOG_BUFFER_SIZE;
+	}
+}
+
+static void _ring_enable(uint32_t size_kb)
+{
+	char size[16];
+	char* argv[] = {"logger", "ring", size};
+
+	sprintf(size, "%u", size_kb);
+	handle_logger_shell_cmd(3, argv);
+}
+
+/* samples of each topic in order, return samples lost between first and last */
+static uint32_t _check_file(uint32_t* record_cnt, uint32_t* marker_cnt)
+{
+	FILE* f = fopen(TRIG_FILE, "rb");
+	const LOG_HeaderDef* header;
+	uint8_t* raw;
+	uint32_t size, pos, lost = 0, footer = 0;
+
+	*record_cnt = 0;
+	*marker_cnt = 0;
+	if(f == NULL){
+		printf("  fail: no %s\n", TRIG_FILE);
+		_fail++;
+		return 0;
+	}
+	fseek(f, 0, SEEK_END);
+	size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	raw = malloc(size);
+	if(fread(raw, 1, size, f) != size)
+		size = 0;
+	fclose(f);
+
+	header = (const LOG_HeaderDef*)raw;
+	if(size < sizeof(LOG_HeaderDef) || header->magic != LOG_MAGIC){
+		printf("  fail: bad log header\n");
+		_fail++;
+		free(raw);
+		return 0;
+	}
+	for(int k = 0 ; k < TOPIC_NUM ; k++)
+		_topic[k].started = 0;
+
+	for(pos = header->header_size ; pos < size ; ){
+		if(raw[pos] == LOG_RECORD_SYNC){
+			const LOG_RecordHeaderDef* record = (const LOG_RecordHeaderDef*)&raw[pos];
+			float seq_val;
+			uint32_t seq;
+			int k;
+
+			for(k = 0 ; k < TOPIC_NUM && _topic[k].msg_id != record->msg_id ; k++);
+			if(k == TOPIC_NUM || pos + sizeof(LOG_RecordHeaderDef) + record->payload_size > size){
+				printf("  fail: bad record at %u\n", pos);
+				_fail++;
+				break;
+			}
+			memcpy(&seq_val, &raw[pos + sizeof(LOG_RecordHeaderDef)], sizeof(seq_val));
+			seq = (uint32_t)seq_val;
+			if(!_topic[k].started){
+				_topic[k].started = 1;
+				_topic[k].first = seq;
+			}else if(seq < _topic[k].next){
+				printf("  fail: msg %u sample %u after %u\n", record->msg_id, seq, _topic[k].next - 1);
+				_fail++;
+			}else{
+				lost += seq - _topic[k].next;
+			}
+			_topic[k].next = seq + 1;
+			(*record_cnt)++;
+			pos += sizeof(LOG_RecordHeaderDef) + record->payload_size;
+		}else if(raw[pos] == LOG_RECORD_SYNC_MARK){
+			const LOG_SyncDef* mark = (const LOG_SyncDef*)&raw[pos];
+
+			if(mark->magic != LOG_SYNC_MAGIC || mark->raw_offset != pos){
+				printf("  fail: bad marker at %u\n", pos);
+				_fail++;
+			}
+			(*marker_cnt)++;
+			pos += sizeof(LOG_SyncDef);
+		}else if(raw[pos] == LOG_RECORD_SYNC_INDEX){
+			const LOG_IndexTailDef* tail = (const LOG_IndexTailDef*)&raw[size - sizeof(LOG_IndexTailDef)];
+
+			if(tail->magic != LOG_INDEX_MAGIC || tail->raw_offset != pos){
+				printf("  fail: bad index footer at %u\n", pos);
+				_fail++;
+			}
+			footer = pos;
+			break;
+		}else{
+			printf("  fail: unknown byte 0x%02x at %u\n", raw[pos], pos);
+			_fail++;
+			break;
+		}
+	}
+	if(!footer){
+		printf("  fail: no index footer\n");
+		_fail++;
+	}
+	free(raw);
+
+	return lost;
+}
+
+static void _start_case(uint32_t ring_kb, uint32_t sd_rate)
+{
+	remove(TRIG_FILE);
+	rt_host_fs_set_hold(0);
+	_sd_rate = sd_rate*1024/1000;
+	_sd_stall = 0;
+	_sd_credit = 0;
+	_sd_written = rt_host_fs_write_bytes();
+	_ring_enable(ring_kb);
+	for(int k = 0 ; k < TOPIC_NUM ; k++)
+		_topic[k].pub_num = 0;
+	_ms = 0;
+}
+
+/* records every 1ms, trigger at trigger ms, logger_stop after run ms */
+static void _test_trigger(uint32_t ring_kb, uint32_t sd_rate, uint32_t trigger, uint32_t run)
+{
+	LOG_WriterStatusDef status;
+	uint32_t lost, record_cnt, marker_cnt;
+
+	_start_case(ring_kb, sd_rate);
+	_run(trigger);
+	logger_trigger(LOG_TRIGGER_SHELL);
+	_run(run - trigger);
+	/* the card takes what is left at its full speed */
+	_sd_rate = 0;
+	rt_host_fs_set_hold(0);
+	logger_stop();
+	status = log_writer_get_status();
+
+	if(_logger_info.status != LOGGER_IDLE){
+		printf("  fail: log is not stopped\n");
+		_fail++;
+	}
+	lost = _check_file(&record_cnt, &marker_cnt);
+	for(int k = 0 ; k < TOPIC_NUM ; k++){
+		/* samples published after the last timer tick are not recorded */
+		if(_topic[k].pub_num - _topic[k].next > RECORD_PERIOD_MS/_topic[k].pub_ms + 1){
+			printf("  fail: msg %u ends at %u, published %u\n", _topic[k].msg_id, _topic[k].next, _topic[k].pub_num);
+			_fail++;
+		}
+	}
+	if(lost || status.drop_cnt || _logger_info.ring_drop_cnt){
+		printf("  fail: %u samples lost, writer dropped %u, ring dropped %u\n", lost, status.drop_cnt,
+				_logger_info.ring_drop_cnt);
+		_fail++;
+	}
+	printf("ring %3u KB, sd %4u KB/s: %4u ms before trigger kept, %6u records, %3u markers, %u lost\n",
+			ring_kb, sd_rate, trigger - _topic[0].first, record_cnt, marker_cnt, lost);
+	remove(TRIG_FILE);
+}
+
+/* card stalls right after the trigger, ring can not drain before stop */
+static void _test_stall(uint32_t ring_kb, uint32_t trigger, uint32_t run)
+{
+	uint32_t lost, record_cnt, marker_cnt;
+	uint64_t start;
+	double stop_ms;
+
+	_start_case(ring_kb, 1000);
+	_run(trigger);
+	logger_trigger(LOG_TRIGGER_SHELL);
+	_sd_stall = 1;
+	_run(run - trigger);
+
+	start = _now_ns();
+	logger_stop();
+	stop_ms = (_now_ns() - start)*1e-6;
+	if(_logger_info.status != LOGGER_BUSY || _logger_info.ring_drop_cnt == 0){
+		printf("  fail: stop with stalled card, status %u, %u ring records dropped\n", _logger_info.status,
+				_logger_info.ring_drop_cnt);
+		_fail++;
+	}
+	/* drain and writer stop each wait WRITER_STOP_TIMEOUT */
+	if(stop_ms < WRITER_STOP_TIMEOUT){
+		printf("  fail: stop gave up after %.0f ms\n", stop_ms);
+		_fail++;
+	}
+
+	_sd_rate = 0;
+	rt_host_fs_set_hold(0);
+	logger_stop();
+	if(_logger_info.status != LOGGER_IDLE){
+		printf("  fail: second stop does not finish the log\n");
+		_fail++;
+	}
+	lost = _check_file(&record_cnt, &marker_cnt);
+	printf("ring %3u KB, card stalled: stop returns after %.0f ms, %u ring records dropped, %u records in file\n",
+			ring_kb, stop_ms, _logger_info.ring_drop_cnt, record_cnt);
+	if(lost){
+		printf("  fail: %u samples lost inside the file\n", lost);
+		_fail++;
+	}
+	remove(TRIG_FILE);
+}
+
+static void _bench(void)
+{
+	uint8_t small[20] = {0};
+	uint64_t start, push_ns;
+	int push_num = 10000000;
+
+	log_ring_init(&_ring, _ring_buff, 256*1024);
+	start = _now_ns();
+	for(int n = 0 ; n < push_num ; n++)
+		log_ring_push(&_ring, small, sizeof(small));
+	push_ns = _now_ns() - start;
+
+	printf("\npush: %.1f ns per 20 B record with eviction\n", (double)push_ns/push_num);
+}
+
+int main(void)
+{
+	const uint32_t ring_kb[] = {16, 64, 256};
+	const uint32_t sd_rate[] = {100, 200, 1000};
+
+	_test_model();
+
+	mcn_advertise_queue(MCN_ID(SENSOR_GYR), QUEUE_DEPTH);
+	mcn_advertise_queue(MCN_ID(SENSOR_ACC), QUEUE_DEPTH);
+	mcn_advertise_queue(MCN_ID(ADRC), QUEUE_DEPTH);
+	mcn_advertise(MCN_ID(SENSOR_MAG));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_GYR));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_ACC));
+	mcn_advertise(MCN_ID(SENSOR_FILTER_MAG));
+	mcn_advertise(MCN_ID(ATT_EULER));
+	mcn_advertise(MCN_ID(ATT_QUATERNION));
+	mcn_advertise(MCN_ID(ALT_INFO));
+	mcn_advertise(MCN_ID(POS_INFO));
+	mcn_advertise(MCN_ID(MOTOR_THROTTLE));
+	mcn_advertise(MCN_ID(GPS_POSITION));
+	mcn_advertise(MCN_ID(BARO_POSITION));
+	mcn_advertise(MCN_ID(SYS_LOAD));
+
+	rt_host_set_verbose(0);
+	log_writer_init();
+	rt_host_thread_start("logger", logger_entry, NULL);
+	rt_host_thread_start("log_writer", log_writer_entry, NULL);
+	rt_host_advance(1000);
+	rt_host_wait_idle();
+
+	for(int i = 0 ; i < 3 ; i++){
+		for(int j = 0 ; j < 3 ; j++)
+			_test_trigger(ring_kb[i], sd_rate[j], 10000, 30000);
+	}
+	/* trigger before the ring is full, and right at start */
+	_test_trigger(256, 200, 100, 3000);
+	_test_trigger(16, 200, 0, 3000);
+	_test_stall(64, 3000, 3500);
+	_bench();
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,670 @@
+/*
+ * File      : rt_host.c
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include "rt_host.h"
+#include "ff.h"
+#include "console.h"
+
+#define HOST_THREAD_MAX		16
+#define HOST_TIMER_MAX		16
+
+enum
+{
+	WAIT_NONE = 0,
+	WAIT_SEM,
+	WAIT_MUTEX,
+	WAIT_EVENT,
+	WAIT_FS_HOLD,
+};
+
+typedef struct
+{
+	struct rt_thread thread;	// only name is used
+	pthread_t tid;
+	void (*entry)(void* parameter);
+	void* parameter;
+	/* what the thread is blocked on */
+	uint8_t wait_kind;
+	void* wait_obj;
+	rt_uint32_t wait_set;
+	rt_uint8_t wait_option;
+}host_thread_t;
+
+static pthread_mutex_t _lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _cond = PTHREAD_COND_INITIALIZER;
+static pthread_mutex_t _critical;
+static pthread_once_t _critical_once = PTHREAD_ONCE_INIT;
+static __thread int _critical_nest;
+static __thread host_thread_t* _self;
+static host_thread_t _thread[HOST_THREAD_MAX];
+static uint32_t _thread_num;
+static host_thread_t _other;				// threads not started by rt_host_thread_start
+static rt_timer_t _timer[HOST_TIMER_MAX];
+static uint8_t _timer_run[HOST_TIMER_MAX];
+static uint32_t _timer_num;
+static volatile uint64_t _now_us;
+static uint8_t _verbose = 1;
+static uint32_t _fs_rate;
+static uint8_t _fs_error;
+static uint64_t _fs_write_bytes;
+static volatile uint8_t _fs_hold;
+
+static host_thread_t* _thread_self(void)
+{
+	return _self ? _self : &_other;
+}
+
+static int _ready(const host_thread_t* th)
+{
+	switch(th->wait_kind)
+	{
+		case WAIT_SEM:
+			return ((struct rt_semaphore*)th->wait_obj)->value > 0;
+		case WAIT_MUTEX:
+		{
+			struct rt_mutex* mutex = (struct rt_mutex*)th->wait_obj;
+			return mutex->owner == NULL || mutex->owner == &th->thread;
+		}
+		case WAIT_EVENT:
+		{
+			rt_uint32_t set = ((struct rt_event*)th->wait_obj)->set & th->wait_set;
+			if(th->wait_option & RT_EVENT_FLAG_AND)
+				return set == th->wait_set;
+			return set != 0;
+		}
+		case WAIT_FS_HOLD:
+			return !_fs_hold;
+		default:
+			return 1;
+	}
+}
+
+/* called with _lock held, return RT_EOK when object is ready */
+static rt_err_t _wait(uint8_t kind, void* obj, rt_uint32_t set, rt_uint8_t option, rt_int32_t time)
+{
+	host_thread_t* th = _thread_self();
+	struct timespec deadline;
+	rt_err_t res = RT_EOK;
+
+	th->wait_kind = kind;
+	th->wait_obj = obj;
+	th->wait_set = set;
+	th->wait_option = option;
+	if(_ready(th)){
+		th->wait_kind = WAIT_NONE;
+		return RT_EOK;
+	}
+	if(time == RT_WAITING_NO){
+		th->wait_kind = WAIT_NONE;
+		return -RT_ETIMEOUT;
+	}
+	if(_critical_nest){
+		fprintf(stderr, "rt_host: thread %s blocks inside a critical section\n", th->thread.name);
+		abort();
+	}
+
+	clock_gettime(CLOCK_REALTIME, &deadline);
+	if(time > 0){
+		deadline.tv_sec += time/1000;
+		deadline.tv_nsec += (time%1000)*1000000;
+		if(deadline.tv_nsec >= 1000000000){
+			deadline.tv_nsec -= 1000000000;
+			deadline.tv_sec++;
+		}
+	}
+	/* wait_idle watches blocked threads */
+	pthread_cond_broadcast(&_cond);
+	while(!_ready(th)){
+		if(time < 0){
+			pthread_cond_wait(&_cond, &_lock);
+		}else if(pthread_cond_timedwait(&_cond, &_lock, &deadline) != 0 && !_ready(th)){
+			res = -RT_ETIMEOUT;
+			break;
+		}
+	}
+	th->wait_kind = WAIT_NONE;
+
+	return res;
+}
+
+static void* _thread_entry(void* arg)
+{
+	host_thread_t* th = (host_thread_t*)arg;
+
+	_self = th;
+	th->entry(th->parameter);
+
+	return NULL;
+}
+
+void rt_host_thread_start(const char* name, void (*entry)(void* parameter), void* parameter)
+{
+	host_thread_t* th;
+
+	pthread_mutex_lock(&_lock);
+	if(_thread_num >= HOST_THREAD_MAX){
+		fprintf(stderr, "rt_host: too many threads\n");
+		abort();
+	}
+	th = &_thread[_thread_num++];
+	memset(th, 0, sizeof(host_thread_t));
+	strncpy(th->thread.name, name, RT_NAME_MAX-1);
+	th->entry = entry;
+	th->parameter = parameter;
+	pthread_create(&th->tid, NULL, _thread_entry, th);
+	pthread_mutex_unlock(&_lock);
+}
+
+void rt_host_advance(uint32_t us)
+{
+	uint64_t end = _now_us + us;
+
+	/* fire timers in time order, like the timer thread does */
+	while(1){
+		uint64_t next = end;
+		int idx = -1;
+
+		pthread_mutex_lock(&_lock);
+		for(uint32_t i = 0 ; i < _timer_num ; i++){
+			uint64_t t = (uint64_t)_timer[i]->timeout_tick*1000;
+
+			if(_timer_run[i] && t <= next){
+				next = t;
+				idx = i;
+			}
+		}
+		_now_us = next;
+		if(idx >= 0)
+			_timer[idx]->timeout_tick += _timer[idx]->init_tick ? _timer[idx]->init_tick : 1;
+		pthread_mutex_unlock(&_lock);
+
+		if(idx < 0)
+			break;
+		_timer[idx]->timeout_func(_timer[idx]->parameter);
+	}
+}
+
+void rt_host_wait_idle(void)
+{
+	pthread_mutex_lock(&_lock);
+	while(1){
+		struct timespec t;
+		uint32_t i;
+
+		for(i = 0 ; i < _thread_num ; i++){
+			if(_thread[i].wait_kind == WAIT_NONE || _ready(&_thread[i]))
+				break;
+		}
+		if(i == _thread_num)
+			break;
+		/* a running thread does not always signal, poll it */
+		clock_gettime(CLOCK_REALTIME, &t);
+		t.tv_nsec += 200000;
+		if(t.tv_nsec >= 1000000000){
+			t.tv_nsec -= 1000000000;
+			t.tv_sec++;
+		}
+		pthread_cond_timedwait(&_cond, &_lock, &t);
+	}
+	pthread_mutex_unlock(&_lock);
+}
+
+void rt_host_set_verbose(uint8_t verbose)
+{
+	_verbose = verbose;
+}
+
+void rt_host_fs_set_rate(uint32_t rate)
+{
+	_fs_rate = rate;
+}
+
+void rt_host_fs_set_error(uint8_t error)
+{
+	_fs_error = error;
+}
+
+void rt_host_fs_set_hold(uint8_t hold)
+{
+	pthread_mutex_lock(&_lock);
+	_fs_hold = hold;
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_lock);
+}
+
+uint64_t rt_host_fs_write_bytes(void)
+{
+	return _fs_write_bytes;
+}
+
+/* kernel */
+static void _critical_init(void)
+{
+	pthread_mutexattr_t attr;
+
+	pthread_mutexattr_init(&attr);
+	pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+	pthread_mutex_init(&_critical, &attr);
+}
+
+void rt_enter_critical(void)
+{
+	pthread_once(&_critical_once, _critical_init);
+	pthread_mutex_lock(&_critical);
+	_critical_nest++;
+}
+
+void rt_exit_critical(void)
+{
+	_critical_nest--;
+	pthread_mutex_unlock(&_critical);
+}
+
+void* rt_malloc(rt_size_t nbytes)
+{
+	return malloc(nbytes);
+}
+
+void rt_free(void* ptr)
+{
+	free(ptr);
+}
+
+rt_thread_t rt_thread_self(void)
+{
+	return &_thread_self()->thread;
+}
+
+rt_tick_t rt_tick_get(void)
+{
+	return _now_us/1000;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+	if(_critical_nest){
+		fprintf(stderr, "rt_host: thread %s sleeps inside a critical section\n", _thread_self()->thread.name);
+		abort();
+	}
+	usleep(tick*1000);
+
+	return RT_EOK;
+}
+
+rt_err_t rt_sem_init(rt_sem_t sem, const char* name, rt_uint32_t value, rt_uint8_t flag)
+{
+	(void)name;
+	(void)flag;
+	memset(sem, 0, sizeof(struct rt_semaphore));
+	sem->value = value;
+
+	return RT_EOK;
+}
+
+rt_err_t rt_sem_take(rt_sem_t sem, rt_int32_t time)
+{
+	rt_err_t res;
+
+	pthread_mutex_lock(&_lock);
+	res = _wait(WAIT_SEM, sem, 0, 0, time);
+	if(res == RT_EOK)
+		sem->value--;
+	pthread_mutex_unlock(&_lock);
+
+	return res;
+}
+
+rt_err_t rt_sem_trytake(rt_sem_t sem)
+{
+	return rt_sem_take(sem, RT_WAITING_NO);
+}
+
+rt_err_t rt_sem_release(rt_sem_t sem)
+{
+	pthread_mutex_lock(&_lock);
+	sem->value++;
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_lock);
+
+	return RT_EOK;
+}
+
+rt_err_t rt_mutex_init(rt_mutex_t mutex, const char* name, rt_uint8_t flag)
+{
+	(void)name;
+	(void)flag;
+	memset(mutex, 0, sizeof(struct rt_mutex));
+
+	return RT_EOK;
+}
+
+/* recursive, as rt_mutex is */
+rt_err_t rt_mutex_take(rt_mutex_t mutex, rt_int32_t time)
+{
+	rt_err_t res;
+
+	pthread_mutex_lock(&_lock);
+	res = _wait(WAIT_MUTEX, mutex, 0, 0, time);
+	if(res == RT_EOK){
+		mutex->owner = rt_thread_self();
+		mutex->hold++;
+	}
+	pthread_mutex_unlock(&_lock);
+
+	return res;
+}
+
+rt_err_t rt_mutex_release(rt_mutex_t mutex)
+{
+	rt_err_t res = RT_EOK;
+
+	pthread_mutex_lock(&_lock);
+	if(mutex->owner != rt_thread_self()){
+		res = -RT_ERROR;
+	}else if(--mutex->hold == 0){
+		mutex->owner = NULL;
+		pthread_cond_broadcast(&_cond);
+	}
+	pthread_mutex_unlock(&_lock);
+
+	return res;
+}
+
+rt_err_t rt_event_init(rt_event_t event, const char* name, rt_uint8_t flag)
+{
+	(void)name;
+	(void)flag;
+	memset(event, 0, sizeof(struct rt_event));
+
+	return RT_EOK;
+}
+
+rt_err_t rt_event_send(rt_event_t event, rt_uint32_t set)
+{
+	pthread_mutex_lock(&_lock);
+	event->set |= set;
+	pthread_cond_broadcast(&_cond);
+	pthread_mutex_unlock(&_lock);
+
+	return RT_EOK;
+}
+
+rt_err_t rt_event_recv(rt_event_t event, rt_uint32_t set, rt_uint8_t option, rt_int32_t timeout, rt_uint32_t* recved)
+{
+	rt_err_t res;
+
+	pthread_mutex_lock(&_lock);
+	res = _wait(WAIT_EVENT, event, set, option, timeout);
+	if(res == RT_EOK){
+		if(recved)
+			*recved = event->set & set;
+		if(option & RT_EVENT_FLAG_CLEAR)
+			event->set &= ~set;
+	}
+	pthread_mutex_unlock(&_lock);
+
+	return res;
+}
+
+void rt_timer_init(rt_timer_t timer, const char* name, void (*timeout)(void* parameter), void* parameter,
+					rt_tick_t time, rt_uint8_t flag)
+{
+	(void)name;
+	(void)flag;
+	memset(timer, 0, sizeof(struct rt_timer));
+	timer->timeout_func = timeout;
+	timer->parameter = parameter;
+	timer->init_tick = time;
+
+	pthread_mutex_lock(&_lock);
+	if(_timer_num >= HOST_TIMER_MAX){
+		fprintf(stderr, "rt_host: too many timers\n");
+		abort();
+	}
+	_timer[_timer_num++] = timer;
+	pthread_mutex_unlock(&_lock);
+}
+
+static int _timer_index(rt_timer_t timer)
+{
+	for(uint32_t i = 0 ; i < _timer_num ; i++){
+		if(_timer[i] == timer)
+			return i;
+	}
+	return -1;
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+	int i;
+
+	pthread_mutex_lock(&_lock);
+	i = _timer_index(timer);
+	if(i >= 0){
+		timer->timeout_tick = _now_us/1000 + timer->init_tick;
+		_timer_run[i] = 1;
+	}
+	pthread_mutex_unlock(&_lock);
+
+	return i >= 0 ? RT_EOK : -RT_ERROR;
+}
+
+rt_err_t rt_timer_stop(rt_timer_t timer)
+{
+	int i;
+
+	pthread_mutex_lock(&_lock);
+	i = _timer_index(timer);
+	if(i >= 0)
+		_timer_run[i] = 0;
+	pthread_mutex_unlock(&_lock);
+
+	return i >= 0 ? RT_EOK : -RT_ERROR;
+}
+
+rt_err_t rt_timer_control(rt_timer_t timer, rt_uint8_t cmd, void* arg)
+{
+	if(cmd == RT_TIMER_CTRL_SET_TIME)
+		timer->init_tick = *(rt_tick_t*)arg;
+
+	return RT_EOK;
+}
+
+/* framework */
+uint64_t time_nowUs(void)
+{
+	return _now_us;
+}
+
+uint32_t time_nowMs(void)
+{
+	return _now_us/1000;
+}
+
+static void _print(const char* fmt, ...)
+{
+	va_list args;
+
+	if(!_verbose)
+		return;
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+static void _print_tag(char* tag, const char* fmt, ...)
+{
+	va_list args;
+
+	printf("[%s] ", tag);
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+CONSOLE_Typedef Console = {.e = _print_tag, .w = _print_tag, .print = _print};
+
+uint8_t fm_init_complete(void)
+{
+	return 1;
+}
+
+/* FatFs on host files, FILE pointer is kept in fs */
+static const char* _host_path(const TCHAR* path)
+{
+	if(path[0] && path[1] == ':')
+		path += 2;
+	while(*path == '/')
+		path++;
+
+	return path;
+}
+
+FRESULT f_open(FIL* fp, const TCHAR* path, BYTE mode)
+{
+	const char* name = _host_path(path);
+	struct stat st;
+	FILE* f;
+
+	memset(fp, 0, sizeof(FIL));
+	if(mode & FA_CREATE_ALWAYS){
+		f = fopen(name, (mode & FA_READ) ? "w+b" : "wb");
+	}else if(stat(name, &st) != 0){
+		if(!(mode & FA_OPEN_ALWAYS))
+			return FR_NO_FILE;
+		f = fopen(name, "w+b");
+	}else{
+		f = fopen(name, (mode & FA_WRITE) ? "r+b" : "rb");
+	}
+	if(f == NULL)
+		return FR_DENIED;
+
+	fseek(f, 0, SEEK_END);
+	fp->fsize = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	fp->fs = (FATFS*)f;
+	fp->flag = mode;
+
+	return FR_OK;
+}
+
+FRESULT f_close(FIL* fp)
+{
+	if(fp->fs == NULL)
+		return FR_INVALID_OBJECT;
+	fclose((FILE*)fp->fs);
+	fp->fs = NULL;
+
+	return FR_OK;
+}
+
+FRESULT f_read(FIL* fp, void* buff, UINT btr, UINT* br)
+{
+	if(fp->fs == NULL)
+		return FR_INVALID_OBJECT;
+	*br = fread(buff, 1, btr, (FILE*)fp->fs);
+	fp->fptr += *br;
+
+	return FR_OK;
+}
+
+FRESULT f_write(FIL* fp, const void* buff, UINT btw, UINT* bw)
+{
+	*bw = 0;
+	if(fp->fs == NULL)
+		return FR_INVALID_OBJECT;
+	if(_fs_hold){
+		/* blocked like on a kernel object, so rt_host_wait_idle() does not wait for it */
+		pthread_mutex_lock(&_lock);
+		_wait(WAIT_FS_HOLD, NULL, 0, 0, RT_WAITING_FOREVER);
+		pthread_mutex_unlock(&_lock);
+	}
+	if(_fs_error)
+		return FR_DISK_ERR;
+	if(_fs_rate)
+		usleep((uint64_t)btw*1000000/_fs_rate);
+	*bw = fwrite(buff, 1, btw, (FILE*)fp->fs);
+	fp->fptr += *bw;
+	if(fp->fptr > fp->fsize)
+		fp->fsize = fp->fptr;
+	_fs_write_bytes += *bw;
+
+	return FR_OK;
+}
+
+int f_printf(FIL* fp, const TCHAR* str, ...)
+{
+	char buff[256];
+	va_list args;
+	UINT bw;
+	int len;
+
+	va_start(args, str);
+	len = vsnprintf(buff, sizeof(buff), str, args);
+	va_end(args);
+	if(len < 0)
+		return EOF;
+	if(len >= (int)sizeof(buff))
+		len = sizeof(buff) - 1;
+	if(f_write(fp, buff, len, &bw) != FR_OK || bw != (UINT)len)
+		return EOF;
+
+	return len;
+}
+
+FRESULT f_lseek(FIL* fp, DWORD ofs)
+{
+	if(fp->fs == NULL)
+		return FR_INVALID_OBJECT;
+	if(fseek((FILE*)fp->fs, ofs, SEEK_SET) != 0)
+		return FR_DISK_ERR;
+	fp->fptr = ofs;
+
+	return FR_OK;
+}
+
+FRESULT f_sync(FIL* fp)
+{
+	if(fp->fs == NULL)
+		return FR_INVALID_OBJECT;
+	if(_fs_error)
+		return FR_DISK_ERR;
+	fflush((FILE*)fp->fs);
+
+	return FR_OK;
+}
+
+FRESULT f_stat(const TCHAR* path, FILINFO* fno)
+{
+	struct stat st;
+
+	if(stat(_host_path(path), &st) != 0)
+		return FR_NO_FILE;
+	memset(fno, 0, sizeof(FILINFO));
+	fno->fsize = st.st_size;
+
+	return FR_OK;
+}
+
+FRESULT f_unlink(const TCHAR* path)
+{
+	return remove(_host_path(path)) == 0 ? FR_OK : FR_NO_FILE;
+}
+
+FRESULT f_rename(const TCHAR* path_old, const TCHAR* path_new)
+{
+	return rename(_host_path(path_old), _host_path(path_new)) == 0 ? FR_OK : FR_NO_FILE;
+}
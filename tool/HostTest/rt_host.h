@@ -0,0 +1,42 @@
+/*
+ * File      : rt_host.h
+ *
+ * Host shim of the rt-thread and FatFs calls used by the framework, so that
+ * modules like logger and log writer run unchanged on pthreads in the host
+ * tests. All kernel objects share one lock. Time is virtual and only moves
+ * by rt_host_advance(), which also fires started timers. Files are host
+ * files under the current directory.
+ *
+ * A blocking call inside rt_enter_critical() aborts the test, since it
+ * would break the scheduler lock on target.
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#ifndef __RT_HOST_H__
+#define __RT_HOST_H__
+
+#include <stdint.h>
+#include <rtthread.h>
+
+/* start a kernel thread on a pthread */
+void rt_host_thread_start(const char* name, void (*entry)(void* parameter), void* parameter);
+/* move virtual time forward and run timers in the calling thread */
+void rt_host_advance(uint32_t us);
+/* wait until every kernel thread is blocked on an object which is not ready */
+void rt_host_wait_idle(void);
+/* 0 to drop Console.print output, errors are always printed */
+void rt_host_set_verbose(uint8_t verbose);
+/* throttle f_write to rate bytes/s of real time, 0 for no limit */
+void rt_host_fs_set_rate(uint32_t rate);
+/* f_write and f_sync fail with FR_DISK_ERR while error is set */
+void rt_host_fs_set_error(uint8_t error);
+/* f_write blocks while hold is set, like a card stuck in a long erase. The
+ * writing thread counts as blocked for rt_host_wait_idle() */
+void rt_host_fs_set_hold(uint8_t hold);
+/* bytes written by f_write and f_printf since start */
+uint64_t rt_host_fs_write_bytes(void);
+
+#endif
@@ -0,0 +1,229 @@
+/*
+ * File      : sd_test.c
+ *
+ * Host test of the FatFs glue in diskio.c against a simulated SD card. The
+ * card is a RAM disk with a timing model on a virtual us clock: 25us per
+ * command, 42.7us per block (4 bit, 24MHz), 300us + 15us per block of write
+ * programming, CMD13 busy polling up to 32 times and then 1ms tick sleeps,
+ * as in SD_ReadDisk/SD_WriteDisk. Log files are written with f_write of
+ * aligned and unaligned buffers and f_sync every 64 writes, then read back
+ * and verified. A DMA transfer on an unaligned buffer fails the test.
+ * Throughput, worst f_write latency, transfer and command counts are printed.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/RTOS/include -I$S/Driver/include -I$S/Library/Fatfs
+ *            -I$S/Library/STM_Lib/CMSIS/Include -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include
+ *            -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o sd_test sd_test.c $S/Library/Fatfs/ff.c $S/Library/Fatfs/diskio.c
+ * usage: sd_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include "sdio.h"
+#include "ff.h"
+
+#define DISK_SECTORS	(64*1024*2)
+#define LOG_SIZE		(2*1024*1024)
+#define MAX_CHUNK		16384
+
+#define T_CMD			25.0		/* one command and response */
+#define T_BLOCK			42.7		/* 512 bytes on 4 bit bus at 24MHz */
+#define T_PROG			300.0		/* write programming busy per write command */
+#define T_PROG_BLK		15.0		/* extra busy per block */
+#define T_ISR			5.0			/* transfer end interrupt and semaphore */
+#define BUSY_POLL_NUM	32
+
+static uint32_t _fail;
+static uint8_t* _disk;
+static double _clock_us;
+static unsigned long _cmd_cnt;
+static unsigned long _xfer_cnt;
+static FATFS _fs;
+static FIL _fp;
+static uint8_t _src[MAX_CHUNK+8];
+static uint8_t _dst[MAX_CHUNK+8];
+
+SD_CardInfo SDCardInfo;
+
+static void _tick_sleep(void)
+{
+	_clock_us = (double)((uint64_t)(_clock_us/1000.0) + 1)*1000.0;
+}
+
+/* CMD13 until the card leaves programming state */
+static void _busy_wait(double ready)
+{
+	int poll = 0;
+
+	do{
+		if(++poll > BUSY_POLL_NUM)
+			_tick_sleep();
+		_clock_us += T_CMD;
+		_cmd_cnt++;
+	}while(_clock_us < ready);
+}
+
+static SD_Error _transfer(uint8_t* buf, uint32_t sector, uint32_t count, int write)
+{
+	if(((uintptr_t)buf & 3) != 0){
+		printf("unaligned DMA %s at sector %u\n", write ? "write" : "read", sector);
+		_fail++;
+	}
+	if(sector + count > DISK_SECTORS){
+		printf("sector %u out of range\n", sector + count);
+		exit(1);
+	}
+
+	_xfer_cnt++;
+	/* multi block: block length, (ACMD23), CMD18/25 and CMD12 */
+	if(count > 1){
+		_clock_us += T_CMD*(write ? 4 : 3);
+		_cmd_cnt += write ? 4 : 3;
+	}else{
+		_clock_us += T_CMD*2;
+		_cmd_cnt += 2;
+	}
+	_clock_us += T_BLOCK*count + T_ISR;
+	if(write)
+		memcpy(_disk + sector*512, buf, count*512);
+	else
+		memcpy(buf, _disk + sector*512, count*512);
+	_busy_wait(_clock_us + (write ? T_PROG + T_PROG_BLK*count : 0.0));
+
+	return SD_OK;
+}
+
+/* driver calls used by diskio.c */
+SD_Error SD_ReadDisk(uint8_t* buf, uint32_t sector, uint32_t count)
+{
+	return _transfer(buf, sector, count, 0);
+}
+
+SD_Error SD_WriteDisk(const uint8_t* buf, uint32_t sector, uint32_t count)
+{
+	return _transfer((uint8_t*)buf, sector, count, 1);
+}
+
+SD_Error SD_Init(void)
+{
+	if(_disk == NULL)
+		_disk = calloc(DISK_SECTORS, 512);
+	SDCardInfo.CardType = SDIO_STD_CAPACITY_SD_CARD_V2_0;
+	SDCardInfo.CardCapacity = (uint64_t)DISK_SECTORS*512;
+	SDCardInfo.CardBlockSize = 512;
+
+	return SD_OK;
+}
+
+SDTransferState SD_GetStatus(void)
+{
+	return SD_TRANSFER_OK;
+}
+
+SD_Error SD_GetCardInfo(SD_CardInfo* cardinfo)
+{
+	*cardinfo = SDCardInfo;
+	return SD_OK;
+}
+
+/* single thread, volume lock is not needed */
+int ff_cre_syncobj(BYTE vol, _SYNC_t* sobj)
+{
+	(void)vol;
+	(void)sobj;
+	return 1;
+}
+
+int ff_del_syncobj(_SYNC_t sobj)
+{
+	(void)sobj;
+	return 1;
+}
+
+int ff_req_grant(_SYNC_t sobj)
+{
+	(void)sobj;
+	return 1;
+}
+
+void ff_rel_grant(_SYNC_t sobj)
+{
+	(void)sobj;
+}
+
+static void _log(const char* name, int chunk, int offset)
+{
+	static int file_id;
+	char file_name[32];
+	unsigned long cmd_cnt = _cmd_cnt;
+	unsigned long xfer_cnt = _xfer_cnt;
+	double worst = 0.0, start, t;
+	int bad = 0;
+	UINT bw, br;
+
+	sprintf(file_name, "0:/L%d.BIN", file_id++);
+	if(f_open(&_fp, file_name, FA_CREATE_ALWAYS | FA_WRITE) != FR_OK){
+		printf("%s open fail\n", file_name);
+		_fail++;
+		return;
+	}
+	start = _clock_us;
+	for(int w = 0 ; w < LOG_SIZE/chunk ; w++){
+		for(int i = 0 ; i < chunk ; i++)
+			_src[offset+i] = (uint8_t)(w*7 + i);
+		t = _clock_us;
+		if(f_write(&_fp, _src + offset, chunk, &bw) != FR_OK || bw != (UINT)chunk){
+			printf("%s write fail\n", name);
+			_fail++;
+			break;
+		}
+		if(_clock_us - t > worst)
+			worst = _clock_us - t;
+		if(w % 64 == 63)
+			f_sync(&_fp);
+	}
+	f_close(&_fp);
+	printf("%-18s %7.1f KB/s, worst f_write %6.0f us, %5lu transfers, %6lu cmds\n", name,
+			LOG_SIZE/1024.0/((_clock_us - start)*1e-6), worst, _xfer_cnt - xfer_cnt, _cmd_cnt - cmd_cnt);
+
+	f_open(&_fp, file_name, FA_READ);
+	start = _clock_us;
+	for(int w = 0 ; w < LOG_SIZE/chunk ; w++){
+		if(f_read(&_fp, _dst + offset, chunk, &br) != FR_OK || br != (UINT)chunk){
+			bad += chunk;
+			continue;
+		}
+		for(int i = 0 ; i < chunk ; i++)
+			bad += _dst[offset+i] != (uint8_t)(w*7 + i);
+	}
+	f_close(&_fp);
+	printf("%-18s %7.1f KB/s read, %d bad bytes\n", "", LOG_SIZE/1024.0/((_clock_us - start)*1e-6), bad);
+	if(bad)
+		_fail++;
+}
+
+int main(void)
+{
+	f_mount(&_fs, "0:", 0);
+	if(f_mkfs("0:", 0, 0) != FR_OK || f_mount(&_fs, "0:", 1) != FR_OK){
+		printf("mkfs fail\n");
+		return 1;
+	}
+
+	_log("4k aligned", 4096, 0);
+	_log("4k unaligned", 4096, 1);
+	_log("16k unaligned", 16384, 2);
+	_log("512 unaligned", 512, 3);
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,232 @@
+/*
+ * File      : starryio_test.c
+ *
+ * Fuzz test and benchmark of the STARRYIO frame codec. Random frames are
+ * encoded into one stream and fed to the decoder in random 1..128 byte
+ * chunks, as DMA delivers them: clean, with 0xFA rich garbage between frames
+ * and with random bit flips. Every decoded frame must match a sent frame in
+ * order, with word aligned data, and none may be lost unless a bit flip hit
+ * it. Pure random input must not produce a frame. Then encode, decode and
+ * crc speed are measured.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -I$S/Library/starryio -o starryio_test starryio_test.c $S/Library/starryio/starryio_frame.c
+ * usage: starryio_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include "starryio_frame.h"
+
+#define FRAME_NUM		100000
+#define RANDOM_SIZE		(8*1024*1024)
+#define BENCH_NUM		FRAME_NUM
+#define CMD_BENCH		4
+
+typedef struct
+{
+	uint8_t		cmd;
+	uint16_t	len;
+	uint8_t		data[STARRYIO_FRAME_MAX_DATA];
+}ref_frame_t;
+
+static uint32_t _fail;
+static uint32_t _rand_state;
+static ref_frame_t _ref[FRAME_NUM];
+static uint8_t _stream[FRAME_NUM*(STARRYIO_FRAME_MAX_SIZE+16)];
+static int _next_ref;
+static int _match_cnt;
+static int _false_cnt;
+static int _unaligned_cnt;
+static volatile uint32_t _sink;
+
+static uint32_t _rand(void)
+{
+	_rand_state ^= _rand_state << 13;
+	_rand_state ^= _rand_state >> 17;
+	_rand_state ^= _rand_state << 5;
+	return _rand_state;
+}
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+/* a frame must match one of the next sent frames, a lost frame may be skipped */
+static void _fuzz_handler(const starryio_frame_t* frame)
+{
+	if(((uintptr_t)frame->data & 3) != 0)
+		_unaligned_cnt++;
+	for(int i = _next_ref ; i < FRAME_NUM && i < _next_ref + 64 ; i++){
+		if(_ref[i].cmd == frame->cmd && _ref[i].len == frame->len && memcmp(_ref[i].data, frame->data, frame->len) == 0){
+			_next_ref = i + 1;
+			_match_cnt++;
+			return;
+		}
+	}
+	_false_cnt++;
+}
+
+static void _bench_handler(const starryio_frame_t* frame)
+{
+	_sink += frame->len;
+}
+
+/* feed the stream in random chunks */
+static void _decode(starryio_decoder_t* dec, const uint8_t* stream, size_t size)
+{
+	size_t pos = 0, chunk;
+
+	while(pos < size){
+		chunk = 1 + _rand() % 128;
+		if(pos + chunk > size)
+			chunk = size - pos;
+		starryio_frame_input(dec, &stream[pos], chunk, _fuzz_handler);
+		pos += chunk;
+	}
+}
+
+/* mode 0: clean, 1: garbage between frames, 2: garbage and bit flips */
+static void _fuzz(int mode)
+{
+	starryio_decoder_t dec;
+	size_t size = 0;
+	uint16_t frame_size;
+	int flip_num = 0;
+
+	_rand_state = 12345 + mode;
+	for(int i = 0 ; i < FRAME_NUM ; i++){
+		_ref[i].cmd = _rand();
+		/* mostly short frames as on the link, some up to the max */
+		_ref[i].len = (_rand() % 4 == 0) ? _rand() % (STARRYIO_FRAME_MAX_DATA+1) : _rand() % 40;
+		for(int k = 0 ; k < _ref[i].len ; k++)
+			_ref[i].data[k] = (_rand() % 5 == 0) ? STARRYIO_FRAME_HEAD : _rand();
+
+		frame_size = starryio_frame_encode(&_stream[size], STARRYIO_FRAME_MAX_SIZE, STARRYIO_HEAD_IO,
+											_ref[i].cmd, _ref[i].data, _ref[i].len);
+		if(frame_size != _ref[i].len + STARRYIO_FRAME_OVERHEAD){
+			printf("encode size %d, expect %d\n", frame_size, _ref[i].len + STARRYIO_FRAME_OVERHEAD);
+			_fail++;
+		}
+		size += frame_size;
+
+		if(mode >= 1 && _rand() % 4 == 0){
+			int garbage = _rand() % 16;
+			for(int k = 0 ; k < garbage ; k++)
+				_stream[size++] = (_rand() % 3 == 0) ? STARRYIO_FRAME_HEAD : _rand();
+		}
+	}
+	if(mode == 2){
+		for(flip_num = 0 ; flip_num < FRAME_NUM/10 ; flip_num++)
+			_stream[_rand() % size] ^= 1 << (_rand() % 8);
+	}
+
+	starryio_decoder_init(&dec, STARRYIO_HEAD_IO);
+	_next_ref = _match_cnt = _false_cnt = _unaligned_cnt = 0;
+	_decode(&dec, _stream, size);
+
+	printf("mode %d: %d frames, decoded %d, false %d, crc err %u, dropped bytes %u, bit flips %d\n",
+			mode, FRAME_NUM, _match_cnt, _false_cnt, dec.err_cnt, dec.drop_cnt, flip_num);
+	if(_false_cnt || _unaligned_cnt || (mode < 2 && _match_cnt != FRAME_NUM))
+		_fail++;
+}
+
+static void _fuzz_random(void)
+{
+	starryio_decoder_t dec;
+
+	_rand_state = 777;
+	for(int k = 0 ; k < RANDOM_SIZE ; k++){
+		uint32_t r = _rand() % 7;
+		_stream[k] = r == 0 ? STARRYIO_FRAME_HEAD : (r == 1 ? STARRYIO_HEAD_IO : _rand());
+	}
+	starryio_decoder_init(&dec, STARRYIO_HEAD_IO);
+	_next_ref = FRAME_NUM;
+	_match_cnt = _false_cnt = 0;
+	_decode(&dec, _stream, RANDOM_SIZE);
+
+	printf("random %d MB: accepted %d, crc err %u, dropped bytes %u\n", RANDOM_SIZE >> 20,
+			_match_cnt + _false_cnt, dec.err_cnt, dec.drop_cnt);
+	if(_match_cnt + _false_cnt)
+		_fail++;
+}
+
+static void _check_encode_limit(void)
+{
+	uint8_t buff[STARRYIO_FRAME_MAX_SIZE+8] = {0};
+
+	if(starryio_frame_encode(buff, sizeof(buff), STARRYIO_HEAD_FMU, 1, buff, STARRYIO_FRAME_MAX_DATA+1) != 0
+		|| starryio_frame_encode(buff, 10, STARRYIO_HEAD_FMU, 1, buff, 3) != 0
+		|| starryio_frame_encode(buff, 11, STARRYIO_HEAD_FMU, 1, buff, 3) != 11){
+		printf("encode limit check fail\n");
+		_fail++;
+	}
+}
+
+static void _bench(uint16_t len)
+{
+	starryio_decoder_t dec;
+	uint8_t data[STARRYIO_FRAME_MAX_DATA];
+	size_t size = 0, chunk;
+	double encode_ns, decode_ns;
+	uint64_t start;
+
+	for(int i = 0 ; i < len ; i++)
+		data[i] = i*7;
+
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_NUM ; i++)
+		_sink += starryio_frame_encode(_stream, STARRYIO_FRAME_MAX_SIZE, STARRYIO_HEAD_FMU, CMD_BENCH, data, len);
+	encode_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	for(int i = 0 ; i < BENCH_NUM ; i++)
+		size += starryio_frame_encode(&_stream[size], STARRYIO_FRAME_MAX_SIZE, STARRYIO_HEAD_FMU, CMD_BENCH, data, len);
+
+	/* 64 byte chunks, as the fmu rx thread reads them */
+	starryio_decoder_init(&dec, STARRYIO_HEAD_FMU);
+	start = _now_ns();
+	for(size_t pos = 0 ; pos < size ; pos += chunk){
+		chunk = size - pos < 64 ? size - pos : 64;
+		starryio_frame_input(&dec, &_stream[pos], chunk, _bench_handler);
+	}
+	decode_ns = (double)(_now_ns() - start)/BENCH_NUM;
+
+	printf("len %3d: encode %6.1f ns, decode %6.1f ns (%.2f Mframe/s)\n", len, encode_ns, decode_ns, 1e3/decode_ns);
+	if(dec.frame_cnt != BENCH_NUM){
+		printf("decoded %u of %d frames\n", dec.frame_cnt, BENCH_NUM);
+		_fail++;
+	}
+}
+
+int main(void)
+{
+	uint64_t start;
+
+	for(int mode = 0 ; mode < 3 ; mode++)
+		_fuzz(mode);
+	_fuzz_random();
+	_check_encode_limit();
+
+	printf("\n");
+	_bench(4);
+	_bench(32);
+	_bench(STARRYIO_FRAME_MAX_DATA);
+	start = _now_ns();
+	_sink += starryio_crc16(0xFFFF, _stream, RANDOM_SIZE);
+	printf("crc16: %.2f ns/byte\n", (double)(_now_ns() - start)/RANDOM_SIZE);
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
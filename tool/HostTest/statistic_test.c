@@ -0,0 +1,311 @@
+/*
+ * File      : statistic_test.c
+ *
+ * Host test of the per-thread accounting in statistic.c. The scheduler hooks
+ * are driven directly on a fake us clock by synthetic threads: fastloop is
+ * made ready every 1ms and runs 200us after 30us, copter every 5ms and runs
+ * 500us after 100us, idle runs otherwise. Load, switch rate, latency, the
+ * log2 histogram, per-interval peak, running thread re-insert, untracked
+ * threads and reset are checked. Then the cost of the hooks is measured.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o statistic_test statistic_test.c $S/Framework/source/Statistic/statistic.c
+ * usage: statistic_test
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <string.h>
+#include <time.h>
+#include <stdint.h>
+#include <rtthread.h>
+#include <rthw.h>
+#include "statistic.h"
+#include "console.h"
+#include "uMCN.h"
+
+#define THREAD_NUM		(STAT_THREAD_MAX_NUM+4)
+#define IDLE			0
+#define FASTLOOP		1
+#define COPTER			2
+/* statistic starts after boot, time 0 would read as not made ready */
+#define START_US		1000000
+
+static uint32_t _fail;
+static uint64_t _now_us;
+static rt_thread_t _cur;
+static struct rt_thread _thread[THREAD_NUM];
+static void (*_switch_hook)(rt_thread_t from, rt_thread_t to);
+static void (*_insert_hook)(rt_thread_t thread);
+static void (*_timer_entry)(void* parameter);
+static sys_load_t _sys_load;
+static uint32_t _publish_cnt;
+
+/* kernel and module calls used by statistic.c */
+uint64_t time_nowUs(void)
+{
+	return _now_us;
+}
+
+rt_thread_t rt_thread_self(void)
+{
+	return _cur;
+}
+
+rt_base_t rt_hw_interrupt_disable(void)
+{
+	return 0;
+}
+
+void rt_hw_interrupt_enable(rt_base_t level)
+{
+	(void)level;
+}
+
+void rt_enter_critical(void)
+{
+}
+
+void rt_exit_critical(void)
+{
+}
+
+void rt_scheduler_sethook(void (*hook)(rt_thread_t from, rt_thread_t to))
+{
+	_switch_hook = hook;
+}
+
+void rt_scheduler_insert_sethook(void (*hook)(rt_thread_t thread))
+{
+	_insert_hook = hook;
+}
+
+void rt_thread_idle_sethook(void (*hook)(void))
+{
+	(void)hook;
+}
+
+rt_err_t rt_thread_delay(rt_tick_t tick)
+{
+	(void)tick;
+	return RT_EOK;
+}
+
+void rt_timer_init(rt_timer_t timer, const char* name, void (*timeout)(void* parameter), void* parameter,
+					rt_tick_t time, rt_uint8_t flag)
+{
+	(void)timer;
+	(void)name;
+	(void)parameter;
+	(void)time;
+	(void)flag;
+	_timer_entry = timeout;
+}
+
+rt_err_t rt_timer_start(rt_timer_t timer)
+{
+	(void)timer;
+	return RT_EOK;
+}
+
+void trace_sched_switch(rt_thread_t from, rt_thread_t to)
+{
+	(void)from;
+	(void)to;
+}
+
+void trace_sched_ready(rt_thread_t thread)
+{
+	(void)thread;
+}
+
+int mcn_advertise(McnHub* hub)
+{
+	(void)hub;
+	return 0;
+}
+
+int mcn_publish(McnHub* hub, const void* data)
+{
+	(void)hub;
+	memcpy(&_sys_load, data, sizeof(_sys_load));
+	_publish_cnt++;
+	return 0;
+}
+
+static void _print(const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+static void _print_tag(char* tag, const char* fmt, ...)
+{
+	va_list args;
+
+	printf("[%s] ", tag);
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+CONSOLE_Typedef Console = {.e = _print_tag, .w = _print_tag, .print = _print};
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000 + t.tv_nsec;
+}
+
+static void _ready(int n, uint64_t t)
+{
+	_now_us = t;
+	_insert_hook(&_thread[n]);
+}
+
+static void _run(int n, uint64_t t)
+{
+	rt_thread_t from = _cur;
+
+	_now_us = t;
+	_cur = &_thread[n];
+	_switch_hook(from, _cur);
+}
+
+static void _check(const char* what, long val, long expect)
+{
+	if(val != expect){
+		printf("%s: %ld, expect %ld\n", what, val, expect);
+		_fail++;
+	}
+}
+
+static const thread_load_t* _load(const char* name)
+{
+	for(int i = 0 ; i < _sys_load.thread_num ; i++){
+		if(strcmp(_sys_load.thread[i].name, name) == 0)
+			return &_sys_load.thread[i];
+	}
+	printf("%s is not in SYS_LOAD\n", name);
+	_fail++;
+	return &_sys_load.thread[0];
+}
+
+/* one statistic interval of the synthetic threads, copter waits copter_lat us */
+static void _interval(uint64_t start, uint32_t copter_lat)
+{
+	for(int ms = 0 ; ms < 500 ; ms++){
+		uint64_t base = start + ms*1000ull;
+
+		_ready(FASTLOOP, base);
+		_run(FASTLOOP, base + 30);
+		/* priority change of the running thread is not a wakeup */
+		_ready(FASTLOOP, base + 100);
+		_run(IDLE, base + 230);
+		if(ms % 5 == 0){
+			_ready(COPTER, base + 300);
+			_run(COPTER, base + 300 + copter_lat);
+			_run(IDLE, base + 800 + copter_lat);
+		}
+	}
+	_now_us = start + 500000;
+	_timer_entry(NULL);
+}
+
+int main(void)
+{
+	thread_stat_t stat;
+	const thread_load_t* load;
+	uint64_t start;
+	int loops = 10000000;
+
+	for(int i = 0 ; i < THREAD_NUM ; i++)
+		snprintf(_thread[i].name, RT_NAME_MAX, "t%d", i);
+	strcpy(_thread[IDLE].name, "tidle");
+	strcpy(_thread[FASTLOOP].name, "fastloop");
+	strcpy(_thread[COPTER].name, "copter");
+
+	_cur = &_thread[IDLE];
+	_now_us = START_US;
+	statistic_init();
+
+	_interval(START_US, 100);
+	_check("publish", _publish_cnt, 1);
+	_check("interval", _sys_load.interval_ms, 500);
+	load = _load("fastloop");
+	_check("fastloop load", load->load, 2000);
+	_check("fastloop switch rate", load->switch_rate, 1000);
+	_check("fastloop latency avg", load->latency_avg, 30);
+	_check("fastloop latency max", load->latency_max, 30);
+	load = _load("copter");
+	_check("copter load", load->load, 1000);
+	_check("copter switch rate", load->switch_rate, 200);
+	_check("copter latency avg", load->latency_avg, 100);
+	_check("copter latency max", load->latency_max, 100);
+	load = _load("tidle");
+	_check("idle load", load->load, 7000);
+	_check("idle switch rate", load->switch_rate, 1200);
+
+	/* 30us in [16, 31], 100us in [64, 127] */
+	statistic_get_thread_stat(FASTLOOP, &stat);
+	_check("fastloop hist[5]", stat.latency_hist[5], 500);
+	_check("fastloop wakeup", stat.wakeup_cnt, 500);
+	statistic_get_thread_stat(COPTER, &stat);
+	_check("copter hist[7]", stat.latency_hist[7], 100);
+
+	/* peak is per interval, max is kept */
+	_interval(START_US + 500000, 40);
+	load = _load("copter");
+	_check("copter latency max 2nd", load->latency_max, 40);
+	_check("copter latency avg 2nd", load->latency_avg, 40);
+	statistic_get_thread_stat(COPTER, &stat);
+	_check("copter total latency max", stat.latency_max, 100);
+	_check("copter hist[6]", stat.latency_hist[6], 100);
+
+	/* table is full after STAT_THREAD_MAX_NUM threads */
+	for(int i = COPTER+1 ; i < THREAD_NUM ; i++){
+		_ready(i, START_US + 1000000 + i*10);
+		_run(i, START_US + 1000000 + i*10 + 5);
+	}
+	_run(IDLE, START_US + 1000500);
+	_now_us = START_US + 1500000;
+	_timer_entry(NULL);
+	_check("thread num", _sys_load.thread_num, STAT_THREAD_MAX_NUM);
+	_check("untracked switch", _sys_load.untracked_switch, THREAD_NUM - STAT_THREAD_MAX_NUM);
+
+	statistic_show_thread();
+	statistic_show_histogram();
+
+	statistic_reset();
+	statistic_get_thread_stat(FASTLOOP, &stat);
+	_check("reset run time", (long)stat.run_time, 0);
+	_check("reset switch", stat.switch_cnt, 0);
+	_check("reset hist[5]", stat.latency_hist[5], 0);
+
+	/* one wakeup and two switches, as on each fastloop period */
+	start = _now_ns();
+	for(int i = 0 ; i < loops ; i++){
+		_now_us++;
+		_insert_hook(&_thread[FASTLOOP]);
+		_run(FASTLOOP, _now_us);
+		_run(IDLE, _now_us);
+	}
+	printf("\ninsert hook + 2 switch hooks: %.1f ns\n", (double)(_now_ns() - start)/loops);
+
+	printf("%s\n", _fail ? "FAIL" : "PASS");
+
+	return _fail != 0;
+}
@@ -0,0 +1,473 @@
+/*
+ * File      : umcn_test.c
+ *
+ * Host test of uMCN hubs, built with the real uMCN.c on pthreads. The
+ * scheduler lock of the critical hub mode is a global mutex here.
+ * stress: one publisher and several readers run on the same hub, every copy
+ *         must be a whole sample and samples must never go backward.
+ * queue:  readers pop a queued hub, every sample must arrive once and in
+ *         order. After the publisher stops each reader pops the rest, then
+ *         pops plus lost must equal publishes and skipped samples must match
+ *         the lost counter. Also run with a 2 kHz publisher drained every 4 ms.
+ * bench:  copy latency with and without a running publisher, and the
+ *         execution time of a 1 kHz fast loop while reader threads keep
+ *         copying, for the critical and the seqlock mode. Pop and copy
+ *         cost of a queued hub.
+ *
+ * build: S=../../starry_fmu
+ *        gcc -O2 -pthread -DSTM32F427X -DUSE_STDPERIPH_DRIVER -DARM_MATH_CM4 -D__FPU_PRESENT=1
+ *            -I$S/Project/sitl_posix -I$S/Framework/include -I$S/RTOS/include -I$S/RTOS/components/drivers/include
+ *            -I$S/HAL/include -I$S/Driver/include -I$S/Library/STM_Lib/CMSIS/Include
+ *            -I$S/Library/STM_Lib/CMSIS/Device/ST/STM32F4xx/Include -I$S/Library/STM_Lib/STM32F4xx_StdPeriph_Driver/inc
+ *            -o umcn_test umcn_test.c $S/Framework/source/uMCN/uMCN.c
+ * usage: umcn_test [seconds per test] [reader threads]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdarg.h>
+#include <string.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include "uMCN.h"
+#include "console.h"
+
+#define TOPIC_WORDS			16
+#define READER_MAX			8
+#define BENCH_COPY_NUM		2000000
+#define LOOP_SAMPLE_MAX		100000
+#define QUEUE_DEPTH			16
+
+typedef struct
+{
+	uint32_t seq;
+	uint32_t word[TOPIC_WORDS-1];
+}topic_t;
+
+MCN_DEFINE(TEST_CRITICAL, sizeof(topic_t));
+MCN_DEFINE_SEQLOCK(TEST_SEQLOCK, sizeof(topic_t));
+MCN_DEFINE(TEST_QUEUE, sizeof(topic_t));
+
+typedef struct
+{
+	McnHub* hub;
+	McnNode_t node;
+	uint64_t copy_cnt;
+	uint64_t torn_cnt;
+	uint64_t back_cnt;
+	uint64_t gap_cnt;			// samples skipped between two pops
+	uint64_t stamp_err;			// publish time went backward
+	uint32_t poll_us;			// 0 to pop as fast as possible
+	uint32_t last;				// seq and publish time of the last pop
+	uint32_t last_stamp;
+}reader_t;
+
+static pthread_mutex_t _sched_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile int _running;
+static volatile uint64_t _pub_cnt;
+
+/* stubs of what uMCN.c needs from rt-thread and the framework */
+void rt_enter_critical(void)
+{
+	pthread_mutex_lock(&_sched_lock);
+}
+
+void rt_exit_critical(void)
+{
+	pthread_mutex_unlock(&_sched_lock);
+}
+
+void* rt_malloc(rt_size_t size)
+{
+	return malloc(size);
+}
+
+void rt_free(void* ptr)
+{
+	free(ptr);
+}
+
+static uint64_t _now_ns(void)
+{
+	struct timespec t;
+
+	clock_gettime(CLOCK_MONOTONIC, &t);
+	return (uint64_t)t.tv_sec*1000000000ull + t.tv_nsec;
+}
+
+uint64_t time_nowUs(void)
+{
+	return _now_ns()/1000;
+}
+
+static void _print(const char* fmt, ...)
+{
+	va_list args;
+
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+static void _print_tag(char* tag, const char* fmt, ...)
+{
+	va_list args;
+
+	printf("[%s] ", tag);
+	va_start(args, fmt);
+	vprintf(fmt, args);
+	va_end(args);
+}
+
+CONSOLE_Typedef Console = {.e = _print_tag, .w = _print_tag, .print = _print};
+
+static void _make_topic(topic_t* t, uint32_t seq)
+{
+	t->seq = seq;
+	for(int i = 0 ; i < TOPIC_WORDS-1 ; i++)
+		t->word[i] = seq*2654435761u + i;
+}
+
+/* return 0 if all words come from the same sample */
+static int _check_topic(const topic_t* t)
+{
+	for(int i = 0 ; i < TOPIC_WORDS-1 ; i++){
+		if(t->word[i] != t->seq*2654435761u + i)
+			return 1;
+	}
+	return 0;
+}
+
+static void* _publisher(void* arg)
+{
+	McnHub* hub = (McnHub*)arg;
+	topic_t t;
+	uint32_t seq = 1;
+
+	while(_running){
+		_make_topic(&t, seq++);
+		mcn_publish(hub, &t);
+	}
+	_pub_cnt = seq - 1;
+
+	return NULL;
+}
+
+static void* _reader(void* arg)
+{
+	reader_t* r = (reader_t*)arg;
+	topic_t t;
+	uint32_t last = 0;
+
+	while(_running){
+		if(mcn_copy(r->hub, r->node, &t) != 0)
+			continue;
+		r->copy_cnt++;
+		if(_check_topic(&t))
+			r->torn_cnt++;
+		if(t.seq < last)
+			r->back_cnt++;
+		last = t.seq;
+	}
+
+	return NULL;
+}
+
+/* drain everything since the last poll, as a slow consumer does */
+static void _pop_all(reader_t* r)
+{
+	topic_t t;
+
+	while(mcn_pop(r->hub, r->node, &t) == 0){
+		r->copy_cnt++;
+		if(_check_topic(&t))
+			r->torn_cnt++;
+		if(t.seq <= r->last)
+			r->back_cnt++;
+		else
+			r->gap_cnt += t.seq - r->last - 1;
+		if(r->node->stamp < r->last_stamp)
+			r->stamp_err++;
+		r->last = t.seq;
+		r->last_stamp = r->node->stamp;
+	}
+}
+
+static void* _pop_reader(void* arg)
+{
+	reader_t* r = (reader_t*)arg;
+
+	while(_running){
+		_pop_all(r);
+		if(r->poll_us)
+			usleep(r->poll_us);
+	}
+
+	return NULL;
+}
+
+static void* _paced_publisher(void* arg)
+{
+	McnHub* hub = (McnHub*)arg;
+	struct timespec next;
+	topic_t t;
+	uint32_t seq = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	while(_running){
+		next.tv_nsec += 500000;
+		if(next.tv_nsec >= 1000000000){
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+		_make_topic(&t, seq++);
+		mcn_publish(hub, &t);
+	}
+	_pub_cnt = seq - 1;
+
+	return NULL;
+}
+
+/* poll_us 0: publisher and readers run flat out, samples are lost and must
+ * be counted. Otherwise 2 kHz publisher against readers polling every poll_us */
+static int _stress_queue(McnHub* hub, const char* name, int seconds, int reader_num, uint32_t poll_us)
+{
+	pthread_t pub, th[READER_MAX];
+	reader_t reader[READER_MAX];
+	uint64_t pop = 0, torn = 0, back = 0, gap = 0, lost = 0, stamp_err = 0;
+	int res = 0;
+
+	_running = 1;
+	for(int i = 0 ; i < reader_num ; i++){
+		memset(&reader[i], 0, sizeof(reader_t));
+		reader[i].hub = hub;
+		reader[i].node = mcn_subscribe(hub, NULL);
+		reader[i].poll_us = poll_us;
+		pthread_create(&th[i], NULL, _pop_reader, &reader[i]);
+	}
+	pthread_create(&pub, NULL, poll_us ? _paced_publisher : _publisher, hub);
+	sleep(seconds);
+	_running = 0;
+	pthread_join(pub, NULL);
+	for(int i = 0 ; i < reader_num ; i++){
+		pthread_join(th[i], NULL);
+		/* publisher has stopped, the rest of the queue is popped here */
+		_pop_all(&reader[i]);
+		/* every sample is popped once or counted as lost */
+		if(reader[i].copy_cnt + reader[i].node->lost != _pub_cnt || reader[i].gap_cnt != reader[i].node->lost){
+			printf("reader %d: %llu pops + %u lost, %llu skipped, expect %llu publishes\n", i,
+					(unsigned long long)reader[i].copy_cnt, reader[i].node->lost,
+					(unsigned long long)reader[i].gap_cnt, (unsigned long long)_pub_cnt);
+			res = 1;
+		}
+		pop += reader[i].copy_cnt;
+		torn += reader[i].torn_cnt;
+		back += reader[i].back_cnt;
+		gap += reader[i].gap_cnt;
+		lost += reader[i].node->lost;
+		stamp_err += reader[i].stamp_err;
+	}
+
+	printf("queue  %-8s: %llu publishes, %llu pops by %d readers, %llu skipped, %llu lost, %llu torn, %llu backward\n",
+			name, (unsigned long long)_pub_cnt, (unsigned long long)pop, reader_num, (unsigned long long)gap,
+			(unsigned long long)lost, (unsigned long long)torn, (unsigned long long)back);
+
+	/* lost depends on how the readers are scheduled, it is only reported */
+	if(torn || back || stamp_err)
+		res = 1;
+
+	return res;
+}
+
+static void _bench_queue(McnHub* hub, McnHub* single)
+{
+	McnNode_t node = mcn_subscribe(hub, NULL);
+	McnNode_t single_node = mcn_subscribe(single, NULL);
+	uint64_t start, pub_ns = 0, pop_ns = 0, copy_ns, single_ns;
+	topic_t t;
+
+	/* publish a queue full, then drain it */
+	for(int n = 0 ; n < BENCH_COPY_NUM/QUEUE_DEPTH ; n++){
+		start = _now_ns();
+		for(int i = 0 ; i < QUEUE_DEPTH ; i++)
+			mcn_publish(hub, &t);
+		pub_ns += _now_ns() - start;
+		start = _now_ns();
+		while(mcn_pop(hub, node, &t) == 0);
+		pop_ns += _now_ns() - start;
+	}
+
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_COPY_NUM ; i++)
+		mcn_copy(hub, node, &t);
+	copy_ns = _now_ns() - start;
+
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_COPY_NUM ; i++)
+		mcn_copy(single, single_node, &t);
+	single_ns = _now_ns() - start;
+
+	printf("queue  bench   : depth %d, %d bytes, publish %.1f ns, pop %.1f ns, copy newest %.1f ns (single slot %.1f ns)\n",
+			QUEUE_DEPTH, (int)sizeof(topic_t), (double)pub_ns/BENCH_COPY_NUM, (double)pop_ns/BENCH_COPY_NUM,
+			(double)copy_ns/BENCH_COPY_NUM, (double)single_ns/BENCH_COPY_NUM);
+}
+
+static int _stress(McnHub* hub, const char* name, int seconds, int reader_num)
+{
+	pthread_t pub, th[READER_MAX];
+	reader_t reader[READER_MAX];
+	uint64_t copy = 0, torn = 0, back = 0;
+	topic_t t;
+
+	_make_topic(&t, 0);
+	mcn_publish(hub, &t);
+	hub->retry = 0;
+
+	_running = 1;
+	for(int i = 0 ; i < reader_num ; i++){
+		memset(&reader[i], 0, sizeof(reader_t));
+		reader[i].hub = hub;
+		reader[i].node = mcn_subscribe(hub, NULL);
+		pthread_create(&th[i], NULL, _reader, &reader[i]);
+	}
+	pthread_create(&pub, NULL, _publisher, hub);
+	sleep(seconds);
+	_running = 0;
+	pthread_join(pub, NULL);
+	for(int i = 0 ; i < reader_num ; i++){
+		pthread_join(th[i], NULL);
+		copy += reader[i].copy_cnt;
+		torn += reader[i].torn_cnt;
+		back += reader[i].back_cnt;
+	}
+
+	printf("stress %-8s: %llu publishes, %llu copies by %d readers, %u retries, %llu torn, %llu backward\n", name,
+			(unsigned long long)_pub_cnt, (unsigned long long)copy, reader_num, hub->retry,
+			(unsigned long long)torn, (unsigned long long)back);
+
+	return torn || back ? 1 : 0;
+}
+
+static void _bench_copy(McnHub* hub, const char* name)
+{
+	McnNode_t node = mcn_subscribe(hub, NULL);
+	pthread_t pub;
+	topic_t t;
+	uint64_t start, idle_ns, busy_ns;
+
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_COPY_NUM ; i++)
+		mcn_copy(hub, node, &t);
+	idle_ns = _now_ns() - start;
+
+	_running = 1;
+	pthread_create(&pub, NULL, _publisher, hub);
+	start = _now_ns();
+	for(int i = 0 ; i < BENCH_COPY_NUM ; i++)
+		mcn_copy(hub, node, &t);
+	busy_ns = _now_ns() - start;
+	_running = 0;
+	pthread_join(pub, NULL);
+
+	printf("copy   %-8s: %.1f ns idle, %.1f ns with publisher running\n", name,
+			(double)idle_ns/BENCH_COPY_NUM, (double)busy_ns/BENCH_COPY_NUM);
+}
+
+static int _cmp_u32(const void* a, const void* b)
+{
+	uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+	return x < y ? -1 : x > y;
+}
+
+/* 1 kHz loop publishes the hub and copies it 4 times, as the fast loop does
+ * with gyr/acc/mag, while the readers keep copying the same hub */
+static void _bench_loop(McnHub* hub, const char* name, int seconds, int reader_num)
+{
+	static uint32_t exec[LOOP_SAMPLE_MAX];
+	pthread_t th[READER_MAX];
+	reader_t reader[READER_MAX];
+	McnNode_t node = mcn_subscribe(hub, NULL);
+	struct timespec next;
+	uint32_t loop_num = seconds*1000;
+	topic_t t;
+	uint64_t sum = 0;
+
+	if(loop_num > LOOP_SAMPLE_MAX)
+		loop_num = LOOP_SAMPLE_MAX;
+
+	_running = 1;
+	for(int i = 0 ; i < reader_num ; i++){
+		memset(&reader[i], 0, sizeof(reader_t));
+		reader[i].hub = hub;
+		reader[i].node = mcn_subscribe(hub, NULL);
+		pthread_create(&th[i], NULL, _reader, &reader[i]);
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &next);
+	for(uint32_t n = 0 ; n < loop_num ; n++){
+		uint64_t start;
+
+		next.tv_nsec += 1000000;
+		if(next.tv_nsec >= 1000000000){
+			next.tv_nsec -= 1000000000;
+			next.tv_sec++;
+		}
+		clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &next, NULL);
+
+		start = _now_ns();
+		_make_topic(&t, n);
+		mcn_publish(hub, &t);
+		for(int i = 0 ; i < 4 ; i++)
+			mcn_copy(hub, node, &t);
+		exec[n] = _now_ns() - start;
+		sum += exec[n];
+	}
+
+	_running = 0;
+	for(int i = 0 ; i < reader_num ; i++)
+		pthread_join(th[i], NULL);
+
+	qsort(exec, loop_num, sizeof(uint32_t), _cmp_u32);
+	printf("loop   %-8s: %u loops with %d readers, exec avg %.2f us, p99 %.2f us, p99.9 %.2f us, max %.2f us\n",
+			name, loop_num, reader_num, sum/1e3/loop_num, exec[loop_num*99/100]/1e3,
+			exec[loop_num*999/1000]/1e3, exec[loop_num-1]/1e3);
+}
+
+int main(int argc, char** argv)
+{
+	int seconds = argc > 1 ? atoi(argv[1]) : 2;
+	int reader_num = argc > 2 ? atoi(argv[2]) : 3;
+	int res = 0;
+
+	if(seconds < 1)
+		seconds = 1;
+	if(reader_num < 1 || reader_num > READER_MAX)
+		reader_num = 3;
+
+	mcn_advertise(MCN_ID(TEST_CRITICAL));
+	mcn_advertise(MCN_ID(TEST_SEQLOCK));
+	mcn_advertise_queue(MCN_ID(TEST_QUEUE), QUEUE_DEPTH);
+
+	res |= _stress(MCN_ID(TEST_CRITICAL), "critical", seconds, reader_num);
+	res |= _stress(MCN_ID(TEST_SEQLOCK), "seqlock", seconds, reader_num);
+	res |= _stress_queue(MCN_ID(TEST_QUEUE), "flat out", seconds, reader_num, 0);
+	res |= _stress_queue(MCN_ID(TEST_QUEUE), "4 ms poll", seconds, reader_num, 4000);
+
+	_bench_copy(MCN_ID(TEST_CRITICAL), "critical");
+	_bench_copy(MCN_ID(TEST_SEQLOCK), "seqlock");
+	_bench_queue(MCN_ID(TEST_QUEUE), MCN_ID(TEST_CRITICAL));
+
+	_bench_loop(MCN_ID(TEST_CRITICAL), "critical", seconds, reader_num);
+	_bench_loop(MCN_ID(TEST_SEQLOCK), "seqlock", seconds, reader_num);
+
+	printf(res ? "FAIL\n" : "PASS\n");
+
+	return res;
+}
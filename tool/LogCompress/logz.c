@@ -0,0 +1,346 @@
+/*
+ * File      : logz.c
+ *
+ * Host side tool of compressed log written by "logger start <file> [period] lzo|deflate".
+ * unpack restores the plain log which log_replay and log_parser read, pack and
+ * bench run the same block compression as the board on a plain log.
+ *
+ * build: gcc -O2 -I../../starry_fmu/RTOS/components/external/lzo -o logz logz.c
+ *            ../../starry_fmu/RTOS/components/external/lzo/minilzo.c -lz
+ * usage: logz unpack <compressed log> <plain log>
+ *        logz pack <plain log> <compressed log> [lzo|deflate]
+ *        logz bench <plain log>
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "minilzo.h"
+
+/* keep in sync with starry_fmu/Framework/include/logger.h, log_compress.h and log_writer.h */
+#define LOG_BLOCK_MAGIC				0x5A4C5053
+#define LOG_BUFFER_SIZE				8192
+#define LOG_COMPRESS_BOUND(_size)	((_size) + (_size)/16 + 64 + 3)
+
+/* keep in sync with starry_fmu/Framework/source/Logger/log_compress.c */
+#define DEFLATE_LEVEL				6
+#define DEFLATE_WINDOW_BITS			12
+#define DEFLATE_MEM_LEVEL			4
+
+enum
+{
+	LOG_COMPRESS_NONE = 0,
+	LOG_COMPRESS_LZO,
+	LOG_COMPRESS_DEFLATE,
+	LOG_COMPRESS_NUM,
+};
+
+static const char* _method_name[LOG_COMPRESS_NUM] = { "none", "lzo", "deflate" };
+
+#pragma pack(push, 1)
+typedef struct
+{
+	uint32_t	magic;
+	uint8_t		method;
+	uint8_t		reserved;
+	uint16_t	raw_size;
+	uint32_t	data_size;
+	uint32_t	raw_offset;
+}block_header_t;
+#pragma pack(pop)
+
+static uint8_t _lzo_wrkmem[LZO1X_1_MEM_COMPRESS];
+static z_stream _zs_deflate;
+static z_stream _zs_inflate;
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static uint8_t* _read_file(const char* name, long* size)
+{
+	FILE* fp = fopen(name, "rb");
+	uint8_t* buff;
+
+	if(fp == NULL){
+		fprintf(stderr, "can not open %s\n", name);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	*size = ftell(fp);
+	rewind(fp);
+	buff = malloc(*size ? *size : 1);
+	if(buff == NULL || fread(buff, 1, *size, fp) != (size_t)*size){
+		fprintf(stderr, "can not read %s\n", name);
+		free(buff);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+
+	return buff;
+}
+
+static int _codec_init(void)
+{
+	if(lzo_init() != LZO_E_OK)
+		return 1;
+	if(deflateInit2(&_zs_deflate, DEFLATE_LEVEL, Z_DEFLATED, -DEFLATE_WINDOW_BITS, DEFLATE_MEM_LEVEL,
+					Z_DEFAULT_STRATEGY) != Z_OK)
+		return 1;
+	/* 15 bits window inflates raw streams of any smaller window */
+	if(inflateInit2(&_zs_inflate, -15) != Z_OK)
+		return 1;
+
+	return 0;
+}
+
+/* same as log_compress_block() on board, 0 means store as it is */
+static uint32_t _compress(int method, const uint8_t* in, uint32_t in_size, uint8_t* out)
+{
+	if(method == LOG_COMPRESS_LZO){
+		lzo_uint out_len = LOG_COMPRESS_BOUND(in_size);
+
+		if(lzo1x_1_compress(in, in_size, out, &out_len, _lzo_wrkmem) != LZO_E_OK || out_len >= in_size)
+			return 0;
+		return out_len;
+	}
+	if(method == LOG_COMPRESS_DEFLATE){
+		deflateReset(&_zs_deflate);
+		_zs_deflate.next_in = (Bytef*)in;
+		_zs_deflate.avail_in = in_size;
+		_zs_deflate.next_out = out;
+		_zs_deflate.avail_out = in_size - 1;
+		if(deflate(&_zs_deflate, Z_FINISH) != Z_STREAM_END)
+			return 0;
+		return _zs_deflate.total_out;
+	}
+
+	return 0;
+}
+
+/* return 0 if out is filled with exactly raw_size bytes */
+static int _decompress(int method, const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t raw_size)
+{
+	if(method == LOG_COMPRESS_NONE){
+		if(in_size != raw_size)
+			return 1;
+		memcpy(out, in, raw_size);
+		return 0;
+	}
+	if(method == LOG_COMPRESS_LZO){
+		lzo_uint out_len = raw_size;
+
+		if(lzo1x_decompress_safe(in, in_size, out, &out_len, NULL) != LZO_E_OK || out_len != raw_size)
+			return 1;
+		return 0;
+	}
+	if(method == LOG_COMPRESS_DEFLATE){
+		inflateReset(&_zs_inflate);
+		_zs_inflate.next_in = (Bytef*)in;
+		_zs_inflate.avail_in = in_size;
+		_zs_inflate.next_out = out;
+		_zs_inflate.avail_out = raw_size;
+		if(inflate(&_zs_inflate, Z_FINISH) != Z_STREAM_END || _zs_inflate.total_out != raw_size)
+			return 1;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* a truncated tail or broken block loses only itself, the next block is found by its magic */
+static int _unpack(const char* in_name, const char* out_name)
+{
+	long size, pos = 0;
+	uint8_t* in = _read_file(in_name, &size);
+	uint8_t out[LOG_BUFFER_SIZE];
+	uint32_t block_cnt[LOG_COMPRESS_NUM] = {0};
+	uint32_t bad_cnt = 0, lost = 0;
+	uint64_t raw_bytes = 0;
+	block_header_t header;
+	FILE* fp;
+
+	if(in == NULL)
+		return 1;
+	fp = fopen(out_name, "wb");
+	if(fp == NULL){
+		fprintf(stderr, "can not create %s\n", out_name);
+		free(in);
+		return 1;
+	}
+
+	while(pos + (long)sizeof(header) <= size){
+		memcpy(&header, &in[pos], sizeof(header));
+		if(header.magic != LOG_BLOCK_MAGIC){
+			pos++;
+			continue;
+		}
+		if(header.method >= LOG_COMPRESS_NUM || header.raw_size > LOG_BUFFER_SIZE
+			|| header.data_size > LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE)
+			|| pos + (long)sizeof(header) + header.data_size > size
+			|| _decompress(header.method, &in[pos+sizeof(header)], header.data_size, out, header.raw_size)){
+			bad_cnt++;
+			pos++;
+			continue;
+		}
+
+		/* keep raw offset of following data, so record parser sees a hole rather than glued records */
+		if(header.raw_offset > raw_bytes){
+			lost += header.raw_offset - raw_bytes;
+			fseek(fp, header.raw_offset, SEEK_SET);
+			raw_bytes = header.raw_offset;
+		}
+		fwrite(out, 1, header.raw_size, fp);
+		raw_bytes += header.raw_size;
+		block_cnt[header.method]++;
+		pos += sizeof(header) + header.data_size;
+	}
+
+	printf("%s: %ld -> %llu bytes\n", in_name, size, (unsigned long long)raw_bytes);
+	for(int i = 0 ; i < LOG_COMPRESS_NUM ; i++)
+		printf("%s blocks: %u\n", _method_name[i], block_cnt[i]);
+	if(bad_cnt || lost)
+		printf("bad blocks: %u, lost raw bytes: %u\n", bad_cnt, lost);
+
+	fclose(fp);
+	free(in);
+
+	return 0;
+}
+
+static int _pack(const char* in_name, const char* out_name, int method)
+{
+	long size;
+	uint8_t* in = _read_file(in_name, &size);
+	uint8_t out[sizeof(block_header_t) + LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE)];
+	block_header_t* header = (block_header_t*)out;
+	uint64_t written = 0;
+	FILE* fp;
+
+	if(in == NULL)
+		return 1;
+	fp = fopen(out_name, "wb");
+	if(fp == NULL){
+		fprintf(stderr, "can not create %s\n", out_name);
+		free(in);
+		return 1;
+	}
+
+	for(long pos = 0 ; pos < size ; pos += LOG_BUFFER_SIZE){
+		uint32_t len = size - pos < LOG_BUFFER_SIZE ? size - pos : LOG_BUFFER_SIZE;
+		uint32_t n = _compress(method, &in[pos], len, &out[sizeof(block_header_t)]);
+
+		header->magic = LOG_BLOCK_MAGIC;
+		header->method = n ? method : LOG_COMPRESS_NONE;
+		header->reserved = 0;
+		header->raw_size = len;
+		header->raw_offset = pos;
+		if(n == 0){
+			memcpy(&out[sizeof(block_header_t)], &in[pos], len);
+			n = len;
+		}
+		header->data_size = n;
+		fwrite(out, 1, sizeof(block_header_t) + n, fp);
+		written += sizeof(block_header_t) + n;
+	}
+
+	printf("%s: %ld -> %llu bytes (%.2f%%)\n", in_name, size, (unsigned long long)written,
+			size ? 100.0*written/size : 0.0);
+
+	fclose(fp);
+	free(in);
+
+	return 0;
+}
+
+static int _bench(const char* in_name)
+{
+	long size;
+	uint8_t* in = _read_file(in_name, &size);
+	uint8_t out[LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE)];
+	uint8_t raw[LOG_BUFFER_SIZE];
+
+	if(in == NULL)
+		return 1;
+
+	printf("%s: %ld bytes, %d byte blocks\n", in_name, size, LOG_BUFFER_SIZE);
+	printf("%-8s %10s %8s %12s %12s %12s\n", "method", "written", "ratio", "comp MB/s", "decomp MB/s", "max block us");
+	for(int method = LOG_COMPRESS_LZO ; method < LOG_COMPRESS_NUM ; method++){
+		uint64_t written = 0;
+		double comp_time = 0, decomp_time = 0, block_max = 0;
+
+		for(long pos = 0 ; pos < size ; pos += LOG_BUFFER_SIZE){
+			uint32_t len = size - pos < LOG_BUFFER_SIZE ? size - pos : LOG_BUFFER_SIZE;
+			double t0 = _now();
+			uint32_t n = _compress(method, &in[pos], len, out);
+			double t1 = _now();
+
+			comp_time += t1 - t0;
+			if(t1 - t0 > block_max)
+				block_max = t1 - t0;
+			if(n){
+				t0 = _now();
+				if(_decompress(method, out, n, raw, len) || memcmp(raw, &in[pos], len)){
+					fprintf(stderr, "%s round trip fail at %ld\n", _method_name[method], pos);
+					free(in);
+					return 1;
+				}
+				decomp_time += _now() - t0;
+			}
+			written += sizeof(block_header_t) + (n ? n : len);
+		}
+
+		printf("%-8s %10llu %7.2f%% %12.1f %12.1f %12.1f\n", _method_name[method], (unsigned long long)written,
+				100.0*written/size, size/comp_time/1e6, size/decomp_time/1e6, block_max*1e6);
+	}
+
+	free(in);
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if(_codec_init()){
+		fprintf(stderr, "codec init fail\n");
+		return 1;
+	}
+
+	if(argc == 4 && strcmp(argv[1], "unpack") == 0)
+		return _unpack(argv[2], argv[3]);
+	if((argc == 4 || argc == 5) && strcmp(argv[1], "pack") == 0){
+		int method = LOG_COMPRESS_LZO;
+
+		if(argc == 5){
+			for(method = LOG_COMPRESS_LZO ; method < LOG_COMPRESS_NUM ; method++){
+				if(strcmp(argv[4], _method_name[method]) == 0)
+					break;
+			}
+			if(method == LOG_COMPRESS_NUM){
+				fprintf(stderr, "unknown method %s\n", argv[4]);
+				return 1;
+			}
+		}
+		return _pack(argv[2], argv[3], method);
+	}
+	if(argc == 3 && strcmp(argv[1], "bench") == 0)
+		return _bench(argv[2]);
+
+	printf("usage: %s unpack <compressed log> <plain log>\n", argv[0]);
+	printf("       %s pack <plain log> <compressed log> [lzo|deflate]\n", argv[0]);
+	printf("       %s bench <plain log>\n", argv[0]);
+
+	return 1;
+}
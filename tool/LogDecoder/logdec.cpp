@@ -0,0 +1,990 @@
+/*
+ * File      : logdec.cpp
+ *
+ * Native log decoder, replaces readlog.m, log_checker.m and the log_parser mex
+ * for reading logs. Log files are memory mapped and decoded to columns, which
+ * are exported as CSV (one file per message) or as a single columnar binary
+ * file. Independent log files are decoded in parallel threads.
+ *
+ * Supported logs: version 1 (fixed float rows, e.g. tool/EKF/HIL.LOG) and
+ * version 2 with delta records, sync markers and index footer, plain or
+ * compressed by "logger start <file> [period] lzo|deflate".
+ *
+ * build: gcc -O2 -c -I../../starry_fmu/RTOS/components/external/lzo -I../../starry_fmu/Framework/include
+ *            ../../starry_fmu/RTOS/components/external/lzo/minilzo.c ../../starry_fmu/Framework/source/Logger/log_delta.c
+ *        g++ -O2 -std=c++17 -pthread -I../../starry_fmu/RTOS/components/external/lzo -I../../starry_fmu/Framework/include
+ *            -o logdec logdec.cpp minilzo.o log_delta.o -lz
+ * usage: logdec [-f csv|col|all|none] [-o out dir] [-j threads] <log> [log...]
+ *
+ * Columnar file (<name>.col), little endian:
+ *   col_header_t, column_num * col_info_t, column data
+ * Every message has a "timestamp" column of uint64 us followed by a column per
+ * element, each column is row_num values of its type starting at offset,
+ * which is 8 bytes aligned. In MATLAB a column is read by
+ *   fseek(fid, offset, 'bof'); x = fread(fid, row_num, 'float=>double');
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <string.h>
+#include <atomic>
+#include <charconv>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+#include "minilzo.h"
+extern "C" {
+#include "log_delta.h"
+}
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/* keep in sync with starry_fmu/Framework/include/logger.h, log_compress.h and log_writer.h */
+#define LOG_MAGIC					0x474C5053
+#define LOG_VERSION					2
+#define LOG_RECORD_SYNC				0xA5
+#define LOG_RECORD_SYNC_DELTA		0xA6
+#define LOG_RECORD_SYNC_MARK		0xA7
+#define LOG_RECORD_SYNC_INDEX		0xA8
+#define LOG_BLOCK_MAGIC				0x5A4C5053
+#define LOG_SYNC_MAGIC				0x59535053
+#define LOG_MAX_NAME_LENGTH			20
+#define LOG_MAX_PAYLOAD_SIZE		256
+#define LOG_BUFFER_SIZE				8192
+#define LOG_COMPRESS_BOUND(_size)	((_size) + (_size)/16 + 64 + 3)
+
+#define COL_MAGIC					0x4C435053	/* "SPCL" */
+#define COL_VERSION					1
+#define CSV_BUFFER_SIZE				(1024*1024)
+
+enum
+{
+	LOG_INT8 = 0,
+	LOG_UINT8,
+	LOG_INT16,
+	LOG_UINT16,
+	LOG_INT32,
+	LOG_UINT32,
+	LOG_FLOAT,
+	LOG_DOUBLE,
+	COL_UINT64,				// timestamp column
+};
+
+enum
+{
+	LOG_COMPRESS_NONE = 0,
+	LOG_COMPRESS_LZO,
+	LOG_COMPRESS_DEFLATE,
+	LOG_COMPRESS_NUM,
+};
+
+enum
+{
+	OUT_NONE = 0,
+	OUT_CSV = 1<<0,
+	OUT_COL = 1<<1,
+};
+
+#pragma pack(push, 1)
+typedef struct
+{
+	uint32_t	start_time;
+	uint32_t	log_period;
+	uint32_t	element_num;
+	uint32_t	header_size;
+	uint32_t	field_size;
+}legacy_header_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	msg_num;
+	uint32_t	start_time;
+	uint32_t	header_size;
+}log_header_t;
+
+typedef struct
+{
+	uint8_t		msg_id;
+	uint8_t		element_num;
+	uint16_t	payload_size;
+	uint32_t	period;
+	char		name[LOG_MAX_NAME_LENGTH];
+}format_t;
+
+typedef struct
+{
+	char		name[LOG_MAX_NAME_LENGTH];
+	uint32_t	type;
+}element_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	payload_size;
+	uint32_t	timestamp;
+}record_header_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	body_size;
+}delta_header_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		reserved;
+	uint16_t	seq;
+	uint32_t	magic;
+	uint32_t	timestamp;
+	uint32_t	raw_offset;
+}sync_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		reserved;
+	uint16_t	stride;
+	uint32_t	entry_num;
+}index_header_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	entry_num;
+	uint32_t	index_size;
+	uint32_t	raw_offset;
+}index_tail_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint8_t		method;
+	uint8_t		reserved;
+	uint16_t	raw_size;
+	uint32_t	data_size;
+	uint32_t	raw_offset;
+}block_header_t;
+
+typedef struct
+{
+	uint32_t	magic;				// COL_MAGIC
+	uint32_t	version;
+	uint32_t	column_num;
+	uint32_t	reserved;
+}col_header_t;
+
+typedef struct
+{
+	char		msg[LOG_MAX_NAME_LENGTH];
+	char		name[LOG_MAX_NAME_LENGTH];
+	uint32_t	type;				// LOG_INT8 ... LOG_DOUBLE, COL_UINT64
+	uint32_t	reserved;
+	uint64_t	row_num;
+	uint64_t	offset;				// from file start
+}col_info_t;
+#pragma pack(pop)
+
+struct Element
+{
+	std::string name;
+	uint32_t type;
+	uint32_t offset;			// in payload
+	uint32_t size;
+};
+
+/* decoded records of a message, payloads are kept as rows and split to columns on export */
+struct Message
+{
+	uint8_t id;
+	std::string name;
+	uint32_t payload_size;
+	std::vector<Element> element;
+	std::vector<uint64_t> time;	// us
+	std::vector<uint8_t> row;
+	log_delta_t delta;
+	std::vector<uint32_t> delta_prev;
+};
+
+struct Log
+{
+	std::string file;
+	std::string out_name;		// output path without extension
+	int version = 0;
+	bool compressed = false;
+	bool footer = false;
+	std::vector<Message> msg;
+	int16_t msg_index[256];
+	uint64_t file_size = 0;
+	uint64_t raw_size = 0;
+	uint64_t record_cnt = 0;
+	uint64_t delta_cnt = 0;
+	uint64_t mark_cnt = 0;
+	uint64_t skip_bytes = 0;
+	uint32_t bad_blocks = 0;
+	double decode_ms = 0;
+	double write_ms = 0;
+	std::string err;
+};
+
+/* read only mapping of a whole file */
+class MappedFile
+{
+public:
+	const uint8_t* data = nullptr;
+	uint64_t size = 0;
+
+	bool open(const char* name)
+	{
+#ifdef _WIN32
+		LARGE_INTEGER len;
+
+		_file = CreateFileA(name, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+		if(_file == INVALID_HANDLE_VALUE || !GetFileSizeEx(_file, &len))
+			return false;
+		size = len.QuadPart;
+		if(size == 0)
+			return true;
+		_map = CreateFileMappingA(_file, NULL, PAGE_READONLY, 0, 0, NULL);
+		if(_map == NULL)
+			return false;
+		data = (const uint8_t*)MapViewOfFile(_map, FILE_MAP_READ, 0, 0, 0);
+#else
+		struct stat st;
+
+		_fd = ::open(name, O_RDONLY);
+		if(_fd < 0 || fstat(_fd, &st) != 0)
+			return false;
+		size = st.st_size;
+		if(size == 0)
+			return true;
+		void* p = mmap(NULL, size, PROT_READ, MAP_PRIVATE, _fd, 0);
+		if(p == MAP_FAILED)
+			return false;
+		/* records are read once from start to end */
+		madvise(p, size, MADV_SEQUENTIAL);
+		data = (const uint8_t*)p;
+#endif
+		return data != nullptr;
+	}
+
+	~MappedFile()
+	{
+#ifdef _WIN32
+		if(data)
+			UnmapViewOfFile(data);
+		if(_map)
+			CloseHandle(_map);
+		if(_file != INVALID_HANDLE_VALUE)
+			CloseHandle(_file);
+#else
+		if(data)
+			munmap((void*)data, size);
+		if(_fd >= 0)
+			close(_fd);
+#endif
+	}
+
+private:
+#ifdef _WIN32
+	HANDLE _file = INVALID_HANDLE_VALUE;
+	HANDLE _map = NULL;
+#else
+	int _fd = -1;
+#endif
+};
+
+static double _now_ms(void)
+{
+	return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint32_t _element_size(uint32_t type)
+{
+	switch(type)
+	{
+		case LOG_INT8:
+		case LOG_UINT8:
+			return 1;
+		case LOG_INT16:
+		case LOG_UINT16:
+			return 2;
+		case LOG_INT32:
+		case LOG_UINT32:
+		case LOG_FLOAT:
+			return 4;
+		case LOG_DOUBLE:
+		case COL_UINT64:
+			return 8;
+		default:
+			return 0;
+	}
+}
+
+static std::string _name(const char* name)
+{
+	return std::string(name, strnlen(name, LOG_MAX_NAME_LENGTH));
+}
+
+/* elements are packed in payload in their order, return 0 if they fill it exactly */
+static int _add_elements(Message& msg, const element_t* element, uint32_t element_num)
+{
+	uint32_t offset = 0;
+
+	for(uint32_t i = 0 ; i < element_num ; i++){
+		Element e;
+
+		e.name = _name(element[i].name);
+		e.type = element[i].type;
+		e.size = _element_size(e.type);
+		e.offset = offset;
+		if(e.size == 0)
+			return 1;
+		offset += e.size;
+		msg.element.push_back(e);
+	}
+
+	return offset == msg.payload_size ? 0 : 1;
+}
+
+/* version 1 log is a fixed row of elements every log_period ms */
+static int _decode_legacy(Log& log, const uint8_t* data, uint64_t size)
+{
+	legacy_header_t header;
+	uint64_t row_num;
+	Message msg;
+
+	memcpy(&header, data, sizeof(header));
+	if(header.header_size > size || header.field_size == 0 || header.field_size > LOG_MAX_PAYLOAD_SIZE*4
+		|| sizeof(header) + (uint64_t)header.element_num*sizeof(element_t) > header.header_size){
+		log.err = "invalid version 1 header";
+		return 1;
+	}
+
+	msg.id = 0;
+	msg.name = "LOG";
+	msg.payload_size = header.field_size;
+	if(_add_elements(msg, (const element_t*)&data[sizeof(header)], header.element_num)){
+		log.err = "element size does not match field size";
+		return 1;
+	}
+
+	/* rows are stored as they are, a partial last row is dropped */
+	row_num = (size - header.header_size)/header.field_size;
+	msg.row.assign(&data[header.header_size], &data[header.header_size] + row_num*header.field_size);
+	msg.time.resize(row_num);
+	for(uint64_t i = 0 ; i < row_num ; i++)
+		msg.time[i] = ((uint64_t)header.start_time + i*header.log_period)*1000;
+
+	log.version = 1;
+	log.raw_size = size;
+	log.record_cnt = row_num;
+	log.skip_bytes = size - header.header_size - row_num*header.field_size;
+	log.msg.push_back(std::move(msg));
+	log.msg_index[0] = 0;
+
+	return 0;
+}
+
+static int _parse_header(Log& log, const uint8_t* raw, uint64_t size)
+{
+	log_header_t header;
+	uint64_t pos = sizeof(header);
+
+	memcpy(&header, raw, sizeof(header));
+	if(header.version != LOG_VERSION || header.header_size > size){
+		log.err = "unsupported log version " + std::to_string(header.version);
+		return 1;
+	}
+
+	for(uint32_t n = 0 ; n < header.msg_num ; n++){
+		format_t format;
+		Message msg;
+
+		if(pos + sizeof(format) > header.header_size){
+			log.err = "truncated format definition";
+			return 1;
+		}
+		memcpy(&format, &raw[pos], sizeof(format));
+		pos += sizeof(format);
+		if(format.payload_size > LOG_MAX_PAYLOAD_SIZE || pos + format.element_num*sizeof(element_t) > header.header_size
+			|| log.msg_index[format.msg_id] >= 0){
+			log.err = "invalid format of message " + std::to_string(format.msg_id);
+			return 1;
+		}
+
+		msg.id = format.msg_id;
+		msg.name = _name(format.name);
+		msg.payload_size = format.payload_size;
+		if(_add_elements(msg, (const element_t*)&raw[pos], format.element_num)){
+			log.err = "element size does not match payload of " + msg.name;
+			return 1;
+		}
+		pos += format.element_num*sizeof(element_t);
+		log.msg_index[msg.id] = log.msg.size();
+		log.msg.push_back(std::move(msg));
+	}
+
+	/* prev is set after all messages are added, vector may move them before */
+	for(Message& msg : log.msg){
+		uint16_t word_num = msg.payload_size % 4 == 0 ? msg.payload_size/4 : 0;
+
+		msg.delta_prev.resize(word_num + 1);
+		log_delta_init(&msg.delta, msg.delta_prev.data(), word_num);
+	}
+	log.version = LOG_VERSION;
+
+	return 0;
+}
+
+/* index footer ends the records, it reaches exactly the end of data */
+static bool _is_footer(const uint8_t* raw, uint64_t pos, uint64_t size)
+{
+	index_header_t header;
+
+	if(pos + sizeof(header) > size)
+		return false;
+	memcpy(&header, &raw[pos], sizeof(header));
+
+	return pos + sizeof(header) + (uint64_t)header.entry_num*16 + sizeof(index_tail_t) == size;
+}
+
+static void _decode_records(Log& log, const uint8_t* raw, uint64_t size, uint64_t pos)
+{
+	uint64_t time_base = 0;
+	uint32_t last_stamp = 0;
+
+	while(pos + sizeof(delta_header_t) <= size){
+		const uint8_t* p = &raw[pos];
+		int16_t index = log.msg_index[p[1]];
+		Message* msg = index >= 0 ? &log.msg[index] : nullptr;
+		uint32_t stamp, len;
+		size_t row;
+
+		if(p[0] == LOG_RECORD_SYNC && msg && pos + sizeof(record_header_t) <= size){
+			record_header_t header;
+
+			memcpy(&header, p, sizeof(header));
+			len = sizeof(header) + header.payload_size;
+			if(header.payload_size != msg->payload_size || pos + len > size){
+				log.skip_bytes++;
+				pos++;
+				continue;
+			}
+			stamp = header.timestamp;
+			row = msg->row.size();
+			msg->row.resize(row + msg->payload_size);
+			memcpy(&msg->row[row], &p[sizeof(header)], msg->payload_size);
+			if(msg->delta.word_num)
+				log_delta_key(&msg->delta, stamp, &p[sizeof(header)]);
+		}else if(p[0] == LOG_RECORD_SYNC_DELTA && msg){
+			delta_header_t header;
+			uint8_t payload[LOG_MAX_PAYLOAD_SIZE];
+
+			memcpy(&header, p, sizeof(header));
+			len = sizeof(header) + header.body_size;
+			if(header.body_size == 0 || pos + len > size
+				|| log_delta_decode(&msg->delta, &p[sizeof(header)], header.body_size, &stamp, payload) != header.body_size){
+				log.skip_bytes++;
+				pos++;
+				continue;
+			}
+			row = msg->row.size();
+			msg->row.resize(row + msg->payload_size);
+			memcpy(&msg->row[row], payload, msg->payload_size);
+			log.delta_cnt++;
+		}else if(p[0] == LOG_RECORD_SYNC_MARK && pos + sizeof(sync_t) <= size && ((const sync_t*)p)->magic == LOG_SYNC_MAGIC){
+			log.mark_cnt++;
+			pos += sizeof(sync_t);
+			continue;
+		}else if(p[0] == LOG_RECORD_SYNC_INDEX && _is_footer(raw, pos, size)){
+			log.footer = true;
+			break;
+		}else{
+			/* lost sync, search next record byte by byte */
+			log.skip_bytes++;
+			pos++;
+			continue;
+		}
+
+		/* same unwrap as log_replay, queued topics may step back a little */
+		if(stamp < last_stamp && last_stamp - stamp > 0x80000000u)
+			time_base += 0x100000000ull;
+		last_stamp = stamp;
+		msg->time.push_back(time_base + stamp);
+		log.record_cnt++;
+		pos += len;
+	}
+
+	if(pos < size && !log.footer)
+		log.skip_bytes += size - pos;
+}
+
+/* return 0 if out is filled with exactly raw_size bytes */
+static int _decompress(z_stream* zs, int method, const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t raw_size)
+{
+	if(method == LOG_COMPRESS_NONE){
+		if(in_size != raw_size)
+			return 1;
+		memcpy(out, in, raw_size);
+		return 0;
+	}
+	if(method == LOG_COMPRESS_LZO){
+		lzo_uint out_len = raw_size;
+
+		if(lzo1x_decompress_safe(in, in_size, out, &out_len, NULL) != LZO_E_OK || out_len != raw_size)
+			return 1;
+		return 0;
+	}
+	if(method == LOG_COMPRESS_DEFLATE){
+		inflateReset(zs);
+		zs->next_in = (Bytef*)in;
+		zs->avail_in = in_size;
+		zs->next_out = out;
+		zs->avail_out = raw_size;
+		if(inflate(zs, Z_FINISH) != Z_STREAM_END || zs->total_out != raw_size)
+			return 1;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* same as logz unpack, a broken block leaves a hole of its raw size */
+static int _unpack(Log& log, const uint8_t* data, uint64_t size, std::vector<uint8_t>& raw)
+{
+	block_header_t header;
+	uint64_t pos = 0;
+	z_stream zs;
+
+	memset(&zs, 0, sizeof(zs));
+	if(inflateInit2(&zs, -15) != Z_OK){
+		log.err = "inflate init fail";
+		return 1;
+	}
+
+	while(pos + sizeof(header) <= size){
+		memcpy(&header, &data[pos], sizeof(header));
+		if(header.magic != LOG_BLOCK_MAGIC){
+			pos++;
+			continue;
+		}
+		if(header.method >= LOG_COMPRESS_NUM || header.data_size > LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE)
+			|| pos + sizeof(header) + header.data_size > size || header.raw_offset < raw.size()
+			|| header.raw_offset - raw.size() > size*64){
+			log.bad_blocks++;
+			pos++;
+			continue;
+		}
+		raw.resize(header.raw_offset + header.raw_size);
+		if(_decompress(&zs, header.method, &data[pos + sizeof(header)], header.data_size,
+						&raw[header.raw_offset], header.raw_size)){
+			raw.resize(header.raw_offset);
+			log.bad_blocks++;
+			pos++;
+			continue;
+		}
+		pos += sizeof(header) + header.data_size;
+	}
+	inflateEnd(&zs);
+
+	return 0;
+}
+
+static void _decode(Log& log)
+{
+	MappedFile file;
+	std::vector<uint8_t> raw;
+	double start = _now_ms();
+	uint32_t magic;
+
+	for(int i = 0 ; i < 256 ; i++)
+		log.msg_index[i] = -1;
+
+	if(!file.open(log.file.c_str())){
+		log.err = "can not open file";
+		return;
+	}
+	log.file_size = file.size;
+	if(file.size < sizeof(log_header_t)){
+		log.err = "file is too short";
+		return;
+	}
+
+	memcpy(&magic, file.data, sizeof(magic));
+	if(magic == LOG_BLOCK_MAGIC){
+		log.compressed = true;
+		if(_unpack(log, file.data, file.size, raw))
+			return;
+		if(raw.size() < sizeof(log_header_t)){
+			log.err = "no valid block";
+			return;
+		}
+		memcpy(&magic, raw.data(), sizeof(magic));
+	}
+
+	if(magic == LOG_MAGIC){
+		const uint8_t* data = log.compressed ? raw.data() : file.data;
+		uint64_t size = log.compressed ? raw.size() : file.size;
+
+		log.raw_size = size;
+		if(_parse_header(log, data, size) == 0)
+			_decode_records(log, data, size, ((const log_header_t*)data)->header_size);
+	}else if(!log.compressed){
+		/* version 1 log has no magic, it starts with the start time */
+		_decode_legacy(log, file.data, file.size);
+	}else{
+		log.err = "unknown log in blocks";
+	}
+
+	log.decode_ms = _now_ms() - start;
+}
+
+/* buffered output, values are formatted by to_chars which is exact and locale free */
+class CsvWriter
+{
+public:
+	explicit CsvWriter(FILE* fp) : _fp(fp), _buff(CSV_BUFFER_SIZE), _len(0) {}
+	~CsvWriter() { flush(); }
+
+	void put(const char* s, size_t n)
+	{
+		if(_len + n > _buff.size())
+			flush();
+		memcpy(&_buff[_len], s, n);
+		_len += n;
+	}
+
+	void put(char c)
+	{
+		if(_len + 1 > _buff.size())
+			flush();
+		_buff[_len++] = c;
+	}
+
+	template<typename T> void value(T v)
+	{
+		if(_len + 32 > _buff.size())
+			flush();
+		_len = std::to_chars(&_buff[_len], &_buff[0] + _buff.size(), v).ptr - &_buff[0];
+	}
+
+	void flush(void)
+	{
+		fwrite(_buff.data(), 1, _len, _fp);
+		_len = 0;
+	}
+
+private:
+	FILE* _fp;
+	std::vector<char> _buff;
+	size_t _len;
+};
+
+template<typename T> static T _get(const uint8_t* p)
+{
+	T v;
+
+	memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+static void _put_element(CsvWriter& csv, const Element& e, const uint8_t* p)
+{
+	switch(e.type)
+	{
+		case LOG_INT8:
+			csv.value((int)_get<int8_t>(p));
+			break;
+		case LOG_UINT8:
+			csv.value((unsigned)_get<uint8_t>(p));
+			break;
+		case LOG_INT16:
+			csv.value((int)_get<int16_t>(p));
+			break;
+		case LOG_UINT16:
+			csv.value((unsigned)_get<uint16_t>(p));
+			break;
+		case LOG_INT32:
+			csv.value(_get<int32_t>(p));
+			break;
+		case LOG_UINT32:
+			csv.value(_get<uint32_t>(p));
+			break;
+		case LOG_FLOAT:
+			csv.value(_get<float>(p));
+			break;
+		case LOG_DOUBLE:
+			csv.value(_get<double>(p));
+			break;
+	}
+}
+
+/* one file per message with records, first column is timestamp in us */
+static int _write_csv(const Log& log)
+{
+	for(const Message& msg : log.msg){
+		std::string name = log.out_name + "_" + msg.name + ".csv";
+		FILE* fp;
+
+		if(msg.time.empty())
+			continue;
+		fp = fopen(name.c_str(), "wb");
+		if(fp == NULL){
+			fprintf(stderr, "can not create %s\n", name.c_str());
+			return 1;
+		}
+		{
+			CsvWriter csv(fp);
+
+			csv.put("timestamp", 9);
+			for(const Element& e : msg.element){
+				csv.put(',');
+				csv.put(e.name.c_str(), e.name.size());
+			}
+			csv.put('\n');
+			for(size_t i = 0 ; i < msg.time.size() ; i++){
+				const uint8_t* row = &msg.row[i*msg.payload_size];
+
+				csv.value(msg.time[i]);
+				for(const Element& e : msg.element){
+					csv.put(',');
+					_put_element(csv, e, &row[e.offset]);
+				}
+				csv.put('\n');
+			}
+		}
+		fclose(fp);
+	}
+
+	return 0;
+}
+
+static int _write_col(const Log& log)
+{
+	std::string name = log.out_name + ".col";
+	std::vector<col_info_t> info;
+	std::vector<uint8_t> column;
+	col_header_t header;
+	uint64_t offset;
+	FILE* fp;
+
+	for(const Message& msg : log.msg){
+		col_info_t col;
+
+		if(msg.time.empty())
+			continue;
+		memset(&col, 0, sizeof(col));
+		strncpy(col.msg, msg.name.c_str(), LOG_MAX_NAME_LENGTH-1);
+		strncpy(col.name, "timestamp", LOG_MAX_NAME_LENGTH-1);
+		col.type = COL_UINT64;
+		col.row_num = msg.time.size();
+		info.push_back(col);
+		for(const Element& e : msg.element){
+			strncpy(col.name, e.name.c_str(), LOG_MAX_NAME_LENGTH-1);
+			col.type = e.type;
+			info.push_back(col);
+		}
+	}
+
+	offset = sizeof(header) + info.size()*sizeof(col_info_t);
+	for(col_info_t& col : info){
+		offset = (offset + 7) & ~(uint64_t)7;
+		col.offset = offset;
+		offset += col.row_num*_element_size(col.type);
+	}
+
+	fp = fopen(name.c_str(), "wb");
+	if(fp == NULL){
+		fprintf(stderr, "can not create %s\n", name.c_str());
+		return 1;
+	}
+	header.magic = COL_MAGIC;
+	header.version = COL_VERSION;
+	header.column_num = info.size();
+	header.reserved = 0;
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(info.data(), sizeof(col_info_t), info.size(), fp);
+
+	/* columns are gathered from rows in the same order as the table */
+	offset = sizeof(header) + info.size()*sizeof(col_info_t);
+	for(const Message& msg : log.msg){
+		if(msg.time.empty())
+			continue;
+		for(int i = -1 ; i < (int)msg.element.size() ; i++){
+			static const uint8_t pad[8] = {0};
+			uint64_t aligned = (offset + 7) & ~(uint64_t)7;
+
+			fwrite(pad, 1, aligned - offset, fp);
+			offset = aligned;
+			if(i < 0){
+				fwrite(msg.time.data(), sizeof(uint64_t), msg.time.size(), fp);
+				offset += msg.time.size()*sizeof(uint64_t);
+				continue;
+			}
+			const Element& e = msg.element[i];
+			column.resize(msg.time.size()*e.size);
+			for(size_t r = 0 ; r < msg.time.size() ; r++)
+				memcpy(&column[r*e.size], &msg.row[r*msg.payload_size + e.offset], e.size);
+			fwrite(column.data(), 1, column.size(), fp);
+			offset += column.size();
+		}
+	}
+	fclose(fp);
+
+	return 0;
+}
+
+static void _process(Log& log, int out)
+{
+	double start;
+
+	_decode(log);
+	if(!log.err.empty())
+		return;
+
+	start = _now_ms();
+	if((out & OUT_CSV) && _write_csv(log))
+		log.err = "csv write fail";
+	if((out & OUT_COL) && _write_col(log))
+		log.err = "columnar write fail";
+	log.write_ms = _now_ms() - start;
+}
+
+static std::string _base_name(const std::string& path)
+{
+	size_t slash = path.find_last_of("/\\");
+	std::string name = slash == std::string::npos ? path : path.substr(slash + 1);
+	size_t dot = name.find_last_of('.');
+
+	return dot == std::string::npos ? name : name.substr(0, dot);
+}
+
+static void _usage(const char* prog)
+{
+	printf("usage: %s [-f csv|col|all|none] [-o out dir] [-j threads] <log> [log...]\n", prog);
+	printf("  -f  output format, default csv. none only decodes, for benchmark\n");
+	printf("  -o  output directory, default is the directory of each log\n");
+	printf("  -j  decode threads, default is the number of cpu cores\n");
+}
+
+int main(int argc, char** argv)
+{
+	int out = OUT_CSV;
+	unsigned thread_num = std::thread::hardware_concurrency();
+	const char* out_dir = NULL;
+	std::vector<Log> logs;
+	std::vector<std::thread> workers;
+	std::atomic<size_t> next(0);
+	uint64_t total_size = 0, total_records = 0;
+	double start;
+	int res = 0;
+
+	for(int i = 1 ; i < argc ; i++){
+		if(strcmp(argv[i], "-f") == 0 && i + 1 < argc){
+			i++;
+			if(strcmp(argv[i], "csv") == 0)
+				out = OUT_CSV;
+			else if(strcmp(argv[i], "col") == 0)
+				out = OUT_COL;
+			else if(strcmp(argv[i], "all") == 0)
+				out = OUT_CSV | OUT_COL;
+			else if(strcmp(argv[i], "none") == 0)
+				out = OUT_NONE;
+			else{
+				_usage(argv[0]);
+				return 1;
+			}
+		}else if(strcmp(argv[i], "-o") == 0 && i + 1 < argc){
+			out_dir = argv[++i];
+		}else if(strcmp(argv[i], "-j") == 0 && i + 1 < argc){
+			thread_num = atoi(argv[++i]);
+		}else if(argv[i][0] == '-'){
+			_usage(argv[0]);
+			return 1;
+		}else{
+			logs.emplace_back();
+			logs.back().file = argv[i];
+		}
+	}
+	if(logs.empty()){
+		_usage(argv[0]);
+		return 1;
+	}
+	if(lzo_init() != LZO_E_OK){
+		fprintf(stderr, "lzo init fail\n");
+		return 1;
+	}
+
+	/* logs of the same name from different directories get a suffix in one out dir */
+	for(size_t i = 0 ; i < logs.size() ; i++){
+		std::string dir = logs[i].file.substr(0, logs[i].file.find_last_of("/\\") + 1);
+		int dup = 0;
+
+		logs[i].out_name = (out_dir ? std::string(out_dir) + "/" : dir) + _base_name(logs[i].file);
+		for(size_t k = 0 ; k < i ; k++){
+			if(out_dir && _base_name(logs[k].file) == _base_name(logs[i].file))
+				dup++;
+		}
+		if(dup)
+			logs[i].out_name += "_" + std::to_string(dup);
+	}
+
+	if(thread_num == 0)
+		thread_num = 1;
+	if(thread_num > logs.size())
+		thread_num = logs.size();
+
+	start = _now_ms();
+	for(unsigned t = 0 ; t < thread_num ; t++){
+		workers.emplace_back([&](){
+			size_t i;
+
+			while((i = next++) < logs.size())
+				_process(logs[i], out);
+		});
+	}
+	for(std::thread& w : workers)
+		w.join();
+
+	for(const Log& log : logs){
+		if(!log.err.empty()){
+			printf("%s: %s\n", log.file.c_str(), log.err.c_str());
+			res = 1;
+			continue;
+		}
+		printf("%s: v%d%s, %llu bytes, %llu records", log.file.c_str(), log.version, log.compressed ? " compressed" : "",
+				(unsigned long long)log.file_size, (unsigned long long)log.record_cnt);
+		if(log.version == LOG_VERSION){
+			printf(" (%llu delta), %llu markers%s", (unsigned long long)log.delta_cnt, (unsigned long long)log.mark_cnt,
+					log.footer ? ", index footer" : "");
+		}
+		if(log.skip_bytes || log.bad_blocks)
+			printf(", skipped %llu bytes, %u bad blocks", (unsigned long long)log.skip_bytes, log.bad_blocks);
+		printf("\n  decode %.2f ms (%.1f MB/s), write %.2f ms\n", log.decode_ms,
+				log.decode_ms > 0 ? log.raw_size/log.decode_ms/1e3 : 0.0, log.write_ms);
+		total_size += log.file_size;
+		total_records += log.record_cnt;
+	}
+	printf("%zu logs, %llu bytes, %llu records in %.2f ms with %u threads\n", logs.size(), (unsigned long long)total_size,
+			(unsigned long long)total_records, _now_ms() - start, thread_num);
+
+	return res;
+}
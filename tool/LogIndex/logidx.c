@@ -0,0 +1,797 @@
+/*
+ * File      : logidx.c
+ *
+ * Host side tool of the log index footer (see LOG_IndexHeaderDef in logger.h).
+ * show checks the footer, seek finds a time through the footer in O(log n)
+ * and compares it with a scan from the start, recover rebuilds the footer of
+ * a log cut by power loss from its sync markers and drops the broken tail.
+ * Plain and compressed logs are both handled.
+ *
+ * build: gcc -O2 -I../../starry_fmu/RTOS/components/external/lzo -o logidx logidx.c
+ *            ../../starry_fmu/RTOS/components/external/lzo/minilzo.c -lz
+ * usage: logidx show <log>
+ *        logidx seek <log> <seconds from log start>
+ *        logidx recover <log> <recovered log>
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-16     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+#include <zlib.h>
+#include "minilzo.h"
+
+/* keep in sync with starry_fmu/Framework/include/logger.h, log_compress.h, log_delta.h and log_writer.h */
+#define LOG_MAGIC					0x474C5053
+#define LOG_VERSION					2
+#define LOG_RECORD_SYNC				0xA5
+#define LOG_RECORD_SYNC_DELTA		0xA6
+#define LOG_RECORD_SYNC_MARK		0xA7
+#define LOG_RECORD_SYNC_INDEX		0xA8
+#define LOG_BLOCK_MAGIC				0x5A4C5053
+#define LOG_SYNC_MAGIC				0x59535053
+#define LOG_INDEX_MAGIC				0x58495053
+#define LOG_MAX_NAME_LENGTH			20
+#define LOG_MAX_PAYLOAD_SIZE		256
+#define LOG_BUFFER_SIZE				8192
+#define LOG_INDEX_MAX_NUM			256
+#define LOG_COMPRESS_BOUND(_size)	((_size) + (_size)/16 + 64 + 3)
+#define LOG_DELTA_BOUND(_word_num)	(5 + 5*(_word_num))
+
+enum
+{
+	LOG_COMPRESS_NONE = 0,
+	LOG_COMPRESS_LZO,
+	LOG_COMPRESS_DEFLATE,
+	LOG_COMPRESS_NUM,
+};
+
+#pragma pack(push, 1)
+typedef struct
+{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	msg_num;
+	uint32_t	start_time;
+	uint32_t	header_size;
+}log_header_t;
+
+typedef struct
+{
+	uint8_t		msg_id;
+	uint8_t		element_num;
+	uint16_t	payload_size;
+	uint32_t	period;
+	char		name[LOG_MAX_NAME_LENGTH];
+}format_t;
+
+typedef struct
+{
+	char		name[LOG_MAX_NAME_LENGTH];
+	uint32_t	type;
+}element_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	payload_size;
+	uint32_t	timestamp;
+}record_header_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		msg_id;
+	uint16_t	body_size;
+}delta_header_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		reserved;
+	uint16_t	seq;
+	uint32_t	magic;
+	uint32_t	timestamp;
+	uint32_t	raw_offset;
+}sync_t;
+
+typedef struct
+{
+	uint8_t		sync;
+	uint8_t		reserved;
+	uint16_t	stride;
+	uint32_t	entry_num;
+}index_header_t;
+
+typedef struct
+{
+	uint64_t	timestamp;
+	uint32_t	raw_offset;
+	uint32_t	file_offset;
+}index_entry_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint32_t	entry_num;
+	uint32_t	index_size;
+	uint32_t	raw_offset;
+}index_tail_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint8_t		method;
+	uint8_t		reserved;
+	uint16_t	raw_size;
+	uint32_t	data_size;
+	uint32_t	raw_offset;
+}block_header_t;
+#pragma pack(pop)
+
+typedef struct
+{
+	uint32_t	file_offset;
+	uint32_t	raw_offset;
+	uint32_t	raw_size;
+}block_t;
+
+/* a log loaded in memory, raw is the uncompressed layout */
+typedef struct
+{
+	uint8_t*	file;
+	uint32_t	file_size;
+	int			compressed;
+	uint8_t*	raw;
+	uint32_t	raw_size;
+	block_t*	block;
+	uint32_t	block_num;
+	uint32_t	header_size;
+	uint16_t	payload_size[256];		// 0 if message is not defined
+	/* footer, NULL if there is none */
+	const index_header_t* index;
+	const index_entry_t* entry;
+}log_t;
+
+static z_stream _zs_inflate;
+
+static double _now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec*1e-9;
+}
+
+static uint8_t* _read_file(const char* name, uint32_t* size)
+{
+	FILE* fp = fopen(name, "rb");
+	uint8_t* buff;
+	long len;
+
+	if(fp == NULL){
+		fprintf(stderr, "can not open %s\n", name);
+		return NULL;
+	}
+	fseek(fp, 0, SEEK_END);
+	len = ftell(fp);
+	rewind(fp);
+	buff = malloc(len ? len : 1);
+	if(buff == NULL || fread(buff, 1, len, fp) != (size_t)len){
+		fprintf(stderr, "can not read %s\n", name);
+		free(buff);
+		fclose(fp);
+		return NULL;
+	}
+	fclose(fp);
+	*size = len;
+
+	return buff;
+}
+
+/* same as logz, return 0 if out is filled with exactly raw_size bytes */
+static int _decompress(int method, const uint8_t* in, uint32_t in_size, uint8_t* out, uint32_t raw_size)
+{
+	if(method == LOG_COMPRESS_NONE){
+		if(in_size != raw_size)
+			return 1;
+		memcpy(out, in, raw_size);
+		return 0;
+	}
+	if(method == LOG_COMPRESS_LZO){
+		lzo_uint out_len = raw_size;
+
+		if(lzo1x_decompress_safe(in, in_size, out, &out_len, NULL) != LZO_E_OK || out_len != raw_size)
+			return 1;
+		return 0;
+	}
+	if(method == LOG_COMPRESS_DEFLATE){
+		inflateReset(&_zs_inflate);
+		_zs_inflate.next_in = (Bytef*)in;
+		_zs_inflate.avail_in = in_size;
+		_zs_inflate.next_out = out;
+		_zs_inflate.avail_out = raw_size;
+		if(inflate(&_zs_inflate, Z_FINISH) != Z_STREAM_END || _zs_inflate.total_out != raw_size)
+			return 1;
+		return 0;
+	}
+
+	return 1;
+}
+
+/* decompress block at file offset into out, return raw size or -1 */
+static int _read_block(const log_t* log, uint32_t file_offset, uint8_t* out, block_header_t* header)
+{
+	if(file_offset + sizeof(*header) > log->file_size)
+		return -1;
+	memcpy(header, &log->file[file_offset], sizeof(*header));
+	if(header->magic != LOG_BLOCK_MAGIC || header->method >= LOG_COMPRESS_NUM || header->raw_size > LOG_BUFFER_SIZE
+		|| header->data_size > LOG_COMPRESS_BOUND(LOG_BUFFER_SIZE)
+		|| file_offset + sizeof(*header) + header->data_size > log->file_size
+		|| _decompress(header->method, &log->file[file_offset + sizeof(*header)], header->data_size, out, header->raw_size))
+		return -1;
+
+	return header->raw_size;
+}
+
+/* footer is plain at the end of file in both layouts */
+static void _find_index(log_t* log)
+{
+	index_tail_t tail;
+	const uint8_t* p;
+
+	log->index = NULL;
+	log->entry = NULL;
+	if(log->file_size < sizeof(tail))
+		return;
+	memcpy(&tail, &log->file[log->file_size - sizeof(tail)], sizeof(tail));
+	if(tail.magic != LOG_INDEX_MAGIC || tail.index_size > log->file_size
+		|| tail.index_size != sizeof(index_header_t) + (uint64_t)tail.entry_num*sizeof(index_entry_t) + sizeof(tail))
+		return;
+	p = &log->file[log->file_size - tail.index_size];
+	if(p[0] != LOG_RECORD_SYNC_INDEX || ((const index_header_t*)p)->entry_num != tail.entry_num)
+		return;
+
+	log->index = (const index_header_t*)p;
+	log->entry = (const index_entry_t*)(p + sizeof(index_header_t));
+}
+
+static int _parse_header(log_t* log)
+{
+	log_header_t header;
+	format_t format;
+	uint32_t pos;
+
+	if(log->raw_size < sizeof(header))
+		return 1;
+	memcpy(&header, log->raw, sizeof(header));
+	if(header.magic != LOG_MAGIC || header.version != LOG_VERSION || header.header_size > log->raw_size){
+		fprintf(stderr, "not a version %d log\n", LOG_VERSION);
+		return 1;
+	}
+
+	memset(log->payload_size, 0, sizeof(log->payload_size));
+	pos = sizeof(header);
+	for(int n = 0 ; n < header.msg_num ; n++){
+		if(pos + sizeof(format) > header.header_size)
+			return 1;
+		memcpy(&format, &log->raw[pos], sizeof(format));
+		if(format.payload_size > LOG_MAX_PAYLOAD_SIZE)
+			return 1;
+		log->payload_size[format.msg_id] = format.payload_size;
+		pos += sizeof(format) + format.element_num*sizeof(element_t);
+	}
+	log->header_size = header.header_size;
+
+	return 0;
+}
+
+/* Load log and build its raw layout. A compressed log is decompressed up to
+ * the first broken block, which is where a power loss cuts it.
+ */
+static int _load(log_t* log, const char* name)
+{
+	block_header_t header;
+	uint32_t pos = 0;
+
+	memset(log, 0, sizeof(*log));
+	log->file = _read_file(name, &log->file_size);
+	if(log->file == NULL)
+		return 1;
+	_find_index(log);
+
+	if(log->file_size < 4 || memcmp(log->file, &(uint32_t){LOG_BLOCK_MAGIC}, 4) != 0){
+		log->raw = log->file;
+		log->raw_size = log->file_size;
+		return _parse_header(log);
+	}
+
+	log->compressed = 1;
+	log->block = malloc((log->file_size/sizeof(header) + 1)*sizeof(block_t));
+	if(log->block == NULL){
+		fprintf(stderr, "out of memory\n");
+		return 1;
+	}
+	while(pos < log->file_size){
+		int n;
+
+		if((log->block_num & (log->block_num - 1)) == 0){
+			/* grow by doubling, block number is a power of 2 here */
+			log->raw = realloc(log->raw, (uint64_t)(2*log->block_num + 1)*LOG_BUFFER_SIZE);
+			if(log->raw == NULL){
+				fprintf(stderr, "out of memory\n");
+				return 1;
+			}
+		}
+		n = _read_block(log, pos, &log->raw[log->raw_size], &header);
+
+		if(n < 0 || header.raw_offset != log->raw_size){
+			printf("blocks end at %u of %u bytes\n", pos, log->file_size);
+			break;
+		}
+		log->block[log->block_num].file_offset = pos;
+		log->block[log->block_num].raw_offset = header.raw_offset;
+		log->block[log->block_num].raw_size = n;
+		log->block_num++;
+		log->raw_size += n;
+		pos += sizeof(header) + header.data_size;
+	}
+
+	return _parse_header(log);
+}
+
+static void _unload(log_t* log)
+{
+	if(log->raw != log->file)
+		free(log->raw);
+	free(log->file);
+	free(log->block);
+}
+
+static uint32_t _get_varint(const uint8_t* p, uint32_t len)
+{
+	uint32_t v = 0;
+
+	for(uint32_t i = 0 ; i < len && i < 5 ; i++){
+		v |= (uint32_t)(p[i] & 0x7F) << (7*i);
+		if(!(p[i] & 0x80))
+			break;
+	}
+
+	return v;
+}
+
+/* size of a whole record at pos of raw data, 0 if there is none */
+static uint32_t _record_size(const log_t* log, const uint8_t* raw, uint32_t len, uint32_t pos, uint32_t raw_pos)
+{
+	const uint8_t* p = &raw[pos];
+	uint32_t left = len - pos;
+
+	if(left < sizeof(delta_header_t))
+		return 0;
+	if(p[0] == LOG_RECORD_SYNC){
+		record_header_t header;
+
+		if(left < sizeof(header))
+			return 0;
+		memcpy(&header, p, sizeof(header));
+		if(header.payload_size == 0 || header.payload_size != log->payload_size[header.msg_id]
+			|| left < sizeof(header) + header.payload_size)
+			return 0;
+		return sizeof(header) + header.payload_size;
+	}
+	if(p[0] == LOG_RECORD_SYNC_DELTA){
+		delta_header_t header;
+
+		memcpy(&header, p, sizeof(header));
+		if(log->payload_size[header.msg_id] == 0 || header.body_size == 0
+			|| header.body_size > LOG_DELTA_BOUND(log->payload_size[header.msg_id]/4)
+			|| left < sizeof(header) + header.body_size)
+			return 0;
+		return sizeof(header) + header.body_size;
+	}
+	if(p[0] == LOG_RECORD_SYNC_MARK){
+		sync_t mark;
+
+		if(left < sizeof(mark))
+			return 0;
+		memcpy(&mark, p, sizeof(mark));
+		if(mark.magic != LOG_SYNC_MAGIC || mark.raw_offset != raw_pos)
+			return 0;
+		return sizeof(mark);
+	}
+
+	return 0;
+}
+
+/* Walk records from a marker or the first record, until a record reaches
+ * target time. Delta records are stamped from the plain record before them,
+ * which always exists after a marker. Return raw position of that record.
+ */
+static uint32_t _walk(const log_t* log, const uint8_t* raw, uint32_t len, uint32_t pos, uint32_t raw_base,
+						uint64_t base_time, uint64_t target, uint64_t* found_time, uint32_t* record_cnt)
+{
+	static uint32_t last[256];
+	uint64_t time = base_time;
+	uint32_t n;
+
+	memset(last, 0, sizeof(last));
+	*record_cnt = 0;
+	while((n = _record_size(log, raw, len, pos, raw_base + pos)) != 0){
+		uint32_t stamp;
+		int has_stamp = 1;
+
+		if(raw[pos] == LOG_RECORD_SYNC){
+			memcpy(&stamp, &raw[pos + 4], sizeof(stamp));
+			last[raw[pos+1]] = stamp;
+		}else if(raw[pos] == LOG_RECORD_SYNC_DELTA){
+			stamp = last[raw[pos+1]] + _get_varint(&raw[pos + sizeof(delta_header_t)], n - sizeof(delta_header_t));
+			last[raw[pos+1]] = stamp;
+		}else{
+			has_stamp = 0;
+		}
+		if(has_stamp){
+			time += (int32_t)(stamp - (uint32_t)time);
+			(*record_cnt)++;
+			if(time >= target){
+				*found_time = time;
+				return raw_base + pos;
+			}
+		}
+		pos += n;
+	}
+
+	*found_time = time;
+	return raw_base + pos;
+}
+
+/* timestamp of first record, log time is counted from it */
+static int _first_stamp(const log_t* log, uint32_t* stamp)
+{
+	uint32_t n = _record_size(log, log->raw, log->raw_size, log->header_size, log->header_size);
+
+	if(n == 0 || log->raw[log->header_size] != LOG_RECORD_SYNC)
+		return 1;
+	memcpy(stamp, &log->raw[log->header_size + 4], sizeof(*stamp));
+
+	return 0;
+}
+
+static int _show(const char* name)
+{
+	log_t log;
+	uint32_t ok = 0;
+	uint8_t* out = malloc(LOG_BUFFER_SIZE);
+
+	if(_load(&log, name)){
+		free(out);
+		return 1;
+	}
+
+	printf("%s: %s log, %u bytes, raw %u bytes\n", name, log.compressed ? "compressed" : "plain",
+			log.file_size, log.raw_size);
+	if(log.index == NULL){
+		printf("no index footer, rebuild it with: logidx recover %s <recovered log>\n", name);
+		_unload(&log);
+		free(out);
+		return 1;
+	}
+
+	for(uint32_t i = 0 ; i < log.index->entry_num ; i++){
+		index_entry_t e = log.entry[i];
+		sync_t mark;
+		uint32_t off = e.raw_offset;
+		const uint8_t* p = log.file + e.raw_offset;
+
+		if(log.compressed){
+			block_header_t header;
+
+			if(_read_block(&log, e.file_offset, out, &header) < 0 || e.raw_offset < header.raw_offset
+				|| e.raw_offset + sizeof(mark) > header.raw_offset + header.raw_size)
+				continue;
+			p = &out[e.raw_offset - header.raw_offset];
+		}else if(off + sizeof(mark) > log.file_size){
+			/* file offset is not used, it is stale in a log unpacked by logz */
+			continue;
+		}
+		memcpy(&mark, p, sizeof(mark));
+		if(mark.sync == LOG_RECORD_SYNC_MARK && mark.magic == LOG_SYNC_MAGIC && mark.raw_offset == off
+			&& mark.timestamp == (uint32_t)e.timestamp)
+			ok++;
+	}
+
+	printf("index: %u entries, one per %u markers, %u bytes\n", log.index->entry_num, log.index->stride,
+			(uint32_t)(sizeof(index_header_t) + log.index->entry_num*sizeof(index_entry_t) + sizeof(index_tail_t)));
+	if(log.index->entry_num){
+		printf("time: %.3f s to %.3f s\n", log.entry[0].timestamp*1e-6,
+				log.entry[log.index->entry_num-1].timestamp*1e-6);
+	}
+	printf("entries pointing at their marker: %u/%u\n", ok, log.index->entry_num);
+	ok = ok == log.index->entry_num;
+
+	_unload(&log);
+	free(out);
+
+	return ok ? 0 : 1;
+}
+
+/* last entry at or before target, binary search */
+static int32_t _search(const log_t* log, uint64_t target)
+{
+	int32_t lo = 0, hi = (int32_t)log->index->entry_num - 1, found = -1;
+
+	while(lo <= hi){
+		int32_t mid = (lo + hi)/2;
+
+		if(log->entry[mid].timestamp <= target){
+			found = mid;
+			lo = mid + 1;
+		}else{
+			hi = mid - 1;
+		}
+	}
+
+	return found;
+}
+
+/* seek through index, reading only the blocks from the entry */
+static uint32_t _seek_index(const log_t* log, uint64_t start, uint64_t target, uint64_t* time, uint32_t* walked)
+{
+	static uint8_t* window = NULL;
+	static uint32_t window_size = 0;
+	int32_t i = _search(log, target);
+	const index_entry_t* e;
+	block_header_t header;
+	uint32_t len = 0, file_offset, skip, end;
+	int n;
+
+	if(i < 0)
+		return _walk(log, log->raw, log->raw_size, log->header_size, 0, start, target, time, walked);
+	e = &log->entry[i];
+	if(!log->compressed)
+		return _walk(log, log->file, log->raw_size, e->raw_offset, 0, e->timestamp, target, time, walked);
+
+	/* target is before the next entry, a record crossing it may end in the block after */
+	end = i + 1 < (int32_t)log->index->entry_num ? log->entry[i+1].raw_offset + LOG_BUFFER_SIZE : log->raw_size;
+	if(end - e->raw_offset + 2*LOG_BUFFER_SIZE > window_size){
+		window_size = end - e->raw_offset + 2*LOG_BUFFER_SIZE;
+		window = realloc(window, window_size);
+	}
+	file_offset = e->file_offset;
+	n = _read_block(log, file_offset, window, &header);
+	if(n < 0)
+		return 0;
+	skip = e->raw_offset - header.raw_offset;
+	len = n;
+	file_offset += sizeof(header) + header.data_size;
+	while(header.raw_offset + n < end && len + LOG_BUFFER_SIZE <= window_size
+			&& (n = _read_block(log, file_offset, &window[len], &header)) >= 0){
+		len += n;
+		file_offset += sizeof(header) + header.data_size;
+	}
+
+	return _walk(log, window + skip, len - skip, 0, e->raw_offset, e->timestamp, target, time, walked);
+}
+
+static int _seek(const char* name, double seconds)
+{
+	log_t log;
+	uint32_t first, scan_pos, index_pos, scan_walked, index_walked;
+	uint64_t start, target, scan_time, index_time;
+	double t0, scan_cost, index_cost;
+	int round = 1000;
+
+	if(_load(&log, name))
+		return 1;
+	if(log.index == NULL || log.index->entry_num == 0 || _first_stamp(&log, &first)){
+		printf("%s has no index footer or no record\n", name);
+		_unload(&log);
+		return 1;
+	}
+
+	/* entries count time from the first marker without wrap around */
+	start = log.entry[0].timestamp - (uint32_t)((uint32_t)log.entry[0].timestamp - first);
+	target = start + (uint64_t)(seconds*1e6);
+
+	/* scan decodes from start, it is what a reader without index has to do */
+	t0 = _now();
+	scan_pos = _walk(&log, log.raw, log.raw_size, log.header_size, 0, start, target, &scan_time, &scan_walked);
+	scan_cost = _now() - t0;
+	if(log.compressed){
+		/* and it has to decompress all blocks before as well */
+		uint8_t* out = malloc(LOG_BUFFER_SIZE);
+		block_header_t header;
+
+		t0 = _now();
+		for(uint32_t i = 0 ; i < log.block_num && log.block[i].raw_offset <= scan_pos ; i++)
+			_read_block(&log, log.block[i].file_offset, out, &header);
+		scan_cost += _now() - t0;
+		free(out);
+	}
+
+	t0 = _now();
+	for(int i = 0 ; i < round ; i++)
+		index_pos = _seek_index(&log, start, target, &index_time, &index_walked);
+	index_cost = (_now() - t0)/round;
+
+	printf("target %.3f s, %u index entries\n", seconds, log.index->entry_num);
+	printf("scan:  raw offset %u at %.6f s, %u records, %.1f us\n", scan_pos, (scan_time - start)*1e-6,
+			scan_walked, scan_cost*1e6);
+	printf("index: raw offset %u at %.6f s, %u records, %.1f us\n", index_pos, (index_time - start)*1e-6,
+			index_walked, index_cost*1e6);
+	if(scan_pos != index_pos)
+		printf("seek result differs from scan\n");
+
+	_unload(&log);
+
+	return scan_pos != index_pos;
+}
+
+/* next marker at or after pos, or len */
+static uint32_t _find_mark(const log_t* log, uint32_t pos)
+{
+	for(; pos + sizeof(sync_t) <= log->raw_size ; pos++){
+		if(log->raw[pos] == LOG_RECORD_SYNC_MARK && _record_size(log, log->raw, log->raw_size, pos, pos))
+			return pos;
+	}
+
+	return log->raw_size;
+}
+
+static void _write_block(FILE* fp, const uint8_t* data, uint32_t size, uint32_t raw_offset)
+{
+	block_header_t header;
+
+	header.magic = LOG_BLOCK_MAGIC;
+	header.method = LOG_COMPRESS_NONE;
+	header.reserved = 0;
+	header.raw_size = size;
+	header.data_size = size;
+	header.raw_offset = raw_offset;
+	fwrite(&header, sizeof(header), 1, fp);
+	fwrite(data, 1, size, fp);
+}
+
+/* Keep data up to the last whole record, skip broken parts in between by
+ * searching the next marker, and append a footer with an entry per marker.
+ */
+static int _recover(const char* in_name, const char* out_name)
+{
+	log_t log;
+	uint32_t pos, end, n, entry_num = 0, lost = 0, record_cnt = 0;
+	uint32_t footer_size, file_size, b, stride = 1;
+	uint64_t time = 0;
+	index_entry_t* entry;
+	uint8_t* footer;
+	index_tail_t tail;
+	FILE* fp;
+
+	if(_load(&log, in_name))
+		return 1;
+	if(log.index)
+		printf("%s already has an index footer, it is rebuilt\n", in_name);
+
+	entry = malloc((log.raw_size/sizeof(sync_t) + 1)*sizeof(index_entry_t));
+	pos = end = log.header_size;
+	while(pos < log.raw_size){
+		n = _record_size(&log, log.raw, log.raw_size, pos, pos);
+		if(n == 0){
+			uint32_t next;
+
+			/* old footer ends the records */
+			if(log.raw[pos] == LOG_RECORD_SYNC_INDEX && log.index)
+				break;
+			next = _find_mark(&log, pos + 1);
+			if(next == log.raw_size)
+				break;
+			lost += next - pos;
+			pos = next;
+			continue;
+		}
+		if(log.raw[pos] == LOG_RECORD_SYNC_MARK){
+			sync_t mark;
+
+			memcpy(&mark, &log.raw[pos], sizeof(mark));
+			if(entry_num == 0)
+				time = mark.timestamp;
+			else
+				time += (int32_t)(mark.timestamp - (uint32_t)time);
+			entry[entry_num].timestamp = time;
+			entry[entry_num].raw_offset = pos;
+			entry[entry_num].file_offset = pos;
+			entry_num++;
+		}else{
+			record_cnt++;
+		}
+		pos += n;
+		end = pos;
+	}
+
+	fp = fopen(out_name, "wb");
+	if(fp == NULL){
+		fprintf(stderr, "can not create %s\n", out_name);
+		free(entry);
+		_unload(&log);
+		return 1;
+	}
+
+	/* data before end is kept as it is, compressed blocks keep their offset */
+	if(log.compressed){
+		for(b = 0 ; b < log.block_num && log.block[b].raw_offset + log.block[b].raw_size <= end ; b++);
+		file_size = b < log.block_num ? log.block[b].file_offset : log.file_size;
+		fwrite(log.file, 1, file_size, fp);
+		/* the block holding the last record is cut and stored */
+		if(b < log.block_num && end > log.block[b].raw_offset){
+			_write_block(fp, &log.raw[log.block[b].raw_offset], end - log.block[b].raw_offset, log.block[b].raw_offset);
+			b++;
+		}
+		for(uint32_t i = 0, k = 0 ; i < entry_num ; i++){
+			while(k + 1 < log.block_num && log.block[k + 1].raw_offset <= entry[i].raw_offset)
+				k++;
+			entry[i].file_offset = log.block[k].file_offset;
+		}
+		/* footer is a single block, thin out entries as the board does */
+		while(entry_num > LOG_INDEX_MAX_NUM){
+			for(uint32_t i = 0 ; 2*i < entry_num ; i++)
+				entry[i] = entry[2*i];
+			entry_num = (entry_num + 1)/2;
+			stride *= 2;
+		}
+	}else{
+		fwrite(log.raw, 1, end, fp);
+	}
+
+	footer_size = sizeof(index_header_t) + entry_num*sizeof(index_entry_t) + sizeof(tail);
+	footer = malloc(footer_size);
+	((index_header_t*)footer)->sync = LOG_RECORD_SYNC_INDEX;
+	((index_header_t*)footer)->reserved = 0;
+	((index_header_t*)footer)->stride = stride;
+	((index_header_t*)footer)->entry_num = entry_num;
+	memcpy(&footer[sizeof(index_header_t)], entry, entry_num*sizeof(index_entry_t));
+	tail.magic = LOG_INDEX_MAGIC;
+	tail.entry_num = entry_num;
+	tail.index_size = footer_size;
+	tail.raw_offset = end;
+	memcpy(&footer[footer_size - sizeof(tail)], &tail, sizeof(tail));
+	if(log.compressed)
+		_write_block(fp, footer, footer_size, end);
+	else
+		fwrite(footer, 1, footer_size, fp);
+	fclose(fp);
+
+	printf("%s: %u records, %u index entries, one per %u markers\n", in_name, record_cnt, entry_num, stride);
+	printf("kept %u of %u raw bytes, %u broken bytes in between\n", end, log.raw_size, lost);
+
+	free(footer);
+	free(entry);
+	_unload(&log);
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	if(lzo_init() != LZO_E_OK || inflateInit2(&_zs_inflate, -15) != Z_OK){
+		fprintf(stderr, "codec init fail\n");
+		return 1;
+	}
+
+	if(argc == 3 && strcmp(argv[1], "show") == 0)
+		return _show(argv[2]);
+	if(argc == 4 && strcmp(argv[1], "seek") == 0)
+		return _seek(argv[2], atof(argv[3]));
+	if(argc == 4 && strcmp(argv[1], "recover") == 0)
+		return _recover(argv[2], argv[3]);
+
+	printf("usage: %s show <log>\n", argv[0]);
+	printf("       %s seek <log> <seconds from log start>\n", argv[0]);
+	printf("       %s recover <log> <recovered log>\n", argv[0]);
+
+	return 1;
+}
@@ -0,0 +1,250 @@
+/*
+ * File      : trace2json.c
+ *
+ * Convert a trace file written by "trace dump <file>" into Chrome trace
+ * event JSON, which can be opened by chrome://tracing or ui.perfetto.dev.
+ *
+ * build: gcc -O2 -o trace2json trace2json.c
+ * usage: trace2json <trace file> [json file]
+ *
+ * Change Logs:
+ * Date           Author       	Notes
+ * 2026-10-15     StarryPilot 	the first version
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+/* keep in sync with starry_fmu/Framework/include/trace.h */
+#define TRACE_FILE_MAGIC			0x43525453
+#define TRACE_FILE_VERSION			1
+#define TRACE_NAME_LEN				16
+
+enum
+{
+	TRACE_EVT_SWITCH = 0,
+	TRACE_EVT_READY,
+	TRACE_EVT_IRQ_ENTER,
+	TRACE_EVT_IRQ_LEAVE,
+	TRACE_EVT_ZONE_BEGIN,
+	TRACE_EVT_ZONE_END,
+	TRACE_EVT_MARK,
+};
+
+#pragma pack(push, 1)
+typedef struct
+{
+	uint32_t	timestamp;
+	uint8_t		type;
+	uint8_t		id;
+	uint16_t	arg;
+}trace_record_t;
+
+typedef struct
+{
+	uint32_t	magic;
+	uint16_t	version;
+	uint16_t	record_size;
+	uint32_t	record_num;
+	uint32_t	lost_num;
+	uint8_t		thread_num;
+	uint8_t		zone_num;
+	uint8_t		mark_num;
+	uint8_t		reserved;
+}trace_file_header_t;
+#pragma pack(pop)
+
+/* lanes (tid) in the json output */
+#define TID_THREAD(_id)		(1 + (_id))
+#define TID_IRQ(_num)		(1000 + (_num))
+#define TID_ZONE(_id)		(2000 + (_id))
+#define TID_MARK			3000
+
+#define MAX_ID				256
+#define NO_START			(-1.0)
+
+static FILE* _out;
+static int _first_event = 1;
+
+static char _thread_name[MAX_ID][TRACE_NAME_LEN+1];
+static char _zone_name[MAX_ID][TRACE_NAME_LEN+1];
+static char _mark_name[MAX_ID][TRACE_NAME_LEN+1];
+
+static double _thread_start[MAX_ID];
+static double _irq_start[MAX_ID];
+static double _zone_start[MAX_ID];
+static int _irq_used[MAX_ID];
+
+static void emit_begin(void)
+{
+	fprintf(_out, _first_event ? "\n" : ",\n");
+	_first_event = 0;
+}
+
+static void emit_meta(int tid, const char* name, int sort_index)
+{
+	emit_begin();
+	fprintf(_out, "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_name\",\"args\":{\"name\":\"%s\"}}", tid, name);
+	emit_begin();
+	fprintf(_out, "{\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"name\":\"thread_sort_index\",\"args\":{\"sort_index\":%d}}", tid, sort_index);
+}
+
+static void emit_span(int tid, const char* name, double start, double end)
+{
+	emit_begin();
+	fprintf(_out, "{\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.0f,\"dur\":%.0f}", tid, name, start, end - start);
+}
+
+static void emit_instant(int tid, const char* name, double ts, const char* scope, int arg)
+{
+	emit_begin();
+	fprintf(_out, "{\"ph\":\"i\",\"pid\":1,\"tid\":%d,\"name\":\"%s\",\"ts\":%.0f,\"s\":\"%s\",\"args\":{\"value\":%d}}",
+			tid, name, ts, scope, arg);
+}
+
+static int read_names(FILE* fp, char names[][TRACE_NAME_LEN+1], int num)
+{
+	for(int i = 0 ; i < num ; i++){
+		if(fread(names[i], 1, TRACE_NAME_LEN, fp) != TRACE_NAME_LEN)
+			return -1;
+		names[i][TRACE_NAME_LEN] = '\0';
+	}
+
+	return 0;
+}
+
+int main(int argc, char** argv)
+{
+	FILE* fp;
+	trace_file_header_t header;
+	trace_record_t rec;
+	uint32_t last_stamp = 0;
+	double ts = 0, base = 0;
+	int cur_thread = -1;
+	char irq_name[32];
+
+	if(argc < 2){
+		fprintf(stderr, "usage: %s <trace file> [json file]\n", argv[0]);
+		return 1;
+	}
+
+	fp = fopen(argv[1], "rb");
+	if(fp == NULL){
+		fprintf(stderr, "fail to open %s\n", argv[1]);
+		return 1;
+	}
+	if(fread(&header, sizeof(header), 1, fp) != 1 || header.magic != TRACE_FILE_MAGIC){
+		fprintf(stderr, "%s is not a trace file\n", argv[1]);
+		return 1;
+	}
+	if(header.version != TRACE_FILE_VERSION || header.record_size != sizeof(trace_record_t)){
+		fprintf(stderr, "unsupported trace version %d, record size %d\n", header.version, header.record_size);
+		return 1;
+	}
+	if(read_names(fp, _thread_name, header.thread_num) || read_names(fp, _zone_name, header.zone_num)
+		|| read_names(fp, _mark_name, header.mark_num)){
+		fprintf(stderr, "truncated name table\n");
+		return 1;
+	}
+
+	_out = stdout;
+	if(argc > 2){
+		_out = fopen(argv[2], "w");
+		if(_out == NULL){
+			fprintf(stderr, "fail to create %s\n", argv[2]);
+			return 1;
+		}
+	}
+
+	for(int i = 0 ; i < MAX_ID ; i++){
+		_thread_start[i] = _irq_start[i] = _zone_start[i] = NO_START;
+		_irq_used[i] = 0;
+	}
+
+	fprintf(_out, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+	for(int i = 0 ; i < header.thread_num ; i++)
+		emit_meta(TID_THREAD(i), _thread_name[i], i);
+	for(int i = 0 ; i < header.zone_num ; i++)
+		emit_meta(TID_ZONE(i), _zone_name[i], 2000 + i);
+	emit_meta(TID_MARK, "mark", 3000);
+
+	for(uint32_t n = 0 ; n < header.record_num ; n++){
+		if(fread(&rec, sizeof(rec), 1, fp) != 1){
+			fprintf(stderr, "truncated at record %u\n", n);
+			break;
+		}
+
+		/* unwrap 32 bit us timestamp, time starts from the first record */
+		if(n == 0)
+			base = rec.timestamp;
+		else
+			ts += (uint32_t)(rec.timestamp - last_stamp);
+		last_stamp = rec.timestamp;
+
+		switch(rec.type)
+		{
+			case TRACE_EVT_SWITCH:
+				if(rec.arg < MAX_ID && _thread_start[rec.arg] != NO_START){
+					emit_span(TID_THREAD(rec.arg), _thread_name[rec.arg], _thread_start[rec.arg], ts);
+					_thread_start[rec.arg] = NO_START;
+				}
+				if(rec.id < header.thread_num)
+					_thread_start[rec.id] = ts;
+				cur_thread = rec.id;
+				break;
+			case TRACE_EVT_READY:
+				if(rec.id < header.thread_num)
+					emit_instant(TID_THREAD(rec.id), "ready", ts, "t", 0);
+				break;
+			case TRACE_EVT_IRQ_ENTER:
+				if(!_irq_used[rec.id]){
+					_irq_used[rec.id] = 1;
+					/* exception number 16 is IRQ0 */
+					if(rec.id >= 16)
+						sprintf(irq_name, "IRQ %d", rec.id - 16);
+					else
+						sprintf(irq_name, "exception %d", rec.id);
+					emit_meta(TID_IRQ(rec.id), irq_name, 1000 + rec.id);
+				}
+				_irq_start[rec.id] = ts;
+				break;
+			case TRACE_EVT_IRQ_LEAVE:
+				if(_irq_start[rec.id] != NO_START){
+					emit_span(TID_IRQ(rec.id), "irq", _irq_start[rec.id], ts);
+					_irq_start[rec.id] = NO_START;
+				}
+				break;
+			case TRACE_EVT_ZONE_BEGIN:
+				_zone_start[rec.id] = ts;
+				break;
+			case TRACE_EVT_ZONE_END:
+				if(rec.id < header.zone_num && _zone_start[rec.id] != NO_START){
+					emit_span(TID_ZONE(rec.id), _zone_name[rec.id], _zone_start[rec.id], ts);
+					_zone_start[rec.id] = NO_START;
+				}
+				break;
+			case TRACE_EVT_MARK:
+				emit_instant(TID_MARK, rec.id < header.mark_num ? _mark_name[rec.id] : "mark", ts, "g", rec.arg);
+				break;
+			default:
+				break;
+		}
+	}
+
+	/* close the thread still running at the end of trace */
+	if(cur_thread >= 0 && cur_thread < MAX_ID && _thread_start[cur_thread] != NO_START)
+		emit_span(TID_THREAD(cur_thread), _thread_name[cur_thread], _thread_start[cur_thread], ts);
+
+	fprintf(_out, "\n]}\n");
+
+	fprintf(stderr, "%u records (%u lost before), %.3f ms, start stamp %.0f us\n", header.record_num,
+			header.lost_num, ts / 1000.0, base);
+
+	fclose(fp);
+	if(_out != stdout)
+		fclose(_out);
+
+	return 0;
+}